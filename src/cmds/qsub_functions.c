@@ -38,6 +38,8 @@
 #include <grp.h>
 #include <csv.h>
 #include <pwd.h>
+#include <string>
+#include <vector>
 
 #ifdef sun
 #include <sys/stream.h>
@@ -3633,7 +3635,7 @@ void process_config_file(
       {
       if (param_val != NULL)
         {
-        host_name_suffix = (char *)calloc(1, strlen(param_val));
+        host_name_suffix = (char *)calloc(1, strlen(param_val) + 1);
         strcpy(host_name_suffix, param_val);
         }
       }
@@ -3660,7 +3662,8 @@ void print_qsub_usage_exit(const char *error_msg)
   /* need secondary usage since there appears to be a 512 byte size limit */
 
   static char usage2[] =
-    "      [-W additional_attributes] [-v variable_list] [-V ] [-x] [-X] [-z] [script]\n";
+    "      [-W additional_attributes] [-v variable_list] [-V ] [-x] [-X] [-z] [script]\n\
+   or: qsub --manifest file [options]\n";
     
   fprintf(stderr,"[%s]\n\n%s%s\n", error_msg, usage, usage2);
 
@@ -3824,51 +3827,39 @@ void process_early_opts(
 
 
 
-/** 
- * qsub main 
+/**
+ * build_job_info - fill ji with the job described by argv
  *
- * @see process_opts() - child
+ * Reads the script named in argv (or standard input) for directives and
+ * writes the copy that will be submitted to script_tmp.  Exits on error.
+ *
+ * @see main_func() - parent
+ * @see submit_manifest() - parent
  */
-void main_func(
 
-  int    argc,  /* I */
-  char **argv,  /* I */
-  char **envp)  /* I */
+void build_job_info(
 
-  {
+  int       argc,       /* I */
+  char    **argv,       /* I */
+  char    **envp,       /* I */
+  job_info *ji,         /* O */
+  char     *script_tmp) /* O (minsize=MAXPATHLEN + 1) */
 
+  {
   int               errflg;                         /* option error */
   char              script[MAXPATHLEN + 1] = ""; /* name of script file */
-  char              script_tmp[MAXPATHLEN + 1] = "";    /* name of script file copy */
   int               script_index;
   char             *bnp;
   FILE             *script_fp;                    /* FILE pointer to the script */
-  char             *destination = NULL;           /* Changed from global to local */
-  char             *s_n_out;                      /* server part of destination */
-  int               sock_num;                     /* return from pbs_connect */
-  char             *errmsg = NULL;                /* return from pbs_geterrmsg */
-  int               local_errno = 0;
   int               job_is_interactive = FALSE;
   int               prefix_index = -1;
 
   struct stat       statbuf;
 
-  struct sigaction  act;
-
   int               script_idx = 0;
   int               idx;
   job_data         *tmp_job_info = NULL;
-  /* Allocate Memmgr */
-  int               debug = FALSE;
-  job_info          ji;
 
-  /**
-   * Before we go to the trouble of allocating memory, initializing structures,
-   * and setting up for ordinary workflow, check options to see if we'll be
-   * short-circuiting. If yes, then we'll exit without ever returning to main_func.
-   */
-  process_early_opts(argc, argv);
-  
   /* The order of precedence for processing options follows:
    * 1 - processing logic (includes submitfilter)
    * 2 - cmdline information
@@ -3884,26 +3875,25 @@ void main_func(
 
 
   /* (5) adds all env variables to a tmp hash */
-  set_env_opts(ji.user_attr, envp);
+  set_env_opts(ji->user_attr, envp);
   /* (6) set option default job values */
-  set_job_defaults(&ji);
+  set_job_defaults(ji);
   /* (6) Adds client default options */
-  set_client_attr_defaults(ji.client_attr);
+  set_client_attr_defaults(ji->client_attr);
   /* The following call  also replaces the functionality of set_job_env
    * up to the v_opt and V_opt sections. Those are replaced below */
   /* The names currently used differ from the actual anvironment names,
    * this adds an expected set */
-  update_job_env_names(&ji);
-  add_submit_args_to_job(ji.job_attr, argc, argv);
-  debug = hash_find(ji.job_attr, "pbsdebug", &tmp_job_info); /* Set debug state */
+  update_job_env_names(ji);
+  add_submit_args_to_job(ji->job_attr, argc, argv);
 
   /* (4) process config file options */
-  process_config_file(&ji);
+  process_config_file(ji);
 
   /* check/set submit filter_path */
-  if (validate_submit_filter(ji.job_attr) == -1)
+  if (validate_submit_filter(ji->job_attr) == -1)
     {
-     hash_find(ji.job_attr, ATTR_pbs_o_submit_filter, &tmp_job_info);
+     hash_find(ji->job_attr, ATTR_pbs_o_submit_filter, &tmp_job_info);
      fprintf(stderr,
              "qsub: invalid submit filter: \"%s\"\n",
              tmp_job_info->value.c_str());
@@ -3925,14 +3915,14 @@ void main_func(
     {
     snprintf(script, sizeof(script), "%s", argv[script_index]);
     /* store the script so it can be used later (e.g. '-x' option) */
-    hash_add_or_exit(ji.client_attr, "cmdline_script", script, CMDLINE_DATA);
+    hash_add_or_exit(ji->client_attr, "cmdline_script", script, CMDLINE_DATA);
     }
 
   if (prefix_index != -1)
-    hash_add_or_exit(ji.client_attr, "pbs_dprefix", argv[prefix_index], CMDLINE_DATA);
+    hash_add_or_exit(ji->client_attr, "pbs_dprefix", argv[prefix_index], CMDLINE_DATA);
 
   script_idx = argc - optind;
-  if (hash_find(ji.job_attr, ATTR_inter, &tmp_job_info))
+  if (hash_find(ji->job_attr, ATTR_inter, &tmp_job_info))
     {
     for (idx = 1; idx < script_idx; idx++)
       {
@@ -3944,8 +3934,8 @@ void main_func(
   /* if script is empty, get standard input */
   if (!strcmp(script, "") || !strcmp(script, "-"))
     {
-    if (hash_find(ji.job_attr, ATTR_N, &tmp_job_info) == FALSE)
-      hash_add_or_exit(ji.job_attr, ATTR_N, "STDIN", CMDLINE_DATA);
+    if (hash_find(ji->job_attr, ATTR_N, &tmp_job_info) == FALSE)
+      hash_add_or_exit(ji->job_attr, ATTR_N, "STDIN", CMDLINE_DATA);
 
     if (job_is_interactive == FALSE)
       {
@@ -3955,7 +3945,7 @@ void main_func(
                       argv,
                       stdin,
                       script_tmp,    /* O */
-                      &ji)) != 0)
+                      ji)) != 0)
         {
         unlink(script_tmp);
 
@@ -3986,7 +3976,7 @@ void main_func(
 
     if ((script_fp = fopen(script, "r")) != NULL)
       {
-      if (hash_find(ji.job_attr, ATTR_N, &tmp_job_info) == FALSE)
+      if (hash_find(ji->job_attr, ATTR_N, &tmp_job_info) == FALSE)
         {
         if ((bnp = strrchr(script, (int)'/')))
           bnp++;
@@ -3994,7 +3984,7 @@ void main_func(
           bnp = script;
 
         if (check_job_name(bnp, 0) == 0)
-          hash_add_or_exit(ji.job_attr, ATTR_N, bnp, CMDLINE_DATA);
+          hash_add_or_exit(ji->job_attr, ATTR_N, bnp, CMDLINE_DATA);
         else
           print_qsub_usage_exit("qsub: cannot form a valid job name from the script name");
         }
@@ -4005,7 +3995,7 @@ void main_func(
                       argv,
                       script_fp,
                       script_tmp, /* O */
-                      &ji)) != 0)
+                      ji)) != 0)
         {
         fclose(script_fp);
         unlink(script_tmp);
@@ -4021,12 +4011,442 @@ void main_func(
     }    /* END else (!strcmp(script,"") || !strcmp(script,"-")) */
  
   /* (2) cmdline options */
-  process_opts(argc, argv, &ji, CMDLINE_DATA);
+  process_opts(argc, argv, ji, CMDLINE_DATA);
 
-  if (((optind + 1) < argc) && (hash_find(ji.job_attr, ATTR_inter, &tmp_job_info) == FALSE))
+  if (((optind + 1) < argc) && (hash_find(ji->job_attr, ATTR_inter, &tmp_job_info) == FALSE))
     print_qsub_usage_exit("index issues");
   
-  post_check_attributes(&ji, script_tmp);
+  post_check_attributes(ji, script_tmp);
+  } /* END build_job_info() */
+
+
+
+/*
+ * is_root_submission - TRUE if the job would run as root, which qsub
+ * does not allow
+ */
+
+int is_root_submission(
+
+  job_info *ji)  /* I */
+
+  {
+  job_data *tmp_job_info = NULL;
+
+  if (hash_find(ji->job_attr, ATTR_P, &tmp_job_info) == TRUE)
+    return(strcmp("root", tmp_job_info->value.c_str()) == 0);
+
+  return((getuid() == 0) && (geteuid() == 0));
+  } /* END is_root_submission() */
+
+
+
+
+/*
+ * get_manifest_opt - find --manifest=file or --manifest file in argv
+ *
+ * The option is removed from argv so the rest can be handed to
+ * process_opts() for each job of the manifest.
+ *
+ * @return the manifest path or NULL if the option was not given
+ */
+
+char *get_manifest_opt(
+
+  int   *argc,  /* M */
+  char **argv)  /* M */
+
+  {
+  char *manifest = NULL;
+  int   i;
+  int   skip = 0;
+
+  for (i = 1; i < *argc; i++)
+    {
+    if (strncmp(argv[i], "--manifest=", strlen("--manifest=")) == 0)
+      {
+      manifest = argv[i] + strlen("--manifest=");
+      skip = 1;
+      }
+    else if (strcmp(argv[i], "--manifest") == 0)
+      {
+      if (i + 1 >= *argc)
+        print_qsub_usage_exit("qsub: --manifest requires a file");
+
+      manifest = argv[i + 1];
+      skip = 2;
+      }
+    else
+      continue;
+
+    for (; i + skip <= *argc; i++)
+      argv[i] = argv[i + skip];
+
+    *argc -= skip;
+
+    break;
+    }
+
+  if ((manifest != NULL) &&
+      (*manifest == '\0'))
+    print_qsub_usage_exit("qsub: --manifest requires a file");
+
+  return(manifest);
+  } /* END get_manifest_opt() */
+
+
+
+
+/*
+ * reset_job_parse_state - forget what parsing one job's options left in
+ * globals, so the next job of a manifest is parsed as if by a fresh qsub
+ */
+
+void reset_job_parse_state()
+
+  {
+  J_opt = FALSE;
+  P_opt = FALSE;
+
+  /* process_config_file() sets it again for every job */
+  if (host_name_suffix != NULL)
+    {
+    free(host_name_suffix);
+    host_name_suffix = NULL;
+    }
+
+  optarg = NULL;
+
+#ifdef linux
+  optind = 0;  /* also makes getopt() drop its state */
+#else
+  optind = 1;
+#endif
+  } /* END reset_job_parse_state() */
+
+
+
+
+/*
+ * manifest_job_argv - build the arguments of one manifest job: qsub's own
+ * arguments followed by those on the manifest line, so the line can
+ * override them
+ *
+ * @return PBSE_NONE or PBSE_IVALREQ if there are too many arguments
+ */
+
+int manifest_job_argv(
+
+  int    argc,      /* I */
+  char **argv,      /* I */
+  char  *line,      /* I */
+  char **line_argv, /* M (minsize=MAX_ARGV_LEN + 1) */
+  int   *job_argc,  /* O */
+  char **job_argv)  /* O (minsize=MAX_ARGV_LEN + 1) */
+
+  {
+  int line_argc;
+  int i;
+
+  make_argv(&line_argc, line_argv, line);
+
+  if (argc + line_argc - 1 > MAX_ARGV_LEN)
+    return(PBSE_IVALREQ);
+
+  *job_argc = 0;
+
+  for (i = 0; i < argc; i++)
+    job_argv[(*job_argc)++] = argv[i];
+
+  for (i = 1; i < line_argc; i++)
+    job_argv[(*job_argc)++] = line_argv[i];
+
+  job_argv[*job_argc] = NULL;
+
+  return(PBSE_NONE);
+  } /* END manifest_job_argv() */
+
+
+
+
+/*
+ * submit_manifest - submit every job listed in a manifest over one
+ * connection
+ *
+ * Each line of the manifest holds qsub options and a script path, as they
+ * would follow qsub on a command line; blank lines and lines starting
+ * with '#' are skipped.  The options given to qsub itself apply to every
+ * job and a line can override them.  The jobs are built as qsub would
+ * build them one by one and then handed to pbs_submit_bulk(), which
+ * streams them to the server.  Job ids are written in manifest order.
+ *
+ * Exits 0 if every job was submitted, otherwise with the first error.
+ */
+
+void submit_manifest(
+
+  int         argc,     /* I */
+  char      **argv,     /* I */
+  char      **envp,     /* I */
+  const char *manifest) /* I */
+
+  {
+  FILE                    *fp;
+  char                     line[MAX_LINE_LEN + 1];
+  char                    *line_argv[MAX_ARGV_LEN + 1] = {};
+  char                    *job_argv[MAX_ARGV_LEN + 1];
+  char                     script_tmp[MAXPATHLEN + 1];
+  char                     server[PBS_MAXSERVERNAME + PBS_MAXPORTNUM + 2] = "";
+  char                    *q_n_out;
+  char                    *s_n_out;
+  char                    *ptr;
+  int                      job_argc;
+  int                      line_num = 0;
+  int                      is_interactive;
+  int                      prefix_index;
+  int                      sock_num;
+  int                      rc = PBSE_NONE;
+  int                      i;
+  job_info                *ji;
+  job_data                *tmp_job_info = NULL;
+  std::vector<job_info *>  jobs;
+  std::vector<std::string> scripts;
+  std::vector<int>         job_lines;
+  struct pbs_bulk_job     *bulk;
+
+  if (strcmp(manifest, "-") == 0)
+    fp = stdin;
+  else if ((fp = fopen(manifest, "r")) == NULL)
+    {
+    fprintf(stderr, "qsub: cannot open manifest '%s' - %s\n",
+      manifest,
+      strerror(errno));
+
+    exit(1);
+    }
+
+  while (fgets(line, sizeof(line), fp) != NULL)
+    {
+    line_num++;
+
+    if ((ptr = strchr(line, '\n')) != NULL)
+      *ptr = '\0';
+
+    for (ptr = line; isspace(*ptr); ptr++);
+
+    if ((*ptr == '\0') ||
+        (*ptr == '#'))
+      continue;
+
+    if (manifest_job_argv(argc, argv, ptr, line_argv, &job_argc, job_argv) != PBSE_NONE)
+      {
+      fprintf(stderr, "qsub: manifest line %d: too many arguments\n", line_num);
+      rc = PBSE_IVALREQ;
+      break;
+      }
+
+    /* nothing the last job's options set may carry over to this one */
+    reset_job_parse_state();
+
+    /* the manifest may be standard input, so every job needs a script */
+    is_interactive = FALSE;
+    prefix_index = -1;
+    i = find_job_script_index(1, &is_interactive, &prefix_index, job_argc, job_argv);
+
+    if ((i == -1) ||
+        (strcmp(job_argv[i], "-") == 0) ||
+        (is_interactive == TRUE))
+      {
+      fprintf(stderr, "qsub: manifest line %d: %s\n",
+        line_num,
+        (is_interactive == TRUE) ? "interactive jobs cannot be submitted from a manifest" : "no job script");
+      rc = PBSE_IVALREQ;
+      break;
+      }
+
+    ji = new job_info();
+    script_tmp[0] = '\0';
+
+    build_job_info(job_argc, job_argv, envp, ji, script_tmp);
+
+    jobs.push_back(ji);
+    scripts.push_back(script_tmp);
+    job_lines.push_back(line_num);
+
+    if (hash_find(ji->job_attr, ATTR_inter, &tmp_job_info))
+      {
+      fprintf(stderr, "qsub: manifest line %d: interactive jobs cannot be submitted from a manifest\n", line_num);
+      rc = PBSE_IVALREQ;
+      break;
+      }
+
+    if (is_root_submission(ji) == TRUE)
+      {
+      fprintf(stderr, "qsub can not be run as root\n");
+      rc = PBSE_BADUSER;
+      break;
+      }
+
+    /* one connection carries the whole manifest, so one server */
+    if (hash_find(ji->client_attr, "destination", &tmp_job_info))
+      {
+      if (parse_destination_id((char *)tmp_job_info->value.c_str(), &q_n_out, &s_n_out))
+        {
+        fprintf(stderr, "qsub: manifest line %d: illegally formed destination: %s\n",
+          line_num,
+          tmp_job_info->value.c_str());
+        rc = PBSE_IVALREQ;
+        break;
+        }
+      }
+    else
+      s_n_out = (char *)"";
+
+    if (jobs.size() == 1)
+      snprintf(server, sizeof(server), "%s", s_n_out);
+    else if (strcmp(server, s_n_out) != 0)
+      {
+      fprintf(stderr, "qsub: manifest line %d: all jobs of a manifest must go to the same server\n", line_num);
+      rc = PBSE_IVALREQ;
+      break;
+      }
+
+    set_minwclimit(ji->job_attr);
+
+    if (hash_find(ji->client_attr, "user_attr", &tmp_job_info))
+      add_variable_list(ji, ATTR_v, ji->user_attr);
+    }
+
+  if (fp != stdin)
+    fclose(fp);
+
+  for (i = 1; i <= MAX_ARGV_LEN; i++)
+    free(line_argv[i]);
+
+  if ((rc == PBSE_NONE) &&
+      (jobs.size() > 0))
+    {
+    if (hash_find(jobs[0]->client_attr, "cnt2server_retry", &tmp_job_info))
+      {
+      int tmpNum = atoi(tmp_job_info->value.c_str());
+      if (tmpNum > 0)
+        {
+        cnt2server_conf(tmpNum); /* set number of seconds to retry */
+        }
+      }
+
+    snprintf(server_out, sizeof(server_out), "%s", server);
+
+    if ((sock_num = cnt2server(server_out)) <= 0)
+      {
+      rc = -1 * sock_num;
+
+      fprintf(stderr, "qsub: cannot connect to server %s (errno=%d) %s\n",
+        (server_out[0] != '\0') ? server_out : pbs_server,
+        rc,
+        pbs_strerror(rc));
+      }
+    else
+      {
+      calloc_or_fail((char **)&bulk, jobs.size() * sizeof(struct pbs_bulk_job), "manifest jobs");
+
+      for (i = 0; i < (int)jobs.size(); i++)
+        {
+        bulk[i].job_attr = jobs[i]->job_attr;
+        bulk[i].res_attr = jobs[i]->res_attr;
+        bulk[i].script = (char *)scripts[i].c_str();
+
+        if (hash_find(jobs[i]->client_attr, "destination", &tmp_job_info))
+          bulk[i].destination = (char *)tmp_job_info->value.c_str();
+        else
+          bulk[i].destination = (char *)"";
+        }
+
+      pbs_submit_bulk(sock_num, bulk, jobs.size(), NULL);
+
+      for (i = 0; i < (int)jobs.size(); i++)
+        {
+        if (bulk[i].jobid != NULL)
+          {
+          if (hash_find(jobs[i]->client_attr, "no_jobid_out", &tmp_job_info) == FALSE)
+            printf("%s\n", bulk[i].jobid);
+          }
+        else
+          {
+          fprintf(stderr, "qsub: submit error for manifest line %d (%s)\n",
+            job_lines[i],
+            (bulk[i].errmsg != NULL) ? bulk[i].errmsg : pbs_strerror(bulk[i].errcode));
+
+          if (rc == PBSE_NONE)
+            rc = bulk[i].errcode;
+          }
+
+        free(bulk[i].jobid);
+        free(bulk[i].errmsg);
+        }
+
+      free(bulk);
+
+      pbs_disconnect(sock_num);
+      }
+    }
+
+  for (i = 0; i < (int)jobs.size(); i++)
+    {
+    unlink(scripts[i].c_str());
+    delete jobs[i];
+    }
+
+  exit(rc);
+  } /* END submit_manifest() */
+
+
+
+
+/** 
+ * qsub main 
+ *
+ * @see process_opts() - child
+ */
+void main_func(
+
+  int    argc,  /* I */
+  char **argv,  /* I */
+  char **envp)  /* I */
+
+  {
+
+  char              script_tmp[MAXPATHLEN + 1] = "";    /* name of script file copy */
+  char             *destination = NULL;           /* Changed from global to local */
+  char             *s_n_out;                      /* server part of destination */
+  int               sock_num;                     /* return from pbs_connect */
+  char             *errmsg = NULL;                /* return from pbs_geterrmsg */
+  int               local_errno = 0;
+  char             *manifest;                     /* --manifest file */
+
+  struct sigaction  act;
+
+  job_data         *tmp_job_info = NULL;
+  /* Allocate Memmgr */
+  int               debug = FALSE;
+  job_info          ji;
+
+  /**
+   * Before we go to the trouble of allocating memory, initializing structures,
+   * and setting up for ordinary workflow, check options to see if we'll be
+   * short-circuiting. If yes, then we'll exit without ever returning to main_func.
+   */
+  process_early_opts(argc, argv);
+  
+  if ((manifest = get_manifest_opt(&argc, argv)) != NULL)
+    {
+    /* does not return */
+    submit_manifest(argc, argv, envp, manifest);
+    }
+
+  build_job_info(argc, argv, envp, &ji, script_tmp);
+
+  debug = hash_find(ji.job_attr, "pbsdebug", &tmp_job_info); /* Set debug state */
 
   if (hash_find(ji.client_attr, "DISPLAY", &tmp_job_info))
     {
@@ -4117,19 +4537,7 @@ void main_func(
   set_minwclimit(ji.job_attr);
 
   /* Root user submission not allowed */
-  local_errno = PBSE_NONE;
-  if (hash_find(ji.job_attr, ATTR_P, &tmp_job_info) == TRUE)
-    {
-    if (strcmp("root", tmp_job_info->value.c_str()) == 0)
-      {
-      local_errno = PBSE_BADUSER;
-      }
-    }
-  else if ((getuid() == 0) && (geteuid() == 0))
-    {
-    local_errno = PBSE_BADUSER;
-    }
-  if (local_errno != PBSE_NONE)
+  if (is_root_submission(&ji) == TRUE)
     {
     fprintf(stderr, "qsub can not be run as root\n");
     unlink(script_tmp);
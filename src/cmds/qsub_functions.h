@@ -262,6 +262,35 @@ void print_qsub_usage_exit(
 
 void add_submit_args_to_job(job_data_container *job_attr, int argc, char **argv);
 
+void build_job_info(
+    int       argc,               /* I */
+    char    **argv,               /* I */
+    char    **envp,               /* I */
+    job_info *ji,                 /* O */
+    char     *script_tmp);        /* O */
+
+int is_root_submission(job_info *ji);
+
+char *get_manifest_opt(
+    int   *argc,                  /* M */
+    char **argv);                 /* M */
+
+void reset_job_parse_state();
+
+int manifest_job_argv(
+    int    argc,                  /* I */
+    char **argv,                  /* I */
+    char  *line,                  /* I */
+    char **line_argv,             /* M */
+    int   *job_argc,              /* O */
+    char **job_argv);             /* O */
+
+void submit_manifest(
+    int         argc,             /* I */
+    char      **argv,             /* I */
+    char      **envp,             /* I */
+    const char *manifest);        /* I */
+
 void main_func(
     int    argc,                  /* I */
     char **argv,                  /* I */
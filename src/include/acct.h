@@ -110,6 +110,10 @@ void        acct_close (bool acct_mutex_locked);
 extern void account_record (int acctype, job *pjob, const char *text);
 extern void account_jobstr (job *pjob);
 extern void account_jobend (job *pjob, std::string &acct_data);
+void        account_batch_begin();
+void        account_batch_end();
+void        account_batch_detach(std::string &records);
+void        account_batch_write(const std::string &records);
 
 #endif
 
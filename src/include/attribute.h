@@ -213,6 +213,7 @@ unsigned int at_flags:
 unsigned int at_type:
   ATRTYPE; /* type of attribute    */
   union  attr_val at_val;  /* the attribute value */
+  struct resource_index *at_rindex; /* index of a resource list (alloc), see attr_fn_resc.c */
   };
 
 typedef struct pbs_attribute pbs_attribute;
@@ -357,6 +358,7 @@ struct array_strings
 
 extern void clear_attr(pbs_attribute *pattr, attribute_def *pdef);
 extern int  find_attr(attribute_def *attrdef, const char *name, int limit);
+extern int  index_attr_defs(attribute_def *attrdef, int count);
 extern int  recov_attr(int fd, void *parent, attribute_def *padef,
 			   pbs_attribute *pattr, int limit, int unknown, int do_actions);
 extern long attr_ifelse_long(pbs_attribute *, pbs_attribute *, long);
@@ -129,6 +129,8 @@ struct rq_queuejob
   char     rq_destin[PBS_MAXDEST+1];
   char     rq_jid[PBS_MAXSVRJOBID+1];
   tlist_head    rq_attr; /* svrattrlist */
+  char    *rq_script; /* job script, SubmitJob only (alloc) */
+  long     rq_scriptsz;
   };
 
 /* JobCredential */
@@ -337,6 +339,7 @@ struct batch_request
   int                 rq_failcode;
   char               *rq_extend; /* request "extension" data  */
   char               *rq_id;      /* the batch request's id */
+  struct batch_request *rq_parent; /* request this is a step of, it takes the reply */
 
   struct batch_reply  rq_reply;   /* the reply area for this request */
 
@@ -455,6 +458,7 @@ extern int decode_DIS_Manage (struct tcp_chan *chan, struct batch_request *);
 extern int decode_DIS_MoveJob (struct tcp_chan *chan, struct batch_request *);
 extern int decode_DIS_MessageJob (struct tcp_chan *chan, struct batch_request *);
 extern int decode_DIS_QueueJob (struct tcp_chan *chan, struct batch_request *);
+extern int decode_DIS_SubmitJob (struct tcp_chan *chan, struct batch_request *);
 extern int decode_DIS_Register (struct tcp_chan *chan, struct batch_request *);
 extern int decode_DIS_ReturnFiles (struct tcp_chan *chan, struct batch_request *);
 extern int decode_DIS_ReqExtend (struct tcp_chan *chan, struct batch_request *);
@@ -478,6 +482,10 @@ extern int encode_DIS_ReturnFiles (struct tcp_chan *chan, struct batch_request *
 extern int encode_DIS_TrackJob (struct tcp_chan *chan, struct batch_request *);
 extern int encode_DIS_reply (struct tcp_chan *chan, struct batch_reply *);
 extern int encode_DIS_svrattrl (struct tcp_chan *chan, svrattrl *);
+extern int encode_DIS_svrattrl_entry (struct tcp_chan *chan, svrattrl *);
+extern int encode_DIS_svrattrl_cached (struct tcp_chan *chan, struct brp_encoded *, svrattrl *);
+extern struct brp_encoded *brp_encoded_hold (struct brp_encoded *);
+extern void brp_encoded_release (struct brp_encoded *);
 
 extern int dis_request_read (struct tcp_chan *chan, struct batch_request *);
 extern int dis_reply_read (struct tcp_chan *chan, struct batch_reply *);
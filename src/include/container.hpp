@@ -17,6 +17,7 @@
 #include <boost/unordered_map.hpp>
 #include <string>
 #include <vector>
+#include <map>
 #include <pthread.h>
 #include <memory.h>
 #include <errno.h>
@@ -49,7 +50,7 @@ class item
   {
   public:
 
-  item(std::string const &idString, T p): id(idString), ptr(p)
+  item(std::string const &idString, T p): id(idString), rank(0), ranked(false), ptr(p)
     {
     }
 
@@ -70,6 +71,8 @@ class item
     }
 
   std::string id;
+  long        rank;   /* snapshot of the rank used by insert_by_rank() */
+  bool        ranked; /* true if the item is in the rank index */
   private:
   item(){}
   T ptr;
@@ -262,6 +265,56 @@ class item_container
 
 
 
+  /*
+   * inserts an item after every item of the same or lower rank and before
+   * the first item of higher rank.  The rank is kept in an ordered index so
+   * no linear scan of the container, or of what the items point to, is
+   * needed.  Only items inserted with insert_by_rank() are ranked; the list
+   * stays in rank order as long as they are the only ones in it.
+   */
+
+  bool insert_by_rank(
+
+    T                  it,
+    std::string const &id,
+    long               rank)
+
+    {
+    CHECK_LOCK
+    if (exit_called)
+      return false;
+
+    typename boost::unordered_map<std::string, int>::iterator found = map.find(id);
+    if ((found != map.end()) &&
+        (found->second != ALWAYS_EMPTY_INDEX))
+      return false;
+
+    item<T> *pItem = new item<T>(id,it);
+    pItem->rank = rank;
+
+    typename std::multimap<long, item<T> *>::iterator higher = rank_index.upper_bound(rank);
+    int rc;
+
+    if (higher == rank_index.end())
+      rc = insert_thing(pItem);
+    else
+      rc = insert_thing_before(pItem, map[higher->second->id]);
+
+    if (rc < 0)
+      {
+      map.erase(id);
+      delete pItem;
+      return false;
+      }
+
+    pItem->ranked = true;
+    rank_index.insert(std::pair<long, item<T> *>(rank, pItem));
+
+    return true;
+    }
+
+
+
   bool insert_after(
       
     std::string const &location_id,
@@ -401,6 +454,35 @@ class item_container
 
 
 
+  /*
+   * copies the ids of every item, in container order, into ids so the
+   * caller can walk them after dropping the lock
+   */
+  void get_ids(
+
+    std::vector<std::string> &ids)
+
+    {
+    CHECK_LOCK
+    if (exit_called)
+      return;
+
+    int iter = -1;
+    initialize_ra_iterator(&iter);
+
+    while (iter != ALWAYS_EMPTY_INDEX)
+      {
+      item<T> *pItem = next_thing(&iter);
+
+      if (pItem == NULL)
+        break;
+
+      ids.push_back(pItem->id);
+      }
+    } /* END get_ids() */
+
+
+
   T pop(void)
     {
     CHECK_LOCK
@@ -459,6 +541,22 @@ class item_container
     map[id1] = ind2;
     map[id2] = ind1;
 
+    /* the ranks belong to the positions, so the items trade index entries
+     * too, which keeps equal ranks in list order */
+    if ((slots[ind1].pItem->ranked) &&
+        (slots[ind2].pItem->ranked))
+      {
+      typename std::multimap<long, item<T> *>::iterator entry1 = find_rank_entry(slots[ind2].pItem);
+      typename std::multimap<long, item<T> *>::iterator entry2 = find_rank_entry(slots[ind1].pItem);
+
+      entry1->second = slots[ind1].pItem;
+      entry2->second = slots[ind2].pItem;
+
+      long rank = slots[ind1].pItem->rank;
+      slots[ind1].pItem->rank = slots[ind2].pItem->rank;
+      slots[ind2].pItem->rank = rank;
+      }
+
     return true;
     }
 
@@ -502,6 +600,7 @@ class item_container
       slots[i].prev = ALWAYS_EMPTY_INDEX;
       }
 
+    rank_index.clear();
     num = 0;
     next_slot = 1;
     last = 0;
@@ -562,6 +661,37 @@ class item_container
     }
 
 
+
+  typename std::multimap<long, item<T> *>::iterator find_rank_entry(
+
+    item<T> *thing)
+
+    {
+    typename std::multimap<long, item<T> *>::iterator it = rank_index.lower_bound(thing->rank);
+
+    while ((it != rank_index.end()) &&
+           (it->first == thing->rank) &&
+           (it->second != thing))
+      it++;
+
+    return(it);
+    } /* END find_rank_entry() */
+
+
+
+  void unindex_rank(
+
+    item<T> *thing)
+
+    {
+    typename std::multimap<long, item<T> *>::iterator it = find_rank_entry(thing);
+
+    if ((it != rank_index.end()) &&
+        (it->second == thing))
+      rank_index.erase(it);
+    } /* END unindex_rank() */
+
+
   int swap_things(
       
     item<T> *thing1,
@@ -807,6 +937,10 @@ class item_container
     int next = slots[index].next;
 
     map.erase(slots[index].pItem->id);
+
+    if (slots[index].pItem->ranked)
+      unindex_rank(slots[index].pItem);
+
     slots[index].prev = ALWAYS_EMPTY_INDEX;
     slots[index].next = ALWAYS_EMPTY_INDEX;
     delete slots[index].pItem;
@@ -1106,6 +1240,7 @@ class item_container
   int next_slot;
   int last;
   boost::unordered_map<std::string, int> map;
+  std::multimap<long, item<T> *> rank_index; /* ranked items by rank, see insert_by_rank() */
 #ifdef CHECK_LOCKING
   bool locked;
 #endif
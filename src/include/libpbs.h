@@ -163,6 +163,7 @@ struct connect_handle
   int ch_errno; /* last error on this connection */
   char *ch_errtxt; /* pointer to last server error text */
   pthread_mutex_t *ch_mutex;
+  char ch_server[PBS_MAXSERVERNAME + PBS_MAXPORTNUM + 2]; /* HOSTNAME:PORT connected to */
   };
 
 extern struct connect_handle connection[];
@@ -176,12 +177,27 @@ struct brp_select    /* reply to Select Job Request */
   char     brp_jobid[PBS_MAXSVRJOBID+1];
   };
 
+/*
+ * svrattrl entries already DIS encoded, shared by reference count between
+ * the server's job status cache and the replies sent from it
+ */
+
+struct brp_encoded
+  {
+  int    be_refs;
+  int    be_count;   /* number of svrattrl entries in be_data */
+  size_t be_split;   /* offset in be_data where brp_attr entries are sent */
+  size_t be_len;
+  char   be_data[1];
+  };
+
 struct brp_status    /* reply to Status Job/Queue/Server Request */
   {
   list_link brp_stlink;
   int   brp_objtype;
   char   brp_objname[(PBS_MAXSVRJOBID > PBS_MAXDEST ? PBS_MAXSVRJOBID:PBS_MAXDEST)+1];
   tlist_head brp_attr;  /* head of svrattrlist */
+  struct brp_encoded *brp_encoded; /* if set, sent around brp_attr */
   };
 
 struct brp_cmdstat
@@ -310,6 +326,8 @@ PBSD_status_put (int c, int func, char *id, struct attrl *attrib, char *extend);
 
 struct batch_reply *PBSD_rdrpy(int *local_errno, int connect);
 
+struct batch_reply *PBSD_rdrpy_chan(int *local_errno, int connect, struct tcp_chan *chan);
+
 void PBSD_FreeReply (struct batch_reply *);
 
 struct batch_status *PBSD_status(int c, int function, int *, char *id, struct attrl *attrib, char *extend);
@@ -318,6 +336,10 @@ struct batch_status *PBSD_status_get(int *local_errno, int c);
 
 char *PBSD_queuejob (int c, int *, char *j, char *d, struct attropl *a, char *ex);
 int PBSD_QueueJob_hash(int c, char *j, char *d, job_data_container *ja, job_data_container *ra, char *ex, char **job_id, char **msg);
+int PBSD_read_script(char *script_file, char **buf, int *len);
+char *PBSD_submitjob(int c, int *, char *d, struct attropl *a, char *script, int script_len, char *ex);
+int PBSD_SubmitJob_hash(int c, char *d, job_data_container *ja, job_data_container *ra, char *script, int script_len, char *ex, char **job_id, char **msg);
+int PBSD_submit_bulk(int c, struct pbs_bulk_job *jobs, int job_count, char *ex);
 
 
 extern int decode_DIS_JobId (struct tcp_chan *chan, char *jobid);
@@ -332,6 +354,8 @@ extern int encode_DIS_MoveJob (struct tcp_chan *chan, char *jid, char *dest);
 extern int encode_DIS_MessageJob (struct tcp_chan *chan, char *jid, int fopt, char *m);
 extern int encode_DIS_QueueJob (struct tcp_chan *chan, char *jid, char *dest, struct attropl *);
 int encode_DIS_QueueJob_hash(struct tcp_chan *chan, char *jid, char *destin, job_data_container *job_attr, job_data_container *res_attr);
+extern int encode_DIS_SubmitJob (struct tcp_chan *chan, char *dest, struct attropl *, char *script, int script_len);
+int encode_DIS_SubmitJob_hash(struct tcp_chan *chan, char *destin, job_data_container *job_attr, job_data_container *res_attr, char *script, int script_len);
 extern int encode_DIS_ReqExtend (struct tcp_chan *chan, char *extend);
 extern int encode_DIS_PowerState (struct tcp_chan *chan, unsigned short power_state);
 extern int encode_DIS_ReqHdr (struct tcp_chan *chan, int reqt, char *user);
@@ -157,6 +157,7 @@ extern char             PRE_EXEC[1024];
 extern int              src_login_batch;
 extern int              src_login_interactive;
 extern long             TJobStartBlockTime; /* seconds to wait for job to launch before backgrounding */
+extern int              max_concurrent_launches; /* job starters in flight at once */
 extern char             config_file[_POSIX_PATH_MAX];
 extern int              config_file_specified;
 extern struct config   *config_array;
@@ -171,6 +172,10 @@ extern int              max_join_job_wait_time;
 extern int              resend_join_job_wait_time;
 extern int              mom_hierarchy_retry_time;
 extern int              MOMJobDirStickySet;
+extern int              MOMConfigCgroupAccounting; /* 0: off, 1: on */
+extern int              MOMConfigStatusDelta; /* 0: off, 1: on */
+extern int              MOMCopyStreams; /* local files copied at once, 0: fork cp */
+extern int              MOMCopyVerify; /* 0: off, 1: on */
 
 struct specials
   {
@@ -184,6 +189,7 @@ extern struct config    common_config[];
 unsigned long setstatusupdatetime(const char *value);
 unsigned long setcheckpolltime(const char *value);
 unsigned long jobstartblocktime(const char *value);
+unsigned long setmaxconcurrentlaunches(const char *value);
 unsigned long setloglevel(const char *value);
 unsigned long setdownonerror(const char *value);
 unsigned long setenablemomrestart(const char *value);
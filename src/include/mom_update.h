@@ -77,8 +77,39 @@
 * without reference to its choice of law rules.
 */
 
+#ifndef _MOM_UPDATE_H
+#define _MOM_UPDATE_H
+
 #include <string>
 #include <vector>
 
+struct pbsnode;
+
+#define MOM_UPDATE_SHARDS 16 /* queues of status updates waiting to be applied */
+
+/* a status update read from a mom, queued until an apply task gets to it */
+typedef struct mom_update
+  {
+  struct mom_update        *next;          /* the update queued before this one */
+  std::string               node_name;     /* the mom that sent it */
+  std::vector<std::string>  status;
+  bool                      full;          /* not relative to an earlier update */
+  bool                      coalescable;   /* may be replaced by a newer full update */
+  bool                      first_update;  /* the mom just started */
+  } mom_update;
+
+typedef struct mom_update_shard
+  {
+  mom_update * volatile     head;          /* newest first */
+  volatile int              scheduled;     /* an apply task owns the shard */
+  } mom_update_shard;
+
 
 int process_status_info(const char *nd_name, std::vector<std::string> &status_info);
+int refresh_node_status(struct pbsnode *np);
+mom_update *new_mom_update(const char *node_name, std::vector<std::string> &status);
+int coalesce_mom_updates(std::vector<mom_update *> &batch);
+void *apply_mom_updates(void *vp);
+int queue_mom_update(const char *node_name, std::vector<std::string> &status);
+
+#endif /* _MOM_UPDATE_H */
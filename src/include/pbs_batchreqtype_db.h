@@ -83,5 +83,6 @@ PbsBatchReqType(PBS_BATCH_DeleteReservation,    "DeleteAlpsReservation")
 PbsBatchReqType(PBS_BATCH_SelStatAttr,          "SelStatAttr")
 PbsBatchReqType(PBS_BATCH_ChangePowerState,     "ChangePowerState")
 PbsBatchReqType(PBS_BATCH_ModifyNode,           "ModifyNode")
+PbsBatchReqType(PBS_BATCH_SubmitJob,            "SubmitJob")
 #endif
 #endif /* _PBS_BATCHREQTYPE_DB_H */
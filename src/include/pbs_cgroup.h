@@ -0,0 +1,29 @@
+#ifndef PBS_CGROUP_H
+#define PBS_CGROUP_H 1
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "pbs_job.h"
+
+#define TCGROUP_ROOT_PATH   "/sys/fs/cgroup"
+#define TCGROUP_TORQUE_NAME "torque"
+
+/* usage of one job as read from its cgroup */
+typedef struct cgroup_usage
+  {
+  unsigned long      cput;      /* cpu seconds used by every process ever in the cgroup */
+  unsigned long long mem;       /* resident bytes, high water mark if the kernel keeps one */
+  unsigned long long vmem;      /* resident plus swapped bytes */
+  bool               populated; /* the cgroup still holds at least one process */
+  } cgroup_usage;
+
+extern int  init_torque_cgroup(const char *);
+extern bool cgroup_accounting_enabled(void);
+extern int  create_job_cgroup(const char *);
+extern int  move_to_job_cgroup(pid_t, const char *);
+extern int  delete_job_cgroup(const char *);
+extern int  read_job_cgroup_usage(const char *, cgroup_usage *);
+extern void cleanup_torque_cgroup(void);
+
+#endif /* END PBS_CGROUP_H */
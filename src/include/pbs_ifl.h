@@ -363,6 +363,19 @@
 #define ATTR_exitcodecanceledjob       "exit_code_canceled_job"
 #define ATTR_timeoutforjobdelete       "timeout_for_job_delete"
 #define ATTR_timeoutforjobrequeue      "timeout_for_job_requeue"
+#define ATTR_threadpoolstats           "threadpool_stats"
+#define ATTR_jobstatuscache            "job_status_cache"
+#define ATTR_obitstats                 "obit_stats"
+#define ATTR_userusage                 "user_usage"
+#define ATTR_capabilities              "capabilities"
+
+/* listed in the server's capabilities when it takes Submit Job requests */
+#define SUBMIT_JOB_CAPABILITY "submit_job"
+
+/* returned by a DELTASTATUS job status */
+#define ATTR_delta_seq      "delta_seq"
+#define ATTR_delta_full     "delta_full"
+#define ATTR_delta_purged   "delta_purged"
 
 /* notification email formating */
 #define ATTR_mailsubjectfmt "mail_subject_fmt"
@@ -386,6 +399,7 @@
 #define DELASYNC     "delasync"   /* see req_delete.c */
 #define PURGECOMP    "purgecomplete="   /* see req_delete.c */
 #define EXECQUEONLY  "exec_queue_only"   /* see req_stat.c */
+#define DELTASTATUS  "delta="   /* see job_delta.c */
 #define RERUNFORCE   "force"
 
 #define USER_HOLD   "u"
@@ -599,6 +613,21 @@ struct batch_status
   };
 
 
+/* one job of a pbs_submit_bulk() call */
+
+struct pbs_bulk_job
+  {
+  struct attropl *attrib;      /* I job attributes, or NULL to send the hashes */
+  void           *job_attr;    /* I job attribute hash (see pbs_submit_hash_ext) */
+  void           *res_attr;    /* I resource hash */
+  char           *script;      /* I path of the job script (optional) */
+  char           *destination; /* I queue[@server] (optional) */
+  char           *jobid;       /* O new job id (malloc'd), NULL if not submitted */
+  int             errcode;     /* O PBSE_NONE or why the job was not submitted */
+  char           *errmsg;      /* O server's message for errcode (malloc'd) */
+  };
+
+
 
 
 /* Resource Reservation Information */
@@ -675,6 +704,8 @@ char *pbs_submit(int connect, struct attropl *attrib, char *script, char *destin
 
 int pbs_submit_hash_ext(int connect, void *job_attr, void *res_attr, char *script, char *destination, char *extend, char **job_id, char **msg);
 
+int pbs_submit_bulk(int connect, struct pbs_bulk_job *jobs, int job_count, char *extend);
+
 int pbs_terminate(int connect, int manner, char *extend);
 
 int totpool(int connect, int update);
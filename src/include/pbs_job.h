@@ -122,6 +122,7 @@
 
 #ifndef PBS_MOM
 struct job_array;
+struct brp_encoded;
 #endif
 
 #define JOB_REPORTED_POLL_TIMEOUT 300
@@ -471,10 +472,6 @@ typedef std::set<pid_t> job_pid_set_t;
 #endif /* MOM */
 
 
-#define COUNTED_GLOBALLY 0x0001
-#define COUNTED_IN_QUEUE 0x0010
-
-
 typedef struct
   {
   char      jobid[PBS_MAXSVRJOBID+1];
@@ -656,6 +653,11 @@ struct job
   int            ji_mempressure_curr;  /* current memory_pressure value */
   int            ji_mempressure_cnt;   /* counts MOM cycles memory_pressure is over threshold */
 #endif
+  bool               ji_cgroup_sampled;   /* last sample came from the job's cgroup, see mom_get_sample() */
+  bool               ji_cgroup_populated; /* the job's cgroup still held processes */
+  unsigned long      ji_cgroup_cput;      /* cpu seconds from the job's cgroup */
+  unsigned long long ji_cgroup_mem;       /* resident bytes from the job's cgroup */
+  unsigned long long ji_cgroup_vmem;      /* resident plus swap bytes from the job's cgroup */
   int            ji_examined;
   time_t         ji_kill_started;      /* time since we've begun killing the job - MS only */
   time_t         ji_joins_sent;        /* time we sent out the join requests - MS only */
@@ -684,12 +686,25 @@ struct job
   int               ji_internal_id;
   pthread_mutex_t  *ji_mutex;
   char              ji_being_recycled;
+  unsigned long long ji_retired_epoch;  /* job epoch when recycled, see job_container.c */
   time_t            ji_last_reported_time;
   time_t            ji_mod_time;       // the timestamp of when the state last changed
-  // This is used as a bitmap to ensure that a job is only counted once as a queued job for 
-  // the queue count and the server count
-  unsigned          ji_queue_counted;
   bool              ji_being_deleted;
+
+  /* job journal bookkeeping, see job_journal.c */
+  unsigned long long ji_journal_seq;     /* last journal sequence covered by the job file */
+  int               ji_journal_gen;      /* oldest journal generation holding records newer than the job file, 0 if none */
+  int               ji_journal_records;  /* journal records written since the job file */
+  unsigned int     *ji_saved_hash;       /* hash of each attribute as last written, NULL until the job file exists */
+
+  unsigned long long ji_delta_seq;       /* change sequence of the last change, see job_delta.c */
+  struct job_index_entry *ji_index_entry; /* what job_select_index.c has the job indexed under */
+
+  /* cached encoded status, see status_job() */
+  struct brp_encoded *ji_status_cache;
+  unsigned long long  ji_status_cache_seq;      /* ji_delta_seq the cache was built at */
+  unsigned long       ji_status_cache_key;      /* which status request it answers */
+  bool                ji_status_cache_walltime; /* walltime remaining is added fresh */
 #endif/* PBS_MOM */   /* END SERVER ONLY */
   int               ji_commit_done;   /* req_commit has completed. If in routing queue job can now be routed */
 
@@ -734,6 +749,7 @@ typedef container::item_container<job *>::item_iterator all_jobs_iterator;
 #define MINIMUM_RECYCLE_TIME       300
 #define TOO_MANY_JOBS_IN_RECYCLER -1
 #define JOBS_TO_REMOVE             1000
+#define JOB_SHARDS                 64   /* hash shards of the job registry */
 
 
 
@@ -749,8 +765,20 @@ int  swap_jobs(all_jobs *,job *,job *);
 struct pbs_queue *get_jobs_queue(job **);
 
 job *next_job(all_jobs *,all_jobs_iterator *);
+void get_job_ids(all_jobs *, std::vector<std::string> &ids);
 extern all_jobs alljobs;
 
+/* alljobs' jobs by id, for lookups which don't need alljobs' order */
+void job_registry_add(job *);
+void job_registry_remove(job *);
+bool job_registry_has(const char *job_id);
+job *find_job_in_registry(const char *job_id, int get_subjob);
+
+void               job_epoch_enter();
+void               job_epoch_exit();
+unsigned long long job_epoch_retire();
+bool               job_epoch_passed(unsigned long long retired);
+
 typedef struct job_recycler
   {
   unsigned int     rc_next_id;
@@ -970,9 +998,10 @@ typedef struct send_job_request
 /*
  * Related defines
  */
-#define SAVEJOB_QUICK 0
-#define SAVEJOB_FULL  1
-#define SAVEJOB_NEW   2
+#define SAVEJOB_QUICK    0
+#define SAVEJOB_FULL     1
+#define SAVEJOB_NEW      2
+#define SAVEJOB_SNAPSHOT 3  /* always rewrite the job file, never journal */
 
 #define MAIL_NONE  (int)'n'
 #define MAIL_ABORT (int)'a'
@@ -995,6 +1024,8 @@ typedef struct send_job_request
 #define JOB_TASKDIR_SUFFIX      ".TK"    /* job task directory */
 #define JOB_BAD_SUFFIX          ".BD"    /* save bad job file */
 #define JOB_FILE_TMP_SUFFIX     ".TA"    /* job array template file suffix */
+#define JOB_JOURNAL_FILE        "jobs.JNL"     /* server job journal */
+#define JOB_JOURNAL_OLD_FILE    "jobs.JNL.old" /* journal being compacted */
 /*
  * Job states are defined by POSIX as:
  */
@@ -86,6 +86,7 @@
 #include <pthread.h>
 #include <netinet/in.h> /* sockaddr_in */
 #include <set>
+#include <map>
 
 #include "execution_slot_tracker.hpp"
 #include "net_connect.h" /* pbs_net_t */
@@ -265,6 +266,7 @@ typedef struct nodeboard_t
 
 
 #define SEND_HELLO 11
+#define STATUS_SEQ_MISMATCH 12 /* a status delta didn't apply to the node's last update */
 
 /* container for holding communication information */
 class received_node
@@ -347,6 +349,10 @@ struct pbsnode
   char                          nd_ttl[32];
   struct array_strings         *nd_acl;
   std::string                  *nd_requestid;
+  unsigned long                 nd_status_seq;       /* sequence number of the mom's last status update, 0 if unversioned */
+  std::map<std::string, std::string> *nd_raw_status; /* status strings as sent by the mom by key, for applying deltas */
+  bool                          nd_status_stale;     /* nd_status must be rebuilt from nd_raw_status before it is read */
+  unsigned char                 nd_request_full_status; /* a queued delta did not apply, ask the mom for everything */
   unsigned char               nd_tmp_unlock_count;    /*Nodes will get temporarily unlocked so that
                                                        further processing can happen, but the function
                                                        doing the unlock intends to lock it again
@@ -97,4 +97,9 @@ ATTR_count,
 ATTR_status,
 ATTR_total,
 ATTR_netcounter,
+ATTR_threadpoolstats,
+ATTR_jobstatuscache,
+ATTR_obitstats,
+ATTR_userusage,
+ATTR_capabilities,
 ATTR_pbsversion,
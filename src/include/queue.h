@@ -209,7 +209,6 @@ typedef struct pbs_queue
 
   pbs_attribute qu_attr[QA_ATR_LAST];
 
-  user_info_holder *qu_uih;
   pthread_t        route_retry_thread_id;
   int              qu_reserved_jobs; /* When moving a job from one queue to another this 
                                       * allows us to set a count against max_queuable
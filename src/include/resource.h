@@ -144,7 +144,10 @@ extern int         svr_resc_size;
 
 extern resource     *add_resource_entry(pbs_attribute *, resource_def *);
 extern resource_def *find_resc_def(resource_def *, const char *, int);
+extern int           index_resc_defs(resource_def *, int, resource_def *);
 extern resource     *find_resc_entry(pbs_attribute *, resource_def *);
+extern void          unlink_resc_entry(pbs_attribute *, resource *);
+extern void          move_resc_list(pbs_attribute *, pbs_attribute *);
 
 /* END resource.h */
 #endif
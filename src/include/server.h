@@ -217,6 +217,11 @@ enum srv_atr
   SRV_ATR_ExitCodeCanceledJob,
   SRV_ATR_TimeoutForJobDelete,
   SRV_ATR_TimeoutForJobRequeue,
+  SRV_ATR_ThreadpoolStats,
+  SRV_ATR_JobStatusCache,
+  SRV_ATR_ObitStats,
+  SRV_ATR_UserUsage,
+  SRV_ATR_Capabilities,
 
   /* This must be last */
   SRV_ATR_LAST
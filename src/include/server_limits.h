@@ -136,6 +136,7 @@
 #define PBS_ACCT            "accounting"
 #define PBS_ARRAYDIR        "arrays"
 #define PBS_JOBDIR          "jobs"
+#define PBS_MAILDIR         "mail"
 #define PBS_SPOOLDIR        "spool"
 #define PBS_CHKPTDIR        "checkpoint"
 #define PBS_QUEDIR          "queues"
@@ -42,7 +42,9 @@ int set_svr_attr(int, void *);
 #ifdef PBS_JOB_H
 extern int   set_nodes(job *, char *, int, char **, char **, char *, char *);
 extern void  free_nodes(job *);
+extern void  queue_free_nodes(job *);
 #endif /* PBS_JOB_H */
+extern int   free_queued_nodes();
 
 #ifdef ATTRIBUTE_H
 extern int   check_que_enable(pbs_attribute *, void *, int);
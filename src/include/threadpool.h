@@ -87,28 +87,63 @@
 
 
 #include <pthread.h>
+#include <time.h> /* timespec */
 
 
 #define POOL_DESTROY 0x1
 
+#define TP_DEQUE_SIZE  256 /* work a worker can hold on its own deque, power of 2 */
+#define TP_SPIN_COUNT  64  /* looks for work an idle worker makes before sleeping */
+#define TP_SHARED_BATCH 4  /* extra work taken from the shared queue at once */
+#define TP_CACHE_MAX   32  /* free work items a thread keeps for itself */
+#define TP_FREE_MAX    1024 /* free work items a pool keeps */
+
 
 
 typedef struct tp_work tp_work_t;
 struct tp_work
   {
-  tp_work_t *next;
-  void      *(*work_func)(void *); /* function to call */
-  void      *work_arg; /* argument */
+  tp_work_t       *next;
+  void            *(*work_func)(void *); /* function to call */
+  void            *work_arg; /* argument */
+  struct timespec  queued_at; /* when the work was enqueued */
+  };
+
+
+
+
+/*
+ * Each worker owns a deque.  Work enqueued by a worker of the same pool is
+ * pushed and popped at the bottom by that worker alone; idle workers steal
+ * from the top.  Only the steal and the pop of the last item use a
+ * compare and swap, nothing takes a lock.
+ */
+
+typedef struct tp_deque tp_deque_t;
+struct tp_deque
+  {
+  volatile long  dq_top;
+  volatile long  dq_bottom;
+  int            dq_in_use;  /* slot belongs to a live worker (tp_mutex) */
+  volatile int   dq_working; /* the worker is running work */
+  pthread_t      dq_thread;  /* id of the owning worker */
+  tp_work_t     *dq_items[TP_DEQUE_SIZE];
   };
 
 
 
 
-typedef struct tp_working tp_working_t;
-struct tp_working
+typedef struct tp_stats tp_stats_t;
+struct tp_stats
   {
-  tp_working_t *next;
-  pthread_t     working_id; /* id of thread currently working */
+  int   threads;      /* worker threads */
+  int   idle;         /* workers looking for work */
+  long  queued;       /* work waiting to start */
+  long  max_queued;   /* most work waiting since the last call */
+  long  enqueued;     /* work ever enqueued */
+  long  stolen;       /* work taken from another worker's deque */
+  long  avg_wait_us;  /* mean time from enqueue to start */
+  long  max_wait_us;  /* longest time from enqueue to start since the last call */
   };
 
 
@@ -120,17 +155,31 @@ struct threadpool
   pthread_mutex_t  tp_mutex;
   pthread_cond_t   tp_waiting_work; /* what waiting threads pend on */
   pthread_cond_t   tp_can_destroy; /* thread pool is ready to be deleted */
-  tp_working_t    *tp_active;  /* list of currently working threads */
-  tp_work_t       *tp_first; /* first in queue */
-  tp_work_t       *tp_last;  /* last in queue */
+  tp_work_t       *tp_first; /* first in the shared queue */
+  tp_work_t       *tp_last;  /* last in the shared queue */
+  volatile long    tp_shared_count; /* work in the shared queue */
+  tp_deque_t      *tp_deques; /* one per possible worker */
+  volatile int     tp_deque_hwm; /* deques that have ever been used */
+  tp_work_t       *tp_free_work; /* pooled work items */
+  int              tp_free_count;
   pthread_attr_t   tp_attr; /* attributes for workers */
   int              tp_nthreads; /* number of threads */
   int              tp_min_threads; /* minimum number of threads */
   int              tp_max_threads; /* maximum number of threads */
-  int              tp_idle_threads; /* number of currently idle threads */
+  volatile int     tp_idle_threads; /* number of currently idle threads */
+  int              tp_sleeping; /* idle threads waiting on tp_waiting_work */
   int              tp_max_idle_secs; /* number of seconds before a thread terminates */
-  int              tp_flags; /* pool state flags */
-  unsigned char    tp_started; /* once this is TRUE begin processing */
+  volatile int     tp_flags; /* pool state flags */
+  volatile unsigned char tp_started; /* once this is TRUE begin processing */
+
+  /* statistics, updated without tp_mutex */
+  volatile long    tp_queued; /* work waiting in the shared queue and the deques */
+  volatile long    tp_max_queued;
+  volatile long    tp_enqueued;
+  volatile long    tp_dequeued;
+  volatile long    tp_stolen;
+  volatile long    tp_wait_usecs; /* total time work waited to start */
+  volatile long    tp_max_wait_usecs;
   };
 
 
@@ -145,6 +194,7 @@ int  initialize_threadpool(threadpool_t **,int,int,int);
 void destroy_request_pool(threadpool_t *tp);
 void start_request_pool(threadpool_t *tp);
 bool threadpool_is_too_busy(threadpool_t *tp, int permissions);
+void get_threadpool_stats(threadpool_t *tp, tp_stats_t *stats);
 
 
 #endif /* ndef THREADPOOL_H */ 
@@ -82,30 +82,24 @@
 
 #include <pthread.h>
 #include <string>
-#include "container.hpp"
 #include "pbs_job.h"
 
-#define INITIAL_USER_INFO_COUNT 50
-
-typedef struct user_info
+/* what one user's jobs add up to in one queue, or on the whole server */
+typedef struct user_usage
   {
-  char *user_name;
-  int   num_jobs_queued;
-  } user_info;
-
-
-
-typedef container::item_container<user_info *>                    user_info_holder;
-typedef container::item_container<user_info *>::item_iterator     user_info_holder_iterator;
+  int  queued;   /* jobs not yet complete, running ones included */
+  int  running;
+  long procs;    /* processors requested by the running jobs */
+  } user_usage;
 
-extern user_info_holder users;
 
 
 int          can_queue_new_job(char *user_name, job *pjob);
-int          increment_queued_jobs(user_info_holder *uih, char *user_name, job *pjob);
-int          decrement_queued_jobs(user_info_holder *uih, char *user_name, job *pjob);
-unsigned int get_num_queued(user_info_holder *uih, const char *user_name);
-void         free_user_info_holder(user_info_holder *uih);
 void         remove_server_suffix(std::string &user_name);
+void         add_user_usage(job *pjob);
+void         update_user_usage(job *pjob);
+void         remove_user_usage(job *pjob);
+void         get_user_usage(const char *user_name, const char *queue_name, user_usage &uu);
+void         format_user_usage(std::string &out);
 
 #endif /* ifndef USER_INFO_H */
@@ -0,0 +1,349 @@
+#include "license_pbs.h" /* See here for the software license */
+/*
+ * attr_def_index.c - name indexes for attribute and resource definition arrays
+ *
+ * find_attr() and find_resc_def() are called for every attribute of every
+ * request, status line and recovered job.  Instead of comparing the name
+ * against each definition in turn they look it up in a hash table built
+ * over the definition array.
+ *
+ * Indexes are built when a definition array is set up - the static
+ * attribute arrays at start up and svr_resc_def whenever init_resc_defs()
+ * (re)builds it - and are never changed afterwards, so lookups need no
+ * locking.  Arrays without an index are still searched linearly.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pbs_error.h"
+#include "attribute.h"
+#include "resource.h"
+#include "attr_def_index.h"
+
+#define MAX_DEF_INDEXES 16
+
+typedef struct def_index
+  {
+  const void  *di_defs;     /* the definition array */
+  int          di_count;    /* number of definitions indexed */
+  int          di_nocase;   /* names compare without case */
+  unsigned int di_mask;     /* number of buckets - 1 */
+  int         *di_buckets;  /* definition index + 1, 0 if empty */
+  } def_index;
+
+static def_index *volatile def_indexes[MAX_DEF_INDEXES];
+static pthread_mutex_t     def_index_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*
+ * hash_def_name - FNV-1a hash of a definition name
+ */
+
+static unsigned int hash_def_name(
+
+  const char *name,
+  int         nocase)
+
+  {
+  unsigned int hash = 2166136261U;
+
+  for (; *name != '\0'; name++)
+    {
+    hash ^= (unsigned char)(nocase ? tolower((int)*name) : *name);
+    hash *= 16777619U;
+    }
+
+  return(hash);
+  } /* END hash_def_name() */
+
+
+
+static int def_name_matches(
+
+  const char *def_name,
+  const char *name,
+  int         nocase)
+
+  {
+  if (nocase)
+    return(strcasecmp(def_name, name) == 0);
+
+  return(strcmp(def_name, name) == 0);
+  } /* END def_name_matches() */
+
+
+
+/*
+ * lookup_def_index - find name in an index
+ *
+ * @param names - the array of definition names the index was built over
+ * @return the definition's position in its array, or -1
+ */
+
+static int lookup_def_index(
+
+  def_index   *di,
+  const char  *name,
+  const char **names,
+  size_t       stride)
+
+  {
+  unsigned int bucket = hash_def_name(name, di->di_nocase) & di->di_mask;
+  int          i;
+
+  while ((i = di->di_buckets[bucket]) != 0)
+    {
+    const char *def_name = *(const char **)((const char *)names + (i - 1) * stride);
+
+    if (def_name_matches(def_name, name, di->di_nocase))
+      return(i - 1);
+
+    bucket = (bucket + 1) & di->di_mask;
+    }
+
+  return(-1);
+  } /* END lookup_def_index() */
+
+
+
+/*
+ * build_def_index - hash the names of count definitions.  Only the first
+ * of several definitions with the same name is indexed, like a linear
+ * search would find.
+ */
+
+static def_index *build_def_index(
+
+  const void  *defs,
+  const char **names,
+  size_t       stride,
+  int          count,
+  int          nocase)
+
+  {
+  def_index    *di;
+  unsigned int  size = 16;
+
+  while (size < (unsigned int)count * 2)
+    size *= 2;
+
+  if ((di = (def_index *)calloc(1, sizeof(def_index))) == NULL)
+    return(NULL);
+
+  if ((di->di_buckets = (int *)calloc(size, sizeof(int))) == NULL)
+    {
+    free(di);
+    return(NULL);
+    }
+
+  di->di_defs = defs;
+  di->di_count = count;
+  di->di_nocase = nocase;
+  di->di_mask = size - 1;
+
+  for (int i = 0; i < count; i++)
+    {
+    const char   *name = *(const char **)((const char *)names + i * stride);
+    unsigned int  bucket;
+
+    if ((name == NULL) ||
+        (lookup_def_index(di, name, names, stride) >= 0))
+      continue;
+
+    bucket = hash_def_name(name, nocase) & di->di_mask;
+
+    while (di->di_buckets[bucket] != 0)
+      bucket = (bucket + 1) & di->di_mask;
+
+    di->di_buckets[bucket] = i + 1;
+    }
+
+  return(di);
+  } /* END build_def_index() */
+
+
+
+/*
+ * register_def_index - make an index visible to lookups.  It replaces the
+ * index of replaces (or of the same array) if there is one.  Replaced
+ * indexes are not freed because lookups may still be using them.
+ */
+
+static int register_def_index(
+
+  def_index  *di,
+  const void *replaces)
+
+  {
+  int rc = -1;
+
+  pthread_mutex_lock(&def_index_mutex);
+
+  for (int i = 0; i < MAX_DEF_INDEXES; i++)
+    {
+    if ((def_indexes[i] == NULL) ||
+        (def_indexes[i]->di_defs == di->di_defs) ||
+        ((replaces != NULL) &&
+         (def_indexes[i]->di_defs == replaces)))
+      {
+      /* the index must be complete before it can be seen */
+      __sync_synchronize();
+      def_indexes[i] = di;
+      rc = PBSE_NONE;
+      break;
+      }
+    }
+
+  pthread_mutex_unlock(&def_index_mutex);
+
+  return(rc);
+  } /* END register_def_index() */
+
+
+
+static def_index *get_def_index(
+
+  const void *defs)
+
+  {
+  def_index *di;
+
+  for (int i = 0; i < MAX_DEF_INDEXES; i++)
+    {
+    if ((di = def_indexes[i]) == NULL)
+      break;
+
+    if (di->di_defs == defs)
+      return(di);
+    }
+
+  return(NULL);
+  } /* END get_def_index() */
+
+
+
+/*
+ * index_attr_defs - index the first count definitions of an attribute
+ * definition array for find_attr()
+ *
+ * @return PBSE_NONE, or -1 if the array will be searched linearly
+ */
+
+int index_attr_defs(
+
+  attribute_def *defs,  /* I */
+  int            count) /* I */
+
+  {
+  def_index *di;
+
+  if ((defs == NULL) ||
+      (count <= 0))
+    return(-1);
+
+  if ((di = build_def_index(defs, &defs->at_name, sizeof(attribute_def), count, TRUE)) == NULL)
+    return(-1);
+
+  if (register_def_index(di, NULL) != PBSE_NONE)
+    {
+    free(di->di_buckets);
+    free(di);
+    return(-1);
+    }
+
+  return(PBSE_NONE);
+  } /* END index_attr_defs() */
+
+
+
+/*
+ * index_resc_defs - index a resource definition array for find_resc_def()
+ *
+ * @param replaces - an array defs takes the place of, whose index is dropped
+ * @return PBSE_NONE, or -1 if the array will be searched linearly
+ */
+
+int index_resc_defs(
+
+  resource_def *defs,     /* I */
+  int           count,    /* I */
+  resource_def *replaces) /* I (optional) */
+
+  {
+  def_index *di;
+
+  if ((defs == NULL) ||
+      (count <= 0))
+    return(-1);
+
+  if ((di = build_def_index(defs, &defs->rs_name, sizeof(resource_def), count, FALSE)) == NULL)
+    return(-1);
+
+  if (register_def_index(di, replaces) != PBSE_NONE)
+    {
+    free(di->di_buckets);
+    free(di);
+    return(-1);
+    }
+
+  return(PBSE_NONE);
+  } /* END index_resc_defs() */
+
+
+
+/*
+ * find_indexed_attr - look name up in the index of an attribute definition
+ * array
+ *
+ * @param indexed - set to the number of definitions the index covers,
+ *                  0 if the array has no index
+ * @return the definition's position, or -1
+ */
+
+int find_indexed_attr(
+
+  attribute_def *defs,    /* I */
+  const char    *name,    /* I */
+  int           *indexed) /* O */
+
+  {
+  def_index *di = get_def_index(defs);
+
+  if (di == NULL)
+    {
+    *indexed = 0;
+    return(-1);
+    }
+
+  *indexed = di->di_count;
+
+  return(lookup_def_index(di, name, &defs->at_name, sizeof(attribute_def)));
+  } /* END find_indexed_attr() */
+
+
+
+int find_indexed_resc(
+
+  resource_def *defs,    /* I */
+  const char   *name,    /* I */
+  int          *indexed) /* O */
+
+  {
+  def_index *di = get_def_index(defs);
+
+  if (di == NULL)
+    {
+    *indexed = 0;
+    return(-1);
+    }
+
+  *indexed = di->di_count;
+
+  return(lookup_def_index(di, name, &defs->rs_name, sizeof(resource_def)));
+  } /* END find_indexed_resc() */
@@ -0,0 +1,16 @@
+#ifndef _ATTR_DEF_INDEX_H
+#define _ATTR_DEF_INDEX_H
+#include "license_pbs.h" /* See here for the software license */
+
+#include "attribute.h" /* attribute_def */
+#include "resource.h" /* resource_def */
+
+int index_attr_defs(attribute_def *defs, int count);
+
+int index_resc_defs(resource_def *defs, int count, resource_def *replaces);
+
+int find_indexed_attr(attribute_def *defs, const char *name, int *indexed);
+
+int find_indexed_resc(resource_def *defs, const char *name, int *indexed);
+
+#endif /* _ATTR_DEF_INDEX_H */
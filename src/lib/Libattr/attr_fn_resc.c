@@ -90,6 +90,7 @@
 #include "attribute.h"
 #include "resource.h"
 #include "pbs_error.h"
+#include "attr_def_index.h"
 
 /*
  * This file contains functions for manipulating attributes of type
@@ -123,6 +124,196 @@ int comp_resc_eq; /* count of resources compared = */
 int comp_resc_lt; /* count of resources compared < */
 int comp_resc_nc; /* count of resources not compared */
 
+/*
+ * Resource lists stay sorted linked lists, but once a list with at least
+ * RESC_INDEX_MIN entries is searched, find_resc_entry() also builds an index
+ * of its entries by their position in svr_resc_def and keeps it in
+ * at_rindex, so later searches don't have to walk the list.  Only the
+ * functions in this file modify the list and they keep the index current or
+ * drop it.
+ *
+ * An index belongs to the list head it was built for.  A struct copy of the
+ * pbs_attribute carries the pointer along but never uses or frees it.
+ */
+
+#define RESC_INDEX_MIN 4
+
+typedef struct resource_index
+  {
+  tlist_head   *ri_head;     /* list the index was built for */
+  resource_def *ri_defs;     /* svr_resc_def the ids refer to */
+  int           ri_size;     /* number of slots */
+  resource     *ri_slots[1]; /* entries by position in svr_resc_def */
+  } resource_index;
+
+
+
+/*
+ * resc_def_id - the position of a resource's definition in svr_resc_def
+ *
+ * @return the position or -1 if svr_resc_def has no resource of that name
+ */
+
+static int resc_def_id(
+
+  resource_def *rscdf)
+
+  {
+  resource_def *prdef;
+
+  if ((svr_resc_def == NULL) ||
+      (rscdf == NULL))
+    return(-1);
+
+  if ((rscdf >= svr_resc_def) &&
+      (rscdf < svr_resc_def + svr_resc_size))
+    return(rscdf - svr_resc_def);
+
+  /* a definition from an older svr_resc_def */
+  if ((prdef = find_resc_def(svr_resc_def, rscdf->rs_name, svr_resc_size)) == NULL)
+    return(-1);
+
+  return(prdef - svr_resc_def);
+  } /* END resc_def_id() */
+
+
+
+/*
+ * clear_resc_index - free the index of a resource list, or forget the one
+ * a copy of the pbs_attribute came with
+ */
+
+static void clear_resc_index(
+
+  pbs_attribute *pattr)
+
+  {
+  if ((pattr->at_rindex != NULL) &&
+      (pattr->at_rindex->ri_head == &pattr->at_val.at_list))
+    free(pattr->at_rindex);
+
+  pattr->at_rindex = NULL;
+  } /* END clear_resc_index() */
+
+
+
+/*
+ * get_resc_index - the index of a resource list if it can be used
+ */
+
+resource_index *get_resc_index(
+
+  pbs_attribute *pattr)
+
+  {
+  resource_index *ri = pattr->at_rindex;
+
+  if ((ri == NULL) ||
+      (ri->ri_head != &pattr->at_val.at_list))
+    return(NULL);
+
+  if (ri->ri_defs != svr_resc_def)
+    {
+    /* svr_resc_def was replaced, the ids may have moved */
+    clear_resc_index(pattr);
+    return(NULL);
+    }
+
+  return(ri);
+  } /* END get_resc_index() */
+
+
+
+/*
+ * resc_index_set - record an entry in an index, making room for it
+ *
+ * @return PBSE_NONE or PBSE_SYSTEM if memory is short
+ */
+
+static int resc_index_set(
+
+  pbs_attribute *pattr,
+  int            id,
+  resource      *pr)
+
+  {
+  resource_index *ri = pattr->at_rindex;
+
+  if (id >= ri->ri_size)
+    {
+    int size = (id + 1 > svr_resc_size) ? id + 1 : svr_resc_size;
+
+    ri = (resource_index *)realloc(ri, sizeof(resource_index) + (size - 1) * sizeof(resource *));
+
+    if (ri == NULL)
+      return(PBSE_SYSTEM);
+
+    memset(ri->ri_slots + ri->ri_size, 0, (size - ri->ri_size) * sizeof(resource *));
+    ri->ri_size = size;
+    pattr->at_rindex = ri;
+    }
+
+  ri->ri_slots[id] = pr;
+
+  return(PBSE_NONE);
+  } /* END resc_index_set() */
+
+
+
+/*
+ * build_resc_index - index a resource list that is long enough to be worth
+ * it.  The list is left without an index if memory is short.
+ *
+ * @return the index or NULL
+ */
+
+static resource_index *build_resc_index(
+
+  pbs_attribute *pattr)
+
+  {
+  resource_index *ri;
+  resource       *pr;
+  int             count = 0;
+  int             id;
+
+  for (pr = (resource *)GET_NEXT(pattr->at_val.at_list);
+       (pr != NULL) && (count < RESC_INDEX_MIN);
+       pr = (resource *)GET_NEXT(pr->rs_link))
+    count++;
+
+  if ((count < RESC_INDEX_MIN) ||
+      (svr_resc_size <= 0))
+    return(NULL);
+
+  clear_resc_index(pattr);
+
+  ri = (resource_index *)calloc(1, sizeof(resource_index) + (svr_resc_size - 1) * sizeof(resource *));
+
+  if (ri == NULL)
+    return(NULL);
+
+  ri->ri_head = &pattr->at_val.at_list;
+  ri->ri_defs = svr_resc_def;
+  ri->ri_size = svr_resc_size;
+  pattr->at_rindex = ri;
+
+  for (pr = (resource *)GET_NEXT(pattr->at_val.at_list);
+       pr != NULL;
+       pr = (resource *)GET_NEXT(pr->rs_link))
+    {
+    /* resources svr_resc_def no longer has can't be looked up by id */
+    if (((id = resc_def_id(pr->rs_defin)) >= 0) &&
+        (resc_index_set(pattr, id, pr) != PBSE_NONE))
+      {
+      clear_resc_index(pattr);
+      return(NULL);
+      }
+    }
+
+  return(pattr->at_rindex);
+  } /* END build_resc_index() */
+
 
 
 /*
@@ -159,7 +350,10 @@ int decode_resc(
     }
 
   if (!(patr->at_flags & ATR_VFLAG_SET))
+    {
     CLEAR_HEAD(patr->at_val.at_list);
+    clear_resc_index(patr);
+    }
 
   prdef = find_resc_def(svr_resc_def, rescn, svr_resc_size);
 
@@ -327,6 +521,10 @@ int set_resc(
 
   assert(old && new_attr);
 
+  /* an index old came with as a copy of another pbs_attribute is not its own */
+  if (get_resc_index(old) == NULL)
+    clear_resc_index(old);
+
   newresc = (resource *)GET_NEXT(new_attr->at_val.at_list);
 
   while (newresc != NULL)
@@ -697,6 +895,8 @@ void free_resc(
     pr = next;
     }
 
+  clear_resc_index(pattr);
+
   CLEAR_HEAD(pattr->at_val.at_list);
 
   pattr->at_flags &= ~ATR_VFLAG_SET;
@@ -722,6 +922,19 @@ resource_def *find_resc_def(
   int           limit) /* number of members in resource_def array */
 
   {
+  int index;
+  int indexed;
+
+  /* svr_resc_def is indexed, only definitions past the index are scanned */
+  index = find_indexed_resc(rscdf, name, &indexed);
+
+  if ((index >= 0) ||
+      (indexed >= limit))
+    return(((index >= 0) && (index < limit)) ? rscdf + index : NULL);
+
+  rscdf += indexed;
+  limit -= indexed;
+
   while (limit--)
     {
     if (!strcmp(rscdf->rs_name, name))
@@ -754,11 +967,18 @@ resource *find_resc_entry(
   resource_def *rscdf)  /* I */
 
   {
-  resource *pr;
+  resource       *pr;
+  resource_index *ri;
+  int             id;
 
   if (pattr == NULL)
     return(NULL);
 
+  if (((id = resc_def_id(rscdf)) >= 0) &&
+      (((ri = get_resc_index(pattr)) != NULL) ||
+       ((ri = build_resc_index(pattr)) != NULL)))
+    return((id < ri->ri_size) ? ri->ri_slots[id] : NULL);
+
   pr = (resource *)GET_NEXT(pattr->at_val.at_list);
 
   while (pr != NULL)
@@ -793,8 +1013,16 @@ resource *add_resource_entry(
 
   {
   int    i;
+  int    id = resc_def_id(prdef);
   resource *new_resource;
   resource *pr;
+  resource_index *ri = get_resc_index(pattr);
+
+  if ((ri != NULL) &&
+      (id >= 0) &&
+      (id < ri->ri_size) &&
+      (ri->ri_slots[id] != NULL))
+    return(ri->ri_slots[id]);
 
   pr = (resource *)GET_NEXT(pattr->at_val.at_list);
 
@@ -833,6 +1061,12 @@ resource *add_resource_entry(
     append_link(&pattr->at_val.at_list, &new_resource->rs_link, new_resource);
     }
 
+  /* the index is built again by the next find_resc_entry() if this fails */
+  if ((ri != NULL) &&
+      (id >= 0) &&
+      (resc_index_set(pattr, id, new_resource) != PBSE_NONE))
+    clear_resc_index(pattr);
+
   pattr->at_flags |= ATR_VFLAG_SET | ATR_VFLAG_MODIFY;
 
   return(new_resource);
@@ -840,6 +1074,61 @@ resource *add_resource_entry(
 
 
 
+
+/*
+ * unlink_resc_entry - take a resource entry out of its list.  The entry
+ * itself is not freed.
+ */
+
+void unlink_resc_entry(
+
+  pbs_attribute *pattr,  /* I/O */
+  resource      *pr)     /* I */
+
+  {
+  resource_index *ri = get_resc_index(pattr);
+  int             id = resc_def_id(pr->rs_defin);
+
+  delete_link(&pr->rs_link);
+
+  if ((ri != NULL) &&
+      (id >= 0) &&
+      (id < ri->ri_size) &&
+      (ri->ri_slots[id] == pr))
+    ri->ri_slots[id] = NULL;
+  } /* END unlink_resc_entry() */
+
+
+
+
+/*
+ * move_resc_list - move the resources of one pbs_attribute to another,
+ * whose list must be empty, along with their index
+ */
+
+void move_resc_list(
+
+  pbs_attribute *from,  /* I/O */
+  pbs_attribute *to)    /* O */
+
+  {
+  resource_index *ri = get_resc_index(from);
+
+  list_move(&from->at_val.at_list, &to->at_val.at_list);
+
+  clear_resc_index(to);
+
+  if (ri != NULL)
+    {
+    ri->ri_head = &to->at_val.at_list;
+    to->at_rindex = ri;
+    }
+
+  from->at_rindex = NULL;
+  } /* END move_resc_list() */
+
+
+
 /*
  * action_resc - the at_action for the resource_list pbs_attribute
  * For each resource in the list, if it has its own action routine,
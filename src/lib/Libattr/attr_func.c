@@ -87,6 +87,7 @@
 #include "list_link.h"
 #include "attribute.h"
 #include "pbs_error.h"
+#include "attr_def_index.h"
 
 /*
  * This file contains general functions for manipulating attributes.
@@ -184,10 +185,18 @@ int find_attr(
 
   {
   int index;
+  int indexed;
 
   if (attr_def != NULL)
     {
-    for (index = 0;index < limit;index++)
+    /* most arrays are indexed, only definitions past the index are scanned */
+    index = find_indexed_attr(attr_def, name, &indexed);
+
+    if ((index >= 0) ||
+        (indexed >= limit))
+      return((index < limit) ? index : -1);
+
+    for (index = indexed, attr_def += indexed;index < limit;index++)
       {
       if (!str_nc_cmp(attr_def->at_name, name))
         {
@@ -98,26 +98,32 @@
 
 
 
-struct batch_reply *PBSD_rdrpy(
+/*
+ * PBSD_rdrpy_chan - read a reply through a channel owned by the caller
+ *
+ * Used when several replies are outstanding on one connection: a reply
+ * read ahead into chan's buffer is kept for the next call, where a
+ * channel set up per reply would drop it.
+ */
 
-  int *local_errno, /* O */
-  int  c)           /* I */
+struct batch_reply *PBSD_rdrpy_chan(
+
+  int             *local_errno, /* O */
+  int              c,           /* I */
+  struct tcp_chan *chan)        /* I */
 
   {
   int      rc;
 
   struct batch_reply *reply;
-  int      sock;
   const char    *the_msg = NULL;
-  struct tcp_chan *chan = NULL;
-  
+
   if ((c < 0) || 
       (c >= PBS_NET_MAX_CONNECTIONS))
     {
     return(NULL);
     }
 
-  sock = connection[c].ch_socket;
   /* clear any prior error message */
 
   if (connection[c].ch_errtxt != NULL)
@@ -136,13 +142,7 @@ struct batch_reply *PBSD_rdrpy(
     return(NULL);
     }
 
-  if ((chan = DIS_tcp_setup(sock)) == NULL)
-    {
-    *local_errno = PBSE_MEM_MALLOC;
-    free(reply);
-    return(NULL);
-    }
-  else if ((rc = decode_DIS_replyCmd(chan, reply)))
+  if ((rc = decode_DIS_replyCmd(chan, reply)))
     {
     PBSD_FreeReply(reply);
 
@@ -166,13 +166,9 @@ struct batch_reply *PBSD_rdrpy(
         }
       }
 
-    DIS_tcp_cleanup(chan);
-
     return(NULL);
     }
 
-  DIS_tcp_cleanup(chan);
-
   connection[c].ch_errno = reply->brp_code;
 
   *local_errno = reply->brp_code;
@@ -185,6 +181,37 @@ struct batch_reply *PBSD_rdrpy(
       }
     }
 
+  return(reply);
+  }  /* END PBSD_rdrpy_chan() */
+
+
+
+
+struct batch_reply *PBSD_rdrpy(
+
+  int *local_errno, /* O */
+  int  c)           /* I */
+
+  {
+  struct batch_reply *reply;
+  struct tcp_chan    *chan = NULL;
+
+  if ((c < 0) || 
+      (c >= PBS_NET_MAX_CONNECTIONS))
+    {
+    return(NULL);
+    }
+
+  if ((chan = DIS_tcp_setup(connection[c].ch_socket)) == NULL)
+    {
+    *local_errno = PBSE_MEM_MALLOC;
+    return(NULL);
+    }
+
+  reply = PBSD_rdrpy_chan(local_errno, c, chan);
+
+  DIS_tcp_cleanup(chan);
+
   return(reply);
   }  /* END PBSD_rdrpy() */
 
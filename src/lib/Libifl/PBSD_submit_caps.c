@@ -78,6 +78,7 @@
 */
 #include <pbs_config.h>   /* the master config generated by configure */
 
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -90,6 +91,9 @@
 #include "../lib/Libifl/lib_ifl.h"
 #include "server_limits.h"
 
+/* Submit Job requests PBSD_submit_bulk() writes ahead of their replies */
+#define PBSD_BULK_WINDOW 32
+
 /* PBSD_submit.c
 
         PBSD_rdytocmt()
@@ -701,4 +705,458 @@ int PBSD_QueueJob_hash(
   return rc;
   }  /* END PBSD_queuejob() */
 
+
+
+
+/*
+ * PBSD_read_script - read a job script into memory so it can be sent
+ * with a Submit Job request.  No script leaves *buf NULL.
+ *
+ * @return PBSE_NONE, PBSE_BADSCRIPT or PBSE_MEM_MALLOC
+ */
+
+int PBSD_read_script(
+
+  char  *script_file, /* I (optional) */
+  char **buf,         /* O (alloc) */
+  int   *len)         /* O */
+
+  {
+  int   fd;
+  int   cc;
+  int   size = SCRIPT_CHUNK_Z;
+  char *tmp;
+
+  *buf = NULL;
+  *len = 0;
+
+  if ((script_file == NULL) ||
+      (*script_file == '\0'))
+    return(PBSE_NONE);
+
+  if ((fd = open(script_file, O_RDONLY, 0)) < 0)
+    return(PBSE_BADSCRIPT);
+
+  if ((*buf = (char *)malloc(size)) == NULL)
+    {
+    close(fd);
+    return(PBSE_MEM_MALLOC);
+    }
+
+  while ((cc = read_ac_socket(fd, *buf + *len, size - *len)) > 0)
+    {
+    *len += cc;
+
+    if (*len == size)
+      {
+      if ((tmp = (char *)realloc(*buf, size * 2)) == NULL)
+        {
+        cc = -1;
+        break;
+        }
+
+      *buf = tmp;
+      size *= 2;
+      }
+    }
+
+  close(fd);
+
+  if (cc < 0)
+    {
+    free(*buf);
+    *buf = NULL;
+    *len = 0;
+
+    return(PBSE_BADSCRIPT);
+    }
+
+  return(PBSE_NONE);
+  }  /* END PBSD_read_script() */
+
+
+
+
+/*
+ * PBSD_submitjob - send a whole job submission, attributes and script,
+ * as a single Submit Job request.  The server queues and commits the job
+ * before it replies.
+ *
+ * @return the new job's id (alloc) or NULL with *local_errno set
+ */
+
+char *PBSD_submitjob(
+
+  int             connect,     /* I */
+  int            *local_errno, /* O */
+  char           *destin,
+  struct attropl *attrib,
+  char           *script,      /* I (optional) script contents */
+  int             script_len,
+  char           *extend)
+
+  {
+  struct batch_reply *reply;
+  char               *return_jobid = NULL;
+  int                 rc;
+  int                 sock;
+  struct tcp_chan    *chan = NULL;
+  
+  if ((connect < 0) || 
+      (connect >= PBS_NET_MAX_CONNECTIONS))
+    {
+    return(NULL);
+    }
+
+  pthread_mutex_lock(connection[connect].ch_mutex);
+  sock = connection[connect].ch_socket;
+  connection[connect].ch_errno = 0;
+  pthread_mutex_unlock(connection[connect].ch_mutex);
+
+  if ((chan = DIS_tcp_setup(sock)) == NULL)
+    {
+    *local_errno = PBSE_MEM_MALLOC;
+    return(NULL);
+    }
+  else if ((rc = encode_DIS_ReqHdr(chan, PBS_BATCH_SubmitJob, pbs_current_user)) ||
+           (rc = encode_DIS_SubmitJob(chan, destin, attrib, script, script_len)) ||
+           (rc = encode_DIS_ReqExtend(chan, extend)))
+    {
+    pthread_mutex_lock(connection[connect].ch_mutex);
+    connection[connect].ch_errtxt = strdup(dis_emsg[rc]);
+    pthread_mutex_unlock(connection[connect].ch_mutex);
+
+    *local_errno = PBSE_PROTOCOL;
+    DIS_tcp_cleanup(chan);
+    return(NULL);
+    }
+
+  if (DIS_tcp_wflush(chan))
+    {
+    *local_errno = PBSE_PROTOCOL;
+    DIS_tcp_cleanup(chan);
+    return(NULL);
+    }
+
+  DIS_tcp_cleanup(chan);
+
+  reply = PBSD_rdrpy(local_errno, connect);
+
+  pthread_mutex_lock(connection[connect].ch_mutex);
+  if (reply == NULL)
+    {
+    }
+  else if (reply->brp_choice &&
+           reply->brp_choice != BATCH_REPLY_CHOICE_Text &&
+           reply->brp_choice != BATCH_REPLY_CHOICE_Commit)
+    {
+    *local_errno = PBSE_PROTOCOL;
+    }
+  else if (connection[connect].ch_errno == 0)
+    {
+    return_jobid = strdup(reply->brp_un.brp_jid);
+    }
+  pthread_mutex_unlock(connection[connect].ch_mutex);
+
+  PBSD_FreeReply(reply);
+
+  return(return_jobid);
+  }  /* END PBSD_submitjob() */
+
+
+
+
+int PBSD_SubmitJob_hash(
+
+  int                 connect,     /* I */
+  char               *destin,
+  job_data_container *job_attr,
+  job_data_container *res_attr,
+  char               *script,      /* I (optional) script contents */
+  int                 script_len,
+  char               *extend,
+  char              **job_id,
+  char              **msg)
+
+  {
+  struct batch_reply *reply;
+  int                 rc = PBSE_NONE;
+  int                 sock;
+  struct tcp_chan *chan = NULL;
+  
+  if ((connect < 0) || 
+      (connect >= PBS_NET_MAX_CONNECTIONS))
+    {
+    return(PBSE_IVALREQ);
+    }
+
+  pthread_mutex_lock(connection[connect].ch_mutex);
+  sock = connection[connect].ch_socket;
+  pthread_mutex_unlock(connection[connect].ch_mutex);
+
+  if ((chan = DIS_tcp_setup(sock)) == NULL)
+    {
+    return(PBSE_PROTOCOL);
+    }
+  else if ((rc = encode_DIS_ReqHdr(chan, PBS_BATCH_SubmitJob, pbs_current_user)) ||
+           (rc = encode_DIS_SubmitJob_hash(chan, destin, job_attr, res_attr, script, script_len)) ||
+           (rc = encode_DIS_ReqExtend(chan, extend)))
+    {
+    pthread_mutex_lock(connection[connect].ch_mutex);
+    if (connection[connect].ch_errtxt == NULL)
+      {
+      if ((rc >= 0) &&
+          (rc <= DIS_INVALID))
+        connection[connect].ch_errtxt = strdup(dis_emsg[rc]);
+      }
+
+    if (connection[connect].ch_errtxt != NULL)  
+      *msg = strdup(connection[connect].ch_errtxt);
+
+    pthread_mutex_unlock(connection[connect].ch_mutex);
+
+    DIS_tcp_cleanup(chan);
+
+    return(rc);
+    }
+
+  if ((rc = DIS_tcp_wflush(chan)))
+    {
+    pthread_mutex_lock(connection[connect].ch_mutex);
+    if (connection[connect].ch_errtxt != NULL)
+      {
+      *msg = strdup(connection[connect].ch_errtxt);
+      }
+    pthread_mutex_unlock(connection[connect].ch_mutex);
+
+    DIS_tcp_cleanup(chan);
+
+    return(rc);
+    }
+    
+  DIS_tcp_cleanup(chan);
+
+  reply = PBSD_rdrpy(&rc, connect);
+
+  pthread_mutex_lock(connection[connect].ch_mutex);
+  if (reply == NULL)
+    {
+    if (rc == PBSE_TIMEOUT)
+      rc = PBSE_EXPIRED;
+    }
+  else if (reply->brp_choice &&
+           reply->brp_choice != BATCH_REPLY_CHOICE_Text &&
+           reply->brp_choice != BATCH_REPLY_CHOICE_Commit)
+    {
+    rc = PBSE_PROTOCOL;
+    }
+  else if (reply->brp_choice == BATCH_REPLY_CHOICE_Text)
+    {
+    *msg = strdup(reply->brp_un.brp_txt.brp_str);
+    }
+  else if (connection[connect].ch_errno == 0)
+    {
+    *job_id = strdup(reply->brp_un.brp_jid);
+    }
+    
+  pthread_mutex_unlock(connection[connect].ch_mutex);
+
+  PBSD_FreeReply(reply);
+
+  return rc;
+  }  /* END PBSD_SubmitJob_hash() */
+
+
+
+
+/*
+ * PBSD_submit_bulk - submit jobs[0 .. job_count - 1] as a stream of Submit
+ * Job requests on one connection.
+ *
+ * Up to PBSD_BULK_WINDOW requests are written ahead of their replies, so
+ * the server moves from one job to the next without waiting on a round
+ * trip.  The window bounds what either side has to buffer; the server
+ * answers in request order.  Every job gets its jobid or errcode/errmsg
+ * filled in.
+ *
+ * @return PBSE_NONE, or the error that broke the connection.  Jobs not
+ * answered before that carry the same error.
+ */
+
+int PBSD_submit_bulk(
+
+  int                  connect,   /* I */
+  struct pbs_bulk_job *jobs,      /* I/O */
+  int                  job_count, /* I */
+  char                *extend)    /* I (optional) */
+
+  {
+  struct batch_reply  *reply;
+  struct pbs_bulk_job *pj;
+  struct tcp_chan     *wchan = NULL;
+  struct tcp_chan     *rchan = NULL;
+  char                *script_buf;
+  int                  script_len;
+  int                  window[PBSD_BULK_WINDOW];
+  int                  head = 0;
+  int                  pending = 0;
+  int                  next = 0;
+  int                  unflushed = FALSE;
+  int                  sock;
+  int                  rc = PBSE_NONE;
+
+  if ((connect < 0) || 
+      (connect >= PBS_NET_MAX_CONNECTIONS))
+    {
+    return(PBSE_IVALREQ);
+    }
+
+  for (next = 0; next < job_count; next++)
+    {
+    jobs[next].jobid = NULL;
+    jobs[next].errcode = PBSE_NONE;
+    jobs[next].errmsg = NULL;
+    }
+
+  pthread_mutex_lock(connection[connect].ch_mutex);
+  sock = connection[connect].ch_socket;
+  connection[connect].ch_errno = 0;
+  pthread_mutex_unlock(connection[connect].ch_mutex);
+
+  /* replies are read through one channel for the whole batch: a reply read
+   * ahead with the one before it must not be thrown away */
+
+  if (((wchan = DIS_tcp_setup(sock)) == NULL) ||
+      ((rchan = DIS_tcp_setup(sock)) == NULL))
+    rc = PBSE_MEM_MALLOC;
+
+  next = 0;
+
+  while ((rc == PBSE_NONE) &&
+         ((next < job_count) ||
+          (pending > 0)))
+    {
+    if ((next < job_count) &&
+        (pending < PBSD_BULK_WINDOW))
+      {
+      pj = jobs + next++;
+
+      if ((pj->errcode = PBSD_read_script(pj->script, &script_buf, &script_len)) != PBSE_NONE)
+        continue;
+
+      if ((rc = encode_DIS_ReqHdr(wchan, PBS_BATCH_SubmitJob, pbs_current_user)) == DIS_SUCCESS)
+        {
+        if (pj->attrib != NULL)
+          rc = encode_DIS_SubmitJob(wchan, pj->destination, pj->attrib, script_buf, script_len);
+        else
+          rc = encode_DIS_SubmitJob_hash(wchan, pj->destination,
+                 (job_data_container *)pj->job_attr, (job_data_container *)pj->res_attr,
+                 script_buf, script_len);
+        }
+
+      if (rc == DIS_SUCCESS)
+        rc = encode_DIS_ReqExtend(wchan, extend);
+
+      free(script_buf);
+
+      if (rc != DIS_SUCCESS)
+        {
+        pthread_mutex_lock(connection[connect].ch_mutex);
+        if ((rc > 0) &&
+            (rc <= DIS_INVALID) &&
+            (connection[connect].ch_errtxt == NULL))
+          connection[connect].ch_errtxt = strdup(dis_emsg[rc]);
+        pthread_mutex_unlock(connection[connect].ch_mutex);
+
+        /* the request is half written, nothing after it can be sent */
+        pj->errcode = PBSE_PROTOCOL;
+        rc = PBSE_PROTOCOL;
+
+        break;
+        }
+
+      window[(head + pending) % PBSD_BULK_WINDOW] = pj - jobs;
+      pending++;
+      unflushed = TRUE;
+
+      continue;
+      }
+
+    /* the window is full or every job is queued: hand the requests to the
+     * server and wait for the oldest outstanding reply */
+
+    if (unflushed == TRUE)
+      {
+      if (DIS_tcp_wflush(wchan) != 0)
+        {
+        rc = PBSE_PROTOCOL;
+        break;
+        }
+
+      unflushed = FALSE;
+      }
+
+    pj = jobs + window[head];
+    head = (head + 1) % PBSD_BULK_WINDOW;
+    pending--;
+
+    reply = PBSD_rdrpy_chan(&pj->errcode, connect, rchan);
+
+    pthread_mutex_lock(connection[connect].ch_mutex);
+    if (reply == NULL)
+      {
+      if (pj->errcode == PBSE_TIMEOUT)
+        pj->errcode = PBSE_EXPIRED;
+      else if (pj->errcode == PBSE_NONE)
+        pj->errcode = PBSE_PROTOCOL;
+
+      if (connection[connect].ch_errtxt != NULL)
+        pj->errmsg = strdup(connection[connect].ch_errtxt);
+
+      /* the stream is out of step, later replies cannot be trusted */
+      rc = pj->errcode;
+      }
+    else if (reply->brp_choice &&
+             reply->brp_choice != BATCH_REPLY_CHOICE_Text &&
+             reply->brp_choice != BATCH_REPLY_CHOICE_Commit)
+      {
+      pj->errcode = PBSE_PROTOCOL;
+      }
+    else if (reply->brp_choice == BATCH_REPLY_CHOICE_Text)
+      {
+      pj->errmsg = strdup(reply->brp_un.brp_txt.brp_str);
+
+      if (pj->errcode == PBSE_NONE)
+        pj->errcode = PBSE_PROTOCOL;
+      }
+    else if (pj->errcode == PBSE_NONE)
+      {
+      pj->jobid = strdup(reply->brp_un.brp_jid);
+      }
+    pthread_mutex_unlock(connection[connect].ch_mutex);
+
+    PBSD_FreeReply(reply);
+    }
+
+  if (rc != PBSE_NONE)
+    {
+    /* requests still in the window may or may not have been queued */
+    for (; pending > 0; pending--)
+      {
+      pj = jobs + window[head];
+      head = (head + 1) % PBSD_BULK_WINDOW;
+
+      pj->errcode = rc;
+      }
+
+    for (; next < job_count; next++)
+      jobs[next].errcode = rc;
+    }
+
+  DIS_tcp_cleanup(wchan);
+  DIS_tcp_cleanup(rchan);
+
+  return(rc);
+  }  /* END PBSD_submit_bulk() */
+
 /* END PBSD_submit.c */
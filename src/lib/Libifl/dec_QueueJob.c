@@ -88,6 +88,7 @@
 #include <pbs_config.h>   /* the master config generated by configure */
 
 #include <sys/types.h>
+#include <stdlib.h>
 #include "libpbs.h"
 #include "list_link.h"
 #include "server_limits.h"
@@ -105,6 +106,8 @@ int decode_DIS_QueueJob(
   int rc;
 
   CLEAR_HEAD(preq->rq_ind.rq_queuejob.rq_attr);
+  preq->rq_ind.rq_queuejob.rq_script = NULL;
+  preq->rq_ind.rq_queuejob.rq_scriptsz = 0;
 
   rc = disrfst(chan, PBS_MAXSVRJOBID, preq->rq_ind.rq_queuejob.rq_jid);
 
@@ -128,4 +131,45 @@ int decode_DIS_QueueJob(
 
 
 
+/*
+ * decode_DIS_SubmitJob() - decode a Submit Job Batch Request
+ *
+ * Data items are: the Queue Job data items, see decode_DIS_QueueJob()
+ *   cnt str job script (may be empty)
+ */
+
+int decode_DIS_SubmitJob(
+
+  struct tcp_chan *chan,
+  struct batch_request *preq)
+
+  {
+  int    rc;
+  size_t amt = 0;
+  char  *script;
+
+  if ((rc = decode_DIS_QueueJob(chan, preq)) != 0)
+    {
+    return(rc);
+    }
+
+  script = disrcs(chan, &amt, &rc);
+
+  if (rc != 0)
+    {
+    if (script != NULL)
+      free(script);
+
+    return(rc);
+    }
+
+  preq->rq_ind.rq_queuejob.rq_script = script;
+  preq->rq_ind.rq_queuejob.rq_scriptsz = amt;
+
+  return(rc);
+  }  /* END decode_DIS_SubmitJob() */
+
+
+
+
 
@@ -123,4 +123,35 @@ int encode_DIS_QueueJob(
 
 
 
+/*
+ * encode_DIS_SubmitJob() - encode a Submit Job Batch Request
+ *
+ * This request carries a whole job submission, the Queue Job request
+ * followed by the job script, so the server can queue and commit the
+ * job in one exchange.
+ *
+ * Data items are: the Queue Job data items, see encode_DIS_QueueJob()
+ *   cnt str job script
+ */
+
+int encode_DIS_SubmitJob(
+
+  struct tcp_chan *chan,
+  char  *destin,
+  struct attropl *aoplp,
+  char  *script,
+  int    script_len)
+
+  {
+  int   rc;
+
+  if ((rc = encode_DIS_QueueJob(chan, (char *)"", destin, aoplp)) != 0)
+    return(rc);
+
+  return(diswcs(chan, script, (size_t)script_len));
+  }  /* END encode_DIS_SubmitJob() */
+
+
+
+
 
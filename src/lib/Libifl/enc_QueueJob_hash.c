@@ -127,4 +127,32 @@ int encode_DIS_QueueJob_hash(
 
 
 
+/*
+ * encode_DIS_SubmitJob_hash() - encode a Submit Job Batch Request
+ *
+ * Data items are: the Queue Job data items, see encode_DIS_QueueJob_hash()
+ *   cnt str job script
+ */
+
+int encode_DIS_SubmitJob_hash(
+
+  struct tcp_chan *chan,
+  char  *destin,
+  job_data_container *job_attr,
+  job_data_container *res_attr,
+  char  *script,
+  int    script_len)
+
+  {
+  int   rc;
+
+  if ((rc = encode_DIS_QueueJob_hash(chan, (char *)"", destin, job_attr, res_attr)) != 0)
+    return(rc);
+
+  return(diswcs(chan, script, (size_t)script_len));
+  }  /* END encode_DIS_SubmitJob_hash() */
+
+
+
+
 
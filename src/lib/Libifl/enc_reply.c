@@ -201,7 +201,12 @@ int encode_DIS_reply(
 
         psvrl = (svrattrl *)GET_NEXT(pstat->brp_attr);
 
-        if ((rc = encode_DIS_svrattrl(chan, psvrl)))
+        if (pstat->brp_encoded != NULL)
+          rc = encode_DIS_svrattrl_cached(chan, pstat->brp_encoded, psvrl);
+        else
+          rc = encode_DIS_svrattrl(chan, psvrl);
+
+        if (rc)
           return rc;
 
         pstat = (struct brp_status *)GET_NEXT(pstat->brp_stlink);
@@ -101,10 +101,63 @@
 
 #include <pbs_config.h>   /* the master config generated by configure */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "libpbs.h"
 #include "list_link.h"
 #include "attribute.h"
 #include "dis.h"
+#include "tcp.h"
+
+
+/*
+ * encode_DIS_svrattrl_entry() - encode one svrattrl entry, without the count
+ */
+
+int encode_DIS_svrattrl_entry(
+
+  struct tcp_chan *chan,
+  svrattrl        *ps)
+
+  {
+  unsigned int name_len;
+  int          rc;
+
+  /* length of three strings */
+  name_len = (int)strlen(ps->al_atopl.name) +
+             (int)strlen(ps->al_atopl.value) + 2;
+
+  if (ps->al_atopl.resource)
+    name_len += strlen(ps->al_atopl.resource) + 1;
+
+  if ((rc = diswui(chan, name_len)))
+    return(rc);
+
+  if ((rc = diswst(chan, ps->al_atopl.name)))
+    return(rc);
+
+  if (ps->al_atopl.resource)
+    {
+    if ((rc = diswui(chan, 1)))
+      return(rc);
+
+    if ((rc = diswst(chan, ps->al_atopl.resource)))
+      return(rc);
+    }
+  else
+    {
+    if ((rc = diswui(chan, 0))) /* no resource name */
+      return(rc);
+    }
+
+  if ((rc = diswst(chan, ps->al_atopl.value)) ||
+      (rc = diswui(chan, (unsigned int)ps->al_op)))
+    return(rc);
+
+  return(DIS_SUCCESS);
+  } /* END encode_DIS_svrattrl_entry() */
+
 
 
 int encode_DIS_svrattrl(
@@ -114,7 +167,6 @@ int encode_DIS_svrattrl(
 
   {
   unsigned int ct = 0;
-  unsigned int name_len;
   svrattrl *ps;
   int rc;
 
@@ -130,37 +182,89 @@ int encode_DIS_svrattrl(
 
   for (ps = psattl; ps; ps = (svrattrl *)GET_NEXT(ps->al_link))
     {
-    /* length of three strings */
-    name_len = (int)strlen(ps->al_atopl.name) +
-               (int)strlen(ps->al_atopl.value) + 2;
+    if ((rc = encode_DIS_svrattrl_entry(chan, ps)))
+      break;
+    }
 
-    if (ps->al_atopl.resource)
-      name_len += strlen(ps->al_atopl.resource) + 1;
+  return rc;
+  }
 
-    if ((rc = diswui(chan, name_len)))
-      break;
 
-    if ((rc = diswst(chan, ps->al_atopl.name)))
-      break;
 
-    if (ps->al_atopl.resource)
-      {
-      if ((rc = diswui(chan, 1)))
-        break;
-
-      if ((rc = diswst(chan, ps->al_atopl.resource)))
-        break;
-      }
-    else
-      {
-      if ((rc = diswui(chan, 0))) /* no resource name */
-        break;
-      }
-
-    if ((rc = diswst(chan, ps->al_atopl.value)) ||
-        (rc = diswui(chan, (unsigned int)ps->al_op)))
-      break;
+/*
+ * encode_DIS_svrattrl_cached() - encode pre-encoded entries plus a list
+ *
+ * Encodes the same stream as encode_DIS_svrattrl() would for the entries in
+ * penc followed by psattl, except that psattl is sent at penc->be_split.
+ */
+
+int encode_DIS_svrattrl_cached(
+
+  struct tcp_chan    *chan,
+  struct brp_encoded *penc,
+  svrattrl           *psattl)
+
+  {
+  unsigned int ct = penc->be_count;
+  svrattrl    *ps;
+  int          rc;
+
+  for (ps = psattl; ps; ps = (svrattrl *)GET_NEXT(ps->al_link))
+    ++ct;
+
+  if ((rc = diswui(chan, ct)))
+    return(rc);
+
+  if ((penc->be_split > 0) &&
+      (tcp_puts(chan, penc->be_data, penc->be_split) != (int)penc->be_split))
+    return(DIS_PROTO);
+
+  tcp_wcommit(chan, TRUE);
+
+  for (ps = psattl; ps; ps = (svrattrl *)GET_NEXT(ps->al_link))
+    {
+    if ((rc = encode_DIS_svrattrl_entry(chan, ps)))
+      return(rc);
     }
 
-  return rc;
-  }
+  if ((penc->be_len > penc->be_split) &&
+      (tcp_puts(chan, penc->be_data + penc->be_split, penc->be_len - penc->be_split) != (int)(penc->be_len - penc->be_split)))
+    return(DIS_PROTO);
+
+  tcp_wcommit(chan, TRUE);
+
+  return(DIS_SUCCESS);
+  } /* END encode_DIS_svrattrl_cached() */
+
+
+
+/*
+ * brp_encoded_hold() - take a reference to pre-encoded status entries
+ */
+
+struct brp_encoded *brp_encoded_hold(
+
+  struct brp_encoded *penc)
+
+  {
+  if (penc != NULL)
+    __sync_fetch_and_add(&penc->be_refs, 1);
+
+  return(penc);
+  } /* END brp_encoded_hold() */
+
+
+
+/*
+ * brp_encoded_release() - drop a reference, freeing on the last one
+ */
+
+void brp_encoded_release(
+
+  struct brp_encoded *penc)
+
+  {
+  if ((penc != NULL) &&
+      (__sync_sub_and_fetch(&penc->be_refs, 1) == 0))
+    free(penc);
+  } /* END brp_encoded_release() */
@@ -51,6 +51,7 @@ int PBSD_msg_put(int c, char *jobid, int fileopt, char *msg, char *extend);
 
 /* PBSD_rdrpy.c */
 struct batch_reply *PBSD_rdrpy(int *, int c); 
+struct batch_reply *PBSD_rdrpy_chan(int *local_errno, int c, struct tcp_chan *chan);
 void PBSD_FreeReply(struct batch_reply *reply);
 
 /* PBSD_sig2.c */
@@ -83,6 +84,10 @@ int PBSD_jscript(int c, char *script_file, char *jobid);
 int PBSD_jobfile(int c, int req_type, char *path, char *jobid, enum job_file which);
 char *PBSD_queuejob(int connect, int *, char *jobid, char *destin, struct attropl *attrib, char *extend);
 int PBSD_QueueJob_hash(int connect, char *jobid, char *destin, job_data *job_attr, job_data *res_attr, char *extend, char **job_id, char **msg);
+int PBSD_read_script(char *script_file, char **buf, int *len);
+char *PBSD_submitjob(int connect, int *, char *destin, struct attropl *attrib, char *script, int script_len, char *extend);
+int PBSD_SubmitJob_hash(int connect, char *destin, job_data_container *job_attr, job_data_container *res_attr, char *script, int script_len, char *extend, char **job_id, char **msg);
+int PBSD_submit_bulk(int connect, struct pbs_bulk_job *jobs, int job_count, char *extend);
 
 /* PBS_attr.c */
 int PBS_val_al(struct attrl *alp);
@@ -125,6 +130,7 @@ int decode_DIS_MessageJob(struct tcp_chan *chan, struct batch_request *preq);
 
 /* dec_QueueJob.c */
 int decode_DIS_QueueJob(struct tcp_chan *chan, struct batch_request *preq);
+int decode_DIS_SubmitJob(struct tcp_chan *chan, struct batch_request *preq);
 
 /* dec_Reg.c */
 int decode_DIS_Register(struct tcp_chan *chan, struct batch_request *preq);
@@ -200,6 +206,7 @@ int encode_DIS_MessageJob(struct tcp_chan *chan, char *jobid, int fileopt, char
 
 /* enc_QueueJob.c */
 int encode_DIS_QueueJob(struct tcp_chan *chan, char *jobid, char *destin, struct attropl *aoplp);
+int encode_DIS_SubmitJob(struct tcp_chan *chan, char *destin, struct attropl *aoplp, char *script, int script_len);
 
 /* enc_Reg.c */
 int encode_DIS_Register(struct tcp_chan *chan, struct batch_request *preq);
@@ -238,7 +245,11 @@ int encode_DIS_attropl(struct tcp_chan *chan, struct attropl *pattropl);
 int encode_DIS_reply(struct tcp_chan *chan, struct batch_reply *reply);
 
 /* enc_svrattrl.c */
+int encode_DIS_svrattrl_entry(struct tcp_chan *chan, svrattrl *ps);
 int encode_DIS_svrattrl(struct tcp_chan *chan, svrattrl *psattl);
+int encode_DIS_svrattrl_cached(struct tcp_chan *chan, struct brp_encoded *penc, svrattrl *psattl);
+struct brp_encoded *brp_encoded_hold(struct brp_encoded *penc);
+void brp_encoded_release(struct brp_encoded *penc);
 
 /* list_link.c */
 void insert_link(struct list_link *old, struct list_link *new_link, void *pobj, int position); 
@@ -362,6 +373,7 @@ struct batch_status *pbs_statserver_err(int c, struct attrl *attrib, char *exten
 
 /* pbsD_submit.c */
 char *pbs_submit_err(int c, struct attropl *attrib, char *script, char *destination, char *extend, int *); 
+bool submit_stepwise(int c);
 
 /* pbsD_termin.c */
 int pbs_terminate_err(int c, int manner, char *extend, int *);
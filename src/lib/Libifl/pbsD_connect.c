@@ -998,6 +998,11 @@ int pbs_original_connect(
     goto cleanup_conn_lite;
     }
 
+  /* remember where this connection goes, see submit_stepwise() */
+
+  snprintf(connection[out].ch_server, sizeof(connection[out].ch_server), "%s:%u",
+    server, server_port);
+
   /* determine who we are */
 
   pbs_current_uid = getuid();
@@ -84,9 +84,127 @@
 #include <pbs_config.h>   /* the master config generated by configure */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+#include <map>
+#include <string>
 #include "libpbs.h"
+#include "lib_ifl.h"
+#include "server_limits.h"
+
+
+/* servers (HOSTNAME:PORT) and whether they take Submit Job requests */
+static std::map<std::string, bool> submit_servers;
+static pthread_mutex_t             submit_servers_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*
+ * submit_job_supported - ask connection c's server whether it takes Submit
+ * Job requests.  A server which does lists SUBMIT_JOB_CAPABILITY in its
+ * read-only capabilities attribute; older ones don't know the attribute and
+ * reject the status request.  They can't be sent a Submit Job to find out:
+ * they fail to decode it without replying and then read the rest of it as
+ * further requests.
+ *
+ * @return 1 if it does, 0 if it doesn't, -1 if the server couldn't be asked
+ */
+
+static int submit_job_supported(
+
+  int c)
+
+  {
+  struct attrl         caps;
+  struct attrl        *pat;
+  struct batch_status *bs;
+  int                  local_errno = 0;
+  int                  supported = 0;
+
+  memset(&caps, 0, sizeof(caps));
+  caps.name = (char *)ATTR_capabilities;
+
+  if ((bs = pbs_statserver_err(c, &caps, NULL, &local_errno)) == NULL)
+    {
+    if (local_errno == PBSE_NOATTR)
+      return(0);
+
+    return(-1);
+    }
+
+  for (pat = bs->attribs; pat != NULL; pat = pat->next)
+    {
+    if ((pat->name != NULL) &&
+        (pat->value != NULL) &&
+        (!strcmp(pat->name, ATTR_capabilities)) &&
+        (strstr(pat->value, SUBMIT_JOB_CAPABILITY) != NULL))
+      supported = 1;
+    }
+
+  pbs_statfree(bs);
+
+  return(supported);
+  }  /* END submit_job_supported() */
+
+
+
+
+/*
+ * submit_stepwise - should jobs go to connection c's server through the
+ * separate Queue Job, Job Script and Commit steps?  They do when
+ * PBSSTEPWISESUBMIT is set or the server doesn't take Submit Job requests.
+ * Each server is asked once per process.
+ */
+
+bool submit_stepwise(
+
+  int c)
+
+  {
+  std::string                            server;
+  std::map<std::string, bool>::iterator  it;
+  int                                    supported;
+
+  if (getenv("PBSSTEPWISESUBMIT") != NULL)
+    return(true);
+
+  if ((c < 0) ||
+      (c >= PBS_NET_MAX_CONNECTIONS))
+    return(false);
+
+  pthread_mutex_lock(connection[c].ch_mutex);
+  server = connection[c].ch_server;
+  pthread_mutex_unlock(connection[c].ch_mutex);
+
+  pthread_mutex_lock(&submit_servers_mutex);
+  it = submit_servers.find(server);
+
+  if (it != submit_servers.end())
+    {
+    supported = (it->second == true) ? 1 : 0;
+    pthread_mutex_unlock(&submit_servers_mutex);
+
+    return(supported == 0);
+    }
+
+  pthread_mutex_unlock(&submit_servers_mutex);
+
+  /* if the server can't be asked, the steps fail the same way */
+  if ((supported = submit_job_supported(c)) < 0)
+    return(true);
+
+  pthread_mutex_lock(&submit_servers_mutex);
+  submit_servers[server] = (supported == 1);
+  pthread_mutex_unlock(&submit_servers_mutex);
+
+  return(supported == 0);
+  }  /* END submit_stepwise() */
+
+
+
 
 char *pbs_submit_err(
 
@@ -100,6 +218,8 @@ char *pbs_submit_err(
   {
   struct attropl *pal;
   char * return_jobid = NULL;
+  char  *script_buf;
+  int    script_len;
 
   /* first be sure that the script is readable if specified ... */
 
@@ -118,6 +238,21 @@ char *pbs_submit_err(
   for (pal = attrib;pal != NULL;pal = pal->next)
     pal->op = SET;  /* force operator to SET */
 
+  /* send the whole job in one Submit Job request unless the server needs
+   * the separate steps (see submit_stepwise()) */
+
+  if (submit_stepwise(c) == false)
+    {
+    if ((*local_errno = PBSD_read_script(script, &script_buf, &script_len)) != PBSE_NONE)
+      return(NULL);
+
+    return_jobid = PBSD_submitjob(c, local_errno, destination, attrib, script_buf, script_len, extend);
+
+    free(script_buf);
+
+    return(return_jobid);
+    }
+
   /* Queue job with null string for job id */
 
   return_jobid = PBSD_queuejob(c, local_errno, (char *)"", destination, attrib, extend);
@@ -180,5 +315,93 @@ char *pbs_submit(
 
 
 
+
+/*
+ * pbs_submit_bulk - submit job_count independent jobs over one connection
+ *
+ * The jobs are streamed to the server as pipelined Submit Job requests
+ * (see PBSD_submit_bulk()).  A server which needs the separate Queue Job
+ * steps (see submit_stepwise()) gets them one at a time instead.
+ *
+ * @return the number of jobs submitted; pbs_errno holds the first failure
+ */
+
+int pbs_submit_bulk(
+
+  int                  c,
+  struct pbs_bulk_job *jobs,
+  int                  job_count,
+  char                *extend)    /* (optional) */
+
+  {
+  struct attropl      *pal;
+  struct pbs_bulk_job *pj;
+  int                  submitted = 0;
+  int                  i;
+
+  pbs_errno = 0;
+
+  if ((c < 0) ||
+      (c >= PBS_NET_MAX_CONNECTIONS) ||
+      (jobs == NULL) ||
+      (job_count < 0))
+    {
+    pbs_errno = PBSE_IVALREQ;
+
+    return(0);
+    }
+
+  for (i = 0; i < job_count; i++)
+    {
+    for (pal = jobs[i].attrib;pal != NULL;pal = pal->next)
+      pal->op = SET;  /* force operator to SET */
+    }
+
+  if (submit_stepwise(c) == false)
+    {
+    pbs_errno = PBSD_submit_bulk(c, jobs, job_count, extend);
+    }
+  else
+    {
+    for (i = 0; i < job_count; i++)
+      {
+      pj = jobs + i;
+
+      pj->jobid = NULL;
+      pj->errmsg = NULL;
+
+      if (pj->attrib != NULL)
+        {
+        pj->errcode = PBSE_NONE;
+
+        if ((pj->jobid = pbs_submit_err(c, pj->attrib, pj->script, pj->destination, extend, &pj->errcode)) == NULL)
+          {
+          if (pj->errcode == PBSE_NONE)
+            pj->errcode = connection[c].ch_errno;
+
+          if (connection[c].ch_errtxt != NULL)
+            pj->errmsg = strdup(connection[c].ch_errtxt);
+          }
+        }
+      else
+        {
+        pj->errcode = pbs_submit_hash_ext(c, pj->job_attr, pj->res_attr, pj->script, pj->destination, extend, &pj->jobid, &pj->errmsg);
+        }
+      }
+    }
+
+  for (i = 0; i < job_count; i++)
+    {
+    if (jobs[i].jobid != NULL)
+      submitted++;
+    else if (pbs_errno == PBSE_NONE)
+      pbs_errno = (jobs[i].errcode != PBSE_NONE) ? jobs[i].errcode : PBSE_PROTOCOL;
+    }
+
+  return(submitted);
+  } /* END pbs_submit_bulk() */
+
+
+
 /* END pbsD_submit.c */
 
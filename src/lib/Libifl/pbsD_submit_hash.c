@@ -90,9 +90,11 @@
 #include <pbs_config.h>   /* the master config generated by configure */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include "libpbs.h"
+#include "lib_ifl.h"
 #include "u_hash_map_structs.h"
 #include "server_limits.h"
 
@@ -109,6 +111,8 @@ int pbs_submit_hash(
 
   {
   int rc = PBSE_NONE;
+  char *script_buf;
+  int   script_len;
 /*  struct attropl *pal; */
   /* first be sure that the script is readable if specified ... */
   
@@ -133,6 +137,21 @@ int pbs_submit_hash(
 /*  for (pal = attrib;pal != NULL;pal = pal->next) */
 /*    pal->op = SET;  *//* force operator to SET */
 
+  /* send the whole job in one Submit Job request unless the server needs
+   * the separate steps (see submit_stepwise()) */
+
+  if (submit_stepwise(socket) == false)
+    {
+    if ((rc = PBSD_read_script(script, &script_buf, &script_len)) != PBSE_NONE)
+      return(rc);
+
+    rc = PBSD_SubmitJob_hash(socket, destination, job_attr, res_attr, script_buf, script_len, extend, return_jobid, msg);
+
+    free(script_buf);
+
+    return(rc);
+    }
+
   /* Queue job with null string for job id */
 
   rc = PBSD_QueueJob_hash(socket, (char *)"", destination, job_attr, res_attr, extend, return_jobid, msg);
@@ -85,6 +85,7 @@
  * log_err()
  * log_ext()
  * log_record()
+ * log_start_writer()
  * log_close()
  * log_roll()
  * log_size()
@@ -112,6 +113,7 @@
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 
 #include "log.h"
 #if SYSLOG
@@ -147,6 +149,24 @@ static int      syslogopen = 0;
 
 pthread_mutex_t log_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
+/* per thread rings drained by the log writer, see log_start_writer() */
+static log_ring * volatile log_rings = NULL;
+static pthread_key_t       log_ring_key;
+static pthread_once_t      log_ring_once = PTHREAD_ONCE_INIT;
+static __thread log_ring  *my_log_ring = NULL;
+static __thread char       log_line[LOG_BUF_SIZE + 512];
+static volatile int        log_writer_running = 0;
+static volatile int        log_writer_pending = 0;
+static volatile unsigned long log_dropped = 0;
+static pthread_t           log_writer_thread;
+static pthread_mutex_t     log_writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t      log_writer_cond = PTHREAD_COND_INITIALIZER;
+
+/* timestamp prefix cached per thread, see log_timestamp() */
+static __thread time_t     log_cached_sec = 0;
+static __thread int        log_cached_yday = 0;
+static __thread char       log_cached_time[32];
+
 /* variables for job logging */
 static int      job_log_auto_switch = 0;
 static int      joblog_open_day;
@@ -177,6 +197,7 @@ static const char *class_names[] =
 
 /* local prototypes */
 const char *log_get_severity_string(int);
+static void log_record_locked(int, int, const char *, const char *, pid_t);
 
 
 /*
@@ -700,17 +721,14 @@ const char *log_get_severity_string(
 /* record job information of completed job to job log */
 int log_job_record(const char *buf)
   {
-  struct tm *ptm;
-  struct tm tmpPtm;
-  time_t now;
+  int yday;
 
-  now = time((time_t *)0);
-  ptm = localtime_r(&now,&tmpPtm);
+  log_timestamp(NULL, &yday);
 
   pthread_mutex_lock(&job_log_mutex);
 
   /* do we need to switch the log to the new day? */
-  if (job_log_auto_switch && (ptm->tm_yday != joblog_open_day))
+  if (job_log_auto_switch && (yday != joblog_open_day))
     {
     job_log_close(1);
 
@@ -748,73 +766,591 @@ bool log_available(int eventtype)
 
 
 /*
- * log_record - log a message to the log file
- * The log file must have been opened by log_open().
+ * log_timestamp - the "MM/DD/YYYY HH:MM:SS" prefix for the current time
  *
- * NOTE:  do not use in pbs_mom spawned children - does not write to syslog!!!
+ * The string is cached per thread and only rebuilt when the second changes,
+ * so busy threads do not pay for localtime_r() on every line.
  *
- * The caller should ensure proper formating of the message if "text"
- * is to contain "continuation lines".
+ * @param milliseconds - RETURN: milliseconds into the current second
+ * @param yday - RETURN: day of the year, may be NULL
  */
 
-void log_record(
+const char *log_timestamp(
 
-  int         eventtype,  /* I */
-  int         objclass,   /* I */
-  const char *objname,    /* I */
-  const char *text)       /* I */
+  int *milliseconds,
+  int *yday)
 
   {
-  int tryagain = 2;
-  time_t now;
-  pid_t  thr_id = -1;
+  struct timeval now;
 
-  struct tm *ptm;
-  struct tm  tmpPtm;
-  struct timeval mytime;
-  int    rc = 0;
-  FILE  *savlog;
-  char  *start = NULL, *end = NULL;
-  size_t nchars;
-  int eventclass = 0;
-  char time_formatted_str[64];
+  gettimeofday(&now, NULL);
 
-  thr_id = syscall(SYS_gettid);
-  pthread_mutex_lock(&log_mutex);
+  if (now.tv_sec != log_cached_sec)
+    {
+    struct tm tm;
 
-#if SYSLOG
-  if (eventtype & PBSEVENT_SYSLOG)
+    localtime_r(&now.tv_sec, &tm);
+
+    snprintf(log_cached_time, sizeof(log_cached_time),
+      "%02d/%02d/%04d %02d:%02d:%02d",
+      tm.tm_mon + 1,
+      tm.tm_mday,
+      tm.tm_year + 1900,
+      tm.tm_hour,
+      tm.tm_min,
+      tm.tm_sec);
+
+    log_cached_yday = tm.tm_yday;
+    log_cached_sec = now.tv_sec;
+    }
+
+  if (milliseconds != NULL)
+    *milliseconds = now.tv_usec / 1000;
+
+  if (yday != NULL)
+    *yday = log_cached_yday;
+
+  return(log_cached_time);
+  }  /* END log_timestamp() */
+
+
+
+static void release_log_ring(
+
+  void *vp)
+
+  {
+  log_ring *ring = (log_ring *)vp;
+
+  /* anything still queued is written by the writer; the ring is reused
+   * by the next thread that needs one */
+  __sync_lock_release(&ring->in_use);
+  }  /* END release_log_ring() */
+
+
+
+static void log_ring_key_init()
+
+  {
+  pthread_key_create(&log_ring_key, release_log_ring);
+  }  /* END log_ring_key_init() */
+
+
+
+/*
+ * get_log_ring - get the calling thread's log ring
+ *
+ * Rings are never freed.  A thread takes a ring given up by an exited
+ * thread if there is one, otherwise a new ring is added to the list.
+ *
+ * @return the ring or NULL if there is no memory for one
+ */
+
+static log_ring *get_log_ring()
+
+  {
+  log_ring *ring;
+
+  if (my_log_ring != NULL)
+    return(my_log_ring);
+
+  pthread_once(&log_ring_once, log_ring_key_init);
+
+  for (ring = log_rings; ring != NULL; ring = ring->next)
     {
-    if (syslogopen == 0)
+    if ((ring->in_use == 0) &&
+        (__sync_lock_test_and_set(&ring->in_use, 1) == 0))
+      break;
+    }
+
+  if (ring == NULL)
+    {
+    if ((ring = (log_ring *)calloc(1, sizeof(log_ring))) == NULL)
+      return(NULL);
+
+    ring->in_use = 1;
+
+    do
       {
-      openlog(msg_daemonname, LOG_NOWAIT, LOG_DAEMON);
+      ring->next = log_rings;
+      } while (!__sync_bool_compare_and_swap(&log_rings, ring->next, ring));
+    }
 
-      syslogopen = 1;
+  pthread_setspecific(log_ring_key, ring);
+  my_log_ring = ring;
+
+  return(ring);
+  }  /* END get_log_ring() */
+
+
+
+/*
+ * log_ring_append - add a formatted line to a ring
+ *
+ * Only the thread owning the ring may append to it.
+ *
+ * @return PBSE_NONE, or -1 if the ring is full and the line was dropped
+ */
+
+int log_ring_append(
+
+  log_ring   *ring,
+  const char *line,
+  size_t      len)
+
+  {
+  unsigned long long head = ring->head;
+  size_t             off;
+  size_t             first;
+
+  if (head + len - ring->tail > LOG_RING_SIZE)
+    {
+    __sync_fetch_and_add(&ring->dropped, 1);
+    return(-1);
+    }
+
+  off = head & (LOG_RING_SIZE - 1);
+  first = LOG_RING_SIZE - off;
+
+  if (first > len)
+    first = len;
+
+  memcpy(ring->data + off, line, first);
+  memcpy(ring->data, line + first, len - first);
+
+  /* the bytes must be visible before the writer sees the new head */
+  __sync_synchronize();
+  ring->head = head + len;
+
+  return(PBSE_NONE);
+  }  /* END log_ring_append() */
+
+
+
+/*
+ * log_writev_all - writev() that finishes short writes
+ */
+
+static int log_writev_all(
+
+  int           fd,
+  struct iovec *iov,
+  int           count)
+
+  {
+  ssize_t written;
+
+  while (count > 0)
+    {
+    written = writev(fd, iov, count);
+
+    if (written < 0)
+      {
+      if (errno == EINTR)
+        continue;
+
+      return(-1);
       }
 
-    syslog(LOG_ERR | LOG_DAEMON,"%s",text);
+    while ((count > 0) &&
+           ((size_t)written >= iov->iov_len))
+      {
+      written -= iov->iov_len;
+      iov++;
+      count--;
+      }
+
+    if (count > 0)
+      {
+      iov->iov_base = (char *)iov->iov_base + written;
+      iov->iov_len -= written;
+      }
     }
-#endif /* SYSLOG */
+
+  return(PBSE_NONE);
+  }  /* END log_writev_all() */
+
+
+
+/*
+ * log_write_batch - write one batch of ring data and free its space
+ */
+
+static int log_write_batch(
+
+  struct iovec       *iov,
+  int                 iov_count,
+  log_ring          **rings,
+  unsigned long long *heads,
+  int                 ring_count)
+
+  {
+  int rc = PBSE_NONE;
+  int i;
+
+  if (iov_count == 0)
+    return(rc);
+
+  if (log_writev_all(fileno(logfile), iov, iov_count) != 0)
+    rc = errno;
+
+  /* on failure the lines are lost, the same as fprintf() failing in
+   * log_record_locked(): holding on to them would only stall every thread */
+  __sync_synchronize();
+
+  for (i = 0; i < ring_count; i++)
+    rings[i]->tail = heads[i];
+
+  return(rc);
+  }  /* END log_write_batch() */
+
+
+
+/*
+ * log_drain_rings - write everything queued in the thread rings to the log
+ *
+ * NOTE: log_mutex must be held
+ *
+ * @return the number of lines reported dropped, or -1 if the log is not open
+ */
+
+long log_drain_rings()
+
+  {
+  struct iovec        iov[LOG_WRITER_IOV];
+  log_ring           *rings[LOG_WRITER_IOV];
+  unsigned long long  heads[LOG_WRITER_IOV];
+  int                 iov_count = 0;
+  int                 ring_count = 0;
+  unsigned long       dropped = 0;
+  int                 rc = PBSE_NONE;
+  log_ring           *ring;
 
   if (log_opened < 1)
+    return(-1);
+
+  /* anything written synchronously goes first */
+  fflush(logfile);
+
+  for (ring = log_rings; ring != NULL; ring = ring->next)
+    {
+    unsigned long long head;
+    unsigned long long tail = ring->tail;
+    size_t             len;
+    size_t             off;
+    size_t             first;
+
+    if (ring->dropped != 0)
+      dropped += __sync_lock_test_and_set(&ring->dropped, 0);
+
+    head = ring->head;
+    __sync_synchronize();
+
+    if (head == tail)
+      continue;
+
+    if (iov_count + 2 > LOG_WRITER_IOV)
+      {
+      if (log_write_batch(iov, iov_count, rings, heads, ring_count) != PBSE_NONE)
+        rc = errno;
+
+      iov_count = 0;
+      ring_count = 0;
+      }
+
+    len = head - tail;
+    off = tail & (LOG_RING_SIZE - 1);
+    first = LOG_RING_SIZE - off;
+
+    if (first > len)
+      first = len;
+
+    iov[iov_count].iov_base = ring->data + off;
+    iov[iov_count++].iov_len = first;
+
+    if (len > first)
+      {
+      iov[iov_count].iov_base = ring->data;
+      iov[iov_count++].iov_len = len - first;
+      }
+
+    rings[ring_count] = ring;
+    heads[ring_count++] = head;
+    }
+
+  if (log_write_batch(iov, iov_count, rings, heads, ring_count) != PBSE_NONE)
+    rc = errno;
+
+  if (rc == EPIPE)
+    {
+    /* same as log_record_locked(): the descriptor now points to a socket */
+    log_opened = 0;
+    log_open(NULL, log_directory);
+    }
+
+  if ((dropped > 0) &&
+      (log_opened > 0))
     {
+    char buf[128];
+
+    __sync_fetch_and_add(&log_dropped, dropped);
+
+    snprintf(buf, sizeof(buf), "%lu log lines dropped, logging could not keep up", dropped);
+    log_record_locked(PBSEVENT_ERROR | PBSEVENT_FORCE, PBS_EVENTCLASS_SERVER,
+      msg_daemonname, buf, syscall(SYS_gettid));
+    fflush(logfile);
+    }
+
+  return(dropped);
+  }  /* END log_drain_rings() */
+
+
+
+/*
+ * log_get_dropped - lines dropped since start up because a ring was full
+ */
+
+unsigned long log_get_dropped()
+
+  {
+  return(__sync_add_and_fetch(&log_dropped, 0));
+  }  /* END log_get_dropped() */
+
+
+
+static void *log_writer(
+
+  void *vp)
+
+  {
+  struct timespec wait_until;
+  int             yday;
+
+  while (log_writer_running)
+    {
+    pthread_mutex_lock(&log_writer_mutex);
+
+    if (log_writer_pending == 0)
+      {
+      clock_gettime(CLOCK_REALTIME, &wait_until);
+
+      wait_until.tv_nsec += LOG_WRITER_WAIT_MS * 1000000;
+
+      if (wait_until.tv_nsec >= 1000000000)
+        {
+        wait_until.tv_sec++;
+        wait_until.tv_nsec -= 1000000000;
+        }
+
+      pthread_cond_timedwait(&log_writer_cond, &log_writer_mutex, &wait_until);
+      }
+
+    log_writer_pending = 0;
+
+    pthread_mutex_unlock(&log_writer_mutex);
+
+    pthread_mutex_lock(&log_mutex);
+
+    /* lines queued before midnight may land in the new day's log */
+    log_timestamp(NULL, &yday);
+
+    if ((log_opened > 0) &&
+        (log_auto_switch) &&
+        (yday != log_open_day))
+      {
+      log_close(1);
+      log_open(NULL, log_directory);
+      }
+
+    log_drain_rings();
+
     pthread_mutex_unlock(&log_mutex);
-    return;
     }
 
-  now = time((time_t *)0); /* get time for message */
+  return(NULL);
+  }  /* END log_writer() */
 
-  ptm = localtime_r(&now,&tmpPtm);
-  
-  /* mytime used to calculate milliseconds */
-  
-  gettimeofday(&mytime, NULL);
-  
-  int milliseconds = mytime.tv_usec/1000;
+
+
+static void log_writer_atfork_child()
+
+  {
+  /* the writer thread does not exist in the child */
+  log_writer_running = 0;
+  log_writer_pending = 0;
+  }  /* END log_writer_atfork_child() */
+
+
+
+/*
+ * log_start_writer - queue log_record() lines in per thread rings
+ *
+ * Once started, log_record() formats each line into a ring owned by the
+ * calling thread and returns without taking log_mutex or touching the file.
+ * A writer thread drains every ring with writev() every LOG_WRITER_WAIT_MS
+ * or as soon as a line is queued after it went idle.  A thread whose ring
+ * is full drops the line; the writer logs how many were dropped.
+ *
+ * Call after log_open() in a daemon; processes that fork and keep logging
+ * in the child fall back to writing synchronously there.
+ */
+
+int log_start_writer()
+
+  {
+  static int     atfork_registered = 0;
+  pthread_attr_t attr;
+  int            rc;
+
+  if (log_writer_running)
+    return(PBSE_NONE);
+
+  if (atfork_registered == 0)
+    {
+    pthread_atfork(NULL, NULL, log_writer_atfork_child);
+    atfork_registered = 1;
+    }
+
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  log_writer_running = 1;
+
+  if ((rc = pthread_create(&log_writer_thread, &attr, log_writer, NULL)) != 0)
+    {
+    log_writer_running = 0;
+    pthread_attr_destroy(&attr);
+    log_err(rc, __func__, "cannot start the log writer, logging synchronously");
+    return(PBSE_SYSTEM);
+    }
+
+  pthread_attr_destroy(&attr);
+
+  return(PBSE_NONE);
+  }  /* END log_start_writer() */
+
+
+
+/*
+ * log_queue_record - format a log_record() message into the thread's ring
+ *
+ * @return PBSE_NONE, or -1 if the thread has no ring and the caller has to
+ * write synchronously
+ */
+
+static int log_queue_record(
+
+  int         eventtype,
+  int         objclass,
+  const char *objname,
+  const char *text,
+  pid_t       thr_id)
+
+  {
+  log_ring   *ring;
+  const char *timestamp;
+  const char *start = text;
+  const char *end;
+  size_t      nchars;
+  int         milliseconds;
+  int         len;
+  bool        queued = false;
+
+  if ((ring = get_log_ring()) == NULL)
+    return(-1);
+
+  timestamp = log_timestamp(&milliseconds, NULL);
+
+  /* split on newlines the same way log_record_locked() does */
+  while (1)
+    {
+    for (end = start; *end != '\n' && *end != '\r' && *end != '\0'; end++)
+      ;
+
+    nchars = end - start;
+
+    if (*end == '\r' && *(end + 1) == '\n')
+      end++;
+
+    len = snprintf(log_line, sizeof(log_line),
+            "%s.%03d;%02d;%10.10s.%d;%s;%s;%s%.*s\n",
+            timestamp,
+            milliseconds,
+            (eventtype & ~PBSEVENT_FORCE),
+            msg_daemonname,
+            thr_id,
+            class_names[objclass],
+            objname,
+            (text == start ? "" : "[continued]"),
+            (int)nchars,
+            start);
+
+    if (len >= (int)sizeof(log_line))
+      {
+      len = sizeof(log_line) - 1;
+      log_line[len - 1] = '\n';
+      }
+
+    if ((len > 0) &&
+        (log_ring_append(ring, log_line, len) == PBSE_NONE))
+      queued = true;
+
+    if (*end == '\0')
+      break;
+
+    start = end + 1;
+    }
+
+  /* wake the writer if it went idle since the last line was queued */
+  if ((queued) &&
+      (__sync_bool_compare_and_swap(&log_writer_pending, 0, 1)))
+    {
+    pthread_mutex_lock(&log_writer_mutex);
+    pthread_cond_signal(&log_writer_cond);
+    pthread_mutex_unlock(&log_writer_mutex);
+    }
+
+  return(PBSE_NONE);
+  }  /* END log_queue_record() */
+
+
+
+/*
+ * log_record_locked - write a log_record() message straight to the file
+ *
+ * NOTE: log_mutex must be held
+ */
+
+static void log_record_locked(
+
+  int         eventtype,  /* I */
+  int         objclass,   /* I */
+  const char *objname,    /* I */
+  const char *text,       /* I */
+  pid_t       thr_id)     /* I */
+
+  {
+  int tryagain = 2;
+  int    rc = 0;
+  FILE  *savlog;
+  char  *start = NULL, *end = NULL;
+  size_t nchars;
+  int eventclass = 0;
+  char time_formatted_str[64];
+  const char *timestamp;
+  int    milliseconds;
+  int    yday;
+
+  if (log_opened < 1)
+    {
+    return;
+    }
+
+  timestamp = log_timestamp(&milliseconds, &yday);
 
   /* Do we need to switch the log? */
 
-  if (log_auto_switch && (ptm->tm_yday != log_open_day))
+  if (log_auto_switch && (yday != log_open_day))
     {
     log_close(1);
 
@@ -822,7 +1358,6 @@ void log_record(
 
     if (log_opened < 1)
       {
-      pthread_mutex_unlock(&log_mutex);
       return;
       }
     }
@@ -855,13 +1390,8 @@ void log_record(
       if (eventclass != PBS_EVENTCLASS_TRQAUTHD)
         {
         rc = fprintf(logfile,
-              "%02d/%02d/%04d %02d:%02d:%02d.%03d;%02d;%10.10s.%d;%s;%s;%s%.*s\n",
-              ptm->tm_mon + 1,
-              ptm->tm_mday,
-              ptm->tm_year + 1900,
-              ptm->tm_hour,
-              ptm->tm_min,
-              ptm->tm_sec,
+              "%s.%03d;%02d;%10.10s.%d;%s;%s;%s%.*s\n",
+              timestamp,
 			        milliseconds,
               (eventtype & ~PBSEVENT_FORCE),
               msg_daemonname,
@@ -927,6 +1457,76 @@ void log_record(
 
     logfile = savlog;
     }
+
+  return;
+  }  /* END log_record_locked() */
+
+
+
+
+/*
+ * log_record - log a message to the log file
+ * The log file must have been opened by log_open().
+ *
+ * Once log_start_writer() has been called the message is queued for the
+ * writer thread instead of being written here.
+ *
+ * NOTE:  do not use in pbs_mom spawned children - does not write to syslog!!!
+ *
+ * The caller should ensure proper formating of the message if "text"
+ * is to contain "continuation lines".
+ */
+
+void log_record(
+
+  int         eventtype,  /* I */
+  int         objclass,   /* I */
+  const char *objname,    /* I */
+  const char *text)       /* I */
+
+  {
+  pid_t  thr_id = -1;
+  int eventclass = 0;
+
+  thr_id = syscall(SYS_gettid);
+
+#if SYSLOG
+  if (eventtype & PBSEVENT_SYSLOG)
+    {
+    pthread_mutex_lock(&log_mutex);
+
+    if (syslogopen == 0)
+      {
+      openlog(msg_daemonname, LOG_NOWAIT, LOG_DAEMON);
+
+      syslogopen = 1;
+      }
+
+    syslog(LOG_ERR | LOG_DAEMON,"%s",text);
+
+    pthread_mutex_unlock(&log_mutex);
+    }
+#endif /* SYSLOG */
+
+  if (log_writer_running)
+    {
+    log_get_set_eventclass(&eventclass, GETV);
+
+    /* lines queued while log_roll() has the log closed are written once it
+     * is reopened */
+    if ((eventclass != PBS_EVENTCLASS_TRQAUTHD) &&
+        (log_queue_record(eventtype, objclass, objname, text, thr_id) == PBSE_NONE))
+      return;
+    }
+
+  if (log_opened < 1)
+    {
+    return;
+    }
+
+  pthread_mutex_lock(&log_mutex);
+
+  log_record_locked(eventtype, objclass, objname, text, thr_id);
   
   pthread_mutex_unlock(&log_mutex);
 
@@ -957,18 +1557,28 @@ void log_close(
       else
         snprintf(buf, sizeof(buf), "Log closed");
        
-      pthread_mutex_unlock(&log_mutex);
-      log_record(
+      }
+
+    pthread_mutex_lock(&log_mutex);
+
+    /* whatever the threads have queued belongs in this file */
+    log_drain_rings();
+
+    if (msg)
+      {
+      log_record_locked(
         PBSEVENT_SYSTEM,
         PBS_EVENTCLASS_SERVER,
         "Log",
-        buf);
-      pthread_mutex_lock(&log_mutex);
+        buf,
+        syscall(SYS_gettid));
       }
 
     fclose(logfile);
 
     log_opened = 0;
+
+    pthread_mutex_unlock(&log_mutex);
     }
 
 #if SYSLOG
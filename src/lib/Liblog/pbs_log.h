@@ -2,8 +2,25 @@
 #define _PBS_LOG_H
 #include "license_pbs.h" /* See here for the software license */
 
+#include <stddef.h>
+
 #include "log.h"
 
+#define LOG_RING_SIZE      65536 /* bytes a thread may have queued, power of 2 */
+#define LOG_WRITER_IOV     64    /* iovecs per writev() by the log writer */
+#define LOG_WRITER_WAIT_MS 50    /* longest a queued line waits to be written */
+
+/* lines queued by one thread for the log writer */
+typedef struct log_ring
+  {
+  struct log_ring             *next;     /* all rings, never removed */
+  volatile int                 in_use;   /* owned by a live thread */
+  volatile unsigned long long  head;     /* bytes queued by the owner */
+  volatile unsigned long long  tail;     /* bytes written by the writer */
+  volatile unsigned long       dropped;  /* lines dropped while full */
+  char                         data[LOG_RING_SIZE];
+  } log_ring;
+
 int log_init(const char *suffix, const char *hostname);
 
 int log_open(char *filename, char *directory); 
@@ -20,6 +37,16 @@ void log_record(int eventtype, int objclass, const char *objname, const char *te
 
 void log_close(int msg);
 
+int log_start_writer();
+
+long log_drain_rings();
+
+int log_ring_append(log_ring *ring, const char *line, size_t len);
+
+unsigned long log_get_dropped();
+
+const char *log_timestamp(int *milliseconds, int *yday);
+
 void job_log_close(int msg);
 
 int log_remove_old(char *DirPath, unsigned long ExpireTime); 
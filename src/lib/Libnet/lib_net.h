@@ -83,6 +83,8 @@ int check_trqauthd_unix_domain_port(const char *);
 int ping_trqauthd(const char *);
 int thread_func(int active_sockets, fd_set *select_set);
 int wait_request(time_t waittime, long *SState);
+void idle_wheel_file(int sd, time_t expire);
+void idle_wheel_remove(int sd);
 /* static void accept_conn(void *new_conn); */
 void globalset_add_sock(int sock);
 void globalset_del_sock(int sock);
@@ -105,6 +105,9 @@
 #if defined(FD_SET_IN_SYS_SELECT_H)
 #include <sys/select.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #if defined(NTOHL_NEEDS_ARPA_INET_H) && defined(HAVE_ARPA_INET_H)
 #include <arpa/inet.h>
 #endif
@@ -158,6 +161,36 @@ static u_long   *GlobalSocketAddrSet = NULL;
 static u_long   *GlobalSocketPortSet = NULL;
 pthread_mutex_t *global_sock_read_mutex = NULL;
 
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * epoll instance mirroring GlobalSocketReadSet.  Forked children inherit
+ * (and share) the instance, so only the process which created it may
+ * change its registrations.
+ */
+
+#define PBS_NET_EPOLL_EVENTS  256
+
+static int       epoll_sd = -1;
+static pid_t     epoll_owner = -1;
+#endif /* HAVE_SYS_EPOLL_H */
+
+/*
+ * Idle connection timer wheel.  FromClientDIS connections are filed in the
+ * slot for the second at which they may time out so that wait_request()
+ * only visits connections which are due instead of the whole table.
+ * IDLE_WHEEL_SIZE must be larger than PBS_NET_MAXCONNECTIDLE.
+ */
+
+#define IDLE_WHEEL_SIZE  1024
+
+static int       idle_wheel[IDLE_WHEEL_SIZE];
+static int       idle_next[PBS_NET_MAX_CONNECTIONS];
+static int       idle_prev[PBS_NET_MAX_CONNECTIONS];
+static int       idle_slot[PBS_NET_MAX_CONNECTIONS];
+static int      *idle_due = NULL;
+static time_t    idle_last_sweep = 0;
+pthread_mutex_t *idle_wheel_mutex = NULL;
+
 void *(*read_func[2])(void *);
 
 pthread_mutex_t *nc_list_mutex  = NULL;
@@ -344,6 +377,24 @@ int init_network(
 
     num_connections_mutex = (pthread_mutex_t *)calloc(1, sizeof(pthread_mutex_t));
     pthread_mutex_init(num_connections_mutex,&t_attr);
+
+    for (i = 0; i < IDLE_WHEEL_SIZE; i++)
+      idle_wheel[i] = -1;
+
+    for (i = 0; i < PBS_NET_MAX_CONNECTIONS; i++)
+      idle_slot[i] = -1;
+
+    idle_due = (int *)calloc(PBS_NET_MAX_CONNECTIONS, sizeof(int));
+    idle_last_sweep = time(NULL);
+
+    idle_wheel_mutex = (pthread_mutex_t *)calloc(1, sizeof(pthread_mutex_t));
+    pthread_mutex_init(idle_wheel_mutex, NULL);
+
+#ifdef HAVE_SYS_EPOLL_H
+    /* if this fails wait_request() falls back to select() */
+    epoll_sd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_owner = getpid();
+#endif /* HAVE_SYS_EPOLL_H */
     
     type = Primary;
     }
@@ -645,11 +696,337 @@ int check_network_port(
 
 
 
+/*
+ * idle_wheel_unlink - remove a socket from its timer wheel slot
+ *
+ * NOTE: idle_wheel_mutex must be held
+ */
+
+static void idle_wheel_unlink(
+
+  int sd)
+
+  {
+  int slot = idle_slot[sd];
+
+  if (slot < 0)
+    return;
+
+  if (idle_prev[sd] >= 0)
+    idle_next[idle_prev[sd]] = idle_next[sd];
+  else
+    idle_wheel[slot] = idle_next[sd];
+
+  if (idle_next[sd] >= 0)
+    idle_prev[idle_next[sd]] = idle_prev[sd];
+
+  idle_slot[sd] = -1;
+  }  /* END idle_wheel_unlink() */
+
+
+
+/*
+ * idle_wheel_file - (re)file a socket in the timer wheel slot for the
+ * time at which it should next be checked for idleness
+ */
+
+void idle_wheel_file(
+
+  int    sd,      /* I */
+  time_t expire)  /* I */
+
+  {
+  int slot = (int)(expire % IDLE_WHEEL_SIZE);
+
+  if ((idle_wheel_mutex == NULL) ||
+      (sd < 0) ||
+      (sd >= PBS_NET_MAX_CONNECTIONS))
+    return;
+
+  pthread_mutex_lock(idle_wheel_mutex);
+
+  idle_wheel_unlink(sd);
+
+  idle_prev[sd] = -1;
+  idle_next[sd] = idle_wheel[slot];
+
+  if (idle_wheel[slot] >= 0)
+    idle_prev[idle_wheel[slot]] = sd;
+
+  idle_wheel[slot] = sd;
+  idle_slot[sd] = slot;
+
+  pthread_mutex_unlock(idle_wheel_mutex);
+  }  /* END idle_wheel_file() */
+
+
+
+/*
+ * idle_wheel_remove - stop tracking a socket for idle timeouts
+ */
+
+void idle_wheel_remove(
+
+  int sd)  /* I */
+
+  {
+  if ((idle_wheel_mutex == NULL) ||
+      (sd < 0) ||
+      (sd >= PBS_NET_MAX_CONNECTIONS))
+    return;
+
+  pthread_mutex_lock(idle_wheel_mutex);
+  idle_wheel_unlink(sd);
+  pthread_mutex_unlock(idle_wheel_mutex);
+  }  /* END idle_wheel_remove() */
+
+
+
+/*
+ * idle_wheel_sweep - close FromClientDIS connections which have been idle
+ * for more than PBS_NET_MAXCONNECTIDLE seconds.  Only the wheel slots which
+ * have come due since the last sweep are examined.  Connections which saw
+ * activity since they were filed are re-filed based on their last activity.
+ */
+
+static void idle_wheel_sweep(
+
+  time_t now)  /* I */
+
+  {
+  time_t             t;
+  time_t             first;
+  int                sd;
+  int                num_due;
+  int                i;
+  struct connection *cp;
+  char               tmpLine[1024];
+  char               buf[80];
+
+  if ((idle_wheel_mutex == NULL) ||
+      (now <= idle_last_sweep))
+    return;
+
+  first = idle_last_sweep + 1;
+
+  /* after a long stall every slot is due once */
+  if (now - first >= IDLE_WHEEL_SIZE)
+    first = now - IDLE_WHEEL_SIZE + 1;
+
+  idle_last_sweep = now;
+
+  for (t = first; t <= now; t++)
+    {
+    num_due = 0;
+
+    pthread_mutex_lock(idle_wheel_mutex);
+
+    while ((sd = idle_wheel[t % IDLE_WHEEL_SIZE]) >= 0)
+      {
+      idle_wheel_unlink(sd);
+      idle_due[num_due++] = sd;
+      }
+
+    pthread_mutex_unlock(idle_wheel_mutex);
+
+    for (i = 0; i < num_due; i++)
+      {
+      sd = idle_due[i];
+
+      pthread_mutex_lock(svr_conn[sd].cn_mutex);
+
+      cp = &svr_conn[sd];
+
+      if (cp->cn_active != FromClientDIS)
+        {
+        pthread_mutex_unlock(svr_conn[sd].cn_mutex);
+
+        continue;
+        }
+
+      if (cp->cn_authen & PBS_NET_CONN_NOTIMEOUT)
+        {
+        /* do not time-out this connection, but keep watching it */
+        idle_wheel_file(sd, now + PBS_NET_MAXCONNECTIDLE + 1);
+
+        pthread_mutex_unlock(svr_conn[sd].cn_mutex);
+
+        continue;
+        }
+
+      if ((now - cp->cn_lasttime) <= PBS_NET_MAXCONNECTIDLE)
+        {
+        idle_wheel_file(sd, cp->cn_lasttime + PBS_NET_MAXCONNECTIDLE + 1);
+
+        pthread_mutex_unlock(svr_conn[sd].cn_mutex);
+
+        continue;
+        }
+
+      /* NOTE:  add info about node associated with connection - NYI */
+
+      snprintf(tmpLine, sizeof(tmpLine), "connection %d to host %s has timed out after %d seconds - closing stale connection\n",
+        sd,
+        netaddr_long(cp->cn_addr, buf),
+        PBS_NET_MAXCONNECTIDLE);
+
+      log_err(-1, __func__, tmpLine);
+
+      /* locate node associated with interface, mark node as down until node responds */
+
+      /* NYI */
+
+      close_conn(sd, TRUE);
+
+      pthread_mutex_unlock(svr_conn[sd].cn_mutex);
+      }
+    }
+  }  /* END idle_wheel_sweep() */
+
+
+
+/*
+ * wait_request_dispatch - invoke the read function of a socket with data
+ */
+
+static void wait_request_dispatch(
+
+  int    sd,    /* I */
+  u_long addr,  /* I */
+  u_long port)  /* I */
+
+  {
+  char tmpLine[1024];
+
+  pthread_mutex_lock(svr_conn[sd].cn_mutex);
+
+  svr_conn[sd].cn_lasttime = time(NULL);
+
+  if (svr_conn[sd].cn_active != Idle)
+    {
+    void *(*func)(void *) = svr_conn[sd].cn_func;
+
+    netcounter_incr();
+
+    pthread_mutex_unlock(svr_conn[sd].cn_mutex);
+
+    if (func != NULL)
+      {
+      int args[3];
+
+      args[0] = sd;
+      args[1] = (int)addr;
+      args[2] = (int)port;
+      func((void *)args);
+      }
+    }
+  else
+    {
+    pthread_mutex_unlock(svr_conn[sd].cn_mutex);
+
+    globalset_del_sock(sd);
+    close_conn(sd, FALSE);
+
+    pthread_mutex_lock(num_connections_mutex);
+
+    sprintf(tmpLine, "closed connections to fd %d - num_connections=%d (select bad socket)",
+      sd,
+      num_connections);
+
+    pthread_mutex_unlock(num_connections_mutex);
+    log_err(-1, __func__, tmpLine);
+    }
+  }  /* END wait_request_dispatch() */
+
+
+
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * wait_request_epoll - epoll flavor of wait_request().
+ * The cost of each pass is proportional to the number of sockets with data
+ * rather than the size of the descriptor table.  Registrations are
+ * level-triggered since the read functions consume a single request per
+ * call and may leave further requests buffered on the socket.
+ */
+
+static int wait_request_epoll(
+
+  time_t  waittime,   /* I (seconds) */
+  long   *SState)     /* I (optional) */
+
+  {
+  int                i;
+  int                n;
+  int                sd;
+  u_long             addr;
+  u_long             port;
+  long               OrigState = 0;
+  struct epoll_event events[PBS_NET_EPOLL_EVENTS];
+
+  if (SState != NULL)
+    OrigState = *SState;
+
+  n = epoll_wait(epoll_sd, events, PBS_NET_EPOLL_EVENTS, waittime * 1000);
+
+  if (n == -1)
+    {
+    if (errno != EINTR)
+      {
+      log_err(errno, __func__, "Unable to wait on sockets to read requests");
+
+      return(-1);
+      }
+
+    n = 0; /* interrupted, cycle around */
+    }
+
+  for (i = 0; i < n; i++)
+    {
+    sd = events[i].data.fd;
+
+    if ((sd < 0) ||
+        (sd >= max_connection))
+      continue;
+
+    pthread_mutex_lock(global_sock_read_mutex);
+
+    if (!FD_ISSET(sd, GlobalSocketReadSet))
+      {
+      /* removed by an earlier read function in this pass */
+      pthread_mutex_unlock(global_sock_read_mutex);
+
+      continue;
+      }
+
+    addr = GlobalSocketAddrSet[sd];
+    port = GlobalSocketPortSet[sd];
+
+    pthread_mutex_unlock(global_sock_read_mutex);
+
+    wait_request_dispatch(sd, addr, port);
+
+    /* NOTE:  breakout if state changed (probably received shutdown request) */
+
+    if ((SState != NULL) && 
+        (OrigState != *SState))
+      return(0);
+    }
+
+  /* have any connections timed out ?? */
+
+  idle_wheel_sweep(time(NULL));
+
+  return(PBSE_NONE);
+  }  /* END wait_request_epoll() */
+#endif /* HAVE_SYS_EPOLL_H */
+
+
+
 /*
  * wait_request - wait for a request (socket with data to read)
- * This routine does a select on the readset of sockets,
- * when data is ready, the processing routine associated with
- * the socket is invoked.
+ * This routine does a select (or epoll_wait where available) on the
+ * readset of sockets, when data is ready, the processing routine
+ * associated with the socket is invoked.
  */
 
 int wait_request(
@@ -660,7 +1037,6 @@ int wait_request(
   {
   int             i;
   int             n;
-  time_t          now;
 
   fd_set          *SelectSet = NULL;
   int             SelectSetSize = 0;
@@ -669,11 +1045,15 @@ int wait_request(
   u_long   		  *SocketAddrSet = NULL;
   u_long          *SocketPortSet = NULL;
 
-
-  char            tmpLine[1024];
   struct timeval  timeout;
   long            OrigState = 0;
 
+#ifdef HAVE_SYS_EPOLL_H
+  if ((epoll_sd >= 0) &&
+      (epoll_owner == getpid()))
+    return(wait_request_epoll(waittime, SState));
+#endif /* HAVE_SYS_EPOLL_H */
+
   if (SState != NULL)
     OrigState = *SState;
 
@@ -754,52 +1134,16 @@ int wait_request(
     {
     if (FD_ISSET(i, SelectSet))
       {
-      pthread_mutex_lock(svr_conn[i].cn_mutex);
       /* this socket has data */
       n--;
 
-      svr_conn[i].cn_lasttime = time(NULL);
+      wait_request_dispatch(i, SocketAddrSet[i], SocketPortSet[i]);
 
-      if (svr_conn[i].cn_active != Idle)
-        {
-        void *(*func)(void *) = svr_conn[i].cn_func;
+      /* NOTE:  breakout if state changed (probably received shutdown request) */
 
-        netcounter_incr();
-
-        pthread_mutex_unlock(svr_conn[i].cn_mutex);
-
-        if (func != NULL)
-          {
-          int args[3];
-
-          args[0] = i;
-          args[1] = (int)SocketAddrSet[i];
-          args[2] = (int)SocketPortSet[i];
-          func((void *)args);
-          }
-
-        /* NOTE:  breakout if state changed (probably received shutdown request) */
-
-        if ((SState != NULL) && 
-            (OrigState != *SState))
-          break;
-        }
-      else
-        {
-        pthread_mutex_unlock(svr_conn[i].cn_mutex);
-
-        globalset_del_sock(i);
-        close_conn(i, FALSE);
-
-        pthread_mutex_lock(num_connections_mutex);
-
-        sprintf(tmpLine, "closed connections to fd %d - num_connections=%d (select bad socket)",
-          i,
-          num_connections);
-
-        pthread_mutex_unlock(num_connections_mutex);
-        log_err(-1, __func__, tmpLine);
-        }
+      if ((SState != NULL) && 
+          (OrigState != *SState))
+        break;
       }
     } /* END for i */
 
@@ -814,58 +1158,7 @@ int wait_request(
 
   /* have any connections timed out ?? */
 
-  now = time((time_t *)0);
-
-  for (i = 0;i < max_connection;i++)
-    {
-    struct connection *cp;
-
-    pthread_mutex_lock(svr_conn[i].cn_mutex);
-
-    cp = &svr_conn[i];
-
-    if (cp->cn_active != FromClientDIS)
-      {
-      pthread_mutex_unlock(svr_conn[i].cn_mutex);
-
-      continue;
-      }
-
-    if ((now - cp->cn_lasttime) <= PBS_NET_MAXCONNECTIDLE)
-      {
-      pthread_mutex_unlock(svr_conn[i].cn_mutex);
-  
-      continue;
-      }
-
-    if (cp->cn_authen & PBS_NET_CONN_NOTIMEOUT)
-      {
-      pthread_mutex_unlock(svr_conn[i].cn_mutex);
-  
-      continue; /* do not time-out this connection */
-      }
-
-    /* NOTE:  add info about node associated with connection - NYI */
-
-    {
-    char buf[80];
-
-    snprintf(tmpLine, sizeof(tmpLine), "connection %d to host %s has timed out after %d seconds - closing stale connection\n",
-      i,
-      netaddr_long(cp->cn_addr, buf),
-      PBS_NET_MAXCONNECTIDLE);
-    }
-    
-    log_err(-1, __func__, tmpLine);
-
-    /* locate node associated with interface, mark node as down until node responds */
-
-    /* NYI */
-
-    close_conn(i, TRUE);
-
-    pthread_mutex_unlock(svr_conn[i].cn_mutex);
-    }  /* END for (i) */
+  idle_wheel_sweep(time(NULL));
 
   return(PBSE_NONE);
   }  /* END wait_request() */
@@ -965,6 +1258,23 @@ void globalset_add_sock(
   FD_SET(sock, GlobalSocketReadSet);
   GlobalSocketAddrSet[sock] = addr;
   GlobalSocketPortSet[sock] = port;
+
+#ifdef HAVE_SYS_EPOLL_H
+  if ((epoll_sd >= 0) &&
+      (epoll_owner == getpid()))
+    {
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = sock;
+
+    if ((epoll_ctl(epoll_sd, EPOLL_CTL_ADD, sock, &ev) != 0) &&
+        (errno == EEXIST))
+      epoll_ctl(epoll_sd, EPOLL_CTL_MOD, sock, &ev);
+    }
+#endif /* HAVE_SYS_EPOLL_H */
+
   pthread_mutex_unlock(global_sock_read_mutex);
   } /* END globalset_add_sock() */
 
@@ -977,6 +1287,18 @@ void globalset_del_sock(
 
   {
   pthread_mutex_lock(global_sock_read_mutex);
+
+#ifdef HAVE_SYS_EPOLL_H
+  if ((epoll_sd >= 0) &&
+      (epoll_owner == getpid()) &&
+      (FD_ISSET(sock, GlobalSocketReadSet)))
+    {
+    struct epoll_event ev; /* non-NULL for pre-2.6.9 kernels */
+
+    epoll_ctl(epoll_sd, EPOLL_CTL_DEL, sock, &ev);
+    }
+#endif /* HAVE_SYS_EPOLL_H */
+
   FD_CLR(sock, GlobalSocketReadSet);
   GlobalSocketAddrSet[sock] = 0;
   GlobalSocketPortSet[sock] = 0;
@@ -1043,6 +1365,11 @@ int add_connection(
   svr_conn[sock].cn_oncl     = 0;
   svr_conn[sock].cn_socktype = socktype;
 
+  if (type == FromClientDIS)
+    idle_wheel_file(sock, svr_conn[sock].cn_lasttime + PBS_NET_MAXCONNECTIDLE + 1);
+  else
+    idle_wheel_remove(sock);
+
 #ifndef NOPRIVPORTS
 
   if ((socktype == PBS_SOCK_INET) && (port < IPPORT_RESERVED))
@@ -1190,6 +1517,8 @@ void close_conn(
     globalset_del_sock(sd);
     }
 
+  idle_wheel_remove(sd);
+
   close(sd);
 
   svr_conn[sd].cn_addr = 0;
@@ -1260,6 +1589,8 @@ void clear_conn(
     globalset_del_sock(sd);
     }
 
+  idle_wheel_remove(sd);
+
   svr_conn[sd].cn_addr = 0;
   svr_conn[sd].cn_handle = -1;
   svr_conn[sd].cn_active = Idle;
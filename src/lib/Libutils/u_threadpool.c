@@ -79,6 +79,7 @@
 
 
 #include <errno.h>
+#include <sched.h>
 #include <signal.h>
 #include <time.h>
 #include <unistd.h>
@@ -95,6 +96,14 @@ threadpool_t *request_pool;
 threadpool_t *task_pool;
 threadpool_t *async_pool;
 
+/* the deque of the worker running on this thread, and its pool */
+static __thread tp_deque_t   *my_deque;
+static __thread threadpool_t *my_pool;
+
+/* free work items kept by this thread */
+static __thread tp_work_t    *my_free_work;
+static __thread int           my_free_count;
+
 static void *work_thread(void *);
 
 
@@ -130,6 +139,442 @@ int create_work_thread(
 
 
 
+
+/*
+ * tp_deque_push() - add work to the bottom of a deque
+ *
+ * Only the deque's owner may call this.
+ * @return TRUE, or FALSE if the deque is full
+ */
+
+int tp_deque_push(
+
+  tp_deque_t *dq,
+  tp_work_t  *work)
+
+  {
+  long bottom = dq->dq_bottom;
+
+  if (bottom - dq->dq_top >= TP_DEQUE_SIZE)
+    return(FALSE);
+
+  dq->dq_items[bottom & (TP_DEQUE_SIZE - 1)] = work;
+
+  /* the item must be visible before thieves can see the new bottom */
+  __sync_synchronize();
+  dq->dq_bottom = bottom + 1;
+
+  return(TRUE);
+  } /* END tp_deque_push() */
+
+
+
+
+/*
+ * tp_deque_pop() - take the most recently pushed work from a deque
+ *
+ * Only the deque's owner may call this.
+ * @return the work or NULL if the deque is empty or a thief took the last item
+ */
+
+tp_work_t *tp_deque_pop(
+
+  tp_deque_t *dq)
+
+  {
+  long       bottom = dq->dq_bottom - 1;
+  long       top;
+  tp_work_t *work = NULL;
+
+  dq->dq_bottom = bottom;
+  __sync_synchronize();
+  top = dq->dq_top;
+
+  if (top <= bottom)
+    {
+    work = dq->dq_items[bottom & (TP_DEQUE_SIZE - 1)];
+
+    if (top == bottom)
+      {
+      /* last item: race the thieves for it */
+      if (__sync_bool_compare_and_swap(&dq->dq_top, top, top + 1) == false)
+        work = NULL;
+
+      dq->dq_bottom = bottom + 1;
+      }
+    }
+  else
+    dq->dq_bottom = bottom + 1;
+
+  return(work);
+  } /* END tp_deque_pop() */
+
+
+
+
+/*
+ * tp_deque_steal() - take the oldest work from another worker's deque
+ *
+ * @return the work or NULL if the deque is empty or another thread won it
+ */
+
+tp_work_t *tp_deque_steal(
+
+  tp_deque_t *dq)
+
+  {
+  long       top = dq->dq_top;
+  long       bottom;
+  tp_work_t *work;
+
+  __sync_synchronize();
+  bottom = dq->dq_bottom;
+
+  if (top >= bottom)
+    return(NULL);
+
+  work = dq->dq_items[top & (TP_DEQUE_SIZE - 1)];
+
+  if (__sync_bool_compare_and_swap(&dq->dq_top, top, top + 1) == false)
+    return(NULL);
+
+  return(work);
+  } /* END tp_deque_steal() */
+
+
+
+
+/*
+ * alloc_work() - get a work item from this thread's cache, then from the
+ * pool's free list, then from malloc
+ *
+ * NOTE: the pool's free list is only used when the caller holds tp_mutex
+ */
+
+static tp_work_t *alloc_work(
+
+  threadpool_t *tp,
+  bool          have_lock)
+
+  {
+  tp_work_t *work;
+
+  if ((work = my_free_work) != NULL)
+    {
+    my_free_work = work->next;
+    my_free_count--;
+    }
+  else if ((have_lock == true) &&
+           ((work = tp->tp_free_work) != NULL))
+    {
+    tp->tp_free_work = work->next;
+    tp->tp_free_count--;
+    }
+  else
+    return((tp_work_t *)calloc(1, sizeof(tp_work_t)));
+
+  work->next = NULL;
+
+  return(work);
+  } /* END alloc_work() */
+
+
+
+
+/*
+ * free_work() - keep a finished work item for reuse
+ *
+ * Items go to this thread's cache.  When that is full half of it is handed
+ * back to the pool, which enqueuers outside the pool allocate from.
+ */
+
+static void free_work(
+
+  threadpool_t *tp,
+  tp_work_t    *work)
+
+  {
+  work->next = my_free_work;
+  my_free_work = work;
+
+  if (++my_free_count <= TP_CACHE_MAX)
+    return;
+
+  pthread_mutex_lock(&tp->tp_mutex);
+
+  while (my_free_count > TP_CACHE_MAX / 2)
+    {
+    work = my_free_work;
+    my_free_work = work->next;
+    my_free_count--;
+
+    if (tp->tp_free_count < TP_FREE_MAX)
+      {
+      work->next = tp->tp_free_work;
+      tp->tp_free_work = work;
+      tp->tp_free_count++;
+      }
+    else
+      free(work);
+    }
+
+  pthread_mutex_unlock(&tp->tp_mutex);
+  } /* END free_work() */
+
+
+
+
+/*
+ * note_queued() - count work added to the pool
+ */
+
+static void note_queued(
+
+  threadpool_t *tp)
+
+  {
+  long queued;
+  long max_queued;
+
+  __sync_fetch_and_add(&tp->tp_enqueued, 1);
+  queued = __sync_add_and_fetch(&tp->tp_queued, 1);
+
+  while (queued > (max_queued = tp->tp_max_queued))
+    {
+    if (__sync_bool_compare_and_swap(&tp->tp_max_queued, max_queued, queued))
+      break;
+    }
+  } /* END note_queued() */
+
+
+
+
+/*
+ * note_started() - count work leaving the pool and how long it waited
+ */
+
+static void note_started(
+
+  threadpool_t *tp,
+  tp_work_t    *work)
+
+  {
+  struct timespec now;
+  long            waited;
+  long            max_waited;
+
+  __sync_fetch_and_sub(&tp->tp_queued, 1);
+  __sync_fetch_and_add(&tp->tp_dequeued, 1);
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  waited = (now.tv_sec - work->queued_at.tv_sec) * 1000000 +
+           (now.tv_nsec - work->queued_at.tv_nsec) / 1000;
+
+  if (waited < 0)
+    waited = 0;
+
+  __sync_fetch_and_add(&tp->tp_wait_usecs, waited);
+
+  while (waited > (max_waited = tp->tp_max_wait_usecs))
+    {
+    if (__sync_bool_compare_and_swap(&tp->tp_max_wait_usecs, max_waited, waited))
+      break;
+    }
+  } /* END note_started() */
+
+
+
+
+/*
+ * take_shared_work() - take work from the shared queue
+ *
+ * A worker takes up to TP_SHARED_BATCH more items onto its own deque so
+ * it goes back to the lock less often; idle workers can steal them.
+ * NOTE: tp_mutex must be held
+ */
+
+static tp_work_t *take_shared_work(
+
+  threadpool_t *tp,
+  tp_deque_t   *dq)
+
+  {
+  tp_work_t *work;
+  tp_work_t *extra;
+  int        moved = 0;
+
+  if ((work = tp->tp_first) == NULL)
+    return(NULL);
+
+  tp->tp_first = work->next;
+  tp->tp_shared_count--;
+
+  while ((dq != NULL) &&
+         (moved < TP_SHARED_BATCH) &&
+         ((extra = tp->tp_first) != NULL) &&
+         (tp->tp_shared_count > tp->tp_nthreads - tp->tp_idle_threads))
+    {
+    if (tp_deque_push(dq, extra) == FALSE)
+      break;
+
+    tp->tp_first = extra->next;
+    tp->tp_shared_count--;
+    moved++;
+    }
+
+  if (tp->tp_first == NULL)
+    tp->tp_last = NULL;
+
+  if ((moved > 0) &&
+      (tp->tp_sleeping > 0))
+    pthread_cond_signal(&tp->tp_waiting_work);
+
+  return(work);
+  } /* END take_shared_work() */
+
+
+
+
+/*
+ * find_work() - look for work without taking tp_mutex, spinning a while
+ * before giving up
+ *
+ * Looks in the worker's own deque, then the shared queue, then steals
+ * from the other workers.
+ */
+
+static tp_work_t *find_work(
+
+  threadpool_t *tp,
+  tp_deque_t   *dq)
+
+  {
+  tp_work_t *work;
+  int        spin;
+  int        first;
+  int        hwm;
+  int        i;
+
+  first = (dq != NULL) ? (dq - tp->tp_deques) + 1 : 0;
+
+  for (spin = 0; spin < TP_SPIN_COUNT; spin++)
+    {
+    if (tp->tp_flags & POOL_DESTROY)
+      return(NULL);
+
+    if ((dq != NULL) &&
+        ((work = tp_deque_pop(dq)) != NULL))
+      return(work);
+
+    if (tp->tp_shared_count > 0)
+      {
+      pthread_mutex_lock(&tp->tp_mutex);
+      work = take_shared_work(tp, dq);
+      pthread_mutex_unlock(&tp->tp_mutex);
+
+      if (work != NULL)
+        return(work);
+      }
+
+    hwm = tp->tp_deque_hwm;
+
+    for (i = 0; i < hwm; i++)
+      {
+      tp_deque_t *victim = tp->tp_deques + ((first + i) % hwm);
+
+      if ((victim == dq) ||
+          (victim->dq_top >= victim->dq_bottom))
+        continue;
+
+      if ((work = tp_deque_steal(victim)) != NULL)
+        {
+        __sync_fetch_and_add(&tp->tp_stolen, 1);
+        return(work);
+        }
+      }
+
+    if (tp->tp_queued == 0)
+      sched_yield();
+    }
+
+  return(NULL);
+  } /* END find_work() */
+
+
+
+
+/*
+ * get_work() - wait for work for the calling worker
+ *
+ * @return the work, or NULL with tp_mutex held when the worker should exit:
+ * the pool is being destroyed or the worker was idle for tp_max_idle_secs
+ */
+
+static tp_work_t *get_work(
+
+  threadpool_t *tp,
+  tp_deque_t   *dq)
+
+  {
+  tp_work_t       *work;
+  int              rc;
+  struct timespec  ts;
+
+  for (;;)
+    {
+    if ((work = find_work(tp, dq)) != NULL)
+      return(work);
+
+    pthread_mutex_lock(&tp->tp_mutex);
+
+    if (tp->tp_flags & POOL_DESTROY)
+      return(NULL);
+
+    if ((work = take_shared_work(tp, dq)) != NULL)
+      {
+      pthread_mutex_unlock(&tp->tp_mutex);
+      return(work);
+      }
+
+    /* announce the sleep before the last look at the queue so that an
+     * enqueuer either sees a sleeper to wake or leaves work to be seen */
+    tp->tp_sleeping++;
+    __sync_synchronize();
+
+    rc = 0;
+
+    if (tp->tp_queued == 0)
+      {
+      if ((tp->tp_nthreads <= tp->tp_min_threads) ||
+          (tp->tp_max_idle_secs < 0))
+        {
+        /* wait until something is ready */ 
+        pthread_cond_wait(&tp->tp_waiting_work, &tp->tp_mutex);
+        }
+      else
+        {
+        clock_gettime(CLOCK_REALTIME,&ts);
+        ts.tv_sec += tp->tp_max_idle_secs;
+        rc = pthread_cond_timedwait(&tp->tp_waiting_work, &tp->tp_mutex, &ts);
+        }
+      }
+
+    tp->tp_sleeping--;
+
+    if ((rc == ETIMEDOUT) && 
+        (tp->tp_queued == 0) &&
+        (tp->tp_nthreads > tp->tp_min_threads) &&
+        (tp->tp_idle_threads > 2))
+      return(NULL);
+
+    pthread_mutex_unlock(&tp->tp_mutex);
+    }
+  } /* END get_work() */
+
+
+
+
 /*
  * Guaranteed to be called whenever a worker thread exits
  *
@@ -147,6 +592,14 @@ static void work_thread_cleanup(
 
   --tp->tp_nthreads;
 
+  if (my_deque != NULL)
+    {
+    my_deque->dq_in_use = FALSE;
+    my_deque->dq_working = FALSE;
+    my_deque = NULL;
+    my_pool = NULL;
+    }
+
   if (tp->tp_flags & POOL_DESTROY)
     {
     if (tp->tp_nthreads == 0)
@@ -157,60 +610,83 @@ static void work_thread_cleanup(
     if (create_work_thread(tp) == 0)
       tp->tp_nthreads++;
     }
-  else if ((tp->tp_first != NULL) &&
+  else if ((tp->tp_queued > 0) &&
            (tp->tp_nthreads < tp->tp_min_threads) &&
            (create_work_thread(tp) == 0))
     {
     tp->tp_nthreads++;
     }
 
+  /* hand this thread's cached work items back */
+  while (my_free_work != NULL)
+    {
+    tp_work_t *work = my_free_work;
+
+    my_free_work = work->next;
+    free(work);
+    }
+
+  my_free_count = 0;
+
   pthread_mutex_unlock(&tp->tp_mutex);
   } /* END work_thread_cleanup() */
 
 
 
 
+/*
+ * Called if a worker is cancelled while running work.  work_thread_cleanup()
+ * runs next and expects tp_mutex to be held.
+ */
+
 void work_cleanup(
     
   void *a)
 
   {
   threadpool_t *tp = (threadpool_t *)a;
-  pthread_t   my_id = pthread_self();
-  tp_working_t  *curr;
-  tp_working_t  *prev = NULL;
+
+  if (my_deque != NULL)
+    my_deque->dq_working = FALSE;
 
   pthread_mutex_lock(&tp->tp_mutex);
+  } /* END work_cleanup() */
+
+
 
-  /* make sure the active process gets removed */
-  curr = tp->tp_active;
 
-  while (curr != NULL)
+/*
+ * claim_deque() - give the calling worker a free deque slot
+ * NOTE: tp_mutex must be held
+ */
+
+static tp_deque_t *claim_deque(
+
+  threadpool_t *tp)
+
+  {
+  int i;
+
+  for (i = 0; i < tp->tp_max_threads; i++)
     {
-    if (curr->working_id == my_id)
+    tp_deque_t *dq = tp->tp_deques + i;
+
+    if (dq->dq_in_use == FALSE)
       {
-      /* handle if it's first in the list */
-      if (prev == NULL)
-        {
-        tp->tp_active = curr->next;
-        }
-      /* anywhere after first position */
-      else
-        {
-        prev->next = curr->next;
-        }
+      dq->dq_in_use = TRUE;
+      dq->dq_working = FALSE;
+      dq->dq_thread = pthread_self();
 
-      /* all done */       
-      break;
-      }
+      if (i >= tp->tp_deque_hwm)
+        tp->tp_deque_hwm = i + 1;
 
-    prev = curr;
-    curr = curr->next;
+      return(dq);
+      }
     }
 
-  } /* END work_cleanup() */
-
-
+  /* more threads than deques; this worker only uses the shared queue */
+  return(NULL);
+  } /* END claim_deque() */
 
 
 
@@ -221,14 +697,10 @@ static void *work_thread(
 
   {
   threadpool_t     *tp = (threadpool_t *)a;
-  int               rc = PBSE_NONE;
 
   void             *(*func)(void *);
   void             *arg;
   tp_work_t        *mywork;
-  tp_working_t      working;
-
-  struct timespec   ts;
 
   if (tp == NULL)
     {
@@ -238,7 +710,21 @@ static void *work_thread(
 
   pthread_mutex_lock(&tp->tp_mutex);
   pthread_cleanup_push(work_thread_cleanup, tp);
-  working.working_id = pthread_self();
+
+  my_pool = tp;
+  my_deque = claim_deque(tp);
+
+  /* stay asleep until the pool is started */
+  while (tp->tp_started == FALSE)
+    {
+    pthread_mutex_unlock(&tp->tp_mutex);
+    
+    sleep(1);
+    
+    pthread_mutex_lock(&tp->tp_mutex);
+    }
+
+  pthread_mutex_unlock(&tp->tp_mutex);
 
   /* this is the main work loop, which is only exited on timeout, if 
    * a timeout is configured */
@@ -249,86 +735,41 @@ static void *work_thread(
     pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED,NULL);
     pthread_setcancelstate(PTHREAD_CANCEL_ENABLE,NULL);
 
-    tp->tp_idle_threads++;
-  
-    /* stay asleep until the pool is started */
-    while (tp->tp_started == FALSE)
-      {
-      pthread_mutex_unlock(&tp->tp_mutex);
-      
-      sleep(1);
-      
-      pthread_mutex_lock(&tp->tp_mutex);
-      }
-
-
-    while ((tp->tp_first == NULL) &&
-           (!(tp->tp_flags & POOL_DESTROY)))
-      {
-      if ((tp->tp_nthreads <= tp->tp_min_threads) ||
-          (tp->tp_max_idle_secs < 0))
-        {
-        /* wait until something is ready */ 
-        pthread_cond_wait(&tp->tp_waiting_work, &tp->tp_mutex);
-        }
-      else
-        {
-        clock_gettime(CLOCK_REALTIME,&ts);
-        ts.tv_sec += tp->tp_max_idle_secs;
-        rc = pthread_cond_timedwait(&tp->tp_waiting_work, &tp->tp_mutex, &ts);
-
-        if (rc == ETIMEDOUT)
-          {
-          break;
-          }
-        }
-      }
+    __sync_fetch_and_add(&tp->tp_idle_threads, 1);
 
-    if ((rc == ETIMEDOUT) && 
-        (tp->tp_nthreads > tp->tp_min_threads) &&
-        (tp->tp_idle_threads > 2))
+    /* returns with tp_mutex held when we should leave */
+    if ((mywork = get_work(tp, my_deque)) == NULL)
       {
-      tp->tp_idle_threads--;
+      __sync_fetch_and_sub(&tp->tp_idle_threads, 1);
       break;
       }
 
-    tp->tp_idle_threads--;
+    __sync_fetch_and_sub(&tp->tp_idle_threads, 1);
 
-    /* if we're shutting down, leave this loop */
-    if (tp->tp_flags & POOL_DESTROY)
-      break;
+    note_started(tp, mywork);
 
-    if ((mywork = tp->tp_first) != NULL)
-      {
-      func = mywork->work_func;
-      arg  = mywork->work_arg;
+    func = mywork->work_func;
+    arg  = mywork->work_arg;
 
-      tp->tp_first = mywork->next;
-      if (tp->tp_last == mywork)
-        tp->tp_last = NULL;
+    free_work(tp, mywork);
 
-      working.next = tp->tp_active;
-      tp->tp_active = &working;
+    if (my_deque != NULL)
+      my_deque->dq_working = TRUE;
 
-      pthread_mutex_unlock(&tp->tp_mutex);
-      pthread_cleanup_push(work_cleanup,tp);
-      free(mywork);
+    pthread_cleanup_push(work_cleanup, tp);
 
-      /* do the work */
-      func(arg);
+    /* do the work */
+    func(arg);
 
-      /* cleanup the work */
-      pthread_cleanup_pop(1); /* calls work_cleanup(NULL) */
-      }
+    pthread_cleanup_pop(0);
+
+    if (my_deque != NULL)
+      my_deque->dq_working = FALSE;
     }
 
   /* calls work_thread_cleanup(tp), this also unlock tp->tp_mutex */
   pthread_cleanup_pop(1);
 
-  /*sprintf(log_buf, "work_thread exiting. Current allocated threads: %d", request_pool->tp_nthreads);
-    log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buf);
-  sprintf(log_buf, "work_thread exiting. Current idle threads: %d", request_pool->tp_idle_threads);
-  log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buf);*/
   pthread_exit(0);
   } /* END work_thread() */
 
@@ -363,6 +804,14 @@ int initialize_threadpool(
     }
 
   memset(*pool,0,sizeof(threadpool_t));
+
+  if (((*pool)->tp_deques = (tp_deque_t *)calloc(max_threads, sizeof(tp_deque_t))) == NULL)
+    {
+    free(*pool);
+    *pool = NULL;
+    return(ENOMEM);
+    }
+
   pthread_mutex_init(&(*pool)->tp_mutex,NULL);
   pthread_cond_init(&(*pool)->tp_waiting_work,NULL);
   pthread_cond_init(&(*pool)->tp_can_destroy,NULL);
@@ -410,6 +859,14 @@ int initialize_threadpool(
 
 
 
+/*
+ * enqueue_threadpool_request()
+ *
+ * Work enqueued by one of tp's own workers goes on that worker's deque
+ * without taking tp_mutex.  Everything else, and work that does not fit,
+ * goes on the shared queue.
+ */
+
 int enqueue_threadpool_request(
 
   void         *(*func)(void *),
@@ -418,29 +875,72 @@ int enqueue_threadpool_request(
 
   {
   tp_work_t *work = NULL;
-/*  char              log_buf[LOCAL_LOG_BUF_SIZE];*/
 
-  if ((work = (tp_work_t *)calloc(1, sizeof(tp_work_t))) == NULL)
+  if ((my_pool == tp) &&
+      (my_deque != NULL))
     {
-    return(ENOMEM);
-    }
+    if ((work = alloc_work(tp, false)) == NULL)
+      return(ENOMEM);
 
-  work->next = NULL;
-  work->work_func = func;
-  work->work_arg  = arg;
+    work->work_func = func;
+    work->work_arg  = arg;
+    clock_gettime(CLOCK_MONOTONIC, &work->queued_at);
+
+    if (tp_deque_push(my_deque, work) == TRUE)
+      {
+      /* a full barrier, pairs with the sleeper's in get_work() */
+      note_queued(tp);
+
+      /* this worker will get to it, but wake someone if it can start now */
+      if ((tp->tp_sleeping > 0) ||
+          ((tp->tp_idle_threads == 0) &&
+           (tp->tp_nthreads < tp->tp_max_threads)))
+        {
+        pthread_mutex_lock(&tp->tp_mutex);
+
+        if (tp->tp_sleeping > 0)
+          pthread_cond_signal(&tp->tp_waiting_work);
+        else if ((tp->tp_idle_threads == 0) &&
+                 (tp->tp_nthreads < tp->tp_max_threads) &&
+                 (create_work_thread(tp) == 0))
+          tp->tp_nthreads++;
+
+        pthread_mutex_unlock(&tp->tp_mutex);
+        }
+
+      return(0);
+      }
+    }
 
   pthread_mutex_lock(&tp->tp_mutex);
 
+  if (work == NULL)
+    {
+    if ((work = alloc_work(tp, true)) == NULL)
+      {
+      pthread_mutex_unlock(&tp->tp_mutex);
+      return(ENOMEM);
+      }
+
+    work->work_func = func;
+    work->work_arg  = arg;
+    clock_gettime(CLOCK_MONOTONIC, &work->queued_at);
+    }
+
   if (tp->tp_first == NULL)
     tp->tp_first = work;
   else
     tp->tp_last->next = work;
   
   tp->tp_last = work;
+  tp->tp_shared_count++;
 
-  if (tp->tp_idle_threads > 0)
+  note_queued(tp);
+
+  if (tp->tp_sleeping > 0)
     pthread_cond_signal(&tp->tp_waiting_work);
-  else if ((tp->tp_nthreads < tp->tp_max_threads) &&
+  else if ((tp->tp_idle_threads == 0) &&
+           (tp->tp_nthreads < tp->tp_max_threads) &&
            (create_work_thread(tp) == 0))
     tp->tp_nthreads++;
 
@@ -489,13 +989,49 @@ bool threadpool_is_too_busy(
 
 
 
+/*
+ * get_threadpool_stats() - report tp's queue depth and wait times
+ *
+ * The maximums restart from the current depth and zero with each call.
+ */
+
+void get_threadpool_stats(
+
+  threadpool_t *tp,
+  tp_stats_t   *stats)
+
+  {
+  long dequeued;
+
+  memset(stats, 0, sizeof(tp_stats_t));
+
+  if (tp == NULL)
+    return;
+
+  pthread_mutex_lock(&tp->tp_mutex);
+  stats->threads = tp->tp_nthreads;
+  stats->idle = tp->tp_idle_threads;
+  pthread_mutex_unlock(&tp->tp_mutex);
+
+  stats->queued = tp->tp_queued;
+  stats->max_queued = __sync_lock_test_and_set(&tp->tp_max_queued, stats->queued);
+  stats->enqueued = tp->tp_enqueued;
+  stats->stolen = tp->tp_stolen;
+  stats->max_wait_us = __sync_lock_test_and_set(&tp->tp_max_wait_usecs, 0);
+
+  if ((dequeued = tp->tp_dequeued) > 0)
+    stats->avg_wait_us = tp->tp_wait_usecs / dequeued;
+  } /* END get_threadpool_stats() */
+
+
+
 void destroy_request_pool(
     
   threadpool_t *tp)
 
   {
   tp_work_t    *work;
-  tp_working_t *ptr;
+  int           i;
 
   pthread_mutex_lock(&tp->tp_mutex);
 
@@ -504,11 +1040,11 @@ void destroy_request_pool(
   pthread_cond_broadcast(&tp->tp_waiting_work);
 
   /* cancel any active work */
-  ptr = tp->tp_active;
-  while (ptr != NULL)
+  for (i = 0; i < tp->tp_deque_hwm; i++)
     {
-    pthread_cancel(ptr->working_id);
-    ptr = ptr->next;
+    if ((tp->tp_deques[i].dq_in_use == TRUE) &&
+        (tp->tp_deques[i].dq_working == TRUE))
+      pthread_cancel(tp->tp_deques[i].dq_thread);
     }
 
   /* wait to be awoken */
@@ -523,6 +1059,26 @@ void destroy_request_pool(
     tp->tp_first = work->next;
     free(work);
     }
+
+  tp->tp_last = NULL;
+  tp->tp_shared_count = 0;
+
+  for (i = 0; i < tp->tp_deque_hwm; i++)
+    {
+    tp_deque_t *dq = tp->tp_deques + i;
+
+    while (dq->dq_top < dq->dq_bottom)
+      free(dq->dq_items[dq->dq_top++ & (TP_DEQUE_SIZE - 1)]);
+    }
+
+  while ((work = tp->tp_free_work) != NULL)
+    {
+    tp->tp_free_work = work->next;
+    free(work);
+    }
+
+  tp->tp_free_count = 0;
+  tp->tp_queued = 0;
   } /* END destroy_request_pool() */
 
 
@@ -542,4 +1098,3 @@ void start_request_pool(
 
 
 /* END u_threadpool.c */
-
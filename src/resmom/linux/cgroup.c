@@ -0,0 +1,502 @@
+#include "license_pbs.h" /* See here for the software license */
+/*
+ * cgroup.c - per job cgroup accounting for the Linux MOM
+ *
+ * When $cgroup_accounting is set in the MOM config file every process the
+ * MOM starts for a job is placed in a cgroup named after the job, and
+ * mom_get_sample() reads each job's usage from its cgroup instead of
+ * scanning /proc.  The unified (v2) hierarchy and the v1 cpuacct and memory
+ * hierarchies are both supported.  If neither can be used the MOM keeps
+ * sampling /proc.
+ *
+ *   v2:  <root>/torque/<jobid>/{cpu.stat,memory.current,memory.peak,memory.swap.current}
+ *   v1:  <root>/cpuacct/torque/<jobid>/cpuacct.usage
+ *        <root>/memory/torque/<jobid>/{memory.usage_in_bytes,memory.max_usage_in_bytes,
+ *                                      memory.memsw.usage_in_bytes}
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "pbs_error.h"
+#include "pbs_job.h"
+#include "log.h"
+#include "pbs_cgroup.h"
+
+#ifndef MAXPATHLEN
+#define MAXPATHLEN 1024
+#endif /* MAXPATHLEN */
+
+extern int LOGLEVEL;
+
+static int  cgroup_version = 0;               /* 0 when cgroup accounting is off */
+static char cgroup_cpu_path[MAXPATHLEN];      /* TORQUE's cgroup in the cpu accounting hierarchy */
+static char cgroup_mem_path[MAXPATHLEN];      /* TORQUE's cgroup in the memory hierarchy */
+
+
+
+/*
+ * read_cgroup_value - read the single number held in a cgroup file
+ *
+ * @return PBSE_NONE or -1 with errno set
+ */
+
+static int read_cgroup_value(
+
+  const char         *dir,    /* I */
+  const char         *file,   /* I */
+  unsigned long long *value)  /* O */
+
+  {
+  char  path[MAXPATHLEN];
+  FILE *fp;
+  int   rc = -1;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+  if ((fp = fopen(path, "r")) == NULL)
+    return(-1);
+
+  if (fscanf(fp, "%llu", value) == 1)
+    rc = PBSE_NONE;
+  else
+    errno = EINVAL;
+
+  fclose(fp);
+
+  return(rc);
+  } /* END read_cgroup_value() */
+
+
+
+/*
+ * read_cgroup_keyed_value - read '<key> <number>' out of a flat keyed
+ * cgroup file such as cpu.stat
+ */
+
+static int read_cgroup_keyed_value(
+
+  const char         *dir,    /* I */
+  const char         *file,   /* I */
+  const char         *key,    /* I */
+  unsigned long long *value)  /* O */
+
+  {
+  char  path[MAXPATHLEN];
+  char  name[64];
+  FILE *fp;
+  int   rc = -1;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+  if ((fp = fopen(path, "r")) == NULL)
+    return(-1);
+
+  while (fscanf(fp, "%63s %llu", name, value) == 2)
+    {
+    if (strcmp(name, key) == 0)
+      {
+      rc = PBSE_NONE;
+      break;
+      }
+    }
+
+  if (rc != PBSE_NONE)
+    errno = ENOENT;
+
+  fclose(fp);
+
+  return(rc);
+  } /* END read_cgroup_keyed_value() */
+
+
+
+static int write_cgroup_value(
+
+  const char *dir,    /* I */
+  const char *file,   /* I */
+  const char *value)  /* I */
+
+  {
+  char    path[MAXPATHLEN];
+  int     fd;
+  ssize_t len = strlen(value);
+  ssize_t written;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, file);
+
+  if ((fd = open(path, O_WRONLY)) < 0)
+    return(-1);
+
+  written = write(fd, value, len);
+  close(fd);
+
+  return((written == len) ? PBSE_NONE : -1);
+  } /* END write_cgroup_value() */
+
+
+
+static int make_cgroup_dir(
+
+  const char *path)
+
+  {
+  if ((mkdir(path, 0755) != 0) &&
+      (errno != EEXIST))
+    return(-1);
+
+  return(PBSE_NONE);
+  } /* END make_cgroup_dir() */
+
+
+
+/*
+ * cgroup_is_populated - true if any process is left in the cgroup
+ */
+
+static bool cgroup_is_populated(
+
+  const char *dir)
+
+  {
+  char  path[MAXPATHLEN];
+  FILE *fp;
+  int   pid;
+  bool  populated = false;
+
+  snprintf(path, sizeof(path), "%s/cgroup.procs", dir);
+
+  if ((fp = fopen(path, "r")) == NULL)
+    return(false);
+
+  if (fscanf(fp, "%d", &pid) == 1)
+    populated = true;
+
+  fclose(fp);
+
+  return(populated);
+  } /* END cgroup_is_populated() */
+
+
+
+/*
+ * init_torque_cgroup - find a usable cgroup hierarchy under root and create
+ * TORQUE's parent cgroup in it.  Called at MOM start up when
+ * $cgroup_accounting is set.
+ *
+ * @param root - where the cgroup file systems are mounted, normally TCGROUP_ROOT_PATH
+ * @return PBSE_NONE if cgroup accounting is on, -1 if the MOM must keep using /proc
+ */
+
+int init_torque_cgroup(
+
+  const char *root)  /* I */
+
+  {
+  char        path[MAXPATHLEN];
+  char        cpu_dir[MAXPATHLEN];
+  char        mem_dir[MAXPATHLEN];
+  struct stat statbuf;
+
+  cgroup_version = 0;
+
+  snprintf(path, sizeof(path), "%s/cgroup.controllers", root);
+
+  if (stat(path, &statbuf) == 0)
+    {
+    /* unified hierarchy - cpu.stat is always there, memory must be delegated */
+    write_cgroup_value(root, "cgroup.subtree_control", "+memory");
+
+    snprintf(cgroup_cpu_path, sizeof(cgroup_cpu_path), "%s/%s", root, TCGROUP_TORQUE_NAME);
+    snprintf(cgroup_mem_path, sizeof(cgroup_mem_path), "%s", cgroup_cpu_path);
+
+    if (make_cgroup_dir(cgroup_cpu_path) != PBSE_NONE)
+      {
+      log_err(errno, __func__, "cannot create the TORQUE cgroup");
+      return(-1);
+      }
+
+    write_cgroup_value(cgroup_cpu_path, "cgroup.subtree_control", "+memory");
+
+    cgroup_version = 2;
+    }
+  else
+    {
+    snprintf(cpu_dir, sizeof(cpu_dir), "%s/cpuacct", root);
+    snprintf(mem_dir, sizeof(mem_dir), "%s/memory", root);
+    snprintf(path, sizeof(path), "%s/cpuacct.usage", cpu_dir);
+
+    if (stat(path, &statbuf) != 0)
+      {
+      log_err(errno, __func__, "no cgroup hierarchy with cpu accounting found");
+      return(-1);
+      }
+
+    snprintf(path, sizeof(path), "%s/memory.usage_in_bytes", mem_dir);
+
+    if (stat(path, &statbuf) != 0)
+      {
+      log_err(errno, __func__, "no cgroup hierarchy with memory accounting found");
+      return(-1);
+      }
+
+    snprintf(cgroup_cpu_path, sizeof(cgroup_cpu_path), "%s/%s", cpu_dir, TCGROUP_TORQUE_NAME);
+    snprintf(cgroup_mem_path, sizeof(cgroup_mem_path), "%s/%s", mem_dir, TCGROUP_TORQUE_NAME);
+
+    if ((make_cgroup_dir(cgroup_cpu_path) != PBSE_NONE) ||
+        (make_cgroup_dir(cgroup_mem_path) != PBSE_NONE))
+      {
+      log_err(errno, __func__, "cannot create the TORQUE cgroups");
+      return(-1);
+      }
+
+    cgroup_version = 1;
+    }
+
+  snprintf(log_buffer, sizeof(log_buffer),
+    "using cgroup v%d accounting under %s", cgroup_version, cgroup_cpu_path);
+  log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buffer);
+
+  return(PBSE_NONE);
+  } /* END init_torque_cgroup() */
+
+
+
+bool cgroup_accounting_enabled(void)
+
+  {
+  return(cgroup_version != 0);
+  } /* END cgroup_accounting_enabled() */
+
+
+
+/*
+ * create_job_cgroup - create the job's cgroup(s).  Does nothing if they
+ * already exist.
+ */
+
+int create_job_cgroup(
+
+  const char *jobid)  /* I */
+
+  {
+  char path[MAXPATHLEN];
+
+  if (cgroup_version == 0)
+    return(-1);
+
+  snprintf(path, sizeof(path), "%s/%s", cgroup_cpu_path, jobid);
+
+  if (make_cgroup_dir(path) != PBSE_NONE)
+    return(-1);
+
+  if (cgroup_version == 1)
+    {
+    snprintf(path, sizeof(path), "%s/%s", cgroup_mem_path, jobid);
+
+    if (make_cgroup_dir(path) != PBSE_NONE)
+      return(-1);
+    }
+
+  return(PBSE_NONE);
+  } /* END create_job_cgroup() */
+
+
+
+/*
+ * move_to_job_cgroup - put a process in the job's cgroup(s).  Its children
+ * are accounted to the job from then on.
+ */
+
+int move_to_job_cgroup(
+
+  pid_t       pid,    /* I */
+  const char *jobid)  /* I */
+
+  {
+  char path[MAXPATHLEN];
+  char pid_str[32];
+
+  if (create_job_cgroup(jobid) != PBSE_NONE)
+    return(-1);
+
+  snprintf(pid_str, sizeof(pid_str), "%d", (int)pid);
+  snprintf(path, sizeof(path), "%s/%s", cgroup_cpu_path, jobid);
+
+  if (write_cgroup_value(path, "cgroup.procs", pid_str) != PBSE_NONE)
+    return(-1);
+
+  if (cgroup_version == 1)
+    {
+    snprintf(path, sizeof(path), "%s/%s", cgroup_mem_path, jobid);
+
+    if (write_cgroup_value(path, "cgroup.procs", pid_str) != PBSE_NONE)
+      return(-1);
+    }
+
+  return(PBSE_NONE);
+  } /* END move_to_job_cgroup() */
+
+
+
+/*
+ * delete_job_cgroup - remove the job's cgroup(s).  Fails while processes
+ * are still in them.
+ */
+
+int delete_job_cgroup(
+
+  const char *jobid)  /* I */
+
+  {
+  char path[MAXPATHLEN];
+  int  rc = PBSE_NONE;
+
+  if (cgroup_version == 0)
+    return(PBSE_NONE);
+
+  snprintf(path, sizeof(path), "%s/%s", cgroup_cpu_path, jobid);
+
+  if ((rmdir(path) != 0) && (errno != ENOENT))
+    rc = -1;
+
+  if (cgroup_version == 1)
+    {
+    snprintf(path, sizeof(path), "%s/%s", cgroup_mem_path, jobid);
+
+    if ((rmdir(path) != 0) && (errno != ENOENT))
+      rc = -1;
+    }
+
+  return(rc);
+  } /* END delete_job_cgroup() */
+
+
+
+/*
+ * read_job_cgroup_usage - read a job's usage from its cgroup(s)
+ *
+ * @return PBSE_NONE, or -1 if the job has no cgroup and must be sampled
+ *         from /proc
+ */
+
+int read_job_cgroup_usage(
+
+  const char   *jobid,  /* I */
+  cgroup_usage *cu)     /* O */
+
+  {
+  char               cpu_dir[MAXPATHLEN];
+  char               mem_dir[MAXPATHLEN];
+  unsigned long long value;
+  unsigned long long swap;
+
+  if (cgroup_version == 0)
+    return(-1);
+
+  snprintf(cpu_dir, sizeof(cpu_dir), "%s/%s", cgroup_cpu_path, jobid);
+  snprintf(mem_dir, sizeof(mem_dir), "%s/%s", cgroup_mem_path, jobid);
+
+  memset(cu, 0, sizeof(cgroup_usage));
+
+  if (cgroup_version == 2)
+    {
+    if (read_cgroup_keyed_value(cpu_dir, "cpu.stat", "usage_usec", &value) != PBSE_NONE)
+      return(-1);
+
+    cu->cput = (unsigned long)(value / 1000000);
+
+    if (read_cgroup_value(mem_dir, "memory.current", &value) != PBSE_NONE)
+      return(-1);
+
+    cu->vmem = value;
+
+    /* memory.peak is only in newer kernels */
+    if (read_cgroup_value(mem_dir, "memory.peak", &cu->mem) != PBSE_NONE)
+      cu->mem = value;
+
+    if (read_cgroup_value(mem_dir, "memory.swap.current", &swap) == PBSE_NONE)
+      cu->vmem += swap;
+    }
+  else
+    {
+    if (read_cgroup_value(cpu_dir, "cpuacct.usage", &value) != PBSE_NONE)
+      return(-1);
+
+    cu->cput = (unsigned long)(value / 1000000000);
+
+    if (read_cgroup_value(mem_dir, "memory.usage_in_bytes", &value) != PBSE_NONE)
+      return(-1);
+
+    if (read_cgroup_value(mem_dir, "memory.max_usage_in_bytes", &cu->mem) != PBSE_NONE)
+      cu->mem = value;
+
+    /* memsw is missing unless swap accounting is enabled */
+    if (read_cgroup_value(mem_dir, "memory.memsw.usage_in_bytes", &cu->vmem) != PBSE_NONE)
+      cu->vmem = value;
+    }
+
+  cu->populated = cgroup_is_populated(cpu_dir);
+
+  return(PBSE_NONE);
+  } /* END read_job_cgroup_usage() */
+
+
+
+/**
+ * Remove the cgroups of jobs that are gone.
+ *
+ * Called after init_abort_jobs.
+ */
+
+void cleanup_torque_cgroup(void)
+
+  {
+  char           path[MAXPATHLEN];
+  struct dirent *pdirent;
+  struct stat    statbuf;
+  DIR           *dir;
+
+  if (cgroup_version == 0)
+    return;
+
+  if ((dir = opendir(cgroup_cpu_path)) == NULL)
+    {
+    log_err(errno, __func__, "failed to open the TORQUE cgroup");
+    return;
+    }
+
+  while ((pdirent = readdir(dir)) != NULL)
+    {
+    if ((!strcmp(pdirent->d_name, ".")) ||
+        (!strcmp(pdirent->d_name, "..")))
+      continue;
+
+    snprintf(path, sizeof(path), "%s/%s", cgroup_cpu_path, pdirent->d_name);
+
+    if ((lstat(path, &statbuf) == -1) ||
+        (!S_ISDIR(statbuf.st_mode)))
+      continue;
+
+    if (mom_find_job(pdirent->d_name) != NULL)
+      continue;
+
+    if (delete_job_cgroup(pdirent->d_name) == PBSE_NONE)
+      {
+      sprintf(log_buffer, "deleted orphaned cgroup %s", path);
+      log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buffer);
+      }
+    }
+
+  closedir(dir);
+  } /* END cleanup_torque_cgroup() */
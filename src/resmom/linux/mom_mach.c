@@ -63,6 +63,7 @@
 #ifdef PENABLE_LINUX26_CPUSETS
 #include "pbs_cpuset.h"
 #endif
+#include "pbs_cgroup.h"
 #include "mom_config.h"
 #include "timer.hpp"
 
@@ -118,6 +119,7 @@ extern  int     LOGLEVEL;
 proc_stat_t   *proc_array = NULL;
 static int            nproc = 0;
 static int            max_proc = 0;
+static bool           proc_array_stale = false; /* jobs were sampled from cgroups, see refresh_proc_array() */
 
 extern pid2jobsid_map_t pid2jobsid_map;
 
@@ -1087,6 +1089,16 @@ unsigned long cput_sum(
   int            nps = 0;
   proc_stat_t   *ps;
 
+  if (pjob->ji_cgroup_sampled == true)
+    {
+    if (pjob->ji_cgroup_populated == false)
+      pjob->ji_flags |= MOM_NO_PROC;
+    else
+      pjob->ji_flags &= ~MOM_NO_PROC;
+
+    return((unsigned long)((double)pjob->ji_cgroup_cput * cputfactor));
+    }
+
   cputime = 0;
 
   if (LOGLEVEL >= 6)
@@ -1237,6 +1249,9 @@ unsigned long long mem_sum(
   unsigned long long  segadd;
   proc_stat_t        *ps;
 
+  if (pjob->ji_cgroup_sampled == true)
+    return(pjob->ji_cgroup_vmem);
+
   segadd = 0;
 
   if (LOGLEVEL >= 6)
@@ -1317,6 +1332,9 @@ unsigned long long resi_sum(
   long long                w_rss;
 #endif
 
+  if (pjob->ji_cgroup_sampled == true)
+    return(pjob->ji_cgroup_mem);
+
   resisize = 0;
 
   if (LOGLEVEL >= 6)
@@ -2133,7 +2151,7 @@ int get_job_sid_from_pid(pid_t pid)
 
 
 /*
- * Declare start of polling loop.
+ * Rebuild the process table.
  *
  * This function caches information about all of processes
  * on the compute node (pbs_mom calls this function). Each process
@@ -2142,8 +2160,9 @@ int get_job_sid_from_pid(pid_t pid)
  * list. This list is then used throughout the pbs_mom to get information
  * about tasks it is monitoring.
  *
- * This function is called from the main MOM loop once every "check_poll_interval"
- * seconds.
+ * Called by mom_get_sample() unless every running job can be sampled from
+ * its cgroup, and by refresh_proc_array() when a resource query needs the
+ * process table.
  *
  * @see get_proc_stat() - child
  * @see mom_set_use() - Aggregates data collected here
@@ -2155,12 +2174,9 @@ int get_job_sid_from_pid(pid_t pid)
  *
  * @see mom_open_poll() - allocs proc_array table.
  * @see mom_close_poll() - frees procs_array.
- * @see setup_program_environment() - parent - called at pbs_mom start
- * @see main_loop() - parent - called once per iteration
- * @see mom_set_use() - populate job structure with usage data for local use or to send to mother superior
  */
 
-int mom_get_sample(void)
+static int scan_proc_array(void)
 
   {
   proc_stat_t           *pi;
@@ -2177,6 +2193,7 @@ int mom_get_sample(void)
     mom_open_poll();
 
   nproc = 0;
+  proc_array_stale = false;
 
   /* clear the maps */
   pid2jobsid_map.clear();
@@ -2317,11 +2334,153 @@ int mom_get_sample(void)
     }
 
   return(PBSE_NONE);
+  }  /* END scan_proc_array() */
+
+
+
+
+/*
+ * Return TRUE if the job has a per process limit.  Those are checked
+ * against the process table, so such a job can't be sampled from its
+ * cgroup alone.
+ */
+
+static int job_has_proc_limits(
+
+  job *pjob)  /* I */
+
+  {
+  resource   *pres;
+  const char *pname;
+
+  for (pres = (resource *)GET_NEXT(pjob->ji_wattr[JOB_ATR_resource].at_val.at_list);
+       pres != NULL;
+       pres = (resource *)GET_NEXT(pres->rs_link))
+    {
+    pname = pres->rs_defin->rs_name;
+
+    if ((igncput == FALSE) && (strcmp(pname, "pcput") == 0))
+      return(TRUE);
+
+    if ((ignvmem == 0) && (strcmp(pname, "pvmem") == 0))
+      return(TRUE);
+    }
+
+  return(FALSE);
+  }  /* END job_has_proc_limits() */
+
+
+
+
+/*
+ * Read the usage of every job from its cgroup into the job structure.
+ *
+ * @return TRUE if every running job was sampled this way, FALSE if the
+ *         process table is still needed.
+ */
+
+static int sample_job_cgroups(void)
+
+  {
+  job          *pjob;
+  cgroup_usage  cu;
+  int           all_sampled = TRUE;
+
+  for (pjob = (job *)GET_NEXT(svr_alljobs);
+       pjob != NULL;
+       pjob = (job *)GET_NEXT(pjob->ji_alljobs))
+    {
+    if (read_job_cgroup_usage(pjob->ji_qs.ji_jobid, &cu) == PBSE_NONE)
+      {
+      pjob->ji_cgroup_sampled = true;
+      pjob->ji_cgroup_populated = cu.populated;
+      pjob->ji_cgroup_cput = cu.cput;
+      pjob->ji_cgroup_mem = cu.mem;
+      pjob->ji_cgroup_vmem = cu.vmem;
+
+      if ((pjob->ji_qs.ji_substate == JOB_SUBSTATE_RUNNING) &&
+          (job_has_proc_limits(pjob) == TRUE))
+        all_sampled = FALSE;
+      }
+    else
+      {
+      /* started before cgroup accounting was turned on or never moved */
+      pjob->ji_cgroup_sampled = false;
+
+      if (pjob->ji_qs.ji_substate == JOB_SUBSTATE_RUNNING)
+        all_sampled = FALSE;
+      }
+    }
+
+  if (LOGLEVEL >= 6)
+    {
+    sprintf(log_buffer, "job cgroups sampled - process table %s",
+      (all_sampled == TRUE) ? "not needed" : "needed");
+
+    log_record(PBSEVENT_DEBUG, 0, __func__, log_buffer);
+    }
+
+  return(all_sampled);
+  }  /* END sample_job_cgroups() */
+
+
+
+
+/*
+ * Declare start of polling loop.
+ *
+ * Samples the usage of every job.  With cgroup accounting each job's usage
+ * is read from its cgroup, which costs O(jobs).  The process table is only
+ * rebuilt from /proc when cgroup accounting is off or some running job
+ * can't be sampled from its cgroup.
+ *
+ * This function is called from the main MOM loop once every "check_poll_interval"
+ * seconds.
+ *
+ * @see scan_proc_array() - child
+ * @see sample_job_cgroups() - child
+ * @see setup_program_environment() - parent - called at pbs_mom start
+ * @see main_loop() - parent - called once per iteration
+ * @see mom_set_use() - populate job structure with usage data for local use or to send to mother superior
+ */
+
+int mom_get_sample(void)
+
+  {
+  if ((cgroup_accounting_enabled() == true) &&
+      (sample_job_cgroups() == TRUE))
+    {
+    /* job usage no longer depends on the process table, it is rebuilt
+     * only when a resource query asks for it */
+    nproc = 0;
+    pid2jobsid_map.clear();
+    pid2procarrayindex_map.clear();
+    proc_array_stale = true;
+
+    return(PBSE_NONE);
+    }
+
+  return(scan_proc_array());
   }  /* END mom_get_sample() */
 
 
 
 
+/*
+ * Rebuild the process table if the last sample skipped it.  Called by the
+ * resource queries which report on processes rather than jobs.
+ */
+
+static void refresh_proc_array(void)
+
+  {
+  if (proc_array_stale == true)
+    scan_proc_array();
+  }  /* END refresh_proc_array() */
+
+
+
+
 
 /*
  * Measure job resource usage and compare with its limits.
@@ -3209,6 +3368,8 @@ char *cput_job(
   double        cputime, addtime;
   proc_stat_t  *ps;
 
+  refresh_proc_array();
+
   cputime = 0.0;
 
   if (LOGLEVEL >= 6)
@@ -3366,6 +3527,8 @@ char *mem_job(
 
   /* max memsize ??? */
 
+  refresh_proc_array();
+
   memsize = 0;
 
   if (LOGLEVEL >= 6)
@@ -3507,6 +3670,8 @@ static char *resi_job(
   long long           w_rss;
 #endif
 
+  refresh_proc_array();
+
   resisize = 0;
 
   if (LOGLEVEL >= 6)
@@ -3750,6 +3915,8 @@ const char *sessions(
 
 #else
 
+  refresh_proc_array();
+
   /* Walk through proc_array, store unique session IDs in the pids list */
 
   for (i = 0;i < nproc;i++)
@@ -3923,6 +4090,8 @@ const char *pids(
     return(NULL);
     }
 
+  refresh_proc_array();
+
   /* Search for members of session */
 
   fmt = ret_string;
@@ -4037,6 +4206,8 @@ const char *nusers(
 
 #else
 
+  refresh_proc_array();
+
   for (i = 0;i < nproc;i++)
     {
     ps = &proc_array[i];
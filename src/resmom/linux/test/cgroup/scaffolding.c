@@ -0,0 +1,16 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "pbs_job.h"
+#include "log.h"
+
+int  LOGLEVEL = 7;
+char log_buffer[LOG_BUF_SIZE];
+
+void log_err(int errnum, const char *routine, const char *text) {}
+void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
+
+job *mom_find_job(const char *jobid)
+  {
+  return(NULL);
+  }
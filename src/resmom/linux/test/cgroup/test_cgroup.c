@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "pbs_error.h"
+#include "pbs_cgroup.h"
+#include <check.h>
+
+
+void write_file(
+
+  const char *path,
+  const char *contents)
+
+  {
+  FILE *fp = fopen(path, "w");
+
+  fail_unless(fp != NULL);
+  fprintf(fp, "%s", contents);
+  fclose(fp);
+  }
+
+
+START_TEST(test_no_hierarchy)
+  {
+  system("rm -rf ./cg_none");
+  mkdir("./cg_none", 0755);
+
+  fail_unless(init_torque_cgroup("./cg_none") == -1);
+  fail_unless(cgroup_accounting_enabled() == false);
+  fail_unless(create_job_cgroup("1.napali") == -1);
+  fail_unless(delete_job_cgroup("1.napali") == PBSE_NONE);
+
+  cgroup_usage cu;
+  fail_unless(read_job_cgroup_usage("1.napali", &cu) == -1);
+
+  system("rm -rf ./cg_none");
+  }
+END_TEST
+
+
+START_TEST(test_unified_hierarchy)
+  {
+  cgroup_usage cu;
+
+  system("rm -rf ./cg2");
+  mkdir("./cg2", 0755);
+  write_file("./cg2/cgroup.controllers", "cpu memory\n");
+
+  fail_unless(init_torque_cgroup("./cg2") == PBSE_NONE);
+  fail_unless(cgroup_accounting_enabled() == true);
+
+  /* no cgroup for the job yet, so it must be sampled from /proc */
+  fail_unless(read_job_cgroup_usage("1.napali", &cu) == -1);
+
+  fail_unless(create_job_cgroup("1.napali") == PBSE_NONE);
+  fail_unless(create_job_cgroup("1.napali") == PBSE_NONE);
+
+  write_file("./cg2/torque/1.napali/cpu.stat", "usage_usec 7500000\nuser_usec 5000000\nsystem_usec 2500000\n");
+  write_file("./cg2/torque/1.napali/memory.current", "1024\n");
+  write_file("./cg2/torque/1.napali/memory.swap.current", "100\n");
+  write_file("./cg2/torque/1.napali/cgroup.procs", "");
+
+  fail_unless(read_job_cgroup_usage("1.napali", &cu) == PBSE_NONE);
+  fail_unless(cu.cput == 7);
+  fail_unless(cu.mem == 1024);
+  fail_unless(cu.vmem == 1124);
+  fail_unless(cu.populated == false);
+
+  /* the high water mark is used when the kernel keeps one */
+  write_file("./cg2/torque/1.napali/memory.peak", "4096\n");
+  fail_unless(move_to_job_cgroup(1234, "1.napali") == PBSE_NONE);
+
+  fail_unless(read_job_cgroup_usage("1.napali", &cu) == PBSE_NONE);
+  fail_unless(cu.mem == 4096);
+  fail_unless(cu.populated == true);
+
+  fail_unless(create_job_cgroup("2.napali") == PBSE_NONE);
+  fail_unless(delete_job_cgroup("2.napali") == PBSE_NONE);
+  fail_unless(access("./cg2/torque/2.napali", F_OK) != 0);
+
+  system("rm -rf ./cg2");
+  }
+END_TEST
+
+
+START_TEST(test_v1_hierarchies)
+  {
+  cgroup_usage cu;
+
+  system("rm -rf ./cg1");
+  mkdir("./cg1", 0755);
+  mkdir("./cg1/cpuacct", 0755);
+  mkdir("./cg1/memory", 0755);
+
+  /* cpu accounting alone isn't enough */
+  write_file("./cg1/cpuacct/cpuacct.usage", "0\n");
+  fail_unless(init_torque_cgroup("./cg1") == -1);
+
+  write_file("./cg1/memory/memory.usage_in_bytes", "0\n");
+  fail_unless(init_torque_cgroup("./cg1") == PBSE_NONE);
+
+  fail_unless(create_job_cgroup("1.napali") == PBSE_NONE);
+  fail_unless(access("./cg1/cpuacct/torque/1.napali", F_OK) == 0);
+  fail_unless(access("./cg1/memory/torque/1.napali", F_OK) == 0);
+
+  write_file("./cg1/cpuacct/torque/1.napali/cpuacct.usage", "3000000000\n");
+  write_file("./cg1/memory/torque/1.napali/memory.usage_in_bytes", "2048\n");
+  write_file("./cg1/cpuacct/torque/1.napali/cgroup.procs", "99\n");
+
+  /* no max usage and no swap accounting */
+  fail_unless(read_job_cgroup_usage("1.napali", &cu) == PBSE_NONE);
+  fail_unless(cu.cput == 3);
+  fail_unless(cu.mem == 2048);
+  fail_unless(cu.vmem == 2048);
+  fail_unless(cu.populated == true);
+
+  write_file("./cg1/memory/torque/1.napali/memory.max_usage_in_bytes", "8192\n");
+  write_file("./cg1/memory/torque/1.napali/memory.memsw.usage_in_bytes", "3072\n");
+
+  fail_unless(read_job_cgroup_usage("1.napali", &cu) == PBSE_NONE);
+  fail_unless(cu.mem == 8192);
+  fail_unless(cu.vmem == 3072);
+
+  system("rm -rf ./cg1");
+  }
+END_TEST
+
+
+Suite *cgroup_suite(void)
+  {
+  Suite *s = suite_create("cgroup test suite methods");
+  TCase *tc_core = tcase_create("test_no_hierarchy");
+  tcase_add_test(tc_core, test_no_hierarchy);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_unified_hierarchy");
+  tcase_add_test(tc_core, test_unified_hierarchy);
+  tcase_add_test(tc_core, test_v1_hierarchies);
+  suite_add_tcase(s, tc_core);
+
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(cgroup_suite());
+  srunner_set_log(sr, "cgroup_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return number_failed;
+  }
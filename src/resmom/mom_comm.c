@@ -131,6 +131,9 @@
 #ifdef PENABLE_LINUX26_CPUSETS
 #include "pbs_cpuset.h"
 #endif
+#ifdef __linux__
+#include "pbs_cgroup.h"
+#endif
 #include "mom_config.h"
 #include <string>
 #include <vector>
@@ -8008,6 +8011,18 @@ static int adoptSession(
     job_save(pjob, SAVEJOB_QUICK, momport);
     }
 
+#ifdef __linux__
+  /* account the adopted session to the job's cgroup */
+  if ((cgroup_accounting_enabled() == true) &&
+      (move_to_job_cgroup(pid, pjob->ji_qs.ji_jobid) != PBSE_NONE))
+    {
+    snprintf(log_buffer, sizeof(log_buffer),
+      "Unable to add process (%d) to the job's cgroup", pid);
+
+    log_err(errno, __func__, log_buffer);
+    }
+#endif /* __linux__ */
+
   if (mom_get_sample() == PBSE_NONE)
     {
     /* time_resc_updated = time_now; */
@@ -0,0 +1,702 @@
+#include "license_pbs.h" /* See here for the software license */
+/*
+ * mom_copy.c - in-process copies of local and $usecp staged files
+ *
+ * req_cpyfile() used to fork and exec /bin/cp -rp for every file whose
+ * source and destination can both be reached from this host.  Those files
+ * are now copied by copy_path(), which does what cp -rp does: directories
+ * are copied recursively, symbolic links are copied as links, and modes,
+ * times and (where permitted) owners are preserved.  File data is moved with
+ * copy_file_range(), falling back to sendfile() and then read()/write().
+ *
+ * copy_paths() copies the files of one request on up to $copy_streams
+ * threads.  The streams of all of the MOM's copy children also share a
+ * table of slots which is mapped before the children are forked, so no
+ * more than $copy_streams files are copied on the node at once.  A slot
+ * holds the pid of the child copying in it, so slots held by children which
+ * died are taken back.
+ *
+ * Like sys_copy(), a copy which fails is tried up to COPY_TRIES times with a
+ * pause between tries, since errors such as ESTALE, EIO or ENOSPC on a
+ * network file system often clear up.  Failures which can't, such as a
+ * missing source, are not tried again.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "pbs_error.h"
+#include "md5.h"
+#include "mom_copy.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define COPY_BUF_SIZE   (1024 * 1024)
+#define COPY_CHUNK_SIZE (64 * 1024 * 1024)  /* bytes asked of copy_file_range() or sendfile() at once */
+#define COPY_SLOT_WAIT  50000               /* usecs between looks for a free slot */
+#define COPY_TRIES      3                   /* tries of each copy, as sys_copy() makes */
+
+static pid_t *copy_slots = NULL;   /* shared with the copy children */
+static int    copy_slot_count = 0;
+
+typedef struct copy_stream_args
+  {
+  std::vector<mom_copy> *copies;
+  int                    verify;
+  int                    next;     /* the next copy to start */
+  } copy_stream_args;
+
+static int copy_tree(const std::string &source, const std::string &dest, int verify, std::string &error);
+
+
+
+/*
+ * mom_copy_init - size the table of copy slots shared with the copy children
+ *
+ * Called by the MOM before it forks a copy child.  Children which were forked
+ * earlier keep the table they were forked with.
+ *
+ * @param streams - the number of files which may be copied at once, 0 for no limit
+ */
+
+int mom_copy_init(
+
+  int streams)
+
+  {
+  void *ptr;
+
+  if (streams == copy_slot_count)
+    return(PBSE_NONE);
+
+  if (copy_slots != NULL)
+    {
+    munmap(copy_slots, sizeof(pid_t) * copy_slot_count);
+
+    copy_slots = NULL;
+    copy_slot_count = 0;
+    }
+
+  if (streams <= 0)
+    return(PBSE_NONE);
+
+  ptr = mmap(NULL, sizeof(pid_t) * streams, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+  if (ptr == MAP_FAILED)
+    return(PBSE_SYSTEM);
+
+  memset(ptr, 0, sizeof(pid_t) * streams);
+
+  copy_slots = (pid_t *)ptr;
+  copy_slot_count = streams;
+
+  return(PBSE_NONE);
+  } /* END mom_copy_init() */
+
+
+
+/*
+ * claim_copy_slot - wait for a free copy slot and take it
+ *
+ * @return the slot, or -1 if copies aren't limited
+ */
+
+static int claim_copy_slot(void)
+
+  {
+  pid_t me = getpid();
+
+  if (copy_slots == NULL)
+    return(-1);
+
+  for (;;)
+    {
+    for (int i = 0; i < copy_slot_count; i++)
+      {
+      if (__sync_bool_compare_and_swap(&copy_slots[i], 0, me))
+        return(i);
+      }
+
+    /* take back the slots of copy children which have died */
+    for (int i = 0; i < copy_slot_count; i++)
+      {
+      pid_t owner = copy_slots[i];
+
+      if ((owner != 0) &&
+          (owner != me) &&
+          (kill(owner, 0) == -1) &&
+          (errno == ESRCH))
+        __sync_bool_compare_and_swap(&copy_slots[i], owner, 0);
+      }
+
+    usleep(COPY_SLOT_WAIT);
+    }
+  } /* END claim_copy_slot() */
+
+
+
+static void release_copy_slot(
+
+  int slot)
+
+  {
+  if (slot >= 0)
+    __sync_bool_compare_and_swap(&copy_slots[slot], getpid(), 0);
+  } /* END release_copy_slot() */
+
+
+
+static int copy_error(
+
+  std::string       &error,
+  int                rc,
+  const char        *what,
+  const std::string &path)
+
+  {
+  error = what;
+  error += " '";
+  error += path;
+  error += "': ";
+  error += strerror(rc);
+
+  return(rc);
+  } /* END copy_error() */
+
+
+
+/*
+ * copy_data - copy what is left of in to out
+ *
+ * @return PBSE_NONE or errno
+ */
+
+static int copy_data(
+
+  int in,
+  int out)
+
+  {
+  ssize_t n;
+
+#ifdef HAVE_COPY_FILE_RANGE
+  for (;;)
+    {
+    if ((n = copy_file_range(in, NULL, out, NULL, COPY_CHUNK_SIZE, 0)) > 0)
+      continue;
+
+    if (n == 0)
+      return(PBSE_NONE);
+
+    if (errno == EINTR)
+      continue;
+
+    if ((errno != ENOSYS) &&
+        (errno != EXDEV) &&
+        (errno != EINVAL) &&
+        (errno != EOPNOTSUPP))
+      return(errno);
+
+    /* not possible between these files, try the next way */
+    break;
+    }
+#endif /* HAVE_COPY_FILE_RANGE */
+
+#ifdef HAVE_SYS_SENDFILE_H
+  for (;;)
+    {
+    if ((n = sendfile(out, in, NULL, COPY_CHUNK_SIZE)) > 0)
+      continue;
+
+    if (n == 0)
+      return(PBSE_NONE);
+
+    if (errno == EINTR)
+      continue;
+
+    if ((errno != ENOSYS) &&
+        (errno != EINVAL))
+      return(errno);
+
+    break;
+    }
+#endif /* HAVE_SYS_SENDFILE_H */
+
+  std::vector<char> buf(COPY_BUF_SIZE);
+
+  for (;;)
+    {
+    if ((n = read(in, &buf[0], buf.size())) == 0)
+      return(PBSE_NONE);
+
+    if (n < 0)
+      {
+      if (errno == EINTR)
+        continue;
+
+      return(errno);
+      }
+
+    for (ssize_t written = 0; written < n;)
+      {
+      ssize_t w = write(out, &buf[written], n - written);
+
+      if (w < 0)
+        {
+        if (errno == EINTR)
+          continue;
+
+        return(errno);
+        }
+
+      written += w;
+      }
+    }
+  } /* END copy_data() */
+
+
+
+/*
+ * file_digest - the MD5 digest of a file's contents
+ *
+ * @return PBSE_NONE or errno
+ */
+
+static int file_digest(
+
+  const char    *path,
+  unsigned char  digest[16])
+
+  {
+  MD5_CTX           c;
+  std::vector<char> buf(COPY_BUF_SIZE);
+  ssize_t           n;
+  int               fd;
+
+  if ((fd = open(path, O_RDONLY)) == -1)
+    return(errno);
+
+  MD5Init(&c);
+
+  while ((n = read(fd, &buf[0], buf.size())) != 0)
+    {
+    if (n < 0)
+      {
+      int rc = errno;
+
+      if (rc == EINTR)
+        continue;
+
+      close(fd);
+
+      return(rc);
+      }
+
+    MD5Update(&c, (unsigned char *)&buf[0], n);
+    }
+
+  close(fd);
+
+  MD5Final(&c);
+
+  memcpy(digest, c.digest, sizeof(c.digest));
+
+  return(PBSE_NONE);
+  } /* END file_digest() */
+
+
+
+/*
+ * set_times - give path st's access and modification times
+ */
+
+static void set_times(
+
+  int          fd,
+  const char  *path,
+  struct stat &st,
+  int          flags)
+
+  {
+  struct timespec times[2];
+
+  times[0] = st.st_atim;
+  times[1] = st.st_mtim;
+
+  if (fd >= 0)
+    futimens(fd, times);
+  else
+    utimensat(AT_FDCWD, path, times, flags);
+  } /* END set_times() */
+
+
+
+static int copy_file(
+
+  const std::string &source,
+  const std::string &dest,
+  struct stat       &st,
+  int                verify,
+  std::string       &error)
+
+  {
+  mode_t mode = st.st_mode & 07777;
+  int    in;
+  int    out;
+  int    rc;
+
+  if ((in = open(source.c_str(), O_RDONLY)) == -1)
+    return(copy_error(error, errno, "cannot open", source));
+
+  if ((out = open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC, mode & 0777)) == -1)
+    {
+    rc = errno;
+
+    close(in);
+
+    return(copy_error(error, rc, "cannot create", dest));
+    }
+
+  if ((rc = copy_data(in, out)) != PBSE_NONE)
+    {
+    close(in);
+    close(out);
+
+    return(copy_error(error, rc, "cannot copy to", dest));
+    }
+
+  close(in);
+
+  /* like cp -p, owners are kept if we're allowed to, and set-id bits only with them */
+  if (fchown(out, st.st_uid, st.st_gid) == -1)
+    mode &= ~(S_ISUID | S_ISGID);
+
+  fchmod(out, mode);
+
+  set_times(out, NULL, st, 0);
+
+  /* errors from NFS writes may only show up here */
+  if (close(out) == -1)
+    return(copy_error(error, errno, "cannot write", dest));
+
+  if (verify)
+    {
+    unsigned char source_digest[16];
+    unsigned char dest_digest[16];
+
+    if ((rc = file_digest(source.c_str(), source_digest)) != PBSE_NONE)
+      return(copy_error(error, rc, "cannot verify", source));
+
+    if ((rc = file_digest(dest.c_str(), dest_digest)) != PBSE_NONE)
+      return(copy_error(error, rc, "cannot verify", dest));
+
+    if (memcmp(source_digest, dest_digest, sizeof(source_digest)))
+      {
+      error = "checksum of '" + dest + "' does not match '" + source + "'";
+
+      return(EIO);
+      }
+    }
+
+  return(PBSE_NONE);
+  } /* END copy_file() */
+
+
+
+static int copy_link(
+
+  const std::string &source,
+  const std::string &dest,
+  struct stat       &st,
+  std::string       &error)
+
+  {
+  std::vector<char> target(st.st_size + 1);
+  ssize_t           len;
+
+  if ((len = readlink(source.c_str(), &target[0], target.size())) == -1)
+    return(copy_error(error, errno, "cannot read link", source));
+
+  target.resize(len);
+  target.push_back('\0');
+
+  unlink(dest.c_str());
+
+  if (symlink(&target[0], dest.c_str()) == -1)
+    return(copy_error(error, errno, "cannot create link", dest));
+
+  if (lchown(dest.c_str(), st.st_uid, st.st_gid) == -1)
+    {
+    /* like cp -p, not being allowed to keep the owner isn't an error */
+    }
+
+  set_times(-1, dest.c_str(), st, AT_SYMLINK_NOFOLLOW);
+
+  return(PBSE_NONE);
+  } /* END copy_link() */
+
+
+
+/*
+ * copy_dir - copy a directory and everything in it.  Like cp -r, the rest of
+ * the directory is still copied after an entry fails, and the first failure
+ * is returned.
+ */
+
+static int copy_dir(
+
+  const std::string &source,
+  const std::string &dest,
+  struct stat       &st,
+  int                verify,
+  std::string       &error)
+
+  {
+  mode_t         mode = st.st_mode & 07777;
+  struct stat    dst;
+  DIR           *dp;
+  struct dirent *pdirent;
+  int            rc = PBSE_NONE;
+
+  /* the directory must be writable by us until it's full */
+  if (mkdir(dest.c_str(), mode | S_IRWXU) == -1)
+    {
+    int mkdir_errno = errno;
+
+    if ((mkdir_errno != EEXIST) ||
+        (stat(dest.c_str(), &dst) == -1) ||
+        (!S_ISDIR(dst.st_mode)))
+      return(copy_error(error, mkdir_errno, "cannot create directory", dest));
+    }
+
+  if ((dp = opendir(source.c_str())) == NULL)
+    return(copy_error(error, errno, "cannot open directory", source));
+
+  while ((pdirent = readdir(dp)) != NULL)
+    {
+    std::string entry_error;
+    int         entry_rc;
+
+    if ((!strcmp(pdirent->d_name, ".")) ||
+        (!strcmp(pdirent->d_name, "..")))
+      continue;
+
+    entry_rc = copy_tree(source + "/" + pdirent->d_name, dest + "/" + pdirent->d_name, verify, entry_error);
+
+    if ((entry_rc != PBSE_NONE) &&
+        (rc == PBSE_NONE))
+      {
+      rc = entry_rc;
+      error = entry_error;
+      }
+    }
+
+  closedir(dp);
+
+  if (chown(dest.c_str(), st.st_uid, st.st_gid) == -1)
+    mode &= ~(S_ISUID | S_ISGID);
+
+  chmod(dest.c_str(), mode);
+
+  set_times(-1, dest.c_str(), st, 0);
+
+  return(rc);
+  } /* END copy_dir() */
+
+
+
+static int copy_tree(
+
+  const std::string &source,
+  const std::string &dest,
+  int                verify,
+  std::string       &error)
+
+  {
+  struct stat st;
+
+  if (lstat(source.c_str(), &st) == -1)
+    return(copy_error(error, errno, "cannot stat", source));
+
+  if (S_ISREG(st.st_mode))
+    return(copy_file(source, dest, st, verify, error));
+
+  if (S_ISDIR(st.st_mode))
+    return(copy_dir(source, dest, st, verify, error));
+
+  if (S_ISLNK(st.st_mode))
+    return(copy_link(source, dest, st, error));
+
+  if (S_ISFIFO(st.st_mode))
+    {
+    unlink(dest.c_str());
+
+    if (mkfifo(dest.c_str(), st.st_mode & 0777) == -1)
+      return(copy_error(error, errno, "cannot create fifo", dest));
+
+    return(PBSE_NONE);
+    }
+
+  return(copy_error(error, EINVAL, "cannot copy special file", source));
+  } /* END copy_tree() */
+
+
+
+/*
+ * copy_path - copy source to dest the way cp -rp would.  If dest is a
+ * directory, source is copied into it.
+ *
+ * @param verify - TRUE to compare the MD5 digests of each copied file with its source
+ * @param error - RETURN: what went wrong
+ * @return PBSE_NONE or the errno of the (first) failure
+ */
+
+int copy_path(
+
+  const char  *source,
+  const char  *dest,
+  int          verify,
+  std::string &error)
+
+  {
+  std::string src(source);
+  std::string target(dest);
+  struct stat dst;
+
+  error.clear();
+
+  while ((src.size() > 1) &&
+         (src[src.size() - 1] == '/'))
+    src.erase(src.size() - 1);
+
+  if ((stat(dest, &dst) == 0) &&
+      (S_ISDIR(dst.st_mode)))
+    {
+    std::size_t slash = src.rfind('/');
+
+    target += "/";
+    target += (slash == std::string::npos) ? src : src.substr(slash + 1);
+    }
+
+  return(copy_tree(src, target, verify, error));
+  } /* END copy_path() */
+
+
+
+/*
+ * copy_error_lasts - will a copy which failed with rc fail again if tried?
+ */
+
+static bool copy_error_lasts(
+
+  int rc)
+
+  {
+  switch (rc)
+    {
+    case ENOENT:
+    case ENOTDIR:
+    case EISDIR:
+    case EACCES:
+    case EPERM:
+    case EINVAL:
+
+      return(true);
+
+    default:
+
+      return(false);
+    }
+  } /* END copy_error_lasts() */
+
+
+
+static void *copy_stream(
+
+  void *vp)
+
+  {
+  copy_stream_args *args = (copy_stream_args *)vp;
+  int               i;
+
+  while ((i = __sync_fetch_and_add(&args->next, 1)) < (int)args->copies->size())
+    {
+    mom_copy &mc = (*args->copies)[i];
+
+    for (int loop = 1; loop <= COPY_TRIES; loop++)
+      {
+      int slot = claim_copy_slot();
+
+      mc.rc = copy_path(mc.source.c_str(), mc.dest.c_str(), args->verify, mc.error);
+
+      release_copy_slot(slot);
+
+      if ((mc.rc == PBSE_NONE) ||
+          (copy_error_lasts(mc.rc) == true))
+        break;
+
+      /* copy did not work, try again backing off as sys_copy() does.  The
+       * slot is free while we wait so other copies aren't held up */
+
+      if ((loop % 2) == 0)
+        sleep(loop / 2 * 3 + 1);
+      }
+    }
+
+  return(NULL);
+  } /* END copy_stream() */
+
+
+
+/*
+ * copy_paths - make copies, up to streams of them at a time.  Each copy's
+ * rc and error are set.
+ */
+
+void copy_paths(
+
+  std::vector<mom_copy> &copies,
+  int                    streams,
+  int                    verify)
+
+  {
+  copy_stream_args       args;
+  std::vector<pthread_t> threads;
+
+  args.copies = &copies;
+  args.verify = verify;
+  args.next = 0;
+
+  for (int i = 1; (i < streams) && (i < (int)copies.size()); i++)
+    {
+    pthread_t id;
+
+    if (pthread_create(&id, NULL, copy_stream, &args) == 0)
+      threads.push_back(id);
+    }
+
+  /* this thread is a stream too */
+  copy_stream(&args);
+
+  for (unsigned int i = 0; i < threads.size(); i++)
+    pthread_join(threads[i], NULL);
+  } /* END copy_paths() */
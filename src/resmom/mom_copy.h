@@ -0,0 +1,24 @@
+#ifndef _MOM_COPY_H
+#define _MOM_COPY_H
+#include "license_pbs.h" /* See here for the software license */
+
+#include <string>
+#include <vector>
+
+/* one local (or $usecp) copy of a stage-in or stage-out request */
+typedef struct mom_copy
+  {
+  std::string source;
+  std::string dest;
+  std::string localname;   /* file to remove after a stage out */
+  std::string fp_local;    /* the request's local name, for the undelivered directory */
+  int         from_spool;
+  int         rc;          /* PBSE_NONE or the errno the copy failed with */
+  std::string error;       /* why the copy failed */
+  } mom_copy;
+
+int  mom_copy_init(int streams);
+int  copy_path(const char *source, const char *dest, int verify, std::string &error);
+void copy_paths(std::vector<mom_copy> &copies, int streams, int verify);
+
+#endif /* _MOM_COPY_H */
@@ -140,6 +140,9 @@
 #ifdef PENABLE_LINUX26_CPUSETS
 #include "pbs_cpuset.h"
 #endif
+#ifdef __linux__
+#include "pbs_cgroup.h"
+#endif
 #include "utils.h"
 #include "mom_config.h"
 #include "container.hpp"
@@ -683,6 +686,11 @@ void *delete_job_files(
   delete_cpuset(jfdi->jobid, true);
 #endif /* PENABLE_LINUX26_CPUSETS */
 
+#ifdef __linux__
+  /* Delete the job's cgroups. */
+  delete_job_cgroup(jfdi->jobid);
+#endif /* __linux__ */
+
   /* delete the node file and gpu file */
   sprintf(namebuf,"%s/%s", path_aux, jfdi->jobid);
   unlink(namebuf);
@@ -27,6 +27,7 @@
 #include <limits.h>
 #include <netdb.h>
 #include <grp.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/param.h>
 #include <sys/stat.h>
@@ -84,6 +85,9 @@
 #include "pbs_cpuset.h"
 #include "node_internals.hpp"
 #endif
+#ifdef __linux__
+#include "pbs_cgroup.h"
+#endif
 #include "threadpool.h"
 #include "mom_hierarchy.h"
 #include "../lib/Libutils/u_lock_ctl.h" /* lock_init */
@@ -112,6 +116,10 @@
 #include <sys/statvfs.h>
 #endif
 
+#ifdef HAVE_SYS_SIGNALFD_H
+#include <sys/signalfd.h>
+#endif
+
 #define PMOMTCPTIMEOUT 60  /* duration in seconds mom TCP requests will block */
 #define TCP_READ_PROTO_TIMEOUT  2
 #define DEFAULT_JOB_EXIT_WAIT_TIME 600
@@ -191,6 +199,7 @@ tlist_head svr_newjobs; /* jobs being sent to MOM */
 tlist_head svr_alljobs; /* all jobs under MOM's control */
 tlist_head mom_varattrs; /* variable attributes */
 int  termin_child = 0;  /* boolean - one or more children need to be terminated this iteration */
+int  sigchld_fd = -1;   /* signalfd SIGCHLD is read from, see init_sigchld_fd() */
 time_t  time_now = 0;
 time_t  last_poll_time = 0;
 extern tlist_head svr_requests;
@@ -442,6 +451,8 @@ extern void check_state(int);
 static void    stop_me(int);
 static void    PBSAdjustLogLevel(int);
 int            TMOMScanForStarting(void);
+int            TMOMStartsPending(void);
+int            TMOMWaitForStarting(int);
 unsigned long  getsize(resource *);
 unsigned long  gettime(resource *);
 
@@ -4503,6 +4514,93 @@ void recover_internal_layout()
 
 
 
+/*
+ * drain_sigchld_fd - read the pending SIGCHLDs from sigchld_fd and note
+ * that children need to be reaped
+ *
+ * @return TRUE if there were any
+ */
+
+int drain_sigchld_fd(void)
+
+  {
+#if defined(HAVE_SYS_SIGNALFD_H) && !defined(NOSIGCHLDMOM)
+  struct signalfd_siginfo info;
+  int                     found = FALSE;
+
+  if (sigchld_fd < 0)
+    return(FALSE);
+
+  while (read(sigchld_fd, &info, sizeof(info)) == sizeof(info))
+    found = TRUE;
+
+  if (found == TRUE)
+    termin_child = 1;
+
+  return(found);
+#else
+  return(FALSE);
+#endif /* HAVE_SYS_SIGNALFD_H && !NOSIGCHLDMOM */
+  } /* END drain_sigchld_fd() */
+
+
+
+/*
+ * read_sigchld_fd - wait_request() read function for sigchld_fd.  Returning
+ * lets main_loop() reap the children right away instead of at the end of
+ * the select timeout.
+ */
+
+void *read_sigchld_fd(
+
+  void *new_sock)
+
+  {
+  drain_sigchld_fd();
+
+  return(NULL);
+  } /* END read_sigchld_fd() */
+
+
+
+/*
+ * init_sigchld_fd - receive SIGCHLD through a signalfd which wait_request()
+ * watches, so a child exiting wakes main_loop() up.  SIGCHLD then stays
+ * blocked in main_loop() and catch_child() is no longer called for it.
+ * If the signalfd can't be set up catch_child() is left to do it as before.
+ */
+
+void init_sigchld_fd(void)
+
+  {
+#if defined(HAVE_SYS_SIGNALFD_H) && !defined(NOSIGCHLDMOM)
+  sigset_t chldsigs;
+
+  sigemptyset(&chldsigs);
+  sigaddset(&chldsigs, SIGCHLD);
+
+  if ((sigchld_fd = signalfd(-1, &chldsigs, SFD_NONBLOCK | SFD_CLOEXEC)) < 0)
+    {
+    log_err(errno, __func__, "cannot create signalfd for SIGCHLD");
+    return;
+    }
+
+  if (add_conn(sigchld_fd, Primary, (pbs_net_t)0, 0, PBS_SOCK_UNIX, read_sigchld_fd) != PBSE_NONE)
+    {
+    log_err(-1, __func__, "cannot watch the SIGCHLD signalfd");
+    close(sigchld_fd);
+    sigchld_fd = -1;
+    return;
+    }
+
+  /* signals only reach the signalfd while they are blocked */
+  if (sigprocmask(SIG_BLOCK, &chldsigs, NULL) == -1)
+    log_err(errno, __func__, "sigprocmask(BLOCK)");
+#endif /* HAVE_SYS_SIGNALFD_H && !NOSIGCHLDMOM */
+  } /* END init_sigchld_fd() */
+
+
+
 /**
  * setup_program_environment
  */
@@ -4642,6 +4740,8 @@ int setup_program_environment(void)
 
   init_resc_defs();
 
+  index_attr_defs(job_attr_def, JOB_ATR_LAST);
+
   c |= mom_checkpoint_init();
 
   /* change working directory to mom_priv */
@@ -4847,6 +4947,13 @@ int setup_program_environment(void)
     return(rc);
 #endif
 
+#ifdef __linux__
+  /* without a usable cgroup hierarchy jobs are sampled from /proc */
+  if ((MOMConfigCgroupAccounting) &&
+      (init_torque_cgroup(TCGROUP_ROOT_PATH) != PBSE_NONE))
+    log_err(-1, msg_daemonname, "cgroup accounting is not available, sampling /proc instead");
+#endif
+
 
   /* go into the background and become own session/process group */
 
@@ -4996,6 +5103,8 @@ int setup_program_environment(void)
 
   sigaction(SIGCHLD, &act, NULL);
 
+  init_sigchld_fd();
+
 #ifdef _CRAY
   sigaction(WJSIGNAL, &act, NULL);
 
@@ -5174,6 +5283,11 @@ int setup_program_environment(void)
   recover_internal_layout();
 #endif
 
+#ifdef __linux__
+  /* remove the cgroups of jobs that did not survive the restart */
+  cleanup_torque_cgroup();
+#endif
+
 #ifdef _POSIX_MEMLOCK
   /* call mlockall() only 1 time, since it seems to leak mem */
   if (MOMIsLocked == 0)
@@ -5265,6 +5379,75 @@ int TMOMJobGetStartInfo(
   return(FAILURE);
   }  /* END TMOMJobGetStartInfo() */
 
+
+
+/*
+ * TMOMStartsPending
+ *
+ * the number of jobs whose starter has been set up but has not yet reported
+ * back to MOM
+ */
+
+int TMOMStartsPending(void)
+
+  {
+  int index;
+  int count = 0;
+
+  for (index = 0;index < TMAX_JE;index++)
+    {
+    if (TMOMStartInfo[index].jobid[0] != '\0')
+      count++;
+    }
+
+  return(count);
+  }  /* END TMOMStartsPending() */
+
+
+/*
+ * TMOMWaitForStarting
+ *
+ * wait up to Timeout seconds for the starter of any of the launching jobs
+ * to report back, then finish the launches of the jobs which are ready.
+ *
+ * @return the number of starters which had reported back
+ */
+
+int TMOMWaitForStarting(
+
+  int Timeout) /* I (in seconds) */
+
+  {
+  struct pollfd fds[TMAX_JE];
+  int           nfds = 0;
+  int           index;
+  int           rc;
+
+  for (index = 0;index < TMAX_JE;index++)
+    {
+    if ((TMOMStartInfo[index].jobid[0] == '\0') ||
+        (TMOMStartInfo[index].jsmpipe[0] < 0))
+      continue;
+
+    fds[nfds].fd = TMOMStartInfo[index].jsmpipe[0];
+    fds[nfds].events = POLLIN;
+    fds[nfds].revents = 0;
+    nfds++;
+    }
+
+  if (nfds == 0)
+    return(0);
+
+  rc = poll(fds, nfds, Timeout * 1000);
+
+  if (rc <= 0)
+    return(0);
+
+  TMOMScanForStarting();
+
+  return(rc);
+  }  /* END TMOMWaitForStarting() */
+
 /*
  * TMOMScanForStarting
  */
@@ -5336,7 +5519,7 @@ int TMOMScanForStarting(void)
 
       /* check if job is ready */
 
-      if (TMomCheckJobChild(TJE, 1, &Count, &RC) == FAILURE)
+      if (TMomCheckJobChild(TJE, 0, &Count, &RC) == FAILURE)
         {
         long STime;
 
@@ -5859,6 +6042,8 @@ void kill_all_running_jobs(void)
       }
     }  /* END for (pjob) */
 
+  drain_sigchld_fd();
+
 #ifndef NOSIGCHLDMOM
   if (termin_child != 0)
 #endif
@@ -5926,6 +6111,10 @@ time_t calculate_select_timeout() {
   if (LastServerUpdateTime == 0)
     tmpTime = 1;
 
+  /* check on the jobs that are launching every second */
+  if (TMOMStartsPending() > 0)
+    tmpTime = 1;
+
   return tmpTime;
 }
 
@@ -5942,10 +6131,17 @@ void main_loop(void)
   {
   double        myla;
   time_t        tmpTime;
+  sigset_t      waitsigs;
 #ifdef USESAVEDRESOURCES
   int           check_dead = TRUE;
 #endif    /* USESAVEDRESOURCES */
 
+  /* with a SIGCHLD signalfd, SIGCHLD stays blocked and wakes wait_request() instead */
+  waitsigs = allsigs;
+
+  if (sigchld_fd >= 0)
+    sigdelset(&waitsigs, SIGCHLD);
+
   mom_run_state = MOM_RUN_STATE_RUNNING;  /* mom_run_state is altered by stop_me() or MOMCheckRestart() */
 
   while (mom_run_state == MOM_RUN_STATE_RUNNING)
@@ -6014,8 +6210,11 @@ void main_loop(void)
     check_dead = FALSE;
 #endif    /* USESAVEDRESOURCES */
 
+    /* children which exited since the last pass */
+    drain_sigchld_fd();
+
 #ifndef NOSIGCHLDMOM
-    if (termin_child != 0)  /* termin_child is a flag set by the catch_child signal handler */
+    if (termin_child != 0)  /* termin_child is set by the catch_child signal handler or drain_sigchld_fd() */
 #endif
       scan_for_terminated();  /* machine dependent (calls mom_get_sample()???) */
 
@@ -6047,7 +6246,7 @@ void main_loop(void)
 
     /* unblock signals */
 
-    if (sigprocmask(SIG_UNBLOCK, &allsigs, NULL) == -1)
+    if (sigprocmask(SIG_UNBLOCK, &waitsigs, NULL) == -1)
       log_err(errno, __func__, "sigprocmask(UNBLOCK)");
 
     time_now = time((time_t *)0);
@@ -243,6 +243,8 @@
 #include "mom_config.h"
 #include <string>
 #include <vector>
+#include <map>
+#include <set>
 #include "container.hpp"
 #include <arpa/inet.h>
 
@@ -254,6 +256,8 @@
 #define MAX_SERVER_UPDATE_SPACING         40
 #define NO_SERVER_CONFIGURED             -1
 #define COULD_NOT_CONTACT_SERVER         -2
+#define SENT_TO_PARENT_MOM               -3
+#define MAX_STATUS_DELTAS                 9 /* delta updates sent between full updates */
 
 #ifdef NUMA_SUPPORT
 extern int numa_index;
@@ -299,6 +303,24 @@ extern u_long              localaddr;
 extern container::item_container<received_node *> received_statuses;
 std::vector<std::string>   global_gpu_status;
 std::vector<std::string>   mom_status;
+std::vector<std::string>   mom_status_update; /* what is sent to pbs_server: mom_status or a delta of it */
+
+/* the status pbs_server acknowledged last, by key, for building deltas */
+std::map<std::string, std::string> acked_status;
+unsigned long              acked_status_seq = 0; /* 0 if the next update must be full */
+unsigned long              status_seq = 0;
+int                        status_deltas_sent = 0;
+bool                       status_update_is_full = true;
+
+/* keys whose values drive actions on pbs_server and are sent in every delta */
+const char *always_sent_status[] =
+  {
+  "state",
+  "jobs",
+  "jobdata",
+  "message",
+  NULL
+  };
 
 extern struct config *rm_search(struct config *where, const char *what);
 
@@ -1332,7 +1354,20 @@ int mom_server_update_stat(
       
     close(stream);
   
-    if (ret != DIS_SUCCESS)
+    if (ret == STATUS_SEQ_MISMATCH)
+      {
+      /* the server is up but couldn't apply the delta */
+      if (LOGLEVEL >= 3)
+        {
+        sprintf(log_buffer, "%s is missing status update %lu, will send a full update",
+          pms->pbs_servername, acked_status_seq);
+        
+        log_record(PBSEVENT_SYSTEM, 0, __func__, log_buffer);
+        }
+
+      rc = STATUS_SEQ_MISMATCH;
+      }
+    else if (ret != DIS_SUCCESS)
       {
 
       /* FAILURE */
@@ -1544,10 +1579,14 @@ int send_update_to_a_server()
   /* now, once we contact one server we stop attempting to report in */
   for (int sindex = 0; sindex < PBS_MAXSERVER && rc != PBSE_NONE; sindex++)
     {
-    int tmp_rc = mom_server_update_stat(&mom_servers[sindex], mom_status);
+    int tmp_rc = mom_server_update_stat(&mom_servers[sindex], mom_status_update);
 
     if (tmp_rc != NO_SERVER_CONFIGURED)
       rc = tmp_rc;
+
+    /* the server was reached; the delta just needs to be resent in full */
+    if (rc == STATUS_SEQ_MISMATCH)
+      break;
     }
 
   if (rc == COULD_NOT_CONTACT_SERVER)
@@ -1585,6 +1624,194 @@ void update_mom_status()
   } /* update_mom_status() */
 
 
+
+/*
+ * status_delta_enabled - deltas are only sent when $status_delta is set and
+ * never for NUMA node boards, which are all reported by one mom
+ */
+
+bool status_delta_enabled()
+
+  {
+#ifdef NUMA_SUPPORT
+  return(false);
+#else
+  return(MOMConfigStatusDelta != 0);
+#endif /* NUMA_SUPPORT */
+  } /* END status_delta_enabled() */
+
+
+
+bool is_always_sent_status(
+
+  const std::string &key)
+
+  {
+  for (int i = 0; always_sent_status[i] != NULL; i++)
+    {
+    if (key == always_sent_status[i])
+      return(true);
+    }
+
+  return(false);
+  } /* END is_always_sent_status() */
+
+
+
+/*
+ * build_status_update - choose what to send pbs_server for this update.
+ *
+ * When deltas are enabled every update carries "status_seq=<n>".  A delta
+ * is preceded by "status_delta=<base>", the sequence number of the last
+ * update the server acknowledged, and holds only the keys that changed since
+ * then plus "status_removed=<key>" for keys that went away.  GPU and MIC
+ * status blocks are always sent whole.
+ *
+ * @param status - the full status (I)
+ * @param update - what to send (O)
+ */
+
+void build_status_update(
+
+  std::vector<std::string> &status,
+  std::vector<std::string> &update)
+
+  {
+  std::stringstream     ss;
+  std::set<std::string> keys;
+  bool                  in_block = false;
+
+  update.clear();
+
+  if (status_delta_enabled() == false)
+    {
+    update = status;
+    return;
+    }
+
+  status_seq++;
+
+  status_update_is_full = ((acked_status_seq == 0) ||
+                           (status_deltas_sent >= MAX_STATUS_DELTAS));
+
+  if (status_update_is_full == false)
+    {
+    ss << "status_delta=" << acked_status_seq;
+    update.push_back(ss.str());
+    ss.str("");
+    }
+
+  ss << "status_seq=" << status_seq;
+  update.push_back(ss.str());
+
+  if (status_update_is_full == true)
+    {
+    update.insert(update.end(), status.begin(), status.end());
+    return;
+    }
+
+  for (unsigned int i = 0; i < status.size(); i++)
+    {
+    const std::string &str = status[i];
+
+    if (in_block == true)
+      {
+      update.push_back(str);
+
+      if ((str == END_GPU_STATUS) ||
+          (str == END_MIC_STATUS))
+        in_block = false;
+
+      continue;
+      }
+
+    if ((str == START_GPU_STATUS) ||
+        (str == START_MIC_STATUS))
+      {
+      update.push_back(str);
+      in_block = true;
+      continue;
+      }
+
+    std::string key = str.substr(0, str.find('='));
+    std::map<std::string, std::string>::iterator it = acked_status.find(key);
+
+    keys.insert(key);
+
+    if ((it == acked_status.end()) ||
+        (it->second != str) ||
+        (is_always_sent_status(key) == true))
+      update.push_back(str);
+    }
+
+  for (std::map<std::string, std::string>::iterator it = acked_status.begin();
+       it != acked_status.end();
+       it++)
+    {
+    if (keys.find(it->first) == keys.end())
+      update.push_back("status_removed=" + it->first);
+    }
+  } /* END build_status_update() */
+
+
+
+/*
+ * commit_status_update - pbs_server acknowledged the last update; the next
+ * delta is built against the status it was made from
+ */
+
+void commit_status_update(
+
+  std::vector<std::string> &status)
+
+  {
+  bool in_block = false;
+
+  if (status_delta_enabled() == false)
+    return;
+
+  acked_status.clear();
+
+  for (unsigned int i = 0; i < status.size(); i++)
+    {
+    const std::string &str = status[i];
+
+    if (in_block == true)
+      {
+      if ((str == END_GPU_STATUS) ||
+          (str == END_MIC_STATUS))
+        in_block = false;
+      }
+    else if ((str == START_GPU_STATUS) ||
+             (str == START_MIC_STATUS))
+      in_block = true;
+    else
+      acked_status[str.substr(0, str.find('='))] = str;
+    }
+
+  acked_status_seq = status_seq;
+
+  if (status_update_is_full == true)
+    status_deltas_sent = 0;
+  else
+    status_deltas_sent++;
+  } /* END commit_status_update() */
+
+
+
+/*
+ * reset_status_delta - make the next update a full one
+ */
+
+void reset_status_delta()
+
+  {
+  acked_status.clear();
+  acked_status_seq = 0;
+  status_deltas_sent = 0;
+  } /* END reset_status_delta() */
+
+
 int send_status_through_hierarchy()
 
   {
@@ -1662,6 +1889,7 @@ void mom_server_all_update_stat(void)
   if (is_reporter_mom == TRUE)
     {
     generate_alps_status(mom_status, apbasil_path, apbasil_protocol);
+    mom_status_update = mom_status;
 
     if (send_update_to_a_server() == PBSE_NONE)
       {
@@ -1677,6 +1905,13 @@ void mom_server_all_update_stat(void)
     global_gpu_status.clear();
     add_gpu_status(global_gpu_status);
 #endif
+
+#ifndef NUMA_SUPPORT
+    /* generate the status here so the parent knows what the server acknowledged */
+    update_mom_status();
+    build_status_update(mom_status, mom_status_update);
+#endif /* NUMA_SUPPORT */
+
     /* It is possible that pbs_server may get busy and start queing incoming requests and not be able 
        to process them right away. If pbs_mom is waiting for a reply to a statuys update that has 
        been queued and at the same time the server makes a request to the mom we can get stuck
@@ -1729,10 +1964,26 @@ void mom_server_all_update_stat(void)
         return;
         }
 
-      if (buf[0] != '0')
+      rc = atoi(buf);
+
+      if (rc == STATUS_SEQ_MISMATCH)
+        {
+        /* the server doesn't have the update the delta was built on */
+        log_record(PBSEVENT_SYSTEM, 0, __func__, "server requested a full status update");
+        reset_status_delta();
+        send_update_soon();
+        }
+      else if ((rc != PBSE_NONE) &&
+               (rc != SENT_TO_PARENT_MOM))
         num_stat_update_failures++;
       else
         {
+        /* updates relayed by the hierarchy are always full and unversioned */
+        if (rc == PBSE_NONE)
+          commit_status_update(mom_status);
+        else
+          reset_status_delta();
+
         num_stat_update_failures = 0;
         for (int sindex = 0; sindex < PBS_MAXSERVER; sindex++)
           {
@@ -1752,10 +2003,15 @@ void mom_server_all_update_stat(void)
     for (numa_index = 0; numa_index < num_node_boards; numa_index++)
 #endif /* NUMA_SUPPORT */
       {
+#ifdef NUMA_SUPPORT
       update_mom_status();
+      build_status_update(mom_status, mom_status_update);
+#endif /* NUMA_SUPPORT */
   
       if (send_status_through_hierarchy() != PBSE_NONE)
         rc = send_update_to_a_server();
+      else if (status_delta_enabled() == true)
+        rc = SENT_TO_PARENT_MOM;
       }
 
     sprintf(buf, "%d", rc);
@@ -161,6 +161,10 @@ char             MOMConfigVersion[64];
 int              MOMConfigDownOnError      = 0;
 int              MOMConfigRestart          = 0;
 int              MOMCudaVisibleDevices     = 1;
+int              MOMConfigCgroupAccounting = 0; /* 0: sample /proc, 1: sample job cgroups */
+int              MOMConfigStatusDelta      = 0; /* 0: full status updates, 1: send changed keys only */
+int              MOMCopyStreams            = 4; /* local files copied at once, 0: fork cp */
+int              MOMCopyVerify             = 0; /* 1: compare checksums of copied files */
 double           wallfactor = 1.00;
 struct cphosts  *pcphosts = NULL;
 long             pe_alarm_time = PBS_PROLOG_TIME;
@@ -169,6 +173,7 @@ char             PRE_EXEC[1024];
 int              src_login_batch = TRUE;
 int              src_login_interactive = TRUE;
 long             TJobStartBlockTime = 5; /* seconds to wait for job to launch before backgrounding */
+int              max_concurrent_launches = 8; /* job starters in flight at once, 1 waits for each */
 char             config_file[_POSIX_PATH_MAX] = "config";
 int              config_file_specified = 0;
 struct config   *config_array = NULL;
@@ -293,6 +298,11 @@ unsigned long setmomhierarchyretrytime(const char *);
 unsigned long setjobdirectorysticky(const char *);
 unsigned long setcudavisibledevices(const char *);
 unsigned long setcudavisibledevices(const char *);
+unsigned long setcgroupaccounting(const char *);
+unsigned long setstatusdelta(const char *);
+unsigned long setmaxconcurrentlaunches(const char *);
+unsigned long setcopystreams(const char *);
+unsigned long setcopyverify(const char *);
 
 struct specials special[] = {
   { "alloc_par_cmd",       setallocparcmd },
@@ -374,6 +384,11 @@ struct specials special[] = {
   { "mom_hierarchy_retry_time",  setmomhierarchyretrytime},
   { "jobdirectory_sticky", setjobdirectorysticky},
   { "cuda_visible_devices", setcudavisibledevices},
+  { "cgroup_accounting",   setcgroupaccounting},
+  { "status_delta",        setstatusdelta},
+  { "max_concurrent_launches", setmaxconcurrentlaunches},
+  { "copy_streams",        setcopystreams},
+  { "copy_verify",         setcopyverify},
   { NULL,                  NULL }
   };
 
@@ -1335,6 +1350,84 @@ u_long setjobdirectorysticky(
 
 
 
+u_long setcgroupaccounting(
+
+  const char *value)  /* I */
+
+  {
+  int enable;
+
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, value);
+
+  if ((enable = setbool(value)) != -1)
+    MOMConfigCgroupAccounting = enable;
+
+  return(1);
+  }  /* END setcgroupaccounting() */
+
+
+
+
+u_long setstatusdelta(
+
+  const char *value)  /* I */
+
+  {
+  int enable;
+
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, value);
+
+  if ((enable = setbool(value)) != -1)
+    MOMConfigStatusDelta = enable;
+
+  return(1);
+  }  /* END setstatusdelta() */
+
+
+
+
+u_long setcopystreams(
+
+  const char *value)  /* I */
+
+  {
+  int i;
+
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, value);
+
+  i = (int)strtol(value, NULL, 10);
+
+  if ((i < 0) || ((i == 0) && (value[0] != '0')))
+    {
+    return(0);  /* error */
+    }
+
+  MOMCopyStreams = i;
+
+  return(1);
+  }  /* END setcopystreams() */
+
+
+
+
+u_long setcopyverify(
+
+  const char *value)  /* I */
+
+  {
+  int enable;
+
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, value);
+
+  if ((enable = setbool(value)) != -1)
+    MOMCopyVerify = enable;
+
+  return(1);
+  }  /* END setcopyverify() */
+
+
+
+
 u_long addclient(
 
   const char *name)  /* I */
@@ -2112,6 +2205,30 @@ unsigned long jobstartblocktime(
 
 
 
+unsigned long setmaxconcurrentlaunches(
+
+  const char *value)  /* I */
+
+  {
+  int i;
+
+  log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, value);
+
+  i = (int)strtol(value, NULL, 10);
+
+  if (i < 1)
+    {
+    return(0);  /* error */
+    }
+
+  max_concurrent_launches = i;
+
+  return(1);
+  }  /* END setmaxconcurrentlaunches() */
+
+
+
+
 
 unsigned long setstatusupdatetime(
 
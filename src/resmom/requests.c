@@ -120,6 +120,7 @@
 #include "tcp.h" /* tcp_chan */
 #include "mom_config.h"
 #include "power_state.hpp"
+#include "mom_copy.h"
 
 #ifdef _CRAY
 #include <sys/category.h>
@@ -1625,8 +1626,11 @@ void req_modifyjob(
 
     job_attr_def[i].at_free(pattr + i);
 
-    if ((newattr[i].at_type == ATR_TYPE_LIST) ||
-        (newattr[i].at_type == ATR_TYPE_RESC))
+    if (newattr[i].at_type == ATR_TYPE_RESC)
+      {
+      move_resc_list(&newattr[i], pattr + i);
+      }
+    else if (newattr[i].at_type == ATR_TYPE_LIST)
       {
       list_move(&newattr[i].at_val.at_list, &(pattr + i)->at_val.at_list);
       }
@@ -3238,6 +3242,146 @@ static int sys_copy(
 
 
 
+/*
+ * undo_failed_copy - clean up after a file of a copy request could not be copied
+ *
+ * Staged in files are all removed, and output which couldn't be copied out
+ * of the spool is moved to the undelivered directory.
+ */
+
+static void undo_failed_copy(
+
+  struct batch_request  *preq,
+  int                    dir,
+  int                    from_spool,
+  const char            *fp_local,
+  char                 **bad_list)
+
+  {
+#if NO_SPOOL_OUTPUT == 0
+  char localname[MAXPATHLEN + 1];
+  char undelname[MAXPATHLEN + 1];
+#endif /* !NO_SPOOL_OUTPUT */
+
+  if ((dir == STAGE_DIR_IN) || (dir == CKPT_DIR_IN))
+    {
+    /* delete the stage_in files that were just copied in */
+
+    /* NOTE:  running as user in user homedir */
+
+    del_files(preq, NULL, 1, bad_list);
+
+#if NO_SPOOL_OUTPUT == 0
+    }
+  else if (from_spool == 1)
+    {
+    /* copy out of spool */
+
+    /* Copying out files and in spool area ... */
+    /* move to "undelivered" directory         */
+    snprintf(localname, sizeof(localname), "%s", path_spool);
+    strncat(localname, fp_local, (sizeof(localname) - strlen(localname) - 1));
+    snprintf(undelname, sizeof(undelname), "%s", path_undeliv);
+    strncat(undelname, fp_local, (sizeof(undelname) - strlen(undelname) - 1));
+
+    if (rename(localname, undelname) == 0)
+      {
+      add_bad_list(bad_list, output_retained, 1);
+      add_bad_list(bad_list, undelname, 0);
+      }
+    else
+      {
+      sprintf(log_buffer, "Unable to rename %s to %s",
+              localname,
+              undelname);
+
+      log_err(errno, __func__, log_buffer);
+      }
+
+#endif /* !NO_SPOOL_OUTPUT */
+    }
+  }  /* END undo_failed_copy() */
+
+
+
+
+/*
+ * remove_copied_file - remove the local copy of a file which has been
+ * copied out
+ *
+ * @return PBSE_NONE or -1 if it couldn't be removed
+ */
+
+static int remove_copied_file(
+
+  int     dir,
+  char   *localname,
+  char  **bad_list)
+
+  {
+  if (dir == STAGE_DIR_OUT)
+    {
+    /* have copied out, ok to remove local one */
+
+    if (remtree(localname) < 0)
+      {
+      sprintf(log_buffer, msg_err_unlink,
+              "stage out",
+              localname);
+
+      log_err(errno, __func__, log_buffer);
+
+      add_bad_list(bad_list, log_buffer, 2);
+
+      return(-1);
+      }
+    }
+  else if (dir == CKPT_DIR_OUT)
+    {
+    /*
+     * we need to clean up the job checkpoint file
+     * the job directory gets deleted when job is done
+     */
+
+    /*
+     * If the checkpoint file
+     * is in the the TRemChkptDirList then we do not delete since directory
+     * is remotely mounted.
+     */
+    if (in_remote_checkpoint_dir(localname))
+      {
+      return(PBSE_NONE);
+      }
+
+    if (LOGLEVEL >= 7)
+      {
+      sprintf(log_buffer,"removing checkpoint file (%s)\n", localname);
+      log_ext(-1, __func__, log_buffer, LOG_DEBUG);
+      }
+
+    /* have copied out, ok to remove local one */
+
+    if (remtree(localname) < 0)
+      {
+      sprintf(log_buffer, msg_err_unlink,
+              "checkpoint",
+              localname);
+
+      log_err(errno, __func__, log_buffer);
+
+      add_bad_list(bad_list, log_buffer, 2);
+
+      return(-1);
+      }
+    }
+
+  return(PBSE_NONE);
+  }  /* END remove_copied_file() */
+
+
+
+
+
 /*
  * req_cpyfile - process the Copy Files request from the server to dispose
  * of output from the job.  This is done by a child of MOM since it
@@ -3289,9 +3433,6 @@ void req_cpyfile(
   char           *prmt;
   int             rc;
   int             rmtflag = 0;
-#if NO_SPOOL_OUTPUT == 0
-  char            undelname[MAXPATHLEN + 1];
-#endif /* !NO_SPOOL_OUTPUT */
 
 #ifdef  _CRAY
   char            tmpdirname[MAXPATHLEN + 1];
@@ -3308,6 +3449,8 @@ void req_cpyfile(
 
   job            *pjob = NULL;
 
+  std::vector<mom_copy> local_copies;  /* copied after the loop, several at a time */
+
 #ifdef HAVE_WORDEXP
   int             madefaketmpdir = 0;
   int             usedfaketmpdir = 0;
@@ -3343,6 +3486,10 @@ void req_cpyfile(
     log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, preq->rq_ind.rq_cpyfile.rq_jobid, log_buffer);
     }
 
+  /* the copy children share the copy slots */
+  if (mom_copy_init(MOMCopyStreams) != PBSE_NONE)
+    log_err(errno, __func__, (char *)"cannot map copy slots, local copies will not be limited");
+
   rc = (int)fork_to_user(preq, TRUE, HDir, EMsg);
 
   if (rc < 0)
@@ -3883,7 +4030,23 @@ nextword:
       continue;
       }
 
-    if ((rc = sys_copy(rmtflag, arg2, arg3, preq->rq_conn)) != 0)
+    if ((rmtflag == 0) && (MOMCopyStreams > 0))
+      {
+      /* local and usecp copies are made in-process once every file is known */
+      mom_copy mc;
+
+      mc.source = arg2;
+      mc.dest = arg3;
+      if ((dir == STAGE_DIR_OUT) || (dir == CKPT_DIR_OUT))
+        mc.localname = localname;
+
+      mc.fp_local = pair->fp_local;
+      mc.from_spool = from_spool;
+      mc.rc = PBSE_NONE;
+
+      local_copies.push_back(mc);
+      }
+    else if ((rc = sys_copy(rmtflag, arg2, arg3, preq->rq_conn)) != 0)
       {
       FILE *fp;
 
@@ -3923,43 +4086,7 @@ nextword:
 
 
 error:
-      if ((dir == STAGE_DIR_IN) || (dir == CKPT_DIR_IN))
-        {
-        /* delete the stage_in files that were just copied in */
-
-        /* NOTE:  running as user in user homedir */
-
-        del_files(preq, NULL, 1, &bad_list);
-
-#if NO_SPOOL_OUTPUT == 0
-        }
-      else if (from_spool == 1)
-        {
-        /* copy out of spool */
-
-        /* Copying out files and in spool area ... */
-        /* move to "undelivered" directory         */
-        snprintf(localname, sizeof(localname), "%s", path_spool);
-        strncat(localname, pair->fp_local, (sizeof(localname) - strlen(localname) - 1));
-        snprintf(undelname, sizeof(undelname), "%s", path_undeliv);
-        strncat(undelname, pair->fp_local, (sizeof(undelname) - strlen(undelname) - 1));
-
-        if (rename(localname, undelname) == 0)
-          {
-          add_bad_list(&bad_list, output_retained, 1);
-          add_bad_list(&bad_list, undelname, 0);
-          }
-        else
-          {
-          sprintf(log_buffer, "Unable to rename %s to %s",
-                  localname,
-                  undelname);
-
-          log_err(errno, __func__, log_buffer);
-          }
-
-#endif /* !NO_SPOOL_OUTPUT */
-        }
+      undo_failed_copy(preq, dir, from_spool, (pair != NULL) ? pair->fp_local : NULL, &bad_list);
 
       if ((dir == STAGE_DIR_IN) || (dir == CKPT_DIR_IN))
         {
@@ -3978,73 +4105,67 @@ error:
         log_ext(-1, __func__, log_buffer, LOG_DEBUG);
         }
 
-      if (dir == STAGE_DIR_OUT)
-        {
-        /* have copied out, ok to remove local one */
+      if (remove_copied_file(dir, localname, &bad_list) != PBSE_NONE)
+        bad_files = 1;
+      }
 
-        if (remtree(localname) < 0)
-          {
-          sprintf(log_buffer, msg_err_unlink,
-                  "stage out",
-                  localname);
+    unlink(rcperr);
+
+#ifdef HAVE_WORDEXP
 
-          log_err(errno, __func__, log_buffer);
+    if (!wordexperr)
+      goto nextword;  /* ugh, it's hard to use a real loop when your feature is #ifdef's out */
+
+#endif
+    }  /* END for (pair) */
 
+  /* a failed stage in has already removed what was staged in */
 
-          add_bad_list(&bad_list, log_buffer, 2);
+  if ((!local_copies.empty()) &&
+      ((bad_files == 0) || ((dir != STAGE_DIR_IN) && (dir != CKPT_DIR_IN))))
+    {
+    copy_paths(local_copies, MOMCopyStreams, MOMCopyVerify);
 
-          bad_files = 1;
-          }
-        }
-      else if (dir == CKPT_DIR_OUT)
+    for (unsigned int i = 0; i < local_copies.size(); i++)
+      {
+      mom_copy &mc = local_copies[i];
+
+      if (mc.rc != PBSE_NONE)
         {
-        /*
-         * we need to clean up the job checkpoint file
-         * the job directory gets deleted when job is done
-         */
+        bad_files = 1;
 
-        /*
-         * If the checkpoint file
-         * is in the the TRemChkptDirList then we do not delete since directory
-         * is remotely mounted.
-         */
-        if (in_remote_checkpoint_dir(localname))
-          {
-          continue;
-          }
+        snprintf(log_buffer, sizeof(log_buffer), "Unable to copy file %s to %s, error %d",
+          mc.source.c_str(),
+          mc.dest.c_str(),
+          mc.rc);
 
-        if (LOGLEVEL >= 7)
-          {
-          sprintf(log_buffer,"removing checkpoint file (%s)\n", localname);
-          log_ext(-1, __func__, log_buffer, LOG_DEBUG);
-          }
+        add_bad_list(&bad_list, log_buffer, 2);
 
-        /* have copied out, ok to remove local one */
+        log_err(-1, __func__, log_buffer);
 
-        if (remtree(localname) < 0)
-          {
-          sprintf(log_buffer, msg_err_unlink,
-                  "checkpoint",
-                  localname);
+        add_bad_list(&bad_list, (char *)"*** error from copy", 1);
+        add_bad_list(&bad_list, (char *)mc.error.c_str(), 1);
+        add_bad_list(&bad_list, (char *)"*** end error output", 1);
 
-          log_err(errno, __func__, log_buffer);
+        undo_failed_copy(preq, dir, mc.from_spool, mc.fp_local.c_str(), &bad_list);
 
-          add_bad_list(&bad_list, log_buffer, 2);
+        if ((dir == STAGE_DIR_IN) || (dir == CKPT_DIR_IN))
+          break;
+        }
+      else
+        {
+        if (LOGLEVEL >= 7)
+          {
+          sprintf(log_buffer,"copy succeeded (%s) from (%s) to (%s)\n",
+            (dir == 0)? "In" : "Out", mc.source.c_str(), mc.dest.c_str());
+          log_ext(-1, __func__, log_buffer, LOG_DEBUG);
+          }
 
+        if (remove_copied_file(dir, (char *)mc.localname.c_str(), &bad_list) != PBSE_NONE)
           bad_files = 1;
-          }
         }
       }
-
-    unlink(rcperr);
-
-#ifdef HAVE_WORDEXP
-
-    if (!wordexperr)
-      goto nextword;  /* ugh, it's hard to use a real loop when your feature is #ifdef's out */
-
-#endif
-    }  /* END for (pair) */
+    }
 
 #ifdef HAVE_WORDEXP
   if (madefaketmpdir && !usedfaketmpdir)
@@ -139,6 +139,9 @@ extern "C"
 #ifdef PENABLE_LINUX26_CPUSETS
   #include "pbs_cpuset.h"
 #endif
+#ifdef __linux__
+  #include "pbs_cgroup.h"
+#endif
 #ifdef HAVE_WORDEXP
 #include <wordexp.h>
 #endif /* HAVE_WORDEXP */
@@ -344,6 +347,8 @@ int allocate_demux_sockets(job *pjob, int flag);
 
 static int search_env_and_open(const char *, u_long);
 extern int TMOMJobGetStartInfo(job *, pjobexec_t **);
+extern int TMOMStartsPending(void);
+extern int TMOMWaitForStarting(int);
 extern int mom_reader(int, int);
 extern int mom_writer(int, int);
 extern int x11_create_display(int, char *, char *phost, int pport, char *homedir, char *x11authstr);
@@ -4351,6 +4356,17 @@ int TMomFinalizeChild(
 
 #endif  /* (PENABLE_LINUX26_CPUSETS) */
 
+#ifdef __linux__
+  /* Move this mom process into the job's cgroup so the job is accounted there. */
+
+  if ((cgroup_accounting_enabled() == true) &&
+      (move_to_job_cgroup(getpid(), pjob->ji_qs.ji_jobid) != PBSE_NONE))
+    {
+    sprintf(log_buffer, "cannot move to cgroup of job %s", pjob->ji_qs.ji_jobid);
+    log_err(errno, __func__, log_buffer);
+    }
+#endif /* __linux__ */
+
   if (site_job_setup(pjob) != 0)
     {
     /* FAILURE */
@@ -5386,6 +5402,15 @@ int start_process(
     }
 #endif  /* (PENABLE_LINUX26_CPUSETS) */
 
+#ifdef __linux__
+  if ((cgroup_accounting_enabled() == true) &&
+      (move_to_job_cgroup(getpid(), pjob->ji_qs.ji_jobid) != PBSE_NONE))
+    {
+    sprintf(log_buffer, "cannot move to cgroup of job %s", pjob->ji_qs.ji_jobid);
+    log_err(errno, __func__, log_buffer);
+    }
+#endif /* __linux__ */
+
   if (pjob->ji_numnodes > 1)
     {
     /*
@@ -8952,7 +8977,12 @@ int expand_path(
 
 
 /* exec_job_on_ms starts the execution of a job on the
-   mother superior node */
+   mother superior node.
+
+   Up to max_concurrent_launches jobs are launched at once.  The prologues,
+   nodes file and user environment of each job are set up by its own starter,
+   so when launches overlap the job is left for TMOMScanForStarting() to
+   finish once its starter reports back instead of being waited on here. */
 
 int exec_job_on_ms(
 
@@ -8963,9 +8993,29 @@ int exec_job_on_ms(
   int          Count;
   int          RC;
   int          SC;
+  int          pending;
+  long         block_time;
   char         log_buffer[LOG_BUF_SIZE];
 
-  TMOMJobGetStartInfo(NULL, &TJE);
+  /* finish earlier launches until there is room for this one */
+
+  while ((pending = TMOMStartsPending()) >= max_concurrent_launches)
+    {
+    if ((TMOMWaitForStarting(TJobStartBlockTime) == 0) ||
+        (TMOMStartsPending() >= pending))
+      break;
+    }
+
+  if (TMOMJobGetStartInfo(NULL, &TJE) == FAILURE)
+    {
+    sprintf(log_buffer, "job %s cannot start, too many jobs are starting, server will retry",
+      pjob->ji_qs.ji_jobid);
+    log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, __func__, log_buffer);
+
+    exec_bail(pjob, JOB_EXEC_RETRY);
+
+    return(JOB_EXEC_RETRY);
+    }
 
   if (TMomFinalizeJob1(pjob, TJE, &SC) == FAILURE)
     {
@@ -8999,14 +9049,20 @@ int exec_job_on_ms(
     return(SC);
     }
 
-  /* block, wait for child to complete indicating success/failure of job launch */
+  /* block, wait for child to complete indicating success/failure of job launch,
+     unless launches overlap */
+
+  if (max_concurrent_launches > 1)
+    block_time = 0;
+  else
+    block_time = TJobStartBlockTime;
 
-  if (TMomCheckJobChild(TJE, TJobStartBlockTime, &Count, &RC) == FAILURE)
+  if (TMomCheckJobChild(TJE, block_time, &Count, &RC) == FAILURE)
     {
     if (LOGLEVEL >= 3)
       {
       sprintf(log_buffer, "job not ready after %ld second timeout, MOM will check later",
-          TJobStartBlockTime);
+          block_time);
 
       log_record(PBSEVENT_SYSTEM, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buffer);
       }
@@ -120,6 +120,7 @@
 #define PARSE_MAX_STARVE "max_starve"
 #define PARSE_SORT_QUEUES "sort_queues"
 #define PARSE_IGNORE_QUEUE "ignore_queue"
+#define PARSE_JOB_RESYNC_TIME "job_resync_time"
 
 /* max sizes */
 #define MAX_HOLIDAY_SIZE 50
@@ -469,6 +469,7 @@ unsigned non_prime_lbrr:
   group_info *group_root;  /* root of group_info tree */
   time_t half_life;   /* half-life time in seconds */
   time_t sync_time;   /* time between syncing usage to disk */
+  time_t job_resync_time;  /* time between statusing every job, 0 for never */
 
   struct t prime[HIGH_DAY][HIGH_PRIME]; /* prime time start and prime time end*/
   int holidays[MAX_HOLIDAY_SIZE]; /* holidays in julian date */
@@ -138,28 +138,12 @@ const struct sort_info sorting_info[] =
   {MULTI_SORT, "multi_sort", multi_sort}
   };
 
-/*
- * res_to_get - resources to get from each nodes mom
- */
-const char *res_to_get[] =
-  {
-  "ncpus",  /* number of CPUS */
-  "arch",  /* the architecture of the machine */
-  "physmem",  /* the amount of physical memory */
-  "loadave",  /* the current load average */
-  "max_load",  /* static max_load value */
-  "ideal_load"  /* static ideal_load value */
-  };
-
 /* number of indicies in the res_to_check array */
 const int num_res = sizeof(res_to_check) / sizeof(struct rescheck);
 
 /* number of indicies in the sorting_info array */
 const int num_sorts = sizeof(sorting_info) / sizeof(struct sort_info);
 
-/* number of indicies in the res_to_get array */
-const int num_resget = sizeof(res_to_get) / sizeof(char *);
-
 
 struct config conf;
 
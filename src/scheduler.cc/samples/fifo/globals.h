@@ -90,16 +90,12 @@ extern const struct rescheck res_to_check[];
 
 extern const struct sort_info sorting_info[];
 
-/* info to get from mom */
-extern const char *res_to_get[];
-
 extern struct config conf;
 
 extern struct status cstat;
 
 extern const int num_sorts;
 extern const int num_res;
-extern const int num_resget;
 
 /* Variables from pbs_sched code */
 extern int pbs_rm_port;
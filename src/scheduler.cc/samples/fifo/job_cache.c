@@ -0,0 +1,360 @@
+#include "license_pbs.h" /* See here for the software license */
+/*
+ * job_cache.c - the scheduler's copy of the server's job status
+ *
+ * Instead of statusing every job in every queue each cycle, the scheduler
+ * keeps the status the server last sent for each job and only asks for the
+ * jobs which changed since then (see DELTASTATUS in pbs_statjob(3)).  The
+ * job_info structures are still built from these each cycle, since a cycle
+ * changes them as it goes.
+ *
+ * Running jobs are statused every cycle whatever the delta says, since
+ * fair share and the time left on a job go by their resources_used.
+ *
+ * Every job is statused again when the server can't say what changed
+ * (delta_full), when a status fails, when the server doesn't know about
+ * delta status, and every job_resync_time in case a job changed without
+ * the server noting it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include "pbs_ifl.h"
+#include "log.h"
+#include "job_cache.h"
+#include "config.h"
+#include "misc.h"
+#include "globals.h"
+#include "../lib/Libifl/lib_ifl.h"
+
+
+typedef struct cached_job
+  {
+  unsigned long        order;   /* where the server listed it */
+  std::string          queue;
+  struct batch_status *status;  /* the job's last status */
+  } cached_job;
+
+typedef std::map<unsigned long, struct batch_status *> cached_queue;
+
+/* job name -> job */
+static std::map<std::string, cached_job>   cached_jobs;
+
+/* queue name -> the queue's jobs in the order the server listed them */
+static std::map<std::string, cached_queue> cached_queues;
+
+static unsigned long      next_order = 0;
+static unsigned long long cache_seq = 0;        /* delta sequence to ask from, 0 for all jobs */
+static time_t             last_full_status = 0;
+
+
+/*
+ *
+ * find_status_value - find an attribute's value in a batch_status
+ *
+ *   bs   - the batch_status
+ *   name - the attribute
+ *
+ * returns the value or NULL if the attribute isn't there
+ *
+ */
+static char *find_status_value(struct batch_status *bs, const char *name)
+  {
+  struct attrl *attrp;
+
+  for (attrp = bs -> attribs; attrp != NULL; attrp = attrp -> next)
+    {
+    if (!strcmp(attrp -> name, name))
+      return attrp -> value;
+    }
+
+  return NULL;
+  }
+
+/*
+ *
+ * uncache_job - remove a job from the cache
+ *
+ *   name - the job's name
+ *
+ * returns nothing
+ *
+ */
+static void uncache_job(const char *name)
+  {
+  std::map<std::string, cached_job>::iterator   job;
+  std::map<std::string, cached_queue>::iterator queue;
+
+  if ((job = cached_jobs.find(name)) == cached_jobs.end())
+    return;
+
+  if ((queue = cached_queues.find(job -> second.queue)) != cached_queues.end())
+    {
+    queue -> second.erase(job -> second.order);
+
+    if (queue -> second.empty())
+      cached_queues.erase(queue);
+    }
+
+  pbs_statfree(job -> second.status);
+
+  cached_jobs.erase(job);
+  }
+
+/*
+ *
+ * cache_job - add a job's status to the cache, replacing its old status
+ *
+ *   bs - the job's status, which now belongs to the cache
+ *
+ * returns nothing
+ *
+ */
+static void cache_job(struct batch_status *bs)
+  {
+  std::map<std::string, cached_job>::iterator job;
+  cached_job                                  cj;
+  char                                       *queue;
+
+  bs -> next = NULL;
+
+  /* a job which changed keeps its place */
+  if ((job = cached_jobs.find(bs -> name)) != cached_jobs.end())
+    {
+    cj.order = job -> second.order;
+
+    uncache_job(bs -> name);
+    }
+  else
+    cj.order = next_order++;
+
+  if ((queue = find_status_value(bs, ATTR_queue)) != NULL)
+    cj.queue = queue;
+
+  cj.status = bs;
+
+  cached_jobs[bs -> name] = cj;
+  cached_queues[cj.queue][cj.order] = bs;
+  }
+
+/*
+ *
+ * refresh_running_jobs - get the current status of the running jobs
+ *
+ *   pbs_sd - connection to pbs_server
+ *
+ * returns success/failure
+ *
+ */
+static int refresh_running_jobs(int pbs_sd)
+  {
+  struct batch_status *jobs;
+  struct batch_status *next_job;
+  struct attropl running;
+  int local_errno = 0;
+
+  running.next = NULL;
+  running.name = (char *)ATTR_state;
+  running.resource = NULL;
+  running.value = (char *)"R";
+  running.op = EQ;
+
+  if ((jobs = pbs_selstat_err(pbs_sd, &running, NULL, &local_errno)) == NULL)
+    return local_errno == 0;
+
+  /* a running job not in the cache yet comes with the next full status */
+  for (; jobs != NULL; jobs = next_job)
+    {
+    next_job = jobs -> next;
+
+    if (cached_jobs.find(jobs -> name) != cached_jobs.end())
+      cache_job(jobs);
+    else
+      {
+      jobs -> next = NULL;
+      pbs_statfree(jobs);
+      }
+    }
+
+  return 1;
+  }
+
+/*
+ *
+ * update_job_cache - bring the cached job status up to date with the
+ *                    jobs which changed on the server
+ *
+ *   pbs_sd - connection to pbs_server
+ *
+ * returns success/failure
+ *
+ * NOTE: on failure the cache is emptied so the next update gets all jobs
+ *
+ */
+int update_job_cache(int pbs_sd)
+  {
+  struct batch_status *jobs;  /* the server's reply */
+  struct batch_status *cur_job;
+  struct batch_status *next_job;
+  char extend[64];
+  char log_msg[MAX_LOG_SIZE];
+  char *value;
+  unsigned long long seq = 0; /* the sequence to ask from next time */
+  int full = 1;   /* boolean: is every job in the reply? */
+  int changed = 0;
+  int purged = 0;
+  int local_errno = 0;
+
+  if ((conf.job_resync_time > 0) &&
+      (cstat.current_time - last_full_status >= conf.job_resync_time))
+    cache_seq = 0;
+
+  snprintf(extend, sizeof(extend), "%s%llu", DELTASTATUS, cache_seq);
+
+  if ((jobs = pbs_statjob_err(pbs_sd, (char *)"", NULL, extend, &local_errno)) == NULL)
+    {
+    free_job_cache();
+
+    if (local_errno > 0)
+      {
+      fprintf(stderr, "pbs_statjob failed: %d\n", local_errno);
+      return 0;
+      }
+
+    /* no jobs from a server which doesn't do delta status */
+    last_full_status = cstat.current_time;
+
+    return 1;
+    }
+
+  cur_job = jobs;
+
+  /* a delta status starts with an entry for the server */
+  if ((value = find_status_value(jobs, ATTR_delta_seq)) != NULL)
+    {
+    seq = strtoull(value, NULL, 10);
+
+    value = find_status_value(jobs, ATTR_delta_full);
+    full = (value == NULL) || !strcmp(value, "True");
+
+    cur_job = jobs -> next;
+    jobs -> next = NULL;
+    pbs_statfree(jobs);
+
+    /* the server's sequence went backwards, so what we have can't be trusted */
+    if (!full && seq < cache_seq)
+      {
+      pbs_statfree(cur_job);
+      free_job_cache();
+
+      sched_log(PBSEVENT_DEBUG, PBS_EVENTCLASS_SERVER, "",
+        "job status sequence went backwards, getting all jobs");
+
+      return update_job_cache(pbs_sd);
+      }
+    }
+
+  if (full)
+    {
+    free_job_cache();
+    last_full_status = cstat.current_time;
+    }
+
+  for (; cur_job != NULL; cur_job = next_job)
+    {
+    next_job = cur_job -> next;
+    cur_job -> next = NULL;
+
+    if (((value = find_status_value(cur_job, ATTR_delta_purged)) != NULL) &&
+        !strcmp(value, "True"))
+      {
+      uncache_job(cur_job -> name);
+      pbs_statfree(cur_job);
+      purged++;
+      }
+    else
+      {
+      cache_job(cur_job);
+      changed++;
+      }
+    }
+
+  cache_seq = seq;
+
+  if (!full && !refresh_running_jobs(pbs_sd))
+    {
+    free_job_cache();
+
+    fprintf(stderr, "pbs_selstat of running jobs failed\n");
+    return 0;
+    }
+
+  snprintf(log_msg, sizeof(log_msg), "%s job status: %d changed, %d purged, %d cached",
+    full ? "Full" : "Delta", changed, purged, (int)cached_jobs.size());
+  sched_log(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER, "", log_msg);
+
+  return 1;
+  }
+
+/*
+ *
+ * query_cached_jobs - get the cached status of the jobs in a queue
+ *
+ *   queue - the queue's name
+ *
+ * returns a NULL terminated array of the jobs' status in the order the
+ * server listed them, or NULL on error.  The array must be freed but the
+ * status in it belongs to the cache.
+ *
+ */
+struct batch_status **query_cached_jobs(const char *queue)
+  {
+  std::map<std::string, cached_queue>::iterator cq;
+  cached_queue::iterator                        job;
+  struct batch_status **jobs;
+  int num_jobs = 0;
+  int i = 0;
+
+  if ((cq = cached_queues.find(queue)) != cached_queues.end())
+    num_jobs = cq -> second.size();
+
+  if ((jobs = (struct batch_status **) malloc(sizeof(struct batch_status *) * (num_jobs + 1))) == NULL)
+    {
+    perror("Memory allocation error");
+    return NULL;
+    }
+
+  if (num_jobs > 0)
+    {
+    for (job = cq -> second.begin(); job != cq -> second.end(); job++)
+      jobs[i++] = job -> second;
+    }
+
+  jobs[i] = NULL;
+
+  return jobs;
+  }
+
+/*
+ *
+ * free_job_cache - forget every cached job so the next update gets all
+ *                  of them
+ *
+ * returns nothing
+ *
+ */
+void free_job_cache(void)
+  {
+  std::map<std::string, cached_job>::iterator job;
+
+  for (job = cached_jobs.begin(); job != cached_jobs.end(); job++)
+    pbs_statfree(job -> second.status);
+
+  cached_jobs.clear();
+  cached_queues.clear();
+
+  cache_seq = 0;
+  }
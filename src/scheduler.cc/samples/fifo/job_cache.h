@@ -0,0 +1,24 @@
+#ifndef JOB_CACHE_H
+#define JOB_CACHE_H
+#include "license_pbs.h" /* See here for the software license */
+
+#include "pbs_ifl.h"
+
+/*
+ *      update_job_cache - bring the cached job status up to date with the
+ *                         jobs which changed on the server
+ */
+int update_job_cache(int pbs_sd);
+
+/*
+ *      query_cached_jobs - get the cached status of the jobs in a queue
+ */
+struct batch_status **query_cached_jobs(const char *queue);
+
+/*
+ *      free_job_cache - forget every cached job so the next update gets
+ *                       all of them
+ */
+void free_job_cache(void);
+
+#endif
@@ -84,7 +84,6 @@
 #include <sys/types.h>
 #include "pbs_ifl.h"
 #include "log.h"
-#include "rm.h"
 #include "node_info.h"
 #include "misc.h"
 #include "globals.h"
@@ -153,9 +152,6 @@ node_info **query_nodes(int pbs_sd, server_info *sinfo)
       return NULL;
       }
 
-    /* query mom on the node for resources */
-    talk_with_mom(ninfo);
-
     ninfo_arr[i] = ninfo;
 
     cur_node = cur_node -> next;
@@ -183,6 +179,7 @@ node_info *query_node_info(struct batch_status *node, server_info *sinfo)
   node_info *ninfo;  /* the new node_info */
 
   struct attrl *attrp;  /* used to cycle though attribute list */
+  char *status = NULL;  /* the node's status attribute */
 
   if ((ninfo = new_node_info()) == NULL)
     return NULL;
@@ -211,9 +208,17 @@ node_info *query_node_info(struct batch_status *node, server_info *sinfo)
     else if (!strcmp(attrp -> name, ATTR_NODE_ntype))
       set_node_type(ninfo, attrp -> value);
 
+    /* the resources mom last reported to the server */
+    else if (!strcmp(attrp -> name, ATTR_NODE_status))
+      status = attrp -> value;
+
     attrp = attrp -> next;
     }
 
+  /* the state may come after the status */
+  if (!ninfo -> is_down && !ninfo -> is_offline)
+    set_node_status(ninfo, status);
+
   return ninfo;
   }
 
@@ -403,107 +408,106 @@ int set_node_state(node_info *ninfo, char *state)
 
 /*
  *
- *      talk_with_mom - talk to mom and get resources
+ *      set_node_status - set the node's resources from the status its mom
+ *                        last reported to the server
  *
- *   ninfo - the node to to talk to its mom
+ *   ninfo  - the node
+ *   status - the node's status attribute, a comma separated list of
+ *            name=value pairs
  *
  * returns non-zero on error
  *
  */
 
-int talk_with_mom(
+int set_node_status(
 
-  node_info *ninfo)
+  node_info *ninfo,
+  char      *status)
 
   {
-  int mom_sd;   /* connection descriptor to mom */
-  char *mom_ans;  /* the answer from mom - getreq() */
-  char *endp;   /* used with strtol() */
+  char **items;   /* the name=value pairs */
+  char  *value;
+  char  *endp;   /* used with strtol() */
   double testd;   /* used to convert string -> double */
-  int testi;   /* used to convert string -> int */
-  char errbuf[256];
-  int i;
-  int local_errno = 0;
+  int    testi;   /* used to convert string -> int */
+  int    have_max_load = 0;
+  int    have_ideal_load = 0;
+  int    i;
+
+  if ((ninfo == NULL) || (status == NULL))
+    return 1;
 
-  if ((ninfo != NULL) && !ninfo->is_down && !ninfo->is_offline)
+  if ((items = break_comma_list(status)) == NULL)
+    return 1;
+
+  for (i = 0; items[i] != NULL; i++)
     {
-    if ((mom_sd = openrm(ninfo -> name, pbs_rm_port)) < 0)
-      {
-      sched_log(PBSEVENT_SYSTEM, PBS_EVENTCLASS_REQUEST, ninfo -> name, "Can not open connection to mom");
-      return 1;
-      }
+    if ((value = strchr(items[i], '=')) == NULL)
+      continue;
 
-    if(begin_rm_req(mom_sd,&local_errno,num_resget) != 0)
-      {
-      closerm_err(&local_errno, mom_sd);
-      return 0;
-      }
-    for (i = 0; i < num_resget; i++)
-      addreq_err(mom_sd, &local_errno, (char *) res_to_get[i]);
+    *value++ = '\0';
 
-    for (i = 0; i < num_resget && (mom_ans = getreq_err(&local_errno, (mom_sd))) != NULL; i++)
+    if (!strcmp(items[i], "max_load"))
       {
-      if (!strcmp(res_to_get[i], "max_load"))
-        {
-        testd = strtod(mom_ans, &endp);
-
-        if (*endp == '\0')
-          ninfo -> max_load = testd;
-        else
-          ninfo -> max_load = ninfo -> ncpus;
+      testd = strtod(value, &endp);
 
-        free(mom_ans);
-        }
-      else if (!strcmp(res_to_get[i], "ideal_load"))
+      if (*endp == '\0')
         {
-        testd = strtod(mom_ans, &endp);
-
-        if (*endp == '\0')
-          ninfo -> ideal_load = testd;
-        else
-          ninfo -> ideal_load = ninfo -> ncpus;
-
-        free(mom_ans);
+        ninfo -> max_load = testd;
+        have_max_load = 1;
         }
-      else if (!strcmp(res_to_get[i], "arch"))
-        ninfo -> arch = mom_ans;
-      else if (!strcmp(res_to_get[i], "ncpus"))
-        {
-        testi = strtol(mom_ans, &endp, 10);
-
-        if (*endp == '\0')
-          ninfo -> ncpus = testi;
-        else
-          ninfo -> ncpus = 1;
+      }
+    else if (!strcmp(items[i], "ideal_load"))
+      {
+      testd = strtod(value, &endp);
 
-        free(mom_ans);
-        }
-      else if (!strcmp(res_to_get[i], "physmem"))
+      if (*endp == '\0')
         {
-        ninfo -> physmem = res_to_num(mom_ans);
-        free(mom_ans);
+        ninfo -> ideal_load = testd;
+        have_ideal_load = 1;
         }
-      else if (!strcmp(res_to_get[i], "loadave"))
-        {
-        testd = strtod(mom_ans, &endp);
+      }
+    else if (!strcmp(items[i], "arch"))
+      {
+      if (ninfo -> arch != NULL)
+        free(ninfo -> arch);
 
-        if (*endp == '\0')
-          ninfo -> loadave = testd;
-        else
-          ninfo -> loadave = -1.0;
+      ninfo -> arch = string_dup(value);
+      }
+    else if (!strcmp(items[i], "ncpus"))
+      {
+      testi = strtol(value, &endp, 10);
 
-        free(mom_ans);
-        }
+      if (*endp == '\0')
+        ninfo -> ncpus = testi;
       else
-        {
-        sprintf(errbuf, "Unknown resource value[%d]: %s", i, mom_ans);
-        sched_log(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, ninfo -> name, errbuf);
-        }
+        ninfo -> ncpus = 1;
+      }
+    else if (!strcmp(items[i], "physmem"))
+      {
+      ninfo -> physmem = res_to_num(value);
       }
+    else if (!strcmp(items[i], "loadave"))
+      {
+      testd = strtod(value, &endp);
 
-    closerm_err(&local_errno, mom_sd);
+      if (*endp == '\0')
+        ninfo -> loadave = testd;
+      else
+        ninfo -> loadave = -1.0;
+      }
     }
 
+  /* moms which don't report a load limit are limited by their cpus */
+
+  if (!have_max_load)
+    ninfo -> max_load = ninfo -> ncpus;
+
+  if (!have_ideal_load)
+    ninfo -> ideal_load = ninfo -> ncpus;
+
+  free_string_array(items);
+
   return 0;
   }
 
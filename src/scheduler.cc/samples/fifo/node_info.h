@@ -116,9 +116,9 @@ void free_node_info(node_info *ninfo);
 int set_node_state(node_info *ninfo, char *state);
 
 /*
- *      talk_with_mom - talk to mom and get resources
+ *      set_node_status - set the node's resources from its mom's status
  */
-int talk_with_mom(node_info *ninfo);
+int set_node_status(node_info *ninfo, char *status);
 
 /*
  *      node_filter - filter a node array and return a new filterd array
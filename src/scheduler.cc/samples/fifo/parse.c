@@ -256,6 +256,8 @@ int parse_config(const char *fname)
           conf.half_life = res_to_num(config_value);
         else if (!strcmp(config_name, PARSE_SYNC_TIME))
           conf.sync_time = res_to_num(config_value);
+        else if (!strcmp(config_name, PARSE_JOB_RESYNC_TIME))
+          conf.job_resync_time = res_to_num(config_value);
         else if (!strcmp(config_name, PARSE_UNKNOWN_SHARES))
           conf.unknown_shares = num;
         else if (!strcmp(config_name, PARSE_LOG_FILTER))
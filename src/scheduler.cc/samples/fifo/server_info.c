@@ -86,6 +86,7 @@
 #include "constant.h"
 #include "queue_info.h"
 #include "job_info.h"
+#include "job_cache.h"
 #include "misc.h"
 #include "config.h"
 #include "node_info.h"
@@ -119,6 +120,13 @@ server_info *query_server(int pbs_sd)
     return NULL;
     }
 
+  /* get the jobs which changed since the last cycle */
+  if (!update_job_cache(pbs_sd))
+    {
+    pbs_statfree(server);
+    return NULL;
+    }
+
   /* convert batch_status structure into server_info structure */
   if ((sinfo = query_server_info(server)) == NULL)
     {
@@ -121,6 +121,10 @@ static int           acct_opened_day;
 static int           acct_auto_switch = 0;
 pthread_mutex_t     *acctfile_mutex;
 
+/* records held by account_batch_begin() */
+static __thread std::string *acct_batch = NULL;
+static __thread int          acct_batch_depth = 0;
+
 /* Global Data */
 
 extern attribute_def job_attr_def[];
@@ -417,28 +421,21 @@ void acct_close(
 
 
 /*
- * account_record - write basic accounting record
+ * acct_switch_file - open the accounting file or switch to the day's new one
+ *
+ * NOTE: acctfile_mutex must be held
  */
 
-void account_record(
+static void acct_switch_file(
 
-  int         acctype, /* accounting record type */
-  job        *pjob,
-  const char *text)  /* text to log, may be null */
+  struct tm *ptm)
 
   {
-  time_t     time_now = time(NULL);
-  struct tm *ptm;
-  struct tm  tmpPtm;
-
-  pthread_mutex_lock(acctfile_mutex);
   if (acct_opened == 0)
     {
     acct_open(acct_file, true);
     }
 
-  ptm = localtime_r(&time_now,&tmpPtm);
-
   /* Do we need to switch files */
 
   if ((acct_auto_switch != 0) &&
@@ -448,20 +445,163 @@ void account_record(
 
     acct_open(NULL, true);
     }
+  } /* END acct_switch_file() */
+
+
+
+
+/*
+ * account_batch_begin - hold this thread's accounting records in memory
+ * until account_batch_end() so a batch of them is written at once
+ *
+ * Calls may nest, only the outermost account_batch_end() writes.
+ */
+
+void account_batch_begin()
+
+  {
+  if (acct_batch_depth++ == 0)
+    acct_batch = new std::string();
+  } /* END account_batch_begin() */
+
+
+
+
+/*
+ * account_batch_end - write the records held since account_batch_begin()
+ * with one write
+ */
+
+void account_batch_end()
+
+  {
+  std::string records;
+
+  if (acct_batch_depth > 1)
+    {
+    acct_batch_depth--;
+    return;
+    }
+
+  account_batch_detach(records);
+  account_batch_write(records);
+  } /* END account_batch_end() */
+
+
+
+
+/*
+ * account_batch_detach - end this thread's batch like account_batch_end(),
+ * but hand its records to the caller instead of writing them so several
+ * threads' records can go out in one account_batch_write()
+ */
+
+void account_batch_detach(
+
+  std::string &records) /* O */
+
+  {
+  records.clear();
+
+  if ((acct_batch_depth == 0) ||
+      (--acct_batch_depth > 0))
+    return;
+
+  records.swap(*acct_batch);
+
+  delete acct_batch;
+  acct_batch = NULL;
+  } /* END account_batch_detach() */
+
+
+
+
+/*
+ * account_batch_write - write records held by account_batch_detach() with
+ * one write
+ */
+
+void account_batch_write(
+
+  const std::string &records)
+
+  {
+  time_t     time_now;
+  struct tm *ptm;
+  struct tm  tmpPtm;
+
+  if (records.length() == 0)
+    return;
+
+  time_now = time(NULL);
+  ptm = localtime_r(&time_now, &tmpPtm);
+
+  pthread_mutex_lock(acctfile_mutex);
+
+  acct_switch_file(ptm);
+
+  if (acct_opened == 1)
+    fwrite(records.c_str(), 1, records.length(), acctfile);
+
+  pthread_mutex_unlock(acctfile_mutex);
+  } /* END account_batch_write() */
+
+
+
+
+/*
+ * account_record - write basic accounting record
+ *
+ * Between account_batch_begin() and account_batch_end() the record is only
+ * added to this thread's batch.
+ */
+
+void account_record(
+
+  int         acctype, /* accounting record type */
+  job        *pjob,
+  const char *text)  /* text to log, may be null */
+
+  {
+  time_t      time_now = time(NULL);
+  struct tm  *ptm;
+  struct tm   tmpPtm;
+  char        stamp[64];
+  std::string line;
+
+  ptm = localtime_r(&time_now,&tmpPtm);
 
   if (text == NULL)
     text = (char *)"";
 
-  fprintf(acctfile, "%02d/%02d/%04d %02d:%02d:%02d;%c;%s;%s\n",
+  snprintf(stamp, sizeof(stamp), "%02d/%02d/%04d %02d:%02d:%02d;%c;",
           ptm->tm_mon + 1,
           ptm->tm_mday,
           ptm->tm_year + 1900,
           ptm->tm_hour,
           ptm->tm_min,
           ptm->tm_sec,
-          (char)acctype,
-          pjob->ji_qs.ji_jobid,
-          text);
+          (char)acctype);
+
+  line = stamp;
+  line += pjob->ji_qs.ji_jobid;
+  line += ';';
+  line += text;
+  line += '\n';
+
+  if (acct_batch != NULL)
+    {
+    *acct_batch += line;
+    return;
+    }
+
+  pthread_mutex_lock(acctfile_mutex);
+
+  acct_switch_file(ptm);
+
+  if (acct_opened == 1)
+    fwrite(line.c_str(), 1, line.length(), acctfile);
+
   pthread_mutex_unlock(acctfile_mutex);
 
   return;
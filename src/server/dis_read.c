@@ -282,6 +282,14 @@ int dis_request_read(
 
       break;
 
+    case PBS_BATCH_SubmitJob:
+
+      CLEAR_HEAD(request->rq_ind.rq_queuejob.rq_attr);
+
+      rc = decode_DIS_SubmitJob(chan, request);
+
+      break;
+
     case PBS_BATCH_ModifyNode:
 
     case PBS_BATCH_Manager:
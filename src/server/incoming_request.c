@@ -131,22 +131,38 @@ int get_protocol_type(
 
 
 
+/*
+ * process_pbs_server_port - read and handle one request from sock
+ *
+ * When pchan is not NULL the read channel is kept in *pchan between calls
+ * so that bytes of a following request, read ahead into the channel's
+ * buffer, are still there for the next call.  Clients that pipeline
+ * requests (pbs_submit_bulk()) depend on this.  The caller cleans up
+ * *pchan when it is done with the socket.
+ */
+
 int process_pbs_server_port(
      
-  int   sock,
-  int   is_scheduler_port,
-  long *args)
+  int               sock,
+  int               is_scheduler_port,
+  long             *args,
+  struct tcp_chan **pchan)
  
   {
   int              protocol_type;
   int              rc = PBSE_NONE;
   char             log_buf[LOCAL_LOG_BUF_SIZE];
   struct tcp_chan *chan = NULL;
-   
-  if ((chan = DIS_tcp_setup(sock)) == NULL)
+
+  if ((pchan != NULL) &&
+      (*pchan != NULL))
+    chan = *pchan;
+  else if ((chan = DIS_tcp_setup(sock)) == NULL)
     {
     return(PBSE_MEM_MALLOC);
     }
+  else if (pchan != NULL)
+    *pchan = chan;
 
   protocol_type = get_protocol_type(chan, rc);
   
@@ -179,6 +195,9 @@ int process_pbs_server_port(
 
       // don't let this get cleaned up below
       chan = NULL;
+
+      if (pchan != NULL)
+        *pchan = NULL;
       
       break;
       }
@@ -232,7 +251,8 @@ int process_pbs_server_port(
       }
     }
 
-  if (chan != NULL)
+  if ((chan != NULL) &&
+      (pchan == NULL))
     DIS_tcp_cleanup(chan);
 
   return(rc);
@@ -246,9 +266,10 @@ void *start_process_pbs_server_port(
   void *new_sock)
 
   {
-  long *args = (long *)new_sock;
-  int sock;
-  int rc = PBSE_NONE;
+  long            *args = (long *)new_sock;
+  int              sock;
+  int              rc = PBSE_NONE;
+  struct tcp_chan *chan = NULL;
  
   sock = (int)args[0];
 
@@ -261,9 +282,12 @@ void *start_process_pbs_server_port(
     {
     netcounter_incr();
 
-    rc = process_pbs_server_port(sock, FALSE, args);
+    rc = process_pbs_server_port(sock, FALSE, args, &chan);
     }
 
+  if (chan != NULL)
+    DIS_tcp_cleanup(chan);
+
   free(new_sock);
   close_conn(sock, FALSE);
 
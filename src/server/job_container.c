@@ -81,6 +81,16 @@
 /* job_container.c contains functions for working with the all_jobs struct, 
  * such as finding a job in the server's global list, adding jobs to that
  * list, removing from it, iterating over it, etc.
+ *
+ * alljobs keeps the server's jobs in order under one mutex.  Jobs in it are
+ * also kept in the job registry, JOB_SHARDS hash tables by job id with a
+ * mutex each, so svr_find_job() doesn't contend on alljobs' mutex.
+ *
+ * A registry lookup, like next_job(), locks the job only after letting go
+ * of the container.  Job epochs keep the job from being freed in between:
+ * lookups run inside job_epoch_enter() / job_epoch_exit(), a recycled job
+ * is stamped with job_epoch_retire(), and the recycler only frees it once
+ * job_epoch_passed() says no lookup from before that is still running.
  */
 
 
@@ -96,6 +106,7 @@
 #include "svrfunc.h"
 #include "ji_mutex.h"
 #include "id_map.hpp"
+#include "job_select_index.h"
 
 
 extern char     server_name[];
@@ -104,6 +115,32 @@ extern all_jobs array_summary;
 id_map          job_mapper;
 
 
+
+typedef struct job_shard
+  {
+  pthread_mutex_t                          js_mutex;
+  boost::unordered_map<std::string, job *> js_jobs;
+  } job_shard;
+
+static job_shard       job_shards[JOB_SHARDS];
+static pthread_once_t  job_shards_once = PTHREAD_ONCE_INIT;
+
+/* a thread's current lookup, see job_epoch_enter() */
+typedef struct job_reader
+  {
+  struct job_reader           *next;
+  volatile int                 in_use;
+  volatile unsigned long long  epoch;   /* epoch the lookup started in, 0 if none */
+  } job_reader;
+
+static job_reader *volatile        job_readers = NULL;
+static volatile unsigned long long job_epoch = 1;
+static pthread_key_t               job_reader_key;
+static pthread_once_t              job_reader_once = PTHREAD_ONCE_INIT;
+static __thread job_reader        *my_reader = NULL;
+static __thread int                my_reader_depth = 0;
+
+
 /*
  * get_correct_jobname() - makes sure the job searches for the correct name
  * necessary because of SRV_ATR_display_job_server_suffix and
@@ -311,6 +348,318 @@ char *get_correct_jobname(
 
 
 
+static void release_job_reader(
+
+  void *vp)
+
+  {
+  job_reader *r = (job_reader *)vp;
+
+  r->epoch = 0;
+  __sync_lock_release(&r->in_use);
+  } /* END release_job_reader() */
+
+
+
+static void init_job_reader_key()
+
+  {
+  pthread_key_create(&job_reader_key, release_job_reader);
+  } /* END init_job_reader_key() */
+
+
+
+/*
+ * get_job_reader - this thread's job_reader, reusing one left by an exited
+ * thread if possible
+ */
+
+static job_reader *get_job_reader()
+
+  {
+  job_reader *r;
+
+  if (my_reader != NULL)
+    return(my_reader);
+
+  pthread_once(&job_reader_once, init_job_reader_key);
+
+  for (r = job_readers; r != NULL; r = r->next)
+    {
+    if (__sync_lock_test_and_set(&r->in_use, 1) == 0)
+      break;
+    }
+
+  if (r == NULL)
+    {
+    r = (job_reader *)calloc(1, sizeof(job_reader));
+    r->in_use = 1;
+
+    do
+      {
+      r->next = job_readers;
+      } while (!__sync_bool_compare_and_swap(&job_readers, r->next, r));
+    }
+
+  pthread_setspecific(job_reader_key, r);
+  my_reader = r;
+
+  return(r);
+  } /* END get_job_reader() */
+
+
+
+/*
+ * job_epoch_enter - start a lookup which may reach a job after letting go
+ * of the container it was found in.  Calls may nest.
+ */
+
+void job_epoch_enter()
+
+  {
+  job_reader *r = get_job_reader();
+
+  if (my_reader_depth++ == 0)
+    {
+    r->epoch = __sync_add_and_fetch(&job_epoch, 0);
+    __sync_synchronize();
+    }
+  } /* END job_epoch_enter() */
+
+
+
+void job_epoch_exit()
+
+  {
+  if ((my_reader_depth > 0) &&
+      (--my_reader_depth == 0))
+    {
+    __sync_synchronize();
+    my_reader->epoch = 0;
+    }
+  } /* END job_epoch_exit() */
+
+
+
+/*
+ * job_epoch_retire - start a new epoch for a job leaving the containers
+ *
+ * @return the epoch to pass to job_epoch_passed() before freeing the job
+ */
+
+unsigned long long job_epoch_retire()
+
+  {
+  return(__sync_fetch_and_add(&job_epoch, 1));
+  } /* END job_epoch_retire() */
+
+
+
+/*
+ * job_epoch_passed - check that no lookup which could have found a job
+ * retired in epoch retired is still running
+ */
+
+bool job_epoch_passed(
+
+  unsigned long long retired)
+
+  {
+  __sync_synchronize();
+
+  for (job_reader *r = job_readers; r != NULL; r = r->next)
+    {
+    unsigned long long epoch = r->epoch;
+
+    if ((epoch != 0) &&
+        (epoch <= retired))
+      return(false);
+    }
+
+  return(true);
+  } /* END job_epoch_passed() */
+
+
+
+static void init_job_shards()
+
+  {
+  for (int i = 0; i < JOB_SHARDS; i++)
+    pthread_mutex_init(&job_shards[i].js_mutex, NULL);
+  } /* END init_job_shards() */
+
+
+
+static job_shard *get_job_shard(
+
+  const char *job_id)
+
+  {
+  unsigned int hash = 2166136261U;
+
+  pthread_once(&job_shards_once, init_job_shards);
+
+  for (const char *ptr = job_id; *ptr != '\0'; ptr++)
+    {
+    hash ^= (unsigned char)*ptr;
+    hash *= 16777619U;
+    }
+
+  return(job_shards + (hash % JOB_SHARDS));
+  } /* END get_job_shard() */
+
+
+
+/*
+ * job_registry_add - make pjob findable by svr_find_job()
+ */
+
+void job_registry_add(
+
+  job *pjob)
+
+  {
+  job_shard *shard = get_job_shard(pjob->ji_qs.ji_jobid);
+
+  pthread_mutex_lock(&shard->js_mutex);
+  shard->js_jobs[pjob->ji_qs.ji_jobid] = pjob;
+  pthread_mutex_unlock(&shard->js_mutex);
+
+  job_index_add(pjob);
+  } /* END job_registry_add() */
+
+
+
+void job_registry_remove(
+
+  job *pjob)
+
+  {
+  job_shard *shard = get_job_shard(pjob->ji_qs.ji_jobid);
+
+  pthread_mutex_lock(&shard->js_mutex);
+
+  boost::unordered_map<std::string, job *>::iterator it = shard->js_jobs.find(pjob->ji_qs.ji_jobid);
+
+  if ((it != shard->js_jobs.end()) &&
+      (it->second == pjob))
+    {
+    shard->js_jobs.erase(it);
+    pthread_mutex_unlock(&shard->js_mutex);
+
+    job_index_remove(pjob);
+    return;
+    }
+
+  pthread_mutex_unlock(&shard->js_mutex);
+  } /* END job_registry_remove() */
+
+
+
+bool job_registry_has(
+
+  const char *job_id)
+
+  {
+  job_shard *shard = get_job_shard(job_id);
+  bool       found;
+
+  pthread_mutex_lock(&shard->js_mutex);
+  found = (shard->js_jobs.find(job_id) != shard->js_jobs.end());
+  pthread_mutex_unlock(&shard->js_mutex);
+
+  return(found);
+  } /* END job_registry_has() */
+
+
+
+/*
+ * finish_job_lookup - swap a locked job for its cray sub-job if asked, and
+ * drop it if it is being recycled
+ */
+
+static job *finish_job_lookup(
+
+  job *pj,
+  int  get_subjob)
+
+  {
+  if (pj != NULL)
+    {
+    if (get_subjob == TRUE)
+      {
+      if (pj->ji_cray_clone != NULL)
+        {
+        pj = pj->ji_cray_clone;
+        unlock_ji_mutex(pj->ji_parent_job, __func__, NULL, LOGLEVEL);
+        lock_ji_mutex(pj, __func__, NULL, LOGLEVEL);
+        }
+      }
+
+    if (pj->ji_being_recycled == TRUE)
+      {
+      unlock_ji_mutex(pj, __func__, "1", LOGLEVEL);
+      pj = NULL;
+      }
+    }
+
+  return(pj);
+  } /* END finish_job_lookup() */
+
+
+
+/*
+ * find_job_in_registry - find and lock a job of alljobs by id without
+ * taking alljobs' mutex
+ */
+
+job *find_job_in_registry(
+
+  const char *job_id,
+  int         get_subjob)
+
+  {
+  job_shard *shard;
+  job       *pj = NULL;
+
+  if (job_id == NULL)
+    {
+    log_err(PBSE_BAD_PARAMETER, __func__, "null job_id pointer fail");
+    return(NULL);
+    }
+
+  shard = get_job_shard(job_id);
+
+  job_epoch_enter();
+
+  pthread_mutex_lock(&shard->js_mutex);
+
+  boost::unordered_map<std::string, job *>::iterator it = shard->js_jobs.find(job_id);
+
+  if (it != shard->js_jobs.end())
+    pj = it->second;
+
+  pthread_mutex_unlock(&shard->js_mutex);
+
+  if (pj != NULL)
+    {
+    lock_ji_mutex(pj, __func__, NULL, LOGLEVEL);
+
+    /* it may have been purged and recycled before we got the lock */
+    if (strcmp(pj->ji_qs.ji_jobid, job_id))
+      {
+      unlock_ji_mutex(pj, __func__, "1", LOGLEVEL);
+      pj = NULL;
+      }
+    }
+
+  job_epoch_exit();
+
+  return(finish_job_lookup(pj, get_subjob));
+  } /* END find_job_in_registry() */
+
+
+
 /*
  * Searches the array passed in for the job_id
  * @parent svr_find_job()
@@ -348,26 +697,7 @@ job *find_job_by_array(
   if (locked == false)
     aj->unlock();
   
-  if (pj != NULL)
-    {
-    if (get_subjob == TRUE)
-      {
-      if (pj->ji_cray_clone != NULL)
-        {
-        pj = pj->ji_cray_clone;
-        unlock_ji_mutex(pj->ji_parent_job, __func__, NULL, LOGLEVEL);
-        lock_ji_mutex(pj, __func__, NULL, LOGLEVEL);
-        }
-      }
-
-    if (pj->ji_being_recycled == TRUE)
-      {
-      unlock_ji_mutex(pj, __func__, "1", LOGLEVEL);
-      pj = NULL;
-      }
-    }
-
-  return(pj);
+  return(finish_job_lookup(pj, get_subjob));
   } /* END find_job_by_array() */
 
 
@@ -457,7 +787,7 @@ job *svr_find_job(
     /* if we're searching for the external we want find_job_by_array to 
      * return the parent, but if we're searching for the cray subjob then
      * we want find_job_by_array to return the sub job */
-    pj = find_job_by_array(&alljobs, comp, (dash != NULL) ? FALSE : get_subjob, false);
+    pj = find_job_in_registry(comp, (dash != NULL) ? FALSE : get_subjob);
     }
 
   /* when remotely routing jobs, they are removed from the 
@@ -562,10 +892,18 @@ int insert_job(
     log_err(rc, __func__, "No memory to resize the array...SYSTEM FAILURE\n");
     }
   else
+    {
     rc = PBSE_NONE;
+    }
 
   aj->unlock();
 
+  /* the registry and its indexes have their own locks; keep them out from
+   * under alljobs' mutex so lookups never wait behind an insert */
+  if ((rc == PBSE_NONE) &&
+      (aj == &alljobs))
+    job_registry_add(pjob);
+
   return(rc);
   } /* END insert_job() */
 
@@ -626,11 +964,17 @@ int insert_job_after(
       log_err(rc, __func__, "No memory to resize the array...SYSTEM FAILURE");
       }
     else
+      {
       rc = PBSE_NONE;
+      }
     }
 
   aj->unlock();
 
+  if ((rc == PBSE_NONE) &&
+      (aj == &alljobs))
+    job_registry_add(pjob);
+
   return(rc);
   } /* END insert_job_after() */
 
@@ -685,10 +1029,16 @@ int insert_job_after(
     log_err(rc, __func__, "No memory to resize the array...SYSTEM FAILURE");
     }
   else
+    {
     rc = PBSE_NONE;
+    }
 
   aj->unlock();
 
+  if ((rc == PBSE_NONE) &&
+      (aj == &alljobs))
+    job_registry_add(pjob);
+
   return(rc);
   } /* END insert_job_after() */
 
@@ -725,10 +1075,16 @@ int insert_job_first(
     log_err(rc, __func__, "No memory to resize the array...SYSTEM FAILURE");
     }
   else
+    {
     rc = PBSE_NONE;
+    }
 
   aj->unlock();
 
+  if ((rc == PBSE_NONE) &&
+      (aj == &alljobs))
+    job_registry_add(pjob);
+
   return(rc);
   } /* END insert_job_first () */
 
@@ -853,6 +1209,10 @@ int  remove_job(
 
   aj->unlock();
 
+  if ((rc == PBSE_NONE) &&
+      (aj == &alljobs))
+    job_registry_remove(pjob);
+
   return(rc);
   } /* END remove_job() */
 
@@ -877,14 +1237,19 @@ job *next_job(
     return(NULL);
     }
 
+  job_epoch_enter();
+
   aj->lock();
   pjob = iter->get_next_item();
   aj->unlock();
 
   if (pjob != NULL)
-    {
     lock_ji_mutex(pjob, __func__, NULL, LOGLEVEL);
 
+  job_epoch_exit();
+
+  if (pjob != NULL)
+    {
     if (pjob->ji_being_recycled == TRUE)
       {
       unlock_ji_mutex(pjob, __func__, "1", LOGLEVEL);
@@ -898,6 +1263,31 @@ job *next_job(
 
 
 
+/*
+ * get_job_ids - copy the ids of aj's jobs, in aj's order, so a long walk can
+ * look each one up with find_job_in_registry() instead of going back to aj's
+ * mutex for every job
+ */
+
+void get_job_ids(
+
+  all_jobs                 *aj,
+  std::vector<std::string> &ids)
+
+  {
+  if (aj == NULL)
+    {
+    log_err(PBSE_BAD_PARAMETER, __func__, "null input pointer to all_jobs struct");
+    return;
+    }
+
+  aj->lock();
+  aj->get_ids(ids);
+  aj->unlock();
+  } /* END get_job_ids() */
+
+
+
 /* currently this function can only be called for jobs in the alljobs array */
 int swap_jobs(
 
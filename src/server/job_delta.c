@@ -0,0 +1,200 @@
+#include "license_pbs.h" /* See here for the software license */
+/*
+ * job_delta.c - change sequence numbers for delta job status
+ *
+ * Every change to a job stamps it with the next value of a server wide
+ * sequence (ji_delta_seq).  A client that passes DELTASTATUS<seq> in the
+ * extend field of pbs_statjob() is only sent the jobs stamped after <seq>,
+ * plus the ids of the jobs purged since then, and the sequence to ask from
+ * next time.
+ *
+ * The sequence starts from the server's start time shifted left by 20 bits,
+ * so it keeps increasing across restarts.  Purged job ids are only kept for
+ * the last JOB_DELTA_MAX_PURGED purges and not across restarts;
+ * job_delta_get_purged() reports when a client asks from before the oldest
+ * one still known and so must be sent everything.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "pbs_ifl.h"
+#include "pbs_job.h"
+#include "job_delta.h"
+#include "stat_job.h"
+
+
+
+static pthread_once_t                delta_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t               delta_purged_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static volatile unsigned long long   delta_seq = 0;       /* last sequence handed out */
+static unsigned long long            delta_floor = 0;     /* purges at or before this are unknown */
+static std::deque<job_delta_purged>  delta_purged;        /* oldest first */
+
+
+
+static void job_delta_init()
+
+  {
+  delta_seq = ((unsigned long long)time(NULL)) << 20;
+  delta_floor = delta_seq;
+  } /* END job_delta_init() */
+
+
+
+/*
+ * job_delta_get_seq - the last sequence handed out
+ */
+
+unsigned long long job_delta_get_seq()
+
+  {
+  pthread_once(&delta_once, job_delta_init);
+
+  return(__sync_add_and_fetch(&delta_seq, 0));
+  } /* END job_delta_get_seq() */
+
+
+
+/*
+ * job_delta_touch - mark pjob as changed
+ *
+ * Its cached status can't be sent any more, so it is dropped now rather
+ * than holding its share of the cache until the job is next statused.
+ *
+ * NOTE: pjob's mutex must be held
+ */
+
+void job_delta_touch(
+
+  job *pjob)
+
+  {
+  pthread_once(&delta_once, job_delta_init);
+
+  pjob->ji_delta_seq = __sync_add_and_fetch(&delta_seq, 1);
+
+  job_status_cache_free(pjob);
+  } /* END job_delta_touch() */
+
+
+
+/*
+ * job_delta_note_purged - remember that a job is gone for later delta requests
+ *
+ * @param jobid - the purged job's id
+ * @param owner - its job_owner, used to hide it from other users
+ */
+
+void job_delta_note_purged(
+
+  const char *jobid,
+  const char *owner)
+
+  {
+  job_delta_purged purged;
+
+  pthread_once(&delta_once, job_delta_init);
+
+  purged.jobid = jobid;
+
+  if (owner != NULL)
+    purged.owner = owner;
+
+  pthread_mutex_lock(&delta_purged_mutex);
+
+  purged.seq = __sync_add_and_fetch(&delta_seq, 1);
+  delta_purged.push_back(purged);
+
+  while (delta_purged.size() > JOB_DELTA_MAX_PURGED)
+    {
+    delta_floor = delta_purged.front().seq;
+    delta_purged.pop_front();
+    }
+
+  pthread_mutex_unlock(&delta_purged_mutex);
+  } /* END job_delta_note_purged() */
+
+
+
+/*
+ * job_delta_get_purged - get the jobs purged after since
+ *
+ * @param since - the sequence the client last saw
+ * @param purged - RETURN: the purged jobs, oldest first
+ * @return false if purges after since may have been forgotten, in which case
+ * the client has to be sent every job
+ */
+
+bool job_delta_get_purged(
+
+  unsigned long long             since,
+  std::vector<job_delta_purged> &purged)
+
+  {
+  bool complete = true;
+
+  pthread_once(&delta_once, job_delta_init);
+
+  pthread_mutex_lock(&delta_purged_mutex);
+
+  if (since < delta_floor)
+    complete = false;
+  else
+    {
+    std::deque<job_delta_purged>::reverse_iterator it;
+
+    for (it = delta_purged.rbegin(); it != delta_purged.rend(); it++)
+      {
+      if (it->seq <= since)
+        break;
+      }
+
+    purged.insert(purged.end(), it.base(), delta_purged.end());
+    }
+
+  pthread_mutex_unlock(&delta_purged_mutex);
+
+  return(complete);
+  } /* END job_delta_get_purged() */
+
+
+
+/*
+ * job_delta_parse_extend - find a DELTASTATUS request in a status extend string
+ *
+ * @param extend - the extend field of the request, may be NULL
+ * @param since - RETURN: the sequence the client last saw
+ * @return true if a delta status was requested
+ */
+
+bool job_delta_parse_extend(
+
+  const char         *extend,
+  unsigned long long *since)
+
+  {
+  const char *ptr;
+  char       *end;
+
+  if ((extend == NULL) ||
+      ((ptr = strstr(extend, DELTASTATUS)) == NULL))
+    return(false);
+
+  ptr += strlen(DELTASTATUS);
+  *since = strtoull(ptr, &end, 10);
+
+  if (end == ptr)
+    *since = 0;
+
+  return(true);
+  } /* END job_delta_parse_extend() */
+
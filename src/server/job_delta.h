@@ -0,0 +1,25 @@
+#ifndef _JOB_DELTA_H
+#define _JOB_DELTA_H
+#include "license_pbs.h" /* See here for the software license */
+
+#include <string>
+#include <vector>
+
+#include "pbs_job.h"
+
+#define JOB_DELTA_MAX_PURGED  65536 /* purged job ids remembered for delta status */
+
+typedef struct job_delta_purged
+  {
+  unsigned long long seq;
+  std::string        jobid;
+  std::string        owner;
+  } job_delta_purged;
+
+unsigned long long job_delta_get_seq();
+void               job_delta_touch(job *pjob);
+void               job_delta_note_purged(const char *jobid, const char *owner);
+bool               job_delta_get_purged(unsigned long long since, std::vector<job_delta_purged> &purged);
+bool               job_delta_parse_extend(const char *extend, unsigned long long *since);
+
+#endif /* _JOB_DELTA_H */
@@ -152,6 +152,8 @@
 #include "job_route.h" /* job_route */
 #include "id_map.hpp"
 #include "completed_jobs_map.h"
+#include "job_delta.h"
+#include "job_select_index.h"
 
 #ifndef TRUE
 #define TRUE 1
@@ -179,6 +181,7 @@ void handle_complete_second_time(struct work_task *ptask);
 
 static void job_init_wattr(job *);
 void free_all_of_job(job *pjob);
+void job_status_cache_free(job *pjob);
 
 /* Global Data items */
 all_jobs        alljobs;
@@ -782,6 +785,8 @@ job *job_alloc(void)
 
   pj->ji_momhandle = -1;  /* mark mom connection invalid */
 
+  job_delta_touch(pj);
+
   /* set the working attributes to "unspecified" */
   job_init_wattr(pj);
   
@@ -817,6 +822,15 @@ void free_job_allocation(
     delete pjob->ji_rejectdest;
     pjob->ji_rejectdest = NULL;
     }
+
+  if (pjob->ji_saved_hash != NULL)
+    {
+    free(pjob->ji_saved_hash);
+    pjob->ji_saved_hash = NULL;
+    }
+
+  job_status_cache_free(pjob);
+  job_index_remove(pjob);
   } /* END free_job_allocation() */
 
 
@@ -855,7 +869,10 @@ void job_free(
     log_record(PBSEVENT_DEBUG,PBS_EVENTCLASS_JOB,pj->ji_qs.ji_jobid,log_buf);
     }
 
-  remove_job(&alljobs, pj, true);
+  /* a job which was never in alljobs (job_clone() failing) can't have been
+   * found by a lookup, so it can go right away */
+  if (remove_job(&alljobs, pj, true) == PBSE_NONE)
+    use_recycle = TRUE;
 
   /* move to the recycling structure - deleting right away can cause a race
    * condition where two threads are pending on the same job. Thread 1 gets 
@@ -1902,6 +1919,7 @@ int svr_job_purge(
   job_array     *pa = NULL;
   char          array_id[PBS_MAXSVRJOBID+1];
   std::string	adjusted_path_jobs;
+  std::string   job_owner;
   
   if (pjob == NULL)
     {
@@ -1919,6 +1937,9 @@ int svr_job_purge(
   job_has_arraystruct = ((pjob->ji_arraystructid[0] == '\0') ? FALSE:TRUE);
   job_has_checkpoint_file = pjob->ji_wattr[JOB_ATR_checkpoint_name].at_flags;
 
+  if (pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str != NULL)
+    job_owner = pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str;
+
   if (LOGLEVEL >= 10)
     log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, __func__, pjob->ji_qs.ji_jobid);
 
@@ -2027,6 +2048,9 @@ int svr_job_purge(
     pjob_mutex.set_unlock_on_exit(false); /* job_free will release lock */
     }
 
+  /* tell delta status clients the job is gone */
+  job_delta_note_purged(job_id, job_owner.c_str());
+
   // get the adjusted path_jobs
   //  using the preserved job id in job_id
   adjusted_path_jobs = get_path_jobdata(job_id, path_jobs);
@@ -2461,18 +2485,7 @@ bool job_id_exists(
   const std::string job_id_string)
 
   {
-  bool rc = false;
-
-  alljobs.lock();
-
-  if (alljobs.find(job_id_string) != NULL)
-    {
-    rc = true;
-    }
-
-  alljobs.unlock();
-
-  return(rc);
+  return(job_registry_has(job_id_string.c_str()));
   }
   
 
@@ -0,0 +1,784 @@
+#include "license_pbs.h" /* See here for the software license */
+/*
+ * job_journal.c - append-only journal of job changes
+ *
+ * job_save() only rewrites a job's file (its snapshot) when the job is new or
+ * has built up too many changes.  Otherwise it appends a small record holding
+ * the job's fixed fields and only the attributes which changed since the job
+ * was last written.  Every record carries a server wide sequence number and
+ * each job file remembers the last sequence it covers, so recovery replays
+ * exactly the records which are newer than the job file.
+ *
+ * Records are written with group commit: whichever thread finds no write in
+ * progress writes everything queued so far with one write() and one
+ * fdatasync() while the others wait for their sequence to become durable.
+ * A thread can also queue a batch of records and wait once, for the last of
+ * them (job_journal_begin_batch() / job_journal_end_batch()), or hand the
+ * wait to another thread (job_journal_detach_batch() / job_journal_wait()).
+ *
+ * When the journal grows past JOB_JOURNAL_MAX_SIZE it is renamed to
+ * JOB_JOURNAL_OLD_FILE and a fresh journal is started.  job_journal_compact()
+ * then rewrites the file of every job with records in the old generation and
+ * removes it.
+ *
+ * File format:
+ *   TORQUE_JOURNAL <version> <base sequence>\n
+ *   R <sequence> <jobid> <length>\n<record>\n
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pbs_job.h"
+#include "log.h"
+#include "../lib/Liblog/pbs_log.h"
+#include "../lib/Liblog/log_event.h"
+#include "../lib/Libifl/lib_ifl.h" /* write_ac_socket */
+#include "pbs_error.h"
+#include "svrfunc.h"
+#include "work_task.h"
+#include "ji_mutex.h"
+#include "job_recov.h"
+#include "job_journal.h"
+
+#define JOURNAL_HEADER "TORQUE_JOURNAL"
+
+
+
+typedef struct journal_record
+  {
+  unsigned long long seq;
+  std::string        record;
+  } journal_record;
+
+/* records read from disk at start up, released once recovery is finished */
+static std::map<std::string, std::vector<journal_record> > recovered_records;
+
+static pthread_mutex_t     journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t      journal_cond = PTHREAD_COND_INITIALIZER;
+
+static int                 journal_fd = -1;
+static std::string         journal_dir;
+static std::string         journal_pending;           /* records queued but not yet written */
+static unsigned long long  journal_seq = 0;           /* last sequence handed out */
+static unsigned long long  journal_pending_seq = 0;   /* last sequence in journal_pending */
+static unsigned long long  journal_durable_seq = 0;   /* last sequence known to be on disk */
+static bool                journal_writing = false;
+static off_t               journal_size = 0;
+static int                 journal_gen = 1;           /* generation of the current journal file */
+static int                 journal_compact_gen = 0;   /* generation being compacted, 0 if none */
+static bool                journal_compact_due = false; /* rotated, compaction not yet scheduled */
+static bool                journal_replay_failed = false; /* a job with replayed records wasn't saved */
+
+/* set by job_journal_begin_batch() */
+static __thread int                journal_batch_depth = 0;
+static __thread unsigned long long journal_batch_seq = 0;    /* last sequence this thread's batch queued */
+
+
+
+/*
+ * read_journal_file - read every intact record from a journal file into
+ * recovered_records.  A truncated last record (crash while appending) ends
+ * the file.
+ */
+
+static int read_journal_file(
+
+  const char *filename)
+
+  {
+  FILE               *fp;
+  char                line[PBS_MAXSVRJOBID + 128];
+  char                jobid[sizeof(line)];
+  char                log_buf[LOCAL_LOG_BUF_SIZE];
+  unsigned long long  seq;
+  unsigned long       len;
+  int                 version;
+  int                 count = 0;
+
+  if ((fp = fopen(filename, "r")) == NULL)
+    {
+    if (errno == ENOENT)
+      return(PBSE_NONE);
+
+    snprintf(log_buf, sizeof(log_buf), "cannot open job journal %s", filename);
+    log_err(errno, __func__, log_buf);
+    return(-1);
+    }
+
+  if ((fgets(line, sizeof(line), fp) == NULL) ||
+      (sscanf(line, JOURNAL_HEADER " %d %llu", &version, &seq) != 2) ||
+      (version != JOB_JOURNAL_VERSION))
+    {
+    snprintf(log_buf, sizeof(log_buf), "job journal %s has a bad header, ignoring it", filename);
+    log_err(-1, __func__, log_buf);
+    fclose(fp);
+    return(-1);
+    }
+
+  if (seq > journal_seq)
+    journal_seq = seq;
+
+  while (fgets(line, sizeof(line), fp) != NULL)
+    {
+    journal_record jr;
+    char          *buf;
+
+    if (sscanf(line, "R %llu %s %lu", &seq, jobid, &len) != 3)
+      break;
+
+    if ((buf = (char *)malloc(len + 1)) == NULL)
+      break;
+
+    /* the record is followed by a newline */
+    if ((fread(buf, 1, len + 1, fp) != len + 1) ||
+        (buf[len] != '\n'))
+      {
+      free(buf);
+      break;
+      }
+
+    jr.seq = seq;
+    jr.record.assign(buf, len);
+    free(buf);
+
+    recovered_records[jobid].push_back(jr);
+    count++;
+
+    if (seq > journal_seq)
+      journal_seq = seq;
+    }
+
+  if (!feof(fp))
+    {
+    snprintf(log_buf, sizeof(log_buf),
+      "job journal %s ends with an incomplete record, %d records recovered",
+      filename, count);
+    log_err(-1, __func__, log_buf);
+    }
+  else if (LOGLEVEL >= 3)
+    {
+    snprintf(log_buf, sizeof(log_buf), "%d records read from job journal %s", count, filename);
+    log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buf);
+    }
+
+  fclose(fp);
+
+  return(PBSE_NONE);
+  } /* END read_journal_file() */
+
+
+
+/*
+ * job_journal_load - read the journal(s) left by the previous server instance.
+ * Must be called before any job is recovered.
+ */
+
+int job_journal_load(
+
+  const char *dir)  /* I - path_jobs */
+
+  {
+  std::string old_file(dir);
+  std::string cur_file(dir);
+
+  old_file += JOB_JOURNAL_OLD_FILE;
+  cur_file += JOB_JOURNAL_FILE;
+
+  recovered_records.clear();
+
+  /* the older generation first so each job's records stay in order */
+  read_journal_file(old_file.c_str());
+  read_journal_file(cur_file.c_str());
+
+  return(PBSE_NONE);
+  } /* END job_journal_load() */
+
+
+
+/*
+ * job_journal_get_records - return the recovered records for a job with a
+ * sequence newer than after_seq, oldest first
+ */
+
+void job_journal_get_records(
+
+  const char               *jobid,     /* I */
+  unsigned long long        after_seq, /* I */
+  std::vector<std::string> &records)   /* O */
+
+  {
+  std::map<std::string, std::vector<journal_record> >::iterator it;
+
+  records.clear();
+
+  if ((it = recovered_records.find(jobid)) == recovered_records.end())
+    return;
+
+  for (unsigned int i = 0; i < it->second.size(); i++)
+    {
+    if (it->second[i].seq > after_seq)
+      records.push_back(it->second[i].record);
+    }
+  } /* END job_journal_get_records() */
+
+
+
+/*
+ * job_journal_note_seq - make sure sequences handed out later are newer
+ * than one already recorded in a job file
+ */
+
+void job_journal_note_seq(
+
+  unsigned long long seq)
+
+  {
+  pthread_mutex_lock(&journal_mutex);
+
+  if (seq > journal_seq)
+    journal_seq = seq;
+
+  pthread_mutex_unlock(&journal_mutex);
+  } /* END job_journal_note_seq() */
+
+
+
+/*
+ * job_journal_note_replay_failed - a job which had journal records replayed
+ * could not be saved, so the journal must be kept for the next start
+ */
+
+void job_journal_note_replay_failed()
+
+  {
+  pthread_mutex_lock(&journal_mutex);
+  journal_replay_failed = true;
+  pthread_mutex_unlock(&journal_mutex);
+  } /* END job_journal_note_replay_failed() */
+
+
+
+/*
+ * sync_job_files - make the job files written so far durable before the
+ * journal records they replace are thrown away
+ */
+
+static void sync_job_files(
+
+  int fd)
+
+  {
+#ifdef HAVE_SYNCFS
+  if (syncfs(fd) == 0)
+    return;
+#endif
+
+  sync();
+  } /* END sync_job_files() */
+
+
+
+/*
+ * start_journal_file - create a new, empty journal file whose header records
+ * the current sequence
+ *
+ * NOTE: journal_mutex must be held or the journal must not be in use
+ */
+
+static int start_journal_file(
+
+  const char *filename)
+
+  {
+  int  fd;
+  char header[128];
+  int  len;
+
+  if ((fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0600)) < 0)
+    {
+    log_err(errno, __func__, "cannot create the job journal");
+    return(-1);
+    }
+
+  len = snprintf(header, sizeof(header), "%s %d %llu\n",
+    JOURNAL_HEADER, JOB_JOURNAL_VERSION, journal_seq);
+
+  if ((write_ac_socket(fd, header, len) != len) ||
+      (fdatasync(fd) != 0))
+    {
+    log_err(errno, __func__, "cannot write the job journal header");
+    close(fd);
+    unlink(filename);
+    return(-1);
+    }
+
+  journal_size = len;
+
+  return(fd);
+  } /* END start_journal_file() */
+
+
+
+/*
+ * job_journal_open - start journaling.  Called once all jobs are recovered,
+ * at which point job_recov() has folded every replayed record into a new job
+ * file, so the previous journals can be discarded.
+ *
+ * If a job's replayed records could not be saved (see
+ * job_journal_note_replay_failed()) the journals are left alone for the next
+ * start to replay, and job files are rewritten on every save instead.
+ */
+
+int job_journal_open(
+
+  const char *dir)  /* I - path_jobs */
+
+  {
+  std::string old_file(dir);
+  std::string cur_file(dir);
+  int         fd;
+
+  old_file += JOB_JOURNAL_OLD_FILE;
+  cur_file += JOB_JOURNAL_FILE;
+
+  recovered_records.clear();
+
+  pthread_mutex_lock(&journal_mutex);
+
+  journal_dir = dir;
+
+  if (journal_replay_failed == true)
+    {
+    pthread_mutex_unlock(&journal_mutex);
+
+    log_err(-1, __func__, "a job with replayed journal records could not be saved, keeping the job journal for the next start");
+
+    return(-1);
+    }
+
+  if ((fd = open(dir, O_RDONLY)) >= 0)
+    {
+    sync_job_files(fd);
+    close(fd);
+    }
+
+  unlink(old_file.c_str());
+
+  journal_fd = start_journal_file(cur_file.c_str());
+  journal_pending.clear();
+  journal_pending_seq = journal_seq;
+  journal_durable_seq = journal_seq;
+  journal_compact_gen = 0;
+
+  pthread_mutex_unlock(&journal_mutex);
+
+  return((journal_fd < 0) ? -1 : PBSE_NONE);
+  } /* END job_journal_open() */
+
+
+
+/*
+ * job_journal_close - stop journaling, later saves rewrite the job files
+ */
+
+void job_journal_close()
+
+  {
+  pthread_mutex_lock(&journal_mutex);
+
+  while (journal_writing == true)
+    pthread_cond_wait(&journal_cond, &journal_mutex);
+
+  if (journal_fd >= 0)
+    {
+    close(journal_fd);
+    journal_fd = -1;
+    }
+
+  pthread_cond_broadcast(&journal_cond);
+  pthread_mutex_unlock(&journal_mutex);
+  } /* END job_journal_close() */
+
+
+
+bool job_journal_is_open()
+
+  {
+  bool is_open;
+
+  pthread_mutex_lock(&journal_mutex);
+  is_open = (journal_fd >= 0);
+  pthread_mutex_unlock(&journal_mutex);
+
+  return(is_open);
+  } /* END job_journal_is_open() */
+
+
+
+/*
+ * job_journal_get_seq - the sequence a job file written now covers
+ */
+
+unsigned long long job_journal_get_seq()
+
+  {
+  unsigned long long seq;
+
+  pthread_mutex_lock(&journal_mutex);
+  seq = journal_seq;
+  pthread_mutex_unlock(&journal_mutex);
+
+  return(seq);
+  } /* END job_journal_get_seq() */
+
+
+
+/*
+ * rotate_journal - move the full journal aside and start a new generation.
+ * Skipped while the previous generation is still being compacted.
+ *
+ * NOTE: journal_mutex must be held
+ */
+
+static void rotate_journal()
+
+  {
+  std::string old_file(journal_dir);
+  std::string cur_file(journal_dir);
+  int         fd;
+
+  if (journal_compact_gen != 0)
+    return;
+
+  old_file += JOB_JOURNAL_OLD_FILE;
+  cur_file += JOB_JOURNAL_FILE;
+
+  if (rename(cur_file.c_str(), old_file.c_str()) != 0)
+    {
+    log_err(errno, __func__, "cannot rotate the job journal");
+    return;
+    }
+
+  close(journal_fd);
+
+  if ((fd = start_journal_file(cur_file.c_str())) < 0)
+    {
+    /* job_save() falls back to rewriting job files, compact the rest */
+    journal_fd = -1;
+    }
+  else
+    journal_fd = fd;
+
+  journal_compact_gen = journal_gen++;
+
+  /* scheduled by unlock_journal(), set_task() can't be called under journal_mutex */
+  journal_compact_due = true;
+  } /* END rotate_journal() */
+
+
+
+/*
+ * unlock_journal - release journal_mutex and start the compaction of a
+ * generation rotated out while it was held
+ */
+
+static void unlock_journal()
+
+  {
+  bool compact = journal_compact_due;
+
+  journal_compact_due = false;
+
+  pthread_mutex_unlock(&journal_mutex);
+
+  if (compact == true)
+    set_task(WORK_Immed, 0, job_journal_compact, NULL, FALSE);
+  } /* END unlock_journal() */
+
+
+
+/*
+ * wait_for_durable - write queued records until seq is on disk
+ *
+ * NOTE: journal_mutex must be held
+ * @return PBSE_NONE if seq is durable, -1 if journaling was turned off
+ */
+
+static int wait_for_durable(
+
+  unsigned long long seq)
+
+  {
+  while (journal_durable_seq < seq)
+    {
+    if (journal_fd < 0)
+      {
+      /* a write failed and journaling was turned off */
+      return(-1);
+      }
+
+    if (journal_writing == true)
+      {
+      pthread_cond_wait(&journal_cond, &journal_mutex);
+      continue;
+      }
+
+    /* nobody is writing - write out everything queued so far */
+    std::string        batch;
+    unsigned long long batch_seq = journal_pending_seq;
+    int                fd = journal_fd;
+    bool               ok;
+
+    batch.swap(journal_pending);
+    journal_writing = true;
+
+    pthread_mutex_unlock(&journal_mutex);
+
+    ok = ((write_ac_socket(fd, batch.c_str(), batch.size()) == (ssize_t)batch.size()) &&
+          (fdatasync(fd) == 0));
+
+    pthread_mutex_lock(&journal_mutex);
+
+    journal_writing = false;
+
+    if (ok == true)
+      {
+      journal_durable_seq = batch_seq;
+      journal_size += batch.size();
+
+      if (journal_size > JOB_JOURNAL_MAX_SIZE)
+        rotate_journal();
+      }
+    else
+      {
+      log_err(errno, __func__, "cannot write the job journal, rewriting job files instead");
+
+      close(journal_fd);
+      journal_fd = -1;
+      }
+
+    pthread_cond_broadcast(&journal_cond);
+    }
+
+  return(PBSE_NONE);
+  } /* END wait_for_durable() */
+
+
+
+/*
+ * job_journal_append - append a job's change record to the journal and wait
+ * until it is on disk
+ *
+ * Between job_journal_begin_batch() and job_journal_end_batch() the record is
+ * only queued and job_journal_end_batch() waits for it instead.
+ *
+ * @param jobid - the job the record belongs to
+ * @param record - the encoded record
+ * @param len - the length of record
+ * @param gen - set to the journal generation the record was written to
+ * @return PBSE_NONE if the record is durable, -1 if the caller must rewrite
+ *         the job file instead
+ */
+
+int job_journal_append(
+
+  const char *jobid,   /* I */
+  const char *record,  /* I */
+  size_t      len,     /* I */
+  int        *gen)     /* O */
+
+  {
+  char               header[PBS_MAXSVRJOBID + 128];
+  unsigned long long seq;
+  int                rc = PBSE_NONE;
+
+  pthread_mutex_lock(&journal_mutex);
+
+  if (journal_fd < 0)
+    {
+    pthread_mutex_unlock(&journal_mutex);
+    return(-1);
+    }
+
+  seq = ++journal_seq;
+  *gen = journal_gen;
+
+  snprintf(header, sizeof(header), "R %llu %s %lu\n", seq, jobid, (unsigned long)len);
+  journal_pending += header;
+  journal_pending.append(record, len);
+  journal_pending += '\n';
+  journal_pending_seq = seq;
+
+  if (journal_batch_depth > 0)
+    journal_batch_seq = seq;
+  else
+    rc = wait_for_durable(seq);
+
+  unlock_journal();
+
+  return(rc);
+  } /* END job_journal_append() */
+
+
+
+/*
+ * job_journal_begin_batch - stop this thread's appends from waiting for the
+ * disk until job_journal_end_batch(), so a batch of job saves shares one
+ * write and fdatasync()
+ *
+ * Calls may nest, only the outermost job_journal_end_batch() waits.
+ */
+
+void job_journal_begin_batch()
+
+  {
+  if (journal_batch_depth++ == 0)
+    journal_batch_seq = 0;
+  } /* END job_journal_begin_batch() */
+
+
+
+/*
+ * job_journal_end_batch - wait until the records appended since
+ * job_journal_begin_batch() are on disk
+ *
+ * @return PBSE_NONE if they are, -1 if they were lost when journaling was
+ * turned off and the batch's jobs must be saved again
+ */
+
+int job_journal_end_batch()
+
+  {
+  return(job_journal_wait(job_journal_detach_batch()));
+  } /* END job_journal_end_batch() */
+
+
+
+/*
+ * job_journal_detach_batch - end this thread's batch like
+ * job_journal_end_batch(), but without waiting.  The caller waits with
+ * job_journal_wait(), which can cover several threads' batches at once.
+ *
+ * @return the sequence to wait for, 0 if there is nothing to wait for
+ */
+
+unsigned long long job_journal_detach_batch()
+
+  {
+  unsigned long long seq = journal_batch_seq;
+
+  if ((journal_batch_depth == 0) ||
+      (--journal_batch_depth > 0))
+    return(0);
+
+  journal_batch_seq = 0;
+
+  return(seq);
+  } /* END job_journal_detach_batch() */
+
+
+
+/*
+ * job_journal_wait - wait until the records up to seq are on disk
+ *
+ * @return PBSE_NONE if they are, -1 if they were lost when journaling was
+ * turned off and their jobs must be saved again
+ */
+
+int job_journal_wait(
+
+  unsigned long long seq)
+
+  {
+  int rc;
+
+  if (seq == 0)
+    return(PBSE_NONE);
+
+  pthread_mutex_lock(&journal_mutex);
+  rc = wait_for_durable(seq);
+  unlock_journal();
+
+  return(rc);
+  } /* END job_journal_wait() */
+
+
+
+/*
+ * job_journal_compact - rewrite the file of every job which has records in
+ * the generation that was rotated out, then remove that generation
+ */
+
+void job_journal_compact(
+
+  struct work_task *ptask)
+
+  {
+  job               *pjob;
+  all_jobs_iterator *iter;
+  int                compact_gen;
+  int                count = 0;
+  int                fd;
+  char               log_buf[LOCAL_LOG_BUF_SIZE];
+  std::string        dir;
+  std::string        old_file;
+
+  if (ptask != NULL)
+    free(ptask->wt_mutex);
+
+  free(ptask);
+
+  pthread_mutex_lock(&journal_mutex);
+  compact_gen = journal_compact_gen;
+  dir = journal_dir;
+  pthread_mutex_unlock(&journal_mutex);
+
+  old_file = dir + JOB_JOURNAL_OLD_FILE;
+
+  if (compact_gen == 0)
+    return;
+
+  iter = alljobs.get_iterator();
+
+  while ((pjob = next_job(&alljobs, iter)) != NULL)
+    {
+    if ((pjob->ji_journal_gen != 0) &&
+        (pjob->ji_journal_gen <= compact_gen))
+      {
+      job_save(pjob, SAVEJOB_SNAPSHOT, 0);
+      count++;
+      }
+
+    unlock_ji_mutex(pjob, __func__, NULL, LOGLEVEL);
+    }
+
+  delete iter;
+
+  if ((fd = open(dir.c_str(), O_RDONLY)) >= 0)
+    {
+    sync_job_files(fd);
+    close(fd);
+    }
+
+  unlink(old_file.c_str());
+
+  pthread_mutex_lock(&journal_mutex);
+  journal_compact_gen = 0;
+  pthread_mutex_unlock(&journal_mutex);
+
+  snprintf(log_buf, sizeof(log_buf),
+    "job journal generation %d compacted, %d job files rewritten", compact_gen, count);
+  log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_SERVER, __func__, log_buf);
+  } /* END job_journal_compact() */
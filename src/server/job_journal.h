@@ -0,0 +1,29 @@
+#ifndef _JOB_JOURNAL_H
+#define _JOB_JOURNAL_H
+#include "license_pbs.h" /* See here for the software license */
+
+#include <string>
+#include <vector>
+
+#include "work_task.h"
+
+#define JOB_JOURNAL_VERSION      1
+#define JOB_JOURNAL_MAX_SIZE     (64 * 1024 * 1024) /* rotate and compact past this many bytes */
+#define JOB_JOURNAL_MAX_RECORDS  32                 /* rewrite a job file after this many records */
+
+int                job_journal_load(const char *dir);
+void               job_journal_get_records(const char *jobid, unsigned long long after_seq, std::vector<std::string> &records);
+void               job_journal_note_seq(unsigned long long seq);
+void               job_journal_note_replay_failed();
+int                job_journal_open(const char *dir);
+void               job_journal_close();
+bool               job_journal_is_open();
+unsigned long long job_journal_get_seq();
+int                job_journal_append(const char *jobid, const char *record, size_t len, int *gen);
+void               job_journal_begin_batch();
+int                job_journal_end_batch();
+unsigned long long job_journal_detach_batch();
+int                job_journal_wait(unsigned long long seq);
+void               job_journal_compact(struct work_task *ptask);
+
+#endif /* _JOB_JOURNAL_H */
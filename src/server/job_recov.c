@@ -128,6 +128,11 @@
 #include "array.h"
 #include "ji_mutex.h"
 #include "job_recov.h"
+#ifndef PBS_MOM
+#include "job_journal.h"
+#include "job_delta.h"
+#include "job_select_index.h"
+#endif
 
 #ifndef TRUE
 #define TRUE 1
@@ -321,6 +326,10 @@ int assign_tag_len_11(
 
   if (!(strncmp((const char *)tag, REC_TYPE_TAG, 11)))
     pjob->ji_qs.ji_un_type = atoi((const char*)content);
+#ifndef PBS_MOM
+  else if (!(strncmp((const char *)tag, JOURNAL_SEQ_TAG, 11)))
+    pjob->ji_journal_seq = strtoull((const char*)content, NULL, 10);
+#endif /* !PBS_MOM */
   else if(!(strncmp((const char *)tag, FROM_SOCK_TAG, 11)))
     pjob->ji_qs.ji_un.ji_newt.ji_fromsock = atoi((const char*)content);
   else if (!(strncmp((const char *)tag, SCRT_SIZE_TAG, 11)))
@@ -909,14 +918,55 @@ void translate_dependency_to_string(
 
 
 
+/*
+ * saved_value_hash() - hash of an attribute value as written to disk.
+ * 0 is reserved for "not set".
+ */
+
+unsigned int saved_value_hash(
+
+  unsigned int  hash,  /* I - 0 to start a new hash */
+  const char   *value) /* I */
+
+  {
+  if (hash == 0)
+    hash = 2166136261U;
+
+  if (value != NULL)
+    {
+    for (; *value != '\0'; value++)
+      {
+      hash ^= (unsigned char)*value;
+      hash *= 16777619U;
+      }
+    }
+
+  /* separate consecutive values */
+  hash ^= 0xff;
+  hash *= 16777619U;
+
+  return((hash == 0) ? 1 : hash);
+  } /* END saved_value_hash() */
+
+
+
 /*
  * add_encoded_attributes () - add encoded job attributes xml nodes. 
+ *
+ * If saved_hash is not NULL it is updated with the hash of each value
+ * written.  If changed_only is set, only attributes whose value differs from
+ * saved_hash (or which are flagged ATR_VFLAG_MODIFY) are added, and
+ * attributes which have been unset since are added with empty values.
+ *
+ * @return 0, or -2 if changed_only could not express a change
  */
 
 int add_encoded_attributes(
 
-  xmlNodePtr     *attr_node, /* M attribute node */ 
-  pbs_attribute  *pattr)     /* M ptr to pbs_attribute value array */
+  xmlNodePtr     *attr_node,    /* M attribute node */ 
+  pbs_attribute  *pattr,        /* M ptr to pbs_attribute value array */
+  unsigned int   *saved_hash,   /* M optional hash of each value last written */
+  bool            changed_only) /* I only add attributes which changed */
 
   {
   tlist_head  lhead;
@@ -927,6 +977,7 @@ int add_encoded_attributes(
   xmlNodePtr  attributeNode = *attr_node;
   char        buf[BUFSIZE];
   xmlNodePtr  pal_xmlNode;
+  unsigned int hash;
 
   CLEAR_HEAD(lhead);
   xmlNodePtr  resource_list_head_node = NULL;
@@ -934,67 +985,133 @@ int add_encoded_attributes(
 
   for (i = 0; ((i < JOB_ATR_LAST) && (rc >= 0)); i++)
     {
-    if ((job_attr_def[i].at_type != ATR_TYPE_ACL) &&
-        ((pattr + i)->at_flags & ATR_VFLAG_SET))
+    if (job_attr_def[i].at_type == ATR_TYPE_ACL)
+      continue;
+
+    if (((pattr + i)->at_flags & ATR_VFLAG_SET) == 0)
       {
-      if ((i != JOB_ATR_resource) &&
-          (i != JOB_ATR_resc_used))
-        {
-        std::string value;
+      if ((saved_hash == NULL) ||
+          (saved_hash[i] == 0))
+        continue;
+
+      /* the attribute was unset since the job was last written */
+      saved_hash[i] = 0;
+
+      if (changed_only == false)
+        continue;
+
+      if ((i == JOB_ATR_resource) ||
+          (i == JOB_ATR_resc_used))
+        return(-2);
+
+      pal_xmlNode = xmlNewChild(attributeNode,
+                                NULL,
+                                (xmlChar *)job_attr_def[i].at_name,
+                                (const xmlChar *)"");
+
+      if (pal_xmlNode)
+        xmlSetProp(pal_xmlNode, (const xmlChar *)AL_FLAGS_ATTR, (const xmlChar *)"0");
+
+      continue;
+      }
+
+    if ((i != JOB_ATR_resource) &&
+        (i != JOB_ATR_resc_used))
+      {
+      std::string value;
 
 #ifndef PBS_MOM
-        if (i == JOB_ATR_depend)
-          translate_dependency_to_string(pattr + i, value);
-        else
+      if (i == JOB_ATR_depend)
+        translate_dependency_to_string(pattr + i, value);
+      else
 #endif
-          attr_to_str(value, job_attr_def + i, pattr[i], false);
+        attr_to_str(value, job_attr_def + i, pattr[i], false);
 
-        if (value.size() == 0)
+      if (value.size() == 0)
+        {
+        if (saved_hash != NULL)
+          saved_hash[i] = 0;
+
+        continue;
+        }
+
+      if (saved_hash != NULL)
+        {
+        hash = saved_value_hash(0, value.c_str());
+
+        if ((changed_only == true) &&
+            (hash == saved_hash[i]) &&
+            (((pattr + i)->at_flags & ATR_VFLAG_MODIFY) == 0))
           continue;
 
-        pal_xmlNode = xmlNewChild(attributeNode,
-                                  NULL,
-                                  (xmlChar *)job_attr_def[i].at_name,
-                                  (const xmlChar *)value.c_str());
+        saved_hash[i] = hash;
+        }
 
-        if (pal_xmlNode)
-          {
-          snprintf(buf, sizeof(buf), "%u", (unsigned int)pattr[i].at_flags);
-          xmlSetProp(pal_xmlNode, (const xmlChar *)AL_FLAGS_ATTR, (const xmlChar *)buf);
-          (pattr + i)->at_flags &= ~ATR_VFLAG_MODIFY;
-          }
+      pal_xmlNode = xmlNewChild(attributeNode,
+                                NULL,
+                                (xmlChar *)job_attr_def[i].at_name,
+                                (const xmlChar *)value.c_str());
+
+      if (pal_xmlNode)
+        {
+        snprintf(buf, sizeof(buf), "%u", (unsigned int)pattr[i].at_flags);
+        xmlSetProp(pal_xmlNode, (const xmlChar *)AL_FLAGS_ATTR, (const xmlChar *)buf);
+        (pattr + i)->at_flags &= ~ATR_VFLAG_MODIFY;
         }
-      else
+      }
+    else
+      {
+      rc = job_attr_def[i].at_encode(pattr + i,
+          &lhead,
+          job_attr_def[i].at_name,
+          NULL,
+          ATR_ENCODE_SAVE,
+          resc_access_perm);
+      
+      if (rc < 0)
+        return -1;
+
+      if (saved_hash != NULL)
         {
-        rc = job_attr_def[i].at_encode(pattr + i,
-            &lhead,
-            job_attr_def[i].at_name,
-            NULL,
-            ATR_ENCODE_SAVE,
-            resc_access_perm);
-        
-        if (rc < 0)
-          return -1;
+        hash = 0;
 
-        (pattr + i)->at_flags &= ~ATR_VFLAG_MODIFY;
+        for (pal = (svrattrl *)GET_NEXT(lhead);
+             pal != NULL;
+             pal = (svrattrl *)GET_NEXT(pal->al_link))
+          {
+          hash = saved_value_hash(hash, pal->al_atopl.resource);
+          hash = saved_value_hash(hash, pal->al_atopl.value);
+          }
 
-        while ((pal = (svrattrl *)GET_NEXT(lhead)) != NULL)
+        if ((changed_only == true) &&
+            (hash == saved_hash[i]) &&
+            (((pattr + i)->at_flags & ATR_VFLAG_MODIFY) == 0))
           {
-          if (i == JOB_ATR_resource) 
-            pal_xmlNode = add_resource_list_attribute(ATTR_l, attr_node, &resource_list_head_node, pal);
-          else
-            pal_xmlNode = add_resource_list_attribute(ATTR_used, attr_node, &resource_used_head_node, pal);
-
-            if (pal_xmlNode)
-              {
-              snprintf(buf, sizeof(buf), "%u", (unsigned int)pal->al_flags);
-              xmlSetProp(pal_xmlNode, (const xmlChar *)AL_FLAGS_ATTR, (const xmlChar *)buf);
-              }
-            delete_link(&pal->al_link);
-            free(pal);
-            if (!pal_xmlNode)
-              rc = -1;
+          free_attrlist(&lhead);
+          continue;
           }
+
+        saved_hash[i] = hash;
+        }
+
+      (pattr + i)->at_flags &= ~ATR_VFLAG_MODIFY;
+
+      while ((pal = (svrattrl *)GET_NEXT(lhead)) != NULL)
+        {
+        if (i == JOB_ATR_resource) 
+          pal_xmlNode = add_resource_list_attribute(ATTR_l, attr_node, &resource_list_head_node, pal);
+        else
+          pal_xmlNode = add_resource_list_attribute(ATTR_used, attr_node, &resource_used_head_node, pal);
+
+          if (pal_xmlNode)
+            {
+            snprintf(buf, sizeof(buf), "%u", (unsigned int)pal->al_flags);
+            xmlSetProp(pal_xmlNode, (const xmlChar *)AL_FLAGS_ATTR, (const xmlChar *)buf);
+            }
+          delete_link(&pal->al_link);
+          free(pal);
+          if (!pal_xmlNode)
+            rc = -1;
         }
       }
     }
@@ -1018,10 +1135,20 @@ int add_attributes(
   char  log_buf[LOCAL_LOG_BUF_SIZE];
   xmlNodePtr root_node = *rnode;
 
+  unsigned int *saved_hash = NULL;
+
+#ifndef PBS_MOM
+  /* remember what is written so the journal can tell what changes */
+  if (pjob->ji_saved_hash == NULL)
+    pjob->ji_saved_hash = (unsigned int *)calloc(JOB_ATR_LAST, sizeof(unsigned int));
+
+  saved_hash = pjob->ji_saved_hash;
+#endif /* !PBS_MOM */
+
   if ((attributeNode = xmlNewNode(NULL, (xmlChar *)ATTRIB_TAG)))
    {
    xmlAddChild(root_node, attributeNode);
-   rc = add_encoded_attributes(&attributeNode, pjob->ji_wattr);
+   rc = add_encoded_attributes(&attributeNode, pjob->ji_wattr, saved_hash, false);
    }
   else
    rc = -1;
@@ -1084,6 +1211,15 @@ int saveJobToXML(
     add_fix_fields(&root_node, (const job*)pjob);
     add_union_fields(&root_node, (const job*)pjob);
 
+#ifndef PBS_MOM
+    {
+    char buf[BUFSIZE];
+
+    snprintf(buf, sizeof(buf), "%llu", pjob->ji_journal_seq);
+    xmlNewChild(root_node, NULL, (xmlChar *)JOURNAL_SEQ_TAG, (xmlChar *)buf);
+    }
+#endif /* !PBS_MOM */
+
     if (add_attributes(&root_node, pjob))
       {
       xmlFreeDoc(doc);
@@ -1133,6 +1269,155 @@ int saveJobToXML(
   } /* saveJobToXML */
 
 
+#ifndef PBS_MOM
+/*
+ * saveJobToJournal() - append the job's fixed fields and the attributes which
+ * changed since it was last written to the job journal
+ *
+ * @return PBSE_NONE, or -1 if the job file must be rewritten instead
+ */
+
+int saveJobToJournal(
+
+  job *pjob)  /* I - pointer to job */
+
+  {
+  xmlDocPtr   doc;
+  xmlNodePtr  root_node;
+  xmlNodePtr  attributeNode;
+  xmlChar    *record = NULL;
+  int         len = 0;
+  int         gen;
+  int         rc;
+
+  if ((doc = xmlNewDoc((const xmlChar*) "1.0")) == NULL)
+    return(-1);
+
+  root_node = xmlNewNode(NULL, (const xmlChar*) JOB_TAG);
+  xmlDocSetRootElement(doc, root_node);
+  add_fix_fields(&root_node, (const job*)pjob);
+  add_union_fields(&root_node, (const job*)pjob);
+
+  if ((attributeNode = xmlNewNode(NULL, (xmlChar *)ATTRIB_TAG)) == NULL)
+    {
+    xmlFreeDoc(doc);
+    return(-1);
+    }
+
+  if (add_encoded_attributes(&attributeNode, pjob->ji_wattr, pjob->ji_saved_hash, true) != PBSE_NONE)
+    {
+    xmlFreeNode(attributeNode);
+    xmlFreeDoc(doc);
+    return(-1);
+    }
+
+  if (attributeNode->children != NULL)
+    xmlAddChild(root_node, attributeNode);
+  else
+    xmlFreeNode(attributeNode);
+
+  xmlDocDumpMemory(doc, &record, &len);
+  xmlFreeDoc(doc);
+
+  if (record == NULL)
+    return(-1);
+
+  rc = job_journal_append(pjob->ji_qs.ji_jobid, (char *)record, len, &gen);
+
+  xmlFree(record);
+
+  if (rc != PBSE_NONE)
+    return(-1);
+
+  if (pjob->ji_journal_gen == 0)
+    pjob->ji_journal_gen = gen;
+
+  pjob->ji_journal_records++;
+
+  return(PBSE_NONE);
+  } /* END saveJobToJournal() */
+
+
+
+/*
+ * job_journal_replay() - apply the journal records written after the job's
+ * file was saved
+ *
+ * A record that can't be read or applied, usually one torn by a crash while
+ * it was being appended, ends the replay: it is logged and the job keeps its
+ * snapshot and the records before it.  The bad record may have been partly
+ * applied.
+ *
+ * @return the number of records applied
+ */
+
+int job_journal_replay(
+
+  job   **pjob,     /* M */
+  char   *log_buf,  /* O */
+  size_t  buf_len)  /* I */
+
+  {
+  std::vector<std::string> records;
+  xmlDocPtr                doc;
+  xmlNodePtr               root_element;
+  xmlNodePtr               cur_node;
+  int                      rc = PBSE_NONE;
+  unsigned long long       snapshot_seq = (*pjob)->ji_journal_seq;
+
+  job_journal_note_seq(snapshot_seq);
+
+  job_journal_get_records((*pjob)->ji_qs.ji_jobid, snapshot_seq, records);
+
+  for (unsigned int i = 0; i < records.size(); i++)
+    {
+    if (((doc = xmlReadMemory(records[i].c_str(), records[i].size(), NULL, NULL, 0)) == NULL) ||
+        ((root_element = xmlDocGetRootElement(doc)) == NULL))
+      {
+      if (doc != NULL)
+        xmlFreeDoc(doc);
+
+      snprintf(log_buf, buf_len,
+        "unreadable journal record %u of %u, ignoring it and the records after it",
+        i + 1, (unsigned int)records.size());
+      log_event(PBSEVENT_ERROR | PBSEVENT_JOB, PBS_EVENTCLASS_JOB, (*pjob)->ji_qs.ji_jobid, log_buf);
+
+      return(i);
+      }
+
+    for (cur_node = root_element->children;
+         (cur_node != NULL) && (rc == PBSE_NONE);
+         cur_node = cur_node->next)
+      {
+      /* skip text children, only process elements */
+      if (!strcmp((const char *)cur_node->name, text_name))
+        continue;
+
+      if (!strcmp((const char *)cur_node->name, ATTRIB_TAG))
+        rc = parse_attributes(pjob, cur_node, log_buf, buf_len);
+      else
+        rc = assign_job_field(pjob, cur_node, log_buf, buf_len);
+      }
+
+    xmlFreeDoc(doc);
+
+    if (rc != PBSE_NONE)
+      {
+      snprintf(log_buf, buf_len,
+        "unable to apply journal record %u of %u, ignoring the records after it",
+        i + 1, (unsigned int)records.size());
+      log_event(PBSEVENT_ERROR | PBSEVENT_JOB, PBS_EVENTCLASS_JOB, (*pjob)->ji_qs.ji_jobid, log_buf);
+
+      return(i);
+      }
+    }
+
+  return(records.size());
+  } /* END job_journal_replay() */
+#endif /* !PBS_MOM */
+
+
+
 /*
  * job_save() - Saves (or updates) a job structure image on disk
  *
@@ -1153,6 +1438,10 @@ int saveJobToXML(
  * For a new file write, first time, the data is written directly to
  * the file.
  *
+ * On the server, once a job file exists, quick and full updates append only
+ * what changed to the job journal (see job_journal.c) and the job file is
+ * rewritten every JOB_JOURNAL_MAX_RECORDS updates or on SAVEJOB_SNAPSHOT.
+ *
  *      RETURN:  0 - success, -1 - failure
  */
 
@@ -1221,6 +1510,30 @@ int job_save(
     pjob->ji_wattr[JOB_ATR_mtime].at_val.at_long = time_now;
     }
 
+#ifndef PBS_MOM
+  job_delta_touch(pjob);
+  job_index_update(pjob);
+#endif /* !PBS_MOM */
+
+#ifndef PBS_MOM
+  if (((updatetype == SAVEJOB_QUICK) ||
+       (updatetype == SAVEJOB_FULL)) &&
+      (pjob->ji_saved_hash != NULL) &&
+      (pjob->ji_journal_records < JOB_JOURNAL_MAX_RECORDS) &&
+      (job_journal_is_open() == true))
+    {
+    if (saveJobToJournal(pjob) == PBSE_NONE)
+      {
+      pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
+      return(PBSE_NONE);
+      }
+
+    /* fall back to rewriting the job file */
+    }
+
+  pjob->ji_journal_seq = job_journal_get_seq();
+#endif /* !PBS_MOM */
+
   if (!(saveJobToXML(pjob, namebuf2)))
     {
     unlink(namebuf1);
@@ -1236,6 +1549,11 @@ int job_save(
     else
       {
       unlink(namebuf2);
+
+#ifndef PBS_MOM
+      pjob->ji_journal_gen = 0;
+      pjob->ji_journal_records = 0;
+#endif /* !PBS_MOM */
       }
     }
   else /* saveJobToXML failed */
@@ -1521,6 +1839,8 @@ job *job_recov(
   int   rc;
 #ifdef PBS_MOM
   char namebuf[MAXPATHLEN];
+#else
+  int   replayed = 0;
 #endif
 
   pj = job_alloc(); /* allocate & initialize job structure space */
@@ -1545,6 +1865,10 @@ job *job_recov(
       (rc == PBSE_INVALID_SYNTAX))
     rc = job_recov_binary(filename, &pj, log_buf, logBufLen);
 
+  /* the job file is rewritten below so replayed records are folded into it */
+  if (rc == PBSE_NONE)
+    replayed = job_journal_replay(&pj, log_buf, logBufLen);
+
   if (rc == PBSE_NONE)
     rc = set_array_job_ids(&pj, log_buf, logBufLen);
 #endif
@@ -1573,7 +1897,10 @@ job *job_recov(
 #ifdef PBS_MOM
   job_save(pj, SAVEJOB_FULL, (multi_mom == 0)?0:pbs_rm_port);
 #else
-  job_save(pj, SAVEJOB_FULL, 0);
+  /* the journal can't be dropped until the replayed records are in the job file */
+  if ((job_save(pj, SAVEJOB_FULL, 0) != PBSE_NONE) &&
+      (replayed > 0))
+    job_journal_note_replay_failed();
 #endif
 
   return(pj);
@@ -12,5 +12,11 @@ job *job_recov(const char *);
 void   add_fix_fields(xmlNodePtr *rnode, const job *pjob);
 void   add_union_fields(xmlNodePtr *rnode, const job *pjob);
 int    saveJobToXML(job *pjob, const char *filename);
+unsigned int saved_value_hash(unsigned int hash, const char *value);
+int    add_encoded_attributes(xmlNodePtr *attr_node, pbs_attribute *pattr, unsigned int *saved_hash, bool changed_only);
+#ifndef PBS_MOM
+int    saveJobToJournal(job *pjob);
+int    job_journal_replay(job **pjob, char *log_buf, size_t buf_len);
+#endif /* !PBS_MOM */
 
 #endif /* _JOB_RECOV_H */
@@ -140,7 +140,9 @@ void *remove_some_recycle_jobs(
     if (pjob == NULL)
       break;
 
-    if (time_now - pjob->ji_momstat < MINIMUM_RECYCLE_TIME)
+    /* the oldest is still too young, or a lookup may still reach it */
+    if ((time_now - pjob->ji_momstat < MINIMUM_RECYCLE_TIME) ||
+        (job_epoch_passed(pjob->ji_retired_epoch) == false))
       {
       insert_job(&recycler.rc_jobs, pjob);
       unlock_ji_mutex(pjob, __func__, "1", LOGLEVEL);
@@ -186,6 +188,7 @@ int insert_into_recycler(
 
   sprintf(pjob->ji_qs.ji_jobid,"%016lx",(long)pjob);
   pjob->ji_being_recycled = TRUE;
+  pjob->ji_retired_epoch = job_epoch_retire();
     
   rc = insert_job(&recycler.rc_jobs, pjob);
   pjob->ji_momstat = time(NULL);
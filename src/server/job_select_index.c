@@ -0,0 +1,288 @@
+#include "license_pbs.h" /* See here for the software license */
+/*
+ * job_select_index.c - secondary indexes of the server's jobs for selection
+ *
+ * Every job in the job registry (see job_container.c) is also indexed by
+ * the attributes qselect is most often asked about: its owner's user name,
+ * euser, state, queue and account.  req_selectjobs() uses the smallest index
+ * an equality selection can use to find the jobs to check instead of
+ * checking every job; select_job() still decides whether each one matches,
+ * so the indexes only need to never leave out a job.
+ *
+ * Jobs are added and removed with the registry, and their entries are moved
+ * by job_index_update() when svr_setjobstate() or job_save() may have
+ * changed the indexed values.  What a job is indexed under is kept on the
+ * job (ji_index_entry, under the job's mutex), so an update which changes
+ * nothing indexed takes no index lock, and one which does only locks the
+ * indexes that changed.
+ *
+ * Each index keeps its jobs in the order they joined the registry, which is
+ * submission order for new jobs and job id order for jobs recovered at
+ * startup.  ji_internal_id isn't used for this because recovered jobs are
+ * registered before they're given one.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <pthread.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pbs_job.h"
+#include "job_select_index.h"
+
+
+
+/* registry sequence -> job id of the jobs with one value */
+typedef std::map<unsigned long long, std::string> job_index_jobs;
+
+/* what a job is indexed under */
+struct job_index_entry
+  {
+  unsigned long long seq;
+  std::string        keys[JOB_INDEX_COUNT];
+  };
+
+typedef struct job_index
+  {
+  pthread_mutex_t                       mutex;
+  std::map<std::string, job_index_jobs> jobs;
+  } job_index;
+
+static job_index          indexes[JOB_INDEX_COUNT];
+static pthread_once_t     indexes_once = PTHREAD_ONCE_INIT;
+static unsigned long long index_seq = 0;
+
+
+
+static void init_indexes()
+
+  {
+  for (int i = 0; i < JOB_INDEX_COUNT; i++)
+    pthread_mutex_init(&indexes[i].mutex, NULL);
+  } /* END init_indexes() */
+
+
+
+/*
+ * job_index_get_keys - the values pjob is indexed under
+ *
+ * NOTE: pjob's mutex must be held
+ */
+
+void job_index_get_keys(
+
+  job         *pjob,
+  std::string  keys[JOB_INDEX_COUNT])
+
+  {
+  pbs_attribute *pattr;
+
+  for (int i = 0; i < JOB_INDEX_COUNT; i++)
+    keys[i].clear();
+
+  pattr = &pjob->ji_wattr[JOB_ATR_job_owner];
+  if ((pattr->at_flags & ATR_VFLAG_SET) &&
+      (pattr->at_val.at_str != NULL))
+    {
+    const char *at = strchr(pattr->at_val.at_str, '@');
+
+    if (at != NULL)
+      keys[JOB_INDEX_OWNER].assign(pattr->at_val.at_str, at - pattr->at_val.at_str);
+    else
+      keys[JOB_INDEX_OWNER] = pattr->at_val.at_str;
+    }
+
+  pattr = &pjob->ji_wattr[JOB_ATR_euser];
+  if ((pattr->at_flags & ATR_VFLAG_SET) &&
+      (pattr->at_val.at_str != NULL))
+    keys[JOB_INDEX_EUSER] = pattr->at_val.at_str;
+
+  if (pjob->ji_wattr[JOB_ATR_state].at_val.at_char != '\0')
+    keys[JOB_INDEX_STATE] = pjob->ji_wattr[JOB_ATR_state].at_val.at_char;
+
+  keys[JOB_INDEX_QUEUE] = pjob->ji_qs.ji_queue;
+
+  pattr = &pjob->ji_wattr[JOB_ATR_account];
+  if ((pattr->at_flags & ATR_VFLAG_SET) &&
+      (pattr->at_val.at_str != NULL))
+    keys[JOB_INDEX_ACCOUNT] = pattr->at_val.at_str;
+  } /* END job_index_get_keys() */
+
+
+
+/*
+ * move_job - move a job's entry in kind's index from old_key to new_key.
+ * An empty old_key adds it and an empty new_key removes it.
+ */
+
+static void move_job(
+
+  int                 kind,
+  unsigned long long  seq,
+  const std::string  &old_key,
+  const std::string  &new_key,
+  const char         *job_id)
+
+  {
+  job_index *index = indexes + kind;
+
+  pthread_mutex_lock(&index->mutex);
+
+  if (!old_key.empty())
+    {
+    std::map<std::string, job_index_jobs>::iterator it = index->jobs.find(old_key);
+
+    if (it != index->jobs.end())
+      {
+      it->second.erase(seq);
+
+      if (it->second.empty())
+        index->jobs.erase(it);
+      }
+    }
+
+  if (!new_key.empty())
+    index->jobs[new_key][seq] = job_id;
+
+  pthread_mutex_unlock(&index->mutex);
+  } /* END move_job() */
+
+
+
+/*
+ * job_index_add - index a job which has joined the job registry
+ *
+ * NOTE: pjob's mutex must be held
+ */
+
+void job_index_add(
+
+  job *pjob)
+
+  {
+  pthread_once(&indexes_once, init_indexes);
+
+  /* re-registering a job keeps its place */
+  if (pjob->ji_index_entry == NULL)
+    {
+    pjob->ji_index_entry = new job_index_entry();
+    pjob->ji_index_entry->seq = __sync_add_and_fetch(&index_seq, 1);
+    }
+
+  job_index_update(pjob);
+  } /* END job_index_add() */
+
+
+
+/*
+ * job_index_update - move an indexed job to the entries for its current
+ * values.  Jobs which aren't indexed are left alone.
+ *
+ * NOTE: pjob's mutex must be held
+ */
+
+void job_index_update(
+
+  job *pjob)
+
+  {
+  job_index_entry *entry = pjob->ji_index_entry;
+  std::string      keys[JOB_INDEX_COUNT];
+
+  if (entry == NULL)
+    return;
+
+  job_index_get_keys(pjob, keys);
+
+  for (int i = 0; i < JOB_INDEX_COUNT; i++)
+    {
+    if (entry->keys[i] == keys[i])
+      continue;
+
+    move_job(i, entry->seq, entry->keys[i], keys[i], pjob->ji_qs.ji_jobid);
+    entry->keys[i].swap(keys[i]);
+    }
+  } /* END job_index_update() */
+
+
+
+/*
+ * job_index_remove - take a job out of the indexes
+ *
+ * NOTE: pjob's mutex must be held
+ */
+
+void job_index_remove(
+
+  job *pjob)
+
+  {
+  job_index_entry *entry = pjob->ji_index_entry;
+  std::string      none;
+
+  if (entry == NULL)
+    return;
+
+  for (int i = 0; i < JOB_INDEX_COUNT; i++)
+    {
+    if (!entry->keys[i].empty())
+      move_job(i, entry->seq, entry->keys[i], none, pjob->ji_qs.ji_jobid);
+    }
+
+  pjob->ji_index_entry = NULL;
+  delete entry;
+  } /* END job_index_remove() */
+
+
+
+/*
+ * job_index_lookup - get the jobs indexed under any of keys
+ *
+ * @param kind - the index to use
+ * @param keys - the values to look for
+ * @param job_ids - RETURN: the jobs' ids in the order they were registered
+ */
+
+void job_index_lookup(
+
+  int                             kind,
+  const std::vector<std::string> &keys,
+  std::vector<std::string>       &job_ids)
+
+  {
+  job_index      *index = indexes + kind;
+  job_index_jobs  found;
+
+  job_ids.clear();
+
+  pthread_once(&indexes_once, init_indexes);
+
+  pthread_mutex_lock(&index->mutex);
+
+  for (unsigned int i = 0; i < keys.size(); i++)
+    {
+    std::map<std::string, job_index_jobs>::iterator it = index->jobs.find(keys[i]);
+
+    if (it == index->jobs.end())
+      continue;
+
+    if (keys.size() == 1)
+      {
+      for (job_index_jobs::iterator j = it->second.begin(); j != it->second.end(); j++)
+        job_ids.push_back(j->second);
+
+      pthread_mutex_unlock(&index->mutex);
+      return;
+      }
+
+    found.insert(it->second.begin(), it->second.end());
+    }
+
+  pthread_mutex_unlock(&index->mutex);
+
+  for (job_index_jobs::iterator j = found.begin(); j != found.end(); j++)
+    job_ids.push_back(j->second);
+  } /* END job_index_lookup() */
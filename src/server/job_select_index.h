@@ -0,0 +1,27 @@
+#ifndef _JOB_SELECT_INDEX_H
+#define _JOB_SELECT_INDEX_H
+#include "license_pbs.h" /* See here for the software license */
+
+#include <string>
+#include <vector>
+
+#include "pbs_job.h"
+
+/* the attributes jobs are indexed by for selection */
+enum job_index_kind
+  {
+  JOB_INDEX_OWNER,    /* user name part of job_owner, for User_List */
+  JOB_INDEX_EUSER,
+  JOB_INDEX_STATE,    /* job_state letter */
+  JOB_INDEX_QUEUE,
+  JOB_INDEX_ACCOUNT,
+  JOB_INDEX_COUNT
+  };
+
+void job_index_add(job *pjob);
+void job_index_update(job *pjob);
+void job_index_remove(job *pjob);
+void job_index_get_keys(job *pjob, std::string keys[JOB_INDEX_COUNT]);
+void job_index_lookup(int kind, const std::vector<std::string> &keys, std::vector<std::string> &job_ids);
+
+#endif /* _JOB_SELECT_INDEX_H */
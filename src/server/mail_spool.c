@@ -0,0 +1,846 @@
+#include "license_pbs.h" /* See here for the software license */
+/*
+ * mail_spool.c - queue, coalesce and deliver job mail
+ *
+ * Once mail_spool_start() has run, svr_mailowner() hands its notifications
+ * to mail_spool_add() instead of forking sendmail for each one.
+ * Notifications to the same recipients are held for MAIL_SPOOL_DELAY
+ * seconds and sent as one digest, one digest per job array for subjobs.
+ *
+ * Every message is written to the mail spool directory before it is sent
+ * and removed once sendmail has taken it, so whatever was queued when the
+ * server stopped is sent on the next start.  Messages are passed to a
+ * helper process forked at start up, while the server is still small,
+ * which runs SENDMAIL_CMD for each of them; at most MAIL_SPOOL_RATE are
+ * handed over per second.
+ */
+
+#include <pbs_config.h>   /* the master config generated by configure */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pbs_ifl.h"
+#include "pbs_error.h"
+#include "log.h"
+#include "../lib/Liblog/pbs_log.h"
+#include "../lib/Liblog/log_event.h"
+#include "server.h"
+#include "svrfunc.h" /* get_svr_attr_* */
+#include "mail_spool.h"
+
+/* Unit tests should use the special unit test sendmail command */
+#ifdef UT_SENDMAIL_CMD
+#undef SENDMAIL_CMD
+#define SENDMAIL_CMD UT_SENDMAIL_CMD
+#endif
+
+void free_mail_info(mail_info *mi);
+void write_email_digest(FILE *outmail_input, mail_digest &md);
+
+/* a message passed to the mail helper, followed by the three strings */
+typedef struct mail_helper_request
+  {
+  uint32_t from_len;
+  uint32_t to_len;
+  uint32_t msg_len;
+  } mail_helper_request;
+
+
+
+static pthread_mutex_t                     spool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t                      spool_cond = PTHREAD_COND_INITIALIZER;
+static std::map<std::string, mail_digest>  spool_pending;     /* by recipients and array */
+static std::deque<std::string>             spool_ready;       /* spool files to send, oldest first */
+static std::string                         spool_dir;
+static bool                                spool_running = false;
+static bool                                spool_stopping = false;
+static pthread_t                           spool_thread;
+static unsigned long                       spool_seq = 0;
+
+static int                                 helper_fd = -1;
+static pid_t                               helper_pid = -1;
+
+
+
+/*
+ * write_all / read_all - finish short reads and writes on a pipe or socket
+ */
+
+static int write_all(
+
+  int         fd,
+  const void *buf,
+  size_t      len)
+
+  {
+  const char *ptr = (const char *)buf;
+  ssize_t     rc;
+
+  while (len > 0)
+    {
+    if ((rc = write(fd, ptr, len)) < 0)
+      {
+      if (errno == EINTR)
+        continue;
+
+      return(-1);
+      }
+
+    ptr += rc;
+    len -= rc;
+    }
+
+  return(PBSE_NONE);
+  } /* END write_all() */
+
+
+
+static int read_all(
+
+  int     fd,
+  void   *buf,
+  size_t  len)
+
+  {
+  char    *ptr = (char *)buf;
+  ssize_t  rc;
+
+  while (len > 0)
+    {
+    if ((rc = read(fd, ptr, len)) < 0)
+      {
+      if (errno == EINTR)
+        continue;
+
+      return(-1);
+      }
+
+    if (rc == 0)
+      return(-1);
+
+    ptr += rc;
+    len -= rc;
+    }
+
+  return(PBSE_NONE);
+  } /* END read_all() */
+
+
+
+/*
+ * run_sendmail - pipe one message into SENDMAIL_CMD
+ *
+ * @param mailfrom - the sender passed with -f
+ * @param mailto - comma separated recipients
+ * @return sendmail's wait status, or -1 if it could not be run
+ */
+
+int run_sendmail(
+
+  const char *mailfrom,
+  const char *mailto,
+  const char *msg,
+  size_t      len)
+
+  {
+  // We call sendmail with cmd_name + 2 arguments + # of mailto addresses + 1 for null
+  char  *sendmail_args[100];
+  int    numargs = 0;
+  int    pipes[2];
+  int    status = 0;
+  pid_t  pid;
+  char  *mailptr;
+  char  *ptr;
+
+  if ((mailptr = strdup(mailto)) == NULL)
+    return(-1);
+
+  sendmail_args[numargs++] = (char *)SENDMAIL_CMD;
+  sendmail_args[numargs++] = (char *)"-f";
+  sendmail_args[numargs++] = (char *)mailfrom;
+  sendmail_args[numargs++] = mailptr;
+
+  for (ptr = mailptr; (*ptr != '\0') && (numargs < 99); ptr++)
+    {
+    if (*ptr == ',')
+      {
+      *ptr = '\0';
+      sendmail_args[numargs++] = ptr + 1;
+      }
+    }
+
+  sendmail_args[numargs] = NULL;
+
+  if (pipe(pipes) == -1)
+    {
+    free(mailptr);
+    return(-1);
+    }
+
+  if ((pid = fork()) == -1)
+    {
+    free(mailptr);
+    close(pipes[0]);
+    close(pipes[1]);
+    return(-1);
+    }
+  else if (pid == 0)
+    {
+    /* CHILD */
+    dup2(pipes[0], STDIN_FILENO);
+
+    /* Close the rest of the open file descriptors */
+    int numfds = sysconf(_SC_OPEN_MAX);
+    while (--numfds > 0)
+      close(numfds);
+
+    execv(SENDMAIL_CMD, sendmail_args);
+    /* This never returns, but if the execv fails the child should exit */
+    _exit(1);
+    }
+
+  close(pipes[0]);
+
+  write_all(pipes[1], msg, len);
+  close(pipes[1]);
+
+  while (waitpid(pid, &status, 0) < 0)
+    {
+    if (errno != EINTR)
+      {
+      status = -1;
+      break;
+      }
+    }
+
+  free(mailptr);
+
+  return(status);
+  } /* END run_sendmail() */
+
+
+
+/*
+ * mail_helper_loop - run sendmail for each message read from fd
+ *
+ * Runs in the mail helper process until the server closes its end.  The
+ * reply to each message is sendmail's wait status.
+ *
+ * NOTE: this runs in a forked child of a threaded process and must not log
+ * NOTE: the server ignores SIGPIPE, which the helper inherits
+ */
+
+int mail_helper_loop(
+
+  int fd)
+
+  {
+  mail_helper_request  req;
+  int                  status;
+
+  while (read_all(fd, &req, sizeof(req)) == PBSE_NONE)
+    {
+    std::string mailfrom(req.from_len, '\0');
+    std::string mailto(req.to_len, '\0');
+    std::string msg(req.msg_len, '\0');
+
+    if ((read_all(fd, &mailfrom[0], req.from_len) != PBSE_NONE) ||
+        (read_all(fd, &mailto[0], req.to_len) != PBSE_NONE) ||
+        (read_all(fd, &msg[0], req.msg_len) != PBSE_NONE))
+      break;
+
+    status = run_sendmail(mailfrom.c_str(), mailto.c_str(), msg.c_str(), msg.size());
+
+    if (write_all(fd, &status, sizeof(status)) != PBSE_NONE)
+      break;
+    }
+
+  return(PBSE_NONE);
+  } /* END mail_helper_loop() */
+
+
+
+static int start_mail_helper()
+
+  {
+  int   fds[2];
+  pid_t pid;
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    return(-1);
+
+  if ((pid = fork()) == -1)
+    {
+    close(fds[0]);
+    close(fds[1]);
+    return(-1);
+    }
+  else if (pid == 0)
+    {
+    struct sigaction act;
+    int              numfds = sysconf(_SC_OPEN_MAX);
+
+    /* the server ignores SIGCHLD, the helper has to wait for sendmail */
+    memset(&act, 0, sizeof(act));
+    sigemptyset(&act.sa_mask);
+    act.sa_handler = SIG_DFL;
+    sigaction(SIGCHLD, &act, NULL);
+    sigaction(SIGHUP, &act, NULL);
+    sigaction(SIGINT, &act, NULL);
+    sigaction(SIGTERM, &act, NULL);
+
+    while (--numfds > 2)
+      {
+      if (numfds != fds[1])
+        close(numfds);
+      }
+
+    mail_helper_loop(fds[1]);
+    _exit(0);
+    }
+
+  close(fds[1]);
+  fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+  helper_fd = fds[0];
+  helper_pid = pid;
+
+  return(PBSE_NONE);
+  } /* END start_mail_helper() */
+
+
+
+static void stop_mail_helper()
+
+  {
+  if (helper_fd >= 0)
+    {
+    close(helper_fd);
+    helper_fd = -1;
+    }
+
+  if (helper_pid > 0)
+    {
+    /* the helper exits once its socket is closed; the server ignores
+     * SIGCHLD so there may be nothing left to reap */
+    waitpid(helper_pid, NULL, WNOHANG);
+    helper_pid = -1;
+    }
+  } /* END stop_mail_helper() */
+
+
+
+/*
+ * mail_spool_write_file - save a message to be sent
+ *
+ * The file holds the sender and recipients on the first two lines and the
+ * message after them.  It is written under a temporary name and renamed so
+ * a crash never leaves a partial message behind.
+ */
+
+int mail_spool_write_file(
+
+  const char        *path,
+  const char        *mailfrom,
+  const char        *mailto,
+  const std::string &msg)
+
+  {
+  std::string  tmp_path(path);
+  FILE        *fp;
+  int          rc = PBSE_NONE;
+
+  tmp_path += ".tmp";
+
+  if ((fp = fopen(tmp_path.c_str(), "w")) == NULL)
+    return(-1);
+
+  if ((fprintf(fp, "%s\n%s\n", mailfrom, mailto) < 0) ||
+      (fwrite(msg.c_str(), 1, msg.size(), fp) != msg.size()))
+    rc = -1;
+
+  if (fclose(fp) != 0)
+    rc = -1;
+
+  if ((rc != PBSE_NONE) ||
+      (rename(tmp_path.c_str(), path) != 0))
+    {
+    unlink(tmp_path.c_str());
+    return(-1);
+    }
+
+  return(PBSE_NONE);
+  } /* END mail_spool_write_file() */
+
+
+
+int mail_spool_read_file(
+
+  const char  *path,
+  std::string &mailfrom,
+  std::string &mailto,
+  std::string &msg)
+
+  {
+  FILE   *fp;
+  char    buf[4096];
+  size_t  len;
+  char   *nl;
+
+  if ((fp = fopen(path, "r")) == NULL)
+    return(-1);
+
+  mailfrom.clear();
+  mailto.clear();
+  msg.clear();
+
+  if ((fgets(buf, sizeof(buf), fp) == NULL) ||
+      ((nl = strchr(buf, '\n')) == NULL))
+    {
+    fclose(fp);
+    return(-1);
+    }
+
+  mailfrom.assign(buf, nl - buf);
+
+  if ((fgets(buf, sizeof(buf), fp) == NULL) ||
+      ((nl = strchr(buf, '\n')) == NULL))
+    {
+    fclose(fp);
+    return(-1);
+    }
+
+  mailto.assign(buf, nl - buf);
+
+  while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+    msg.append(buf, len);
+
+  fclose(fp);
+
+  return(PBSE_NONE);
+  } /* END mail_spool_read_file() */
+
+
+
+/*
+ * mail_spool_render - format a digest as the message given to sendmail
+ */
+
+int mail_spool_render(
+
+  mail_digest &md,
+  std::string &msg)
+
+  {
+  char   *buf = NULL;
+  size_t  len = 0;
+  FILE   *fp;
+
+  if ((fp = open_memstream(&buf, &len)) == NULL)
+    return(-1);
+
+  write_email_digest(fp, md);
+
+  fclose(fp);
+
+  msg.assign(buf, len);
+  free(buf);
+
+  return(PBSE_NONE);
+  } /* END mail_spool_render() */
+
+
+
+/*
+ * mail_spool_add - queue a notification
+ *
+ * The spool owns mi from here on.
+ *
+ * @param array_id - the job array of a subjob, or NULL
+ * @return PBSE_NONE, or -1 if the spool is not running and the caller has
+ * to send the mail itself
+ */
+
+int mail_spool_add(
+
+  mail_info  *mi,
+  const char *array_id)
+
+  {
+  std::string key(mi->mailto);
+
+  if (array_id != NULL)
+    key += std::string("\n") + array_id;
+
+  pthread_mutex_lock(&spool_mutex);
+
+  if ((spool_running == false) ||
+      (spool_stopping == true))
+    {
+    pthread_mutex_unlock(&spool_mutex);
+    return(-1);
+    }
+
+  mail_digest &md = spool_pending[key];
+
+  if (md.items.empty())
+    {
+    md.mailto = mi->mailto;
+
+    if (array_id != NULL)
+      md.array_id = array_id;
+    }
+
+  md.items.push_back(mi);
+
+  pthread_mutex_unlock(&spool_mutex);
+
+  return(PBSE_NONE);
+  } /* END mail_spool_add() */
+
+
+
+/*
+ * spool_digests - write digests to the spool directory, queued to be sent
+ */
+
+static void spool_digests(
+
+  std::map<std::string, mail_digest> &digests)
+
+  {
+  std::map<std::string, mail_digest>::iterator  it;
+  const char                                   *mailfrom = NULL;
+  char                                          path[MAXPATHLEN + 1];
+  char                                          log_buf[LOCAL_LOG_BUF_SIZE];
+
+  if (digests.empty())
+    return;
+
+  /* Who is mail from, if SRV_ATR_mailfrom not set use default */
+  get_svr_attr_str(SRV_ATR_mailfrom, (char **)&mailfrom);
+  if (mailfrom == NULL)
+    mailfrom = PBS_DEFAULT_MAIL;
+
+  for (it = digests.begin(); it != digests.end(); it++)
+    {
+    mail_digest &all = it->second;
+
+    for (size_t start = 0; start < all.items.size(); start += MAIL_SPOOL_MAX_ITEMS)
+      {
+      mail_digest  md;
+      std::string  msg;
+      size_t       end = std::min(all.items.size(), start + MAIL_SPOOL_MAX_ITEMS);
+
+      md.mailto = all.mailto;
+      md.array_id = all.array_id;
+      md.items.assign(all.items.begin() + start, all.items.begin() + end);
+
+      snprintf(path, sizeof(path), "%s%010ld.%06lu%s",
+        spool_dir.c_str(), (long)time(NULL), spool_seq++, MAIL_SPOOL_SUFFIX);
+
+      if ((mail_spool_render(md, msg) != PBSE_NONE) ||
+          (mail_spool_write_file(path, mailfrom, md.mailto.c_str(), msg) != PBSE_NONE))
+        {
+        snprintf(log_buf, sizeof(log_buf),
+          "cannot spool mail for %s, %d notifications dropped",
+          md.mailto.c_str(), (int)md.items.size());
+        log_err(errno, __func__, log_buf);
+        continue;
+        }
+
+      pthread_mutex_lock(&spool_mutex);
+      spool_ready.push_back(path);
+      pthread_mutex_unlock(&spool_mutex);
+      }
+
+    for (size_t i = 0; i < all.items.size(); i++)
+      free_mail_info(all.items[i]);
+    }
+
+  digests.clear();
+  } /* END spool_digests() */
+
+
+
+/*
+ * deliver_spooled - hand one spool file to the mail helper
+ *
+ * @return PBSE_NONE if the file is done with, -1 to try it again later
+ */
+
+static int deliver_spooled(
+
+  const char *path)
+
+  {
+  std::string          mailfrom;
+  std::string          mailto;
+  std::string          msg;
+  mail_helper_request  req;
+  int                  status;
+  char                 log_buf[LOCAL_LOG_BUF_SIZE];
+
+  if (mail_spool_read_file(path, mailfrom, mailto, msg) != PBSE_NONE)
+    {
+    snprintf(log_buf, sizeof(log_buf), "cannot read spooled mail %s, removing it", path);
+    log_err(errno, __func__, log_buf);
+    return(PBSE_NONE);
+    }
+
+  if ((helper_fd < 0) &&
+      (start_mail_helper() != PBSE_NONE))
+    {
+    log_err(errno, __func__, "cannot start the mail helper");
+    return(-1);
+    }
+
+  req.from_len = mailfrom.size();
+  req.to_len = mailto.size();
+  req.msg_len = msg.size();
+
+  if ((write_all(helper_fd, &req, sizeof(req)) != PBSE_NONE) ||
+      (write_all(helper_fd, mailfrom.c_str(), req.from_len) != PBSE_NONE) ||
+      (write_all(helper_fd, mailto.c_str(), req.to_len) != PBSE_NONE) ||
+      (write_all(helper_fd, msg.c_str(), req.msg_len) != PBSE_NONE) ||
+      (read_all(helper_fd, &status, sizeof(status)) != PBSE_NONE))
+    {
+    /* the helper died, start another for the next attempt */
+    log_err(errno, __func__, "lost the mail helper");
+    stop_mail_helper();
+    return(-1);
+    }
+
+  if (status != 0)
+    {
+    snprintf(log_buf, sizeof(log_buf),
+      "Sendmail command returned %d. Mail to %s may not have been sent",
+      status, mailto.c_str());
+    log_event(PBSEVENT_ERROR | PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER, __func__, log_buf);
+    }
+
+  return(PBSE_NONE);
+  } /* END deliver_spooled() */
+
+
+
+static void *mail_spool_deliver(
+
+  void *vp)
+
+  {
+  std::map<std::string, mail_digest>  digests;
+  time_t                              last_spooled = time(NULL);
+  struct timespec                     wait_until;
+  bool                                stopping;
+
+  while (true)
+    {
+    pthread_mutex_lock(&spool_mutex);
+
+    if (spool_stopping == false)
+      {
+      wait_until.tv_sec = time(NULL) + 1;
+      wait_until.tv_nsec = 0;
+
+      pthread_cond_timedwait(&spool_cond, &spool_mutex, &wait_until);
+      }
+
+    stopping = spool_stopping;
+
+    if ((stopping) ||
+        (time(NULL) - last_spooled >= MAIL_SPOOL_DELAY))
+      {
+      digests.swap(spool_pending);
+      last_spooled = time(NULL);
+      }
+
+    pthread_mutex_unlock(&spool_mutex);
+
+    spool_digests(digests);
+
+    /* whatever has not been sent stays in the spool for the next start */
+    if (stopping)
+      break;
+
+    for (int sent = 0; sent < MAIL_SPOOL_RATE; sent++)
+      {
+      std::string path;
+
+      pthread_mutex_lock(&spool_mutex);
+
+      if (spool_ready.empty())
+        {
+        pthread_mutex_unlock(&spool_mutex);
+        break;
+        }
+
+      path = spool_ready.front();
+      spool_ready.pop_front();
+
+      pthread_mutex_unlock(&spool_mutex);
+
+      if (deliver_spooled(path.c_str()) != PBSE_NONE)
+        {
+        pthread_mutex_lock(&spool_mutex);
+        spool_ready.push_front(path);
+        pthread_mutex_unlock(&spool_mutex);
+        break;
+        }
+
+      unlink(path.c_str());
+      }
+    }
+
+  return(NULL);
+  } /* END mail_spool_deliver() */
+
+
+
+/*
+ * mail_spool_start - start queueing job mail
+ *
+ * Call before the jobs are recovered: the mail helper is forked here.
+ * Messages left in spool_dir by the last run are queued to be sent.
+ *
+ * @param spool_dir - the mail spool directory, ending in '/'
+ */
+
+int mail_spool_start(
+
+  const char *dir)
+
+  {
+  DIR                      *dp;
+  struct dirent            *pdirent;
+  std::vector<std::string>  found;
+  size_t                    suffix_len = strlen(MAIL_SPOOL_SUFFIX);
+  char                      log_buf[LOCAL_LOG_BUF_SIZE];
+
+  if (spool_running == true)
+    return(PBSE_NONE);
+
+  spool_dir = dir;
+
+  if ((mkdir(dir, 0750) != 0) &&
+      (errno != EEXIST))
+    {
+    snprintf(log_buf, sizeof(log_buf), "cannot create mail spool %s", dir);
+    log_err(errno, __func__, log_buf);
+    return(-1);
+    }
+
+  if ((dp = opendir(dir)) == NULL)
+    {
+    snprintf(log_buf, sizeof(log_buf), "cannot open mail spool %s", dir);
+    log_err(errno, __func__, log_buf);
+    return(-1);
+    }
+
+  while ((pdirent = readdir(dp)) != NULL)
+    {
+    size_t      len = strlen(pdirent->d_name);
+    std::string path(spool_dir + pdirent->d_name);
+
+    if ((len > suffix_len) &&
+        (!strcmp(pdirent->d_name + len - suffix_len, MAIL_SPOOL_SUFFIX)))
+      found.push_back(path);
+    else if ((len > 4) &&
+             (!strcmp(pdirent->d_name + len - 4, ".tmp")))
+      unlink(path.c_str());
+    }
+
+  closedir(dp);
+
+  /* the names sort oldest first */
+  std::sort(found.begin(), found.end());
+
+  if (start_mail_helper() != PBSE_NONE)
+    {
+    log_err(errno, __func__, "cannot start the mail helper");
+    return(-1);
+    }
+
+  pthread_mutex_lock(&spool_mutex);
+
+  spool_ready.assign(found.begin(), found.end());
+  spool_stopping = false;
+
+  if (pthread_create(&spool_thread, NULL, mail_spool_deliver, NULL) != 0)
+    {
+    pthread_mutex_unlock(&spool_mutex);
+    log_err(errno, __func__, "cannot start the mail spool thread");
+    stop_mail_helper();
+    return(-1);
+    }
+
+  spool_running = true;
+
+  pthread_mutex_unlock(&spool_mutex);
+
+  if (found.size() > 0)
+    {
+    snprintf(log_buf, sizeof(log_buf), "%d spooled mail messages queued to be sent",
+      (int)found.size());
+    log_event(PBSEVENT_SYSTEM | PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER, __func__, log_buf);
+    }
+
+  return(PBSE_NONE);
+  } /* END mail_spool_start() */
+
+
+
+/*
+ * mail_spool_shutdown - spool queued notifications and stop sending
+ *
+ * Notifications still being coalesced are written to the spool and, with
+ * any messages not yet sent, sent after the next start.
+ */
+
+void mail_spool_shutdown()
+
+  {
+  pthread_mutex_lock(&spool_mutex);
+
+  if (spool_running == false)
+    {
+    pthread_mutex_unlock(&spool_mutex);
+    return;
+    }
+
+  spool_stopping = true;
+  pthread_cond_signal(&spool_cond);
+
+  pthread_mutex_unlock(&spool_mutex);
+
+  pthread_join(spool_thread, NULL);
+
+  pthread_mutex_lock(&spool_mutex);
+
+  spool_ready.clear();
+  spool_running = false;
+
+  pthread_mutex_unlock(&spool_mutex);
+
+  stop_mail_helper();
+  } /* END mail_spool_shutdown() */
+
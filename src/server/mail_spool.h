@@ -0,0 +1,32 @@
+#ifndef _MAIL_SPOOL_H
+#define _MAIL_SPOOL_H
+#include "license_pbs.h" /* See here for the software license */
+
+#include <string>
+#include <vector>
+
+#include "server.h" /* mail_info */
+
+#define MAIL_SPOOL_DELAY      10   /* seconds notifications wait to be coalesced */
+#define MAIL_SPOOL_RATE       10   /* messages handed to sendmail per second */
+#define MAIL_SPOOL_MAX_ITEMS  500  /* notifications in one digest message */
+#define MAIL_SPOOL_SUFFIX     ".mail"
+
+/* notifications for the same recipients (and array) sent as one message */
+typedef struct mail_digest
+  {
+  std::string              mailto;
+  std::string              array_id;
+  std::vector<mail_info *> items;
+  } mail_digest;
+
+int  mail_spool_start(const char *spool_dir);
+void mail_spool_shutdown();
+int  mail_spool_add(mail_info *mi, const char *array_id);
+int  mail_spool_write_file(const char *path, const char *mailfrom, const char *mailto, const std::string &msg);
+int  mail_spool_read_file(const char *path, std::string &mailfrom, std::string &mailto, std::string &msg);
+int  mail_spool_render(mail_digest &md, std::string &msg);
+int  mail_helper_loop(int fd);
+int  run_sendmail(const char *mailfrom, const char *mailto, const char *msg, size_t len);
+
+#endif /* _MAIL_SPOOL_H */
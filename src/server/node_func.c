@@ -64,6 +64,7 @@
 #include "threadpool.h"
 #include "timer.hpp"
 #include "mom_hierarchy_handler.h"
+#include "mom_update.h" /* refresh_node_status */
 
 #if !defined(H_ERRNO_DECLARED) && !defined(_AIX)
 /*extern int h_errno;*/
@@ -583,6 +584,9 @@ int status_nodeattrib(
 
   memset(&atemp, 0, sizeof(atemp));
 
+  /* versioned mom updates only rebuild the status list when it is read */
+  refresh_node_status(pnode);
+
   priv &= ATR_DFLAG_RDACC;    /* user-client privilege          */
 
   for (i = 0;i < ND_ATR_LAST;i++)
@@ -921,6 +925,7 @@ void effective_node_delete(
     free(pnode->nd_acl);
     }
   if(pnode->nd_requestid != NULL) delete pnode->nd_requestid;
+  if(pnode->nd_raw_status != NULL) delete pnode->nd_raw_status;
 
   free(pnode);
   *ppnode = NULL;
@@ -97,6 +97,7 @@
 #include <arpa/inet.h>
 #endif
 #include <vector>
+#include <map>
 
 #include "portability.h"
 #include "libpbs.h"
@@ -134,6 +135,7 @@
 #include "mutex_mgr.hpp"
 #include "timer.hpp"
 #include "id_map.hpp"
+#include "job_delta.h"
 
 #define IS_VALID_STR(STR)  (((STR) != NULL) && ((STR)[0] != '\0'))
 
@@ -206,6 +208,20 @@ int remove_job_from_node(struct pbsnode *pnode, int internal_job_id);
 /* marks a stream as finished being serviced */
 pthread_mutex_t        *node_state_mutex = NULL;
 
+/* a job's hold on one node, noted by queue_free_nodes() */
+typedef struct queued_release
+  {
+  std::string jobid;
+  int         internal_job_id;
+  std::string exec_gpus;
+  bool        has_gpus;
+  bool        login;      /* its login node: only the slots are freed */
+  } queued_release;
+
+/* releases waiting for free_queued_nodes(), by node name */
+static pthread_mutex_t                                     queued_releases_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, std::vector<queued_release> > queued_releases;
+
 
 
 
@@ -842,6 +858,8 @@ void process_job_attribute_information(
     {
     mutex_mgr job_mutex(pjob->ji_mutex, true);
     char *attr_val = threadsafe_tokenizer(&attr_work, ",");
+    bool  changed = false;
+    int   rc;
     
     while (attr_val != NULL)
       {
@@ -850,16 +868,24 @@ void process_job_attribute_information(
       if ((attr_name != NULL) &&
           (attr_val != '\0'))
         {
-        if (str_to_attr(attr_name, attr_val, pjob->ji_wattr, job_attr_def, JOB_ATR_LAST) == ATTR_NOT_FOUND)
+        if ((rc = str_to_attr(attr_name, attr_val, pjob->ji_wattr, job_attr_def, JOB_ATR_LAST)) == ATTR_NOT_FOUND)
           {
           // should be resources used if not found as attribute
-          decode_resc(&(pjob->ji_wattr[JOB_ATR_resc_used]), ATTR_used, attr_name, attr_val, ATR_DFLAG_ACCESS);
+          rc = decode_resc(&(pjob->ji_wattr[JOB_ATR_resc_used]), ATTR_used, attr_name, attr_val, ATR_DFLAG_ACCESS);
           }
+
+        if (rc == PBSE_NONE)
+          changed = true;
         }
 
       attr_val = threadsafe_tokenizer(&attr_work, ",");
       }
 
+    /* these updates are not saved, so the job has to be marked changed here
+     * for delta status and the status cache to see them */
+    if (changed == true)
+      job_delta_touch(pjob);
+
     pjob->ji_last_reported_time = time(NULL);
     }
 
@@ -3746,22 +3772,34 @@ int add_job_to_mic(
 
 
 
-int remove_job_from_nodes_mics(
+static void release_node_mics(
 
   struct pbsnode *pnode,
-  job            *pjob)
+  int             internal_job_id)
 
   {
   short i;
 
   for (i = 0; i < pnode->nd_nmics; i++)
     {
-    if (pnode->nd_micjobs[i].internal_job_id == pjob->ji_internal_id)
+    if (pnode->nd_micjobs[i].internal_job_id == internal_job_id)
       {
       pnode->nd_nmics_free++;
       pnode->nd_micjobs[i].internal_job_id = -1;
       }
     }
+  } /* END release_node_mics() */
+
+
+
+
+int remove_job_from_nodes_mics(
+
+  struct pbsnode *pnode,
+  job            *pjob)
+
+  {
+  release_node_mics(pnode, pjob->ji_internal_id);
 
   return(PBSE_NONE);
   } /* END remove_job_from_nodes_mics() */
@@ -4675,6 +4713,9 @@ int set_nodes(
 
   int gpu_flags = 0;
 
+  /* nodes still held by finished jobs go back before any are handed out */
+  free_queued_nodes();
+
   if (FailHost != NULL)
     FailHost[0] = '\0';
 
@@ -5309,22 +5350,26 @@ char *get_next_exec_host(
 
 
 
-int remove_job_from_nodes_gpus(
+/*
+ * release_node_gpus - free the gpus of pnode which exec_gpus gives the job
+ *
+ * @param gpu_str - the job's exec_gpus, NULL if it has none
+ */
+
+static void release_node_gpus(
 
   struct pbsnode *pnode,
-  job            *pjob)
+  const char     *jobid,
+  int             internal_job_id,
+  const char     *gpu_str)
 
   {
   struct gpusubn *gn;
-  char           *gpu_str = NULL;
   int             i;
   char            log_buf[LOCAL_LOG_BUF_SIZE];
   std::string     tmp_str;
   char            num_str[6];
  
-  if (pjob->ji_wattr[JOB_ATR_exec_gpus].at_flags & ATR_VFLAG_SET)
-    gpu_str = pjob->ji_wattr[JOB_ATR_exec_gpus].at_val.at_str;
-
   if (gpu_str != NULL)
     {
     /* reset gpu nodes */
@@ -5366,7 +5411,7 @@ int remove_job_from_nodes_gpus(
               sprintf(log_buf, "freeing node %s gpu %d for job %s",
                 pnode->nd_name,
                 i,
-                pjob->ji_qs.ji_jobid);
+                jobid);
               
               log_record(PBSEVENT_SCHED, PBS_EVENTCLASS_REQUEST, __func__, log_buf);
               }
@@ -5376,7 +5421,7 @@ int remove_job_from_nodes_gpus(
         }
       else
         {
-        if (gn->job_internal_id == pjob->ji_internal_id)
+        if (gn->job_internal_id == internal_job_id)
           {
           gn->inuse = FALSE;
           gn->job_internal_id = -1;
@@ -5386,6 +5431,23 @@ int remove_job_from_nodes_gpus(
         }
       }
     }
+  } /* END release_node_gpus() */
+
+
+
+
+int remove_job_from_nodes_gpus(
+
+  struct pbsnode *pnode,
+  job            *pjob)
+
+  {
+  char *gpu_str = NULL;
+
+  if (pjob->ji_wattr[JOB_ATR_exec_gpus].at_flags & ATR_VFLAG_SET)
+    gpu_str = pjob->ji_wattr[JOB_ATR_exec_gpus].at_val.at_str;
+
+  release_node_gpus(pnode, pjob->ji_qs.ji_jobid, pjob->ji_internal_id, gpu_str);
 
   return(PBSE_NONE);
   } /* END remove_job_from_nodes_gpus() */
@@ -5495,6 +5557,123 @@ void free_nodes(
 
 
 
+/*
+ * queue_free_nodes - free_nodes() for the exits of a batch of obituaries:
+ * the job's slots, gpus and mics are only noted here and freed with every
+ * other job's by the next free_queued_nodes(), which locks each node once
+ */
+
+void queue_free_nodes(
+
+  job *pjob)  /* I (modified) */
+
+  {
+  queued_release  qr;
+  char            log_buf[LOCAL_LOG_BUF_SIZE];
+  char           *exec_hosts = NULL;
+  char           *host_ptr = NULL;
+  char           *hostname;
+
+  if (LOGLEVEL >= 3)
+    {
+    sprintf(log_buf, "queueing the freeing of nodes for job %s", pjob->ji_qs.ji_jobid);
+
+    log_record(PBSEVENT_SCHED, PBS_EVENTCLASS_REQUEST, __func__, log_buf);
+    }
+
+  qr.jobid = pjob->ji_qs.ji_jobid;
+  qr.internal_job_id = pjob->ji_internal_id;
+  qr.has_gpus = false;
+  qr.login = false;
+
+  if ((pjob->ji_wattr[JOB_ATR_exec_gpus].at_flags & ATR_VFLAG_SET) &&
+      (pjob->ji_wattr[JOB_ATR_exec_gpus].at_val.at_str != NULL))
+    {
+    qr.exec_gpus = pjob->ji_wattr[JOB_ATR_exec_gpus].at_val.at_str;
+    qr.has_gpus = true;
+    }
+
+  if (pjob->ji_wattr[JOB_ATR_exec_host].at_flags & ATR_VFLAG_SET)
+    {
+    if (pjob->ji_wattr[JOB_ATR_exec_host].at_val.at_str != NULL)
+      {
+      exec_hosts = strdup(pjob->ji_wattr[JOB_ATR_exec_host].at_val.at_str);
+      host_ptr = exec_hosts;
+      }
+    }
+
+  pthread_mutex_lock(&queued_releases_mutex);
+
+  /* once per exec_host entry, as free_nodes() does */
+  while ((hostname = get_next_exec_host(&host_ptr)) != NULL)
+    queued_releases[hostname].push_back(qr);
+
+  if (pjob->ji_wattr[JOB_ATR_login_node_id].at_val.at_str != NULL)
+    {
+    qr.login = true;
+    queued_releases[pjob->ji_wattr[JOB_ATR_login_node_id].at_val.at_str].push_back(qr);
+    }
+
+  pthread_mutex_unlock(&queued_releases_mutex);
+
+  free(exec_hosts);
+
+  pjob->ji_qs.ji_svrflags &= ~JOB_SVFLG_HasNodes;
+  } /* END queue_free_nodes() */
+
+
+
+
+/*
+ * free_queued_nodes - free the nodes queued by queue_free_nodes(), taking
+ * each node's lock once for all the jobs leaving it
+ *
+ * @return the number of nodes visited
+ */
+
+int free_queued_nodes()
+
+  {
+  std::map<std::string, std::vector<queued_release> >           releases;
+  std::map<std::string, std::vector<queued_release> >::iterator it;
+  struct pbsnode *pnode;
+  int             count = 0;
+
+  pthread_mutex_lock(&queued_releases_mutex);
+  releases.swap(queued_releases);
+  pthread_mutex_unlock(&queued_releases_mutex);
+
+  for (it = releases.begin(); it != releases.end(); it++)
+    {
+    if ((pnode = find_nodebyname(it->first.c_str())) == NULL)
+      continue;
+
+    for (unsigned int i = 0; i < it->second.size(); i++)
+      {
+      queued_release &qr = it->second[i];
+
+      remove_job_from_node(pnode, qr.internal_job_id);
+
+      if (qr.login == false)
+        {
+        release_node_gpus(pnode,
+          qr.jobid.c_str(),
+          qr.internal_job_id,
+          (qr.has_gpus == true) ? qr.exec_gpus.c_str() : NULL);
+        release_node_mics(pnode, qr.internal_job_id);
+        }
+      }
+
+    unlock_node(pnode, __func__, NULL, LOGLEVEL);
+    count++;
+    }
+
+  return(count);
+  } /* END free_queued_nodes() */
+
+
+
+
 struct pbsnode *get_compute_node(
 
   char *node_name)
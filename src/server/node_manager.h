@@ -79,6 +79,10 @@ int node_reserve(char *nspec, resource_t tag);
 
 void free_nodes(job *pjob);
 
+void queue_free_nodes(job *pjob);
+
+int free_queued_nodes();
+
 void sync_node_jobs_with_moms(struct pbsnode *np, const char *jobs_in_mom);
 
 #endif /* _NODE_MANAGER_H */
@@ -138,6 +138,8 @@
 #include "id_map.hpp"
 #include "exiting_jobs.h"
 #include "mom_hierarchy_handler.h"
+#include "job_journal.h"
+#include "mail_spool.h"
 
 
 /*#ifndef SIGKILL*/
@@ -183,6 +185,7 @@ extern char  path_log[];
 extern char *path_priv;
 extern char *path_arrays;
 extern char *path_jobs;
+extern char *path_mail;
 extern char *path_credentials;
 extern char *path_queues;
 extern char *path_spool;
@@ -200,6 +203,8 @@ extern char *path_nodenote_new;
 extern char *path_checkpoint;
 extern char *path_jobinfo_log;
 
+extern attribute_def            node_attr_def[];
+
 extern int                      queue_rank;
 extern char                     server_name[];
 extern tlist_head               svr_newnodes;
@@ -751,6 +756,7 @@ int initialize_paths()
   path_spool         = build_path(path_home, PBS_SPOOLDIR, suffix_slash);
   path_queues        = build_path(path_priv, PBS_QUEDIR,   suffix_slash);
   path_jobs          = build_path(path_priv, PBS_JOBDIR,   suffix_slash);
+  path_mail          = build_path(path_priv, PBS_MAILDIR,  suffix_slash);
   path_credentials   = build_path(path_priv, PBS_CREDENTIALDIR, suffix_slash);
   path_acct          = build_path(path_priv, PBS_ACCT,     suffix_slash);
 
@@ -936,6 +942,12 @@ int initialize_data_structures_and_mutexes()
   acctfile_mutex = (pthread_mutex_t *)calloc(1, sizeof(pthread_mutex_t));
   pthread_mutex_init(acctfile_mutex, NULL);
 
+  /* hash the attribute names so find_attr() doesn't scan the definitions */
+  index_attr_defs(svr_attr_def, SRV_ATR_LAST);
+  index_attr_defs(que_attr_def, QA_ATR_LAST);
+  index_attr_defs(job_attr_def, JOB_ATR_LAST);
+  index_attr_defs(node_attr_def, ND_ATR_LAST);
+
   return(PBSE_NONE);
   } /* END initialize_data_structures_and_mutexes() */
 
@@ -1042,6 +1054,14 @@ int setup_server_attrs(
     (char *)PACKAGE_VERSION,
     0);
 
+  /* optional requests clients may use, see submit_stepwise() */
+  svr_attr_def[SRV_ATR_Capabilities].at_decode(
+    &server.sv_attr[SRV_ATR_Capabilities],
+    0,
+    0,
+    (char *)SUBMIT_JOB_CAPABILITY,
+    0);
+
   /* open accounting file and job log file if logging is set */
   if (acct_open(acct_file, false) != 0)
     {
@@ -1419,6 +1439,9 @@ int handle_job_recovery(
 
   had = server.sv_qs.sv_numjobs;
 
+  /* records newer than the job files are replayed as the jobs are recovered */
+  job_journal_load(path_jobs);
+
   server.sv_qs.sv_numjobs = 0;
   sprintf(log_buf, "%s:2", __func__);
   unlock_sv_qs_mutex(server.sv_qs_mutex, log_buf);
@@ -1825,6 +1848,10 @@ int handle_job_and_array_recovery(
   else
     rc = cleanup_recovered_arrays();
 
+  /* every recovered job has been rewritten, start a new journal */
+  if (job_journal_open(path_jobs) != PBSE_NONE)
+    log_err(-1, __func__, "cannot open the job journal, job files will be rewritten on every save");
+
   return(rc);
   } /* END handle_job_and_array_recovery() */
 
@@ -1985,6 +2012,9 @@ int pbsd_init(
 
     initialize_data_structures_and_mutexes();
 
+    /* fork the mail helper before the jobs are read in */
+    mail_spool_start(path_mail);
+
     /* 3. Set default server attibutes values */
     if ((ret = setup_server_attrs(type)) != PBSE_NONE)
       return(ret);
@@ -148,6 +148,7 @@
 #include "mom_hierarchy_handler.h"
 #include "track_alps_reservations.h"
 #include "completed_jobs_map.h"
+#include "mail_spool.h"
 
 
 #define TASK_CHECK_INTERVAL      10
@@ -233,6 +234,7 @@ char                   *path_priv = NULL;
 char                   *path_arrays;
 char                   *path_credentials;
 char                   *path_jobs;
+char                   *path_mail;
 char                   *path_queues;
 char                   *path_spool;
 char                   *path_svrdb = NULL;
@@ -1883,6 +1885,9 @@ int main(
   log_open(log_file, path_log);
   pthread_mutex_unlock(&log_mutex);
 
+  /* from here on log_record() queues lines for the log writer thread */
+  log_start_writer();
+
   sprintf(log_buf, msg_startup1, server_name, server_init_type);
 
   log_event(
@@ -1952,6 +1957,9 @@ int main(
 
   acct_close(false);
 
+  /* mail not yet sent is left in the spool for the next start */
+  mail_spool_shutdown();
+
   pthread_mutex_lock(&log_mutex);
   log_close(1);
   pthread_mutex_unlock(&log_mutex);
@@ -79,6 +79,9 @@
 
 #include <stdio.h>
 #include <ctype.h>
+#include <algorithm>
+#include <set>
+#include <map>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -96,6 +99,7 @@
 #include "../lib/Libutils/u_lock_ctl.h"
 #include "mutex_mgr.hpp"
 #include "id_map.hpp"
+#include "mom_update.h"
 
 
 extern attribute_def    node_attr_def[];   /* node attributes defs */
@@ -742,6 +746,161 @@ int save_node_status(
 
 
 
+/*
+ * status_key_len - the length of the key in a "key=value" status string
+ */
+
+size_t status_key_len(
+
+  const char *str)
+
+  {
+  const char *eq = strchr(str, '=');
+
+  if (eq == NULL)
+    return(strlen(str));
+
+  return(eq - str);
+  } /* END status_key_len() */
+
+
+
+
+/*
+ * record_raw_status - remember a status string the mom sent so that later
+ * deltas can be applied to it.  The string replaces the one with the same key.
+ */
+
+void record_raw_status(
+
+  struct pbsnode *np,
+  const char     *str)
+
+  {
+  if (np->nd_raw_status == NULL)
+    np->nd_raw_status = new std::map<std::string, std::string>();
+
+  (*np->nd_raw_status)[std::string(str, status_key_len(str))] = str;
+  np->nd_status_stale = true;
+  } /* END record_raw_status() */
+
+
+
+
+void remove_raw_status(
+
+  struct pbsnode *np,
+  const char     *key)
+
+  {
+  if (np->nd_raw_status == NULL)
+    return;
+
+  if (np->nd_raw_status->erase(key) != 0)
+    np->nd_status_stale = true;
+  } /* END remove_raw_status() */
+
+
+
+
+/*
+ * refresh_node_status - rebuild nd_status from the strings of the mom's
+ * versioned updates.  This is only done when the status is about to be read,
+ * so a busy mom's deltas are not decoded over and over in between.
+ *
+ * The node must be locked.
+ */
+
+int refresh_node_status(
+
+  struct pbsnode *np)
+
+  {
+  pbs_attribute temp;
+  int           rc;
+
+  if ((np->nd_status_stale == false) ||
+      (np->nd_raw_status == NULL))
+    return(PBSE_NONE);
+
+  memset(&temp, 0, sizeof(temp));
+
+  if ((rc = decode_arst(&temp, NULL, NULL, NULL, 0)) != PBSE_NONE)
+    return(rc);
+
+  for (std::map<std::string, std::string>::iterator it = np->nd_raw_status->begin();
+       it != np->nd_raw_status->end();
+       it++)
+    {
+    if ((rc = decode_arst(&temp, NULL, NULL, it->second.c_str(), 0)) != PBSE_NONE)
+      {
+      free_arst(&temp);
+      return(rc);
+      }
+    }
+
+  if ((rc = node_status_list(&temp, np, ATR_ACTION_ALTER)) == PBSE_NONE)
+    np->nd_status_stale = false;
+
+  free_arst(&temp);
+
+  return(rc);
+  } /* END refresh_node_status() */
+
+
+
+
+/*
+ * save_versioned_status - finish the status update for one node.
+ *
+ * Updates carrying a status_seq have only been recorded in nd_raw_status
+ * while they were processed; nd_status is rebuilt from there by
+ * refresh_node_status() the next time it is read.
+ * Unversioned updates (older moms, updates relayed through a mom hierarchy)
+ * are already in temp and drop whatever sequence the node had.
+ */
+
+int save_versioned_status(
+
+  struct pbsnode *np,
+  pbs_attribute  *temp,
+  unsigned long   status_seq,
+  bool            seq_mismatch)
+
+  {
+  char date_attrib[MAXLINE];
+
+  if (seq_mismatch == true)
+    {
+    /* leave the node's status alone until the mom sends all of it */
+    free_arst(temp);
+    return(PBSE_NONE);
+    }
+
+  np->nd_status_seq = status_seq;
+
+  if (status_seq == 0)
+    {
+    if (np->nd_raw_status != NULL)
+      np->nd_raw_status->clear();
+
+    np->nd_status_stale = false;
+
+    return(save_node_status(np, temp));
+    }
+
+  /* it's nice to know when the last update happened */
+  snprintf(date_attrib, sizeof(date_attrib), "rectime=%ld", (long)time(NULL));
+  record_raw_status(np, date_attrib);
+
+  free_arst(temp);
+
+  return(PBSE_NONE);
+  } /* END save_versioned_status() */
+
+
+
+
 int process_status_info(
 
   const char               *nd_name,
@@ -757,6 +916,11 @@ int process_status_info(
   pbs_attribute   temp;
   int             rc = PBSE_NONE;
   bool            send_hello = false;
+  bool            delta = false;
+  bool            seq_mismatch = false;
+  bool            any_mismatch = false;
+  unsigned long   status_seq = 0;
+  char            log_buf[LOCAL_LOG_BUF_SIZE];
 
   get_svr_attr_l(SRV_ATR_MomJobSync, &mom_job_sync);
   get_svr_attr_l(SRV_ATR_AutoNodeNP, &auto_np);
@@ -797,9 +961,12 @@ int process_status_info(
       {
       /* if we've already processed some, save this before moving on */
       if (i != 0)
-        save_node_status(current, &temp);
+        save_versioned_status(current, &temp, status_seq, seq_mismatch);
       
       dont_change_state = FALSE;
+      delta = false;
+      seq_mismatch = false;
+      status_seq = 0;
 
       if ((current = get_numa_from_str(str, current)) == NULL)
         break;
@@ -810,9 +977,12 @@ int process_status_info(
       {
       /* if we've already processed some, save this before moving on */
       if (i != 0)
-        save_node_status(current, &temp);
+        save_versioned_status(current, &temp, status_seq, seq_mismatch);
 
       dont_change_state = FALSE;
+      delta = false;
+      seq_mismatch = false;
+      status_seq = 0;
 
       if ((current = get_node_from_str(str, name, current)) == NULL)
         break;
@@ -834,6 +1004,56 @@ int process_status_info(
         continue;
         }
       }
+    else if (seq_mismatch == true)
+      {
+      /* the rest of this node's update is relative to one we don't have */
+      continue;
+      }
+    else if (!strncmp(str, "status_delta=", strlen("status_delta=")))
+      {
+      /* only the keys that changed since update <base> follow */
+      unsigned long base = strtoul(str + strlen("status_delta="), NULL, 10);
+
+      if ((base == 0) ||
+          (base != current->nd_status_seq))
+        {
+        if (LOGLEVEL >= 3)
+          {
+          snprintf(log_buf, sizeof(log_buf),
+            "status delta from %s is based on update %lu but the last one received was %lu, requesting a full update",
+            current->nd_name, base, current->nd_status_seq);
+          log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_NODE, __func__, log_buf);
+          }
+
+        seq_mismatch = true;
+        any_mismatch = true;
+        }
+      else
+        delta = true;
+
+      continue;
+      }
+    else if (!strncmp(str, "status_seq=", strlen("status_seq=")))
+      {
+      status_seq = strtoul(str + strlen("status_seq="), NULL, 10);
+
+      /* a full update replaces everything the mom sent before */
+      if ((delta == false) &&
+          (current->nd_raw_status != NULL))
+        {
+        current->nd_raw_status->clear();
+        current->nd_status_stale = true;
+        }
+
+      continue;
+      }
+    else if (!strncmp(str, "status_removed=", strlen("status_removed=")))
+      {
+      if (status_seq != 0)
+        remove_raw_status(current, str + strlen("status_removed="));
+
+      continue;
+      }
 
     /* add the info to the "temp" pbs_attribute */
     else if (!strcmp(str, START_GPU_STATUS))
@@ -855,6 +1075,11 @@ int process_status_info(
       /* reset gpu data in case mom reconnects with changed gpus */
       clear_nvidia_gpus(current);
       }
+    else if (status_seq != 0)
+      {
+      /* versioned updates are decoded from nd_raw_status when saved */
+      record_raw_status(current, str);
+      }
     else if ((rc = decode_arst(&temp, NULL, NULL, str, 0)) != PBSE_NONE)
       {
       DBPRT(("is_stat_get: cannot add attributes\n"));
@@ -935,11 +1160,15 @@ int process_status_info(
 
   if (current != NULL)
     {
-    save_node_status(current, &temp);
+    save_versioned_status(current, &temp, status_seq, seq_mismatch);
     unlock_node(current, __func__, NULL, LOGLEVEL);
     }
   
+  /* a mismatch wins over the hello: the mom must resend before anything else */
   if ((rc == PBSE_NONE) &&
+      (any_mismatch == true))
+    rc = STATUS_SEQ_MISMATCH;
+  else if ((rc == PBSE_NONE) &&
       (send_hello == true))
     rc = SEND_HELLO;
     
@@ -948,6 +1177,248 @@ int process_status_info(
 
 
 
+
+/*
+ * Status updates are read and parsed by the thread that accepted the mom's
+ * connection and queued on one of MOM_UPDATE_SHARDS lock-free stacks, picked
+ * by node name.  One apply task per shard drains it on the task pool, so a
+ * burst of updates after a restart waits in the queues instead of leaving
+ * every request thread blocked on node and job mutexes, and an update that
+ * a newer one from the same mom replaces is never applied at all.
+ */
+
+static mom_update_shard update_shards[MOM_UPDATE_SHARDS];
+
+
+
+/*
+ * new_mom_update - wrap a mom's status strings for the apply queue
+ *
+ * @param status - the strings, taken over (status is left empty)
+ */
+
+mom_update *new_mom_update(
+
+  const char               *node_name,
+  std::vector<std::string> &status)
+
+  {
+  mom_update *mu = new mom_update();
+
+  mu->next = NULL;
+  mu->node_name = node_name;
+  mu->status.swap(status);
+  mu->full = true;
+  mu->coalescable = true;
+  mu->first_update = false;
+
+  for (unsigned int i = 0; i < mu->status.size(); i++)
+    {
+    const char *str = mu->status[i].c_str();
+
+    if (!strncmp(str, "status_delta=", strlen("status_delta=")))
+      mu->full = false;
+    else if (!strcmp(str, "first_update=true"))
+      {
+      /* gpus are reset when this is applied, it can't be skipped */
+      mu->first_update = true;
+      mu->coalescable = false;
+      }
+    else if ((!strncmp(str, "node=", strlen("node="))) &&
+             (strcmp(str + strlen("node="), node_name)))
+      {
+      /* relayed through a mom hierarchy, the next update may carry
+       * different nodes */
+      mu->coalescable = false;
+      }
+    }
+
+  return(mu);
+  } /* END new_mom_update() */
+
+
+
+/*
+ * coalesce_mom_updates - drop updates a newer full update from the same mom replaces
+ *
+ * Deltas are only dropped along with the update they are relative to.
+ *
+ * @param batch - one shard's updates, oldest first; the dropped ones are
+ * freed and removed
+ * @return the number of updates dropped
+ */
+
+int coalesce_mom_updates(
+
+  std::vector<mom_update *> &batch)
+
+  {
+  std::set<std::string> replaced;
+  int                   dropped = 0;
+  unsigned int          kept = 0;
+
+  for (int i = batch.size() - 1; i >= 0; i--)
+    {
+    mom_update *mu = batch[i];
+
+    if ((mu->coalescable == true) &&
+        (replaced.find(mu->node_name) != replaced.end()))
+      {
+      delete mu;
+      batch[i] = NULL;
+      dropped++;
+      continue;
+      }
+
+    if (mu->full == true)
+      replaced.insert(mu->node_name);
+    }
+
+  for (unsigned int i = 0; i < batch.size(); i++)
+    {
+    if (batch[i] != NULL)
+      batch[kept++] = batch[i];
+    }
+
+  batch.resize(kept);
+
+  return(dropped);
+  } /* END coalesce_mom_updates() */
+
+
+
+static void apply_mom_update(
+
+  mom_update *mu)
+
+  {
+  int             rc;
+  struct pbsnode *pnode;
+  char            log_buf[LOCAL_LOG_BUF_SIZE];
+
+  rc = process_status_info(mu->node_name.c_str(), mu->status);
+
+  if (rc == STATUS_SEQ_MISMATCH)
+    {
+    /* the mom was already answered; tell it to send everything next time */
+    if ((pnode = find_nodebyname(mu->node_name.c_str())) != NULL)
+      {
+      pnode->nd_request_full_status = TRUE;
+      unlock_node(pnode, __func__, NULL, LOGLEVEL);
+      }
+    }
+  else if ((rc != PBSE_NONE) &&
+           (rc != SEND_HELLO))
+    {
+    snprintf(log_buf, sizeof(log_buf), "error %d applying the status update from %s",
+      rc, mu->node_name.c_str());
+    log_err(rc, __func__, log_buf);
+    }
+  } /* END apply_mom_update() */
+
+
+
+/*
+ * apply_mom_updates - drain one shard's queue
+ *
+ * Runs until the shard is empty; only one runs per shard at a time.
+ *
+ * @param vp - the mom_update_shard
+ */
+
+void *apply_mom_updates(
+
+  void *vp)
+
+  {
+  mom_update_shard *shard = (mom_update_shard *)vp;
+  mom_update       *mu;
+  int               dropped;
+  char              log_buf[LOCAL_LOG_BUF_SIZE];
+
+  while (true)
+    {
+    std::vector<mom_update *> batch;
+
+    if ((mu = __sync_lock_test_and_set(&shard->head, NULL)) == NULL)
+      {
+      /* give up the shard, unless an update was queued meanwhile */
+      __sync_lock_release(&shard->scheduled);
+      __sync_synchronize();
+
+      if ((shard->head == NULL) ||
+          (!__sync_bool_compare_and_swap(&shard->scheduled, 0, 1)))
+        break;
+
+      continue;
+      }
+
+    for (; mu != NULL; mu = mu->next)
+      batch.push_back(mu);
+
+    std::reverse(batch.begin(), batch.end());
+
+    if (((dropped = coalesce_mom_updates(batch)) > 0) &&
+        (LOGLEVEL >= 7))
+      {
+      snprintf(log_buf, sizeof(log_buf),
+        "%d status updates replaced by newer ones before they were applied", dropped);
+      log_record(PBSEVENT_DEBUG, PBS_EVENTCLASS_NODE, __func__, log_buf);
+      }
+
+    for (unsigned int i = 0; i < batch.size(); i++)
+      {
+      apply_mom_update(batch[i]);
+      delete batch[i];
+      }
+    }
+
+  return(NULL);
+  } /* END apply_mom_updates() */
+
+
+
+/*
+ * queue_mom_update - queue a mom's status update to be applied
+ *
+ * @param status - the strings, taken over (status is left empty)
+ * @return SEND_HELLO if the mom just started, else PBSE_NONE. A
+ * STATUS_SEQ_MISMATCH found when the update is applied is returned to the
+ * mom on its next update (see nd_request_full_status).
+ */
+
+int queue_mom_update(
+
+  const char               *node_name,
+  std::vector<std::string> &status)
+
+  {
+  mom_update       *mu = new_mom_update(node_name, status);
+  mom_update_shard *shard;
+  unsigned int      hash = 2166136261u;
+  int               rc = (mu->first_update == true) ? SEND_HELLO : PBSE_NONE;
+
+  for (const char *ptr = node_name; *ptr != '\0'; ptr++)
+    hash = (hash ^ (unsigned char)*ptr) * 16777619u;
+
+  shard = &update_shards[hash % MOM_UPDATE_SHARDS];
+
+  do
+    {
+    mu->next = shard->head;
+    } while (!__sync_bool_compare_and_swap(&shard->head, mu->next, mu));
+
+  if (__sync_bool_compare_and_swap(&shard->scheduled, 0, 1))
+    {
+    if (enqueue_threadpool_request(apply_mom_updates, shard, task_pool) != PBSE_NONE)
+      apply_mom_updates(shard);
+    }
+
+  return(rc);
+  } /* END queue_mom_update() */
+
+
+
 void move_past_gpu_status(
 
   unsigned int             &i,
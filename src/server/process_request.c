@@ -681,6 +681,7 @@ int process_request(
       case PBS_BATCH_QueueJob:
       case PBS_BATCH_RunJob:
       case PBS_BATCH_StageIn:
+      case PBS_BATCH_SubmitJob:
       case PBS_BATCH_jobscript:
 
         req_reject(PBSE_SVRDOWN, 0, request, NULL, NULL);
@@ -764,6 +765,14 @@ int dispatch_request(
       break;
 
 
+    case PBS_BATCH_SubmitJob:
+
+      net_add_close_func(sfds, close_quejob);
+      rc = req_submitjob(request);
+
+      break;
+
+
     case PBS_BATCH_DeleteJob:
 
       /* if this is a server size job delete request, then the request
@@ -1146,8 +1155,16 @@ void free_br(
     {
     case PBS_BATCH_QueueJob:
 
+    case PBS_BATCH_SubmitJob:
+
       free_attrlist(&preq->rq_ind.rq_queuejob.rq_attr);
 
+      if (preq->rq_ind.rq_queuejob.rq_script)
+        {
+        free(preq->rq_ind.rq_queuejob.rq_script);
+        preq->rq_ind.rq_queuejob.rq_script = NULL;
+        }
+
       break;
 
     case PBS_BATCH_JobCred:
@@ -259,9 +259,6 @@ pbs_queue *que_alloc(
   if (sv_qs_mutex_held == FALSE)
     unlock_sv_qs_mutex(server.sv_qs_mutex, __func__);
 
-  /* set up the user info struct */
-  pq->qu_uih = new user_info_holder();
-
   /* set the working attributes to "unspecified" */
 
   for (i = 0; i < QA_ATR_LAST; i++)
@@ -319,8 +316,6 @@ void que_free(
   if (sv_qs_mutex_held == FALSE)
     unlock_sv_qs_mutex(server.sv_qs_mutex, __func__);
 
-  delete pq->qu_uih;
-
   remove_queue(&svr_queues, pq);
   pq->q_being_recycled = TRUE;
   insert_into_queue_recycler(pq);
@@ -186,7 +186,7 @@ int is_stat_get(
   if (is_reporter_node(node_name))
     rc = process_alps_status(node_name, status_info);
   else
-    rc = process_status_info(node_name, status_info);
+    rc = queue_mom_update(node_name, status_info);
 
   return(rc);
   }  /* END is_stat_get() */
@@ -491,6 +491,9 @@ void *svr_is_request(
 
       {
       std::string node_name = node->nd_name;
+      bool        request_full = (node->nd_request_full_status == TRUE);
+
+      node->nd_request_full_status = FALSE;
      
       if (LOGLEVEL >= 2)
         {
@@ -504,6 +507,12 @@ void *svr_is_request(
 
       ret = is_stat_get(node_name.c_str(), chan);
 
+      /* an earlier delta from this mom could not be applied; a mom that
+       * just started has sent everything anyway and needs its hello */
+      if ((request_full == true) &&
+          (ret == PBSE_NONE))
+        ret = STATUS_SEQ_MISMATCH;
+
       node = find_nodebyname(node_name.c_str());
 
       if (node != NULL)
@@ -519,6 +528,12 @@ void *svr_is_request(
           hierarchy_handler.sendHierarchyToANode(node);
           ret = DIS_SUCCESS;
           }
+        else if (ret == STATUS_SEQ_MISMATCH)
+          {
+          /* not an error: tell the mom to send its full status next time */
+          write_tcp_reply(chan, IS_PROTOCOL, IS_PROTOCOL_VER, IS_STATUS, STATUS_SEQ_MISMATCH);
+          ret = DIS_SUCCESS;
+          }
         else
           write_tcp_reply(chan,IS_PROTOCOL,IS_PROTOCOL_VER,IS_STATUS,ret);
         }
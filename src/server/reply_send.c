@@ -163,9 +163,22 @@ int reply_send_svr(
   char  log_buf[LOCAL_LOG_BUF_SIZE];
   int   sfds = request->rq_conn;  /* socket */
 
+  if (request->rq_parent != NULL)
+    {
+    /* a step of a compound request, which sends the reply itself */
+    struct batch_reply *preply = &request->rq_parent->rq_reply;
+
+    reply_free(preply);
+    memcpy(preply, &request->rq_reply, sizeof(struct batch_reply));
+
+    if (preply->brp_choice == BATCH_REPLY_CHOICE_Status)
+      list_move(&request->rq_reply.brp_un.brp_status, &preply->brp_un.brp_status);
+
+    request->rq_reply.brp_choice = BATCH_REPLY_CHOICE_NULL;
+    }
   /* Handle remote replies - local batch requests no longer create work tasks */
-  if ((sfds >= 0) &&
-      (sfds != PBS_LOCAL_CONNECTION))
+  else if ((sfds >= 0) &&
+           (sfds != PBS_LOCAL_CONNECTION))
     {
     /* Otherwise, the reply is to be sent to a remote client */
 
@@ -293,6 +306,7 @@ void reply_free(
       {
       pstatx = (struct brp_status *)GET_NEXT(pstat->brp_stlink);
       free_attrlist(&pstat->brp_attr);
+      brp_encoded_release(pstat->brp_encoded);
       (void)free(pstat);
       pstat = pstatx;
       }
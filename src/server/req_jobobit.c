@@ -91,6 +91,9 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <errno.h>
+#include <sys/time.h>
+#include <string>
+#include <vector>
 #include "libpbs.h"
 #include "server_limits.h"
 #include "list_link.h"
@@ -124,6 +127,8 @@
 #include "track_alps_reservations.h"
 #include "id_map.hpp"
 #include "completed_jobs_map.h"
+#include "threadpool.h"
+#include "job_journal.h"
 
 #define RESC_USED_BUF 2048
 #define JOBMUSTREPORTDEFAULTKEEP 30
@@ -163,6 +168,44 @@ extern bool cpy_stdout_err_on_rerun;
 
 extern completed_jobs_map_class completed_jobs_map;
 
+/*
+ * the exits of one batch of obituaries.  Each is handled by its own task and
+ * writes its accounting records when it is done.  The wait for their journal
+ * records, the freeing of their nodes and the call of the scheduler are
+ * collected here and done once by the last of them, or by
+ * flush_obit_batch() OBIT_BATCH_HOLD_SECS after an exit left them waiting.
+ */
+typedef struct obit_batch_state
+  {
+  pthread_mutex_t          ob_mutex;
+  int                      ob_pending;      /* exits still being handled */
+  bool                     ob_flush_set;    /* obit_batch_flush_task() is set */
+  unsigned long long       ob_journal_seq;  /* last journal record to wait for */
+  std::vector<std::string> ob_saved;        /* jobs with records up to ob_journal_seq */
+  bool                     ob_released;     /* an exit released resources */
+  } obit_batch_state;
+
+/* obituaries waiting for process_obit_batch() */
+typedef struct obit_entry
+  {
+  std::string       jobid;
+  struct timeval    queued;
+  obit_batch_state *batch;
+  } obit_entry;
+
+static pthread_mutex_t          obit_batch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<obit_entry>  obit_batch;
+static bool                     obit_batch_scheduled = false;
+
+static obit_stage_stats         obit_stats[OBIT_STAGE_COUNT];
+static volatile unsigned long   obit_batches = 0;
+static const char              *obit_stage_names[] =
+  { "queued", "exiting", "returnstd", "stageout", "stagedel", "exited", "complete" };
+
+/* set while this thread handles a batch, see rel_resc() */
+static __thread bool            in_obit_batch = false;
+static __thread bool            obit_batch_released = false;
+
 /* External Functions called */
 
 int         timeval_subtract(struct timeval *,struct timeval *,struct timeval *);
@@ -726,6 +769,26 @@ int mom_comm(
 
 
 
+/*
+ * schedule_after_release - mark that the scheduler should be called now
+ * that resources are free
+ */
+
+static void schedule_after_release()
+
+  {
+  pthread_mutex_lock(svr_do_schedule_mutex);
+  svr_do_schedule = SCH_SCHEDULE_TERM;
+  pthread_mutex_unlock(svr_do_schedule_mutex);
+
+  pthread_mutex_lock(listener_command_mutex);
+  listener_command = SCH_SCHEDULE_TERM;
+  pthread_mutex_unlock(listener_command_mutex);
+  } /* END schedule_after_release() */
+
+
+
+
 /*
  * rel_resc - release resources assigned to the job
  */
@@ -745,19 +808,20 @@ void rel_resc(
     remove_alps_reservation(pjob->ji_wattr[JOB_ATR_reservation_id].at_val.at_str);
     }
 
-  free_nodes(pjob);
+  /* a batch of obits frees its nodes in one pass, see write_obit_batch() */
+  if (in_obit_batch == true)
+    queue_free_nodes(pjob);
+  else
+    free_nodes(pjob);
 
   /* removed the resources used by the job from the used svr/que attr  */
   set_resc_assigned(pjob, DECR);
 
-  /* mark that scheduler should be called */
-  pthread_mutex_lock(svr_do_schedule_mutex);
-  svr_do_schedule = SCH_SCHEDULE_TERM;
-  pthread_mutex_unlock(svr_do_schedule_mutex);
-
-  pthread_mutex_lock(listener_command_mutex);
-  listener_command = SCH_SCHEDULE_TERM;
-  pthread_mutex_unlock(listener_command_mutex);
+  /* and calls the scheduler once, when the nodes are back */
+  if (in_obit_batch == true)
+    obit_batch_released = true;
+  else
+    schedule_after_release();
 
   return;
   }  /* END rel_resc() */
@@ -1993,6 +2057,7 @@ void on_job_exit(
   job                  *pjob;
   int                   type = WORK_Deferred_Reply;
   char                  log_buf[LOCAL_LOG_BUF_SIZE];
+  struct timeval        stage_start;
 
   if (preq == NULL)
     type = WORK_Immed;
@@ -2037,7 +2102,9 @@ void on_job_exit(
 
     case JOB_SUBSTATE_ABORT:
 
+      gettimeofday(&stage_start, NULL);
       rc = handle_exiting_or_abort_substate(pjob);
+      obit_stage_done(OBIT_STAGE_EXITING, &stage_start);
       /* pjob->ji_mutex is always unlocked when returning from handle_exiting_or_abort_substate */
       pjob = NULL;
 
@@ -2055,7 +2122,11 @@ void on_job_exit(
           ((pjob = svr_find_job(job_id, TRUE)) == NULL))
         break;
 
-      if ((rc = handle_returnstd(pjob, preq, type)) != PBSE_NONE)
+      gettimeofday(&stage_start, NULL);
+      rc = handle_returnstd(pjob, preq, type);
+      obit_stage_done(OBIT_STAGE_RETURNSTD, &stage_start);
+
+      if (rc != PBSE_NONE)
         break;
 
       preq = NULL;
@@ -2067,7 +2138,11 @@ void on_job_exit(
           ((pjob = svr_find_job(job_id, TRUE)) == NULL))
         break;
 
-      if ((rc = handle_stageout(pjob, type, preq)) == PBSE_JOBNOTFOUND)
+      gettimeofday(&stage_start, NULL);
+      rc = handle_stageout(pjob, type, preq);
+      obit_stage_done(OBIT_STAGE_STAGEOUT, &stage_start);
+
+      if (rc == PBSE_JOBNOTFOUND)
         {
         snprintf(log_buf, sizeof(log_buf), "handle_stageout failed: %d", rc);
         log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, __func__, log_buf);
@@ -2087,7 +2162,11 @@ void on_job_exit(
         break;
         }
 
-      if ((rc = handle_stagedel(pjob, type, preq)) != PBSE_NONE)
+      gettimeofday(&stage_start, NULL);
+      rc = handle_stagedel(pjob, type, preq);
+      obit_stage_done(OBIT_STAGE_STAGEDEL, &stage_start);
+
+      if (rc != PBSE_NONE)
         {
         snprintf(log_buf, sizeof(log_buf), "handle_stagedel failed: %d", rc);
         log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, __func__, log_buf);
@@ -2107,7 +2186,9 @@ void on_job_exit(
         break;
         }
 
+      gettimeofday(&stage_start, NULL);
       rc = handle_exited(pjob);
+      obit_stage_done(OBIT_STAGE_EXITED, &stage_start);
 
       if ((rc == PBSE_JOBNOTFOUND) ||
           (rc == PBSE_CONNECT))
@@ -2130,6 +2211,8 @@ void on_job_exit(
         break;
         }
 
+      gettimeofday(&stage_start, NULL);
+
       if (pjob->ji_parent_job != NULL)
         {
         handle_complete_subjob(pjob);
@@ -2143,6 +2226,8 @@ void on_job_exit(
         set_task(WORK_Immed, 0, add_to_completed_jobs, strdup(pjob->ji_qs.ji_jobid), FALSE);
         }
 
+      obit_stage_done(OBIT_STAGE_COMPLETE, &stage_start);
+
       break;
 
     default:
@@ -2194,6 +2279,410 @@ void *on_job_exit_task(
 
 
 
+/*
+ * obit_stage_done - add the time since start to a stage of job exit
+ * processing for the obit_stats attribute
+ */
+
+void obit_stage_done(
+
+  int             stage,
+  struct timeval *start)
+
+  {
+  struct timeval     now;
+  unsigned long long usecs;
+  unsigned long long max_usecs;
+
+  gettimeofday(&now, NULL);
+
+  if ((now.tv_sec < start->tv_sec) ||
+      ((now.tv_sec == start->tv_sec) &&
+       (now.tv_usec < start->tv_usec)))
+    usecs = 0;
+  else
+    usecs = (now.tv_sec - start->tv_sec) * 1000000ULL + now.tv_usec - start->tv_usec;
+
+  __sync_add_and_fetch(&obit_stats[stage].count, 1);
+  __sync_add_and_fetch(&obit_stats[stage].usecs, usecs);
+
+  do
+    {
+    max_usecs = obit_stats[stage].max_usecs;
+
+    if (usecs <= max_usecs)
+      break;
+    } while (!__sync_bool_compare_and_swap(&obit_stats[stage].max_usecs, max_usecs, usecs));
+  } /* END obit_stage_done() */
+
+
+
+/*
+ * write_obit_batch - do what a batch's exits held back: one wait for their
+ * journal records, one pass freeing their nodes and one call of the
+ * scheduler if they released resources
+ */
+
+static void write_obit_batch(
+
+  unsigned long long        journal_seq,
+  std::vector<std::string> &saved,
+  bool                      released)
+
+  {
+  if (job_journal_wait(journal_seq) != PBSE_NONE)
+    {
+    /* the journal was turned off before the batch's changes got to disk */
+    for (unsigned int i = 0; i < saved.size(); i++)
+      {
+      job *pjob = svr_find_job((char *)saved[i].c_str(), TRUE);
+
+      if (pjob != NULL)
+        {
+        job_save(pjob, SAVEJOB_FULL, 0);
+        unlock_ji_mutex(pjob, __func__, NULL, LOGLEVEL);
+        }
+      }
+    }
+
+  if (released == true)
+    {
+    free_queued_nodes();
+    schedule_after_release();
+    }
+  } /* END write_obit_batch() */
+
+
+
+/*
+ * flush_obit_batch - do what a batch's exits have held back so far, and free
+ * the batch if all of them are done and no flush task is left to run
+ *
+ * @param flush_task - true when called for obit_batch_flush_task()
+ */
+
+static void flush_obit_batch(
+
+  obit_batch_state *ob,
+  bool              flush_task)
+
+  {
+  std::vector<std::string>  saved;
+  unsigned long long        journal_seq;
+  bool                      released;
+  bool                      done;
+
+  pthread_mutex_lock(&ob->ob_mutex);
+
+  saved.swap(ob->ob_saved);
+  journal_seq = ob->ob_journal_seq;
+  released = ob->ob_released;
+
+  ob->ob_journal_seq = 0;
+  ob->ob_released = false;
+
+  if (flush_task == true)
+    ob->ob_flush_set = false;
+
+  done = ((ob->ob_pending == 0) &&
+          (ob->ob_flush_set == false));
+
+  pthread_mutex_unlock(&ob->ob_mutex);
+
+  write_obit_batch(journal_seq, saved, released);
+
+  if (done == true)
+    {
+    pthread_mutex_destroy(&ob->ob_mutex);
+    delete ob;
+    }
+  } /* END flush_obit_batch() */
+
+
+
+/*
+ * obit_batch_flush_task - keep a slow exit from holding back what the
+ * others of its batch left waiting
+ */
+
+void obit_batch_flush_task(
+
+  struct work_task *ptask)
+
+  {
+  obit_batch_state *ob = (obit_batch_state *)ptask->wt_parm1;
+
+  free(ptask->wt_mutex);
+  free(ptask);
+
+  flush_obit_batch(ob, true);
+  } /* END obit_batch_flush_task() */
+
+
+
+/*
+ * obit_exit_done - add what an exit held back to its batch.  The last exit
+ * of a batch does it all; an earlier one makes sure it is done within
+ * OBIT_BATCH_HOLD_SECS.
+ */
+
+static void obit_exit_done(
+
+  obit_entry         *oe,
+  unsigned long long  journal_seq,
+  bool                released)
+
+  {
+  obit_batch_state *ob = oe->batch;
+  bool              last;
+  bool              set_flush = false;
+
+  pthread_mutex_lock(&ob->ob_mutex);
+
+  if (journal_seq != 0)
+    {
+    if (journal_seq > ob->ob_journal_seq)
+      ob->ob_journal_seq = journal_seq;
+
+    ob->ob_saved.push_back(oe->jobid);
+    }
+
+  if (released == true)
+    ob->ob_released = true;
+
+  last = (--ob->ob_pending == 0);
+
+  if ((last == false) &&
+      (ob->ob_flush_set == false) &&
+      ((ob->ob_journal_seq != 0) ||
+       (ob->ob_released == true)))
+    {
+    ob->ob_flush_set = true;
+    set_flush = true;
+    }
+
+  pthread_mutex_unlock(&ob->ob_mutex);
+
+  if (last == true)
+    flush_obit_batch(ob, false);
+  else if ((set_flush == true) &&
+           (set_task(WORK_Timed, time(NULL) + OBIT_BATCH_HOLD_SECS, obit_batch_flush_task, ob, FALSE) == NULL))
+    flush_obit_batch(ob, true);
+  } /* END obit_exit_done() */
+
+
+
+/*
+ * obit_exit_task - handle one exit of a batch.  Its accounting records are
+ * written when it is done; its journal wait, node release and scheduler
+ * call are left to the batch.
+ */
+
+void *obit_exit_task(
+
+  void *vp)
+
+  {
+  obit_entry         *oe = (obit_entry *)vp;
+  unsigned long long  journal_seq;
+
+  obit_stage_done(OBIT_STAGE_QUEUED, &oe->queued);
+
+  in_obit_batch = true;
+  obit_batch_released = false;
+
+  account_batch_begin();
+  job_journal_begin_batch();
+
+  on_job_exit(NULL, strdup(oe->jobid.c_str()));
+
+  account_batch_end();
+  journal_seq = job_journal_detach_batch();
+
+  in_obit_batch = false;
+
+  obit_exit_done(oe, journal_seq, obit_batch_released);
+
+  delete oe;
+
+  return(NULL);
+  } /* END obit_exit_task() */
+
+
+
+/*
+ * process_obit_batch - start the exits of the obituaries queued so far,
+ * OBIT_BATCH_MAX to a batch
+ *
+ * Each exit is its own task, since its stages talk to the MOM.  The batch
+ * only joins up the wait for their journal records, the freeing of their
+ * nodes and the call of the scheduler (see obit_exit_done()).
+ *
+ * @return the number of obituaries started
+ */
+
+int process_obit_batch()
+
+  {
+  std::vector<obit_entry> batch;
+  obit_batch_state       *ob;
+  bool                    more = true;
+  int                     handled = 0;
+  char                    log_buf[LOCAL_LOG_BUF_SIZE];
+
+  while (more == true)
+    {
+    batch.clear();
+
+    pthread_mutex_lock(&obit_batch_mutex);
+
+    if (obit_batch.size() > OBIT_BATCH_MAX)
+      {
+      batch.assign(obit_batch.begin(), obit_batch.begin() + OBIT_BATCH_MAX);
+      obit_batch.erase(obit_batch.begin(), obit_batch.begin() + OBIT_BATCH_MAX);
+      }
+    else
+      {
+      batch.swap(obit_batch);
+      more = false;
+      obit_batch_scheduled = false;
+      }
+
+    pthread_mutex_unlock(&obit_batch_mutex);
+
+    if (batch.size() == 0)
+      break;
+
+    ob = new obit_batch_state();
+    pthread_mutex_init(&ob->ob_mutex, NULL);
+    ob->ob_pending = batch.size();
+    ob->ob_flush_set = false;
+    ob->ob_journal_seq = 0;
+    ob->ob_released = false;
+
+    /* ob belongs to the exits once the first is started */
+    for (unsigned int i = 0; i < batch.size(); i++)
+      {
+      obit_entry *oe = new obit_entry(batch[i]);
+
+      oe->batch = ob;
+
+      if (enqueue_threadpool_request(obit_exit_task, oe, task_pool) != PBSE_NONE)
+        {
+        /* try this one again later, by itself */
+        set_task(WORK_Timed, time(NULL) + PBS_NET_RETRY_TIME, (void (*)(struct work_task *))on_job_exit_task, strdup(oe->jobid.c_str()), FALSE);
+
+        obit_exit_done(oe, 0, false);
+        delete oe;
+        }
+      }
+
+    __sync_add_and_fetch(&obit_batches, 1);
+    handled += batch.size();
+
+    if (LOGLEVEL >= 7)
+      {
+      snprintf(log_buf, sizeof(log_buf), "started a batch of %d job obituaries", (int)batch.size());
+      log_event(PBSEVENT_JOB, PBS_EVENTCLASS_SERVER, __func__, log_buf);
+      }
+    }
+
+  return(handled);
+  } /* END process_obit_batch() */
+
+
+
+/*
+ * obit_batch_task - start the exits of the obituaries which have queued up
+ * by the time it runs
+ */
+
+void *obit_batch_task(
+
+  void *vp)
+
+  {
+  process_obit_batch();
+
+  return(NULL);
+  } /* END obit_batch_task() */
+
+
+
+/*
+ * queue_obit - queue a job's exit processing for the next obituary batch
+ *
+ * The first obituary of a batch starts a task which starts it, and whatever
+ * queues up behind it while that task waits for a thread.
+ */
+
+void queue_obit(
+
+  const char *job_id)
+
+  {
+  obit_entry oe;
+  bool       start = false;
+
+  oe.jobid = job_id;
+  gettimeofday(&oe.queued, NULL);
+  oe.batch = NULL;
+
+  pthread_mutex_lock(&obit_batch_mutex);
+
+  obit_batch.push_back(oe);
+
+  if (obit_batch_scheduled == false)
+    {
+    obit_batch_scheduled = true;
+    start = true;
+    }
+
+  pthread_mutex_unlock(&obit_batch_mutex);
+
+  if (start == true)
+    {
+    if (enqueue_threadpool_request(obit_batch_task, NULL, task_pool) != PBSE_NONE)
+      process_obit_batch();
+    }
+  } /* END queue_obit() */
+
+
+
+/*
+ * format_obit_stats - describe job exit processing for the obit_stats
+ * attribute
+ */
+
+void format_obit_stats(
+
+  char *buf,
+  int   buf_len)
+
+  {
+  int len;
+
+  len = snprintf(buf, buf_len, "batches=%lu", obit_batches);
+
+  for (int i = 0; (i < OBIT_STAGE_COUNT) && (len < buf_len); i++)
+    {
+    unsigned long      count = obit_stats[i].count;
+    unsigned long long usecs = obit_stats[i].usecs;
+    double             avg = 0;
+
+    if (count > 0)
+      avg = (double)usecs / count / 1000;
+
+    len += snprintf(buf + len, buf_len - len, " %s=%lu/%.1f/%.1f",
+      obit_stage_names[i],
+      count,
+      avg,
+      (double)obit_stats[i].max_usecs / 1000);
+    }
+  } /* END format_obit_stats() */
+
+
+
 void *on_job_rerun_task(
 
   struct work_task *vp)
@@ -3642,7 +4131,7 @@ int req_jobobit(
       log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, job_id, log_buf);
       }
     
-    set_task(WORK_Immed, 0, (void (*)(struct work_task *))on_job_exit_task, strdup(job_id), 0);
+    queue_obit(job_id);
     }
 
   return(PBSE_NONE);
@@ -2,12 +2,37 @@
 #ifndef _REQ_JOBOBIT_H
 #define _REQ_JOBOBIT_H
 
+#include <sys/time.h> /* timeval */
+
 #include "batch_request.h" /* batch_request */
 #include "pbs_job.h" /* job, job_atr */
 #include "work_task.h" /* work_task */
 #include "attribute.h" /* svrattrl */
 #include "list_link.h" /* tlist_head */
 
+#define OBIT_BATCH_HOLD_SECS 1    /* longest a batch holds back its exits' journal wait and node release */
+#define OBIT_BATCH_MAX       1024 /* most obituaries in one batch */
+
+/* the stages of job exit processing timed for the obit_stats attribute */
+enum obit_stage
+  {
+  OBIT_STAGE_QUEUED,    /* waiting for its exit task to start */
+  OBIT_STAGE_EXITING,
+  OBIT_STAGE_RETURNSTD,
+  OBIT_STAGE_STAGEOUT,
+  OBIT_STAGE_STAGEDEL,
+  OBIT_STAGE_EXITED,
+  OBIT_STAGE_COMPLETE,
+  OBIT_STAGE_COUNT
+  };
+
+typedef struct obit_stage_stats
+  {
+  volatile unsigned long      count;
+  volatile unsigned long long usecs;
+  volatile unsigned long long max_usecs;
+  } obit_stage_stats;
+
 
 
 /* static char *setup_from(job *pjob, char *suffix); */
@@ -46,4 +71,12 @@ void encode_job_used(job *pjob, tlist_head *phead);
 
 int req_jobobit(struct batch_request *preq);
 
+void obit_stage_done(int stage, struct timeval *start);
+
+void queue_obit(const char *job_id);
+
+int process_obit_batch();
+
+void format_obit_stats(char *buf, int buf_len);
+
 #endif /* _REQ_JOBOBIT_H */
@@ -141,6 +141,7 @@
 #include "req_rerun.h"
 #include "req_delete.h"
 #include "mom_hierarchy_handler.h"
+#include "mom_update.h" /* refresh_node_status */
 
 
 #define PERM_MANAGER (ATR_DFLAG_MGWR | ATR_DFLAG_MGRD)
@@ -477,8 +478,11 @@ static int mgr_set_attr(
 
       (pdef + index)->at_free(pold);
 
-      if ((pold->at_type == ATR_TYPE_LIST) ||
-          (pold->at_type == ATR_TYPE_RESC))
+      if (pold->at_type == ATR_TYPE_RESC)
+        {
+        move_resc_list(pnew, pold);
+        }
+      else if (pold->at_type == ATR_TYPE_LIST)
         {
         list_move(&pnew->at_val.at_list, &pold->at_val.at_list);
         }
@@ -607,7 +611,7 @@ int mgr_unset_attr(
           prsdef->rs_free(&presc->rs_value);
           }
 
-        delete_link(&presc->rs_link);
+        unlink_resc_entry(pattr + index, presc);
         }
 
       free(presc);
@@ -738,6 +742,9 @@ int mgr_set_node_attr(
     return(PBSE_SYSTEM);
     }
 
+  /* the status list is copied into tnode below, so it has to be current */
+  refresh_node_status(pnode);
+
   for (index = 0; index < limit; index++)
     {
     if ((pdef + index)->at_action)
@@ -112,6 +112,7 @@
 #include "ji_mutex.h"
 #include "mutex_mgr.hpp"
 #include "threadpool.h"
+#include "job_delta.h"
 #include "mutex_mgr.hpp"
 #include <string>
 
@@ -1245,8 +1246,11 @@ int modify_job_attr(
 
       job_attr_def[i].at_free(pattr + i);
 
-      if ((newattr[i].at_type == ATR_TYPE_LIST) ||
-          (newattr[i].at_type == ATR_TYPE_RESC))
+      if (newattr[i].at_type == ATR_TYPE_RESC)
+        {
+        move_resc_list(&newattr[i], pattr + i);
+        }
+      else if (newattr[i].at_type == ATR_TYPE_LIST)
         {
         list_move(
           &newattr[i].at_val.at_list,
@@ -1264,6 +1268,7 @@ int modify_job_attr(
   /* note, the newattr[] attributes are on the stack, they go away automatically */
 
   pjob->ji_modified = 1;
+  job_delta_touch(pjob);
 
   return(PBSE_NONE);
   }  /* END modify_job_attr() */
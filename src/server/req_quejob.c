@@ -133,6 +133,7 @@
 #include "req_runjob.h"
 #include "mutex_mgr.hpp"
 #include "id_map.hpp"
+#include "reply_send.h"
 
 
 /* External Functions Called: */
@@ -2292,11 +2293,7 @@ int req_commit(
             log_buf);
           }
 
-        if (!pj->ji_is_array_template)
-          {
-          decrement_queued_jobs(pque->qu_uih, pj->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pj);
-          decrement_queued_jobs(&users, pj->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pj);
-          }
+        remove_user_usage(pj);
 
         svr_job_purge(pj);
         req_reject(rc, 0, preq, NULL, log_buf);
@@ -2315,11 +2312,7 @@ int req_commit(
         log_record(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, pj->ji_qs.ji_jobid, log_buf);
         }
       
-       if (!pj->ji_is_array_template)
-         {
-         decrement_queued_jobs(pque->qu_uih, pj->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pj);
-         decrement_queued_jobs(&users, pj->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pj);
-         }
+       remove_user_usage(pj);
 
       svr_job_purge(pj);
       req_reject(rc, 0, preq, NULL, log_buf);
@@ -2423,6 +2416,170 @@ int req_commit(
 
 
 
+/*
+ * new_submit_step - allocate a request for one step of a Submit Job
+ * request.  The step replies into the Submit Job request instead of to
+ * the client.
+ */
+
+static batch_request *new_submit_step(
+
+  batch_request *preq,  /* I */
+  int            type)  /* I */
+
+  {
+  batch_request *step;
+
+  if ((step = alloc_br(type)) == NULL)
+    return(NULL);
+
+  step->rq_perm    = preq->rq_perm;
+  step->rq_fromsvr = preq->rq_fromsvr;
+  step->rq_conn    = preq->rq_conn;
+  step->rq_orgconn = preq->rq_orgconn;
+  step->rq_time    = preq->rq_time;
+  step->rq_parent  = preq;
+
+  strcpy(step->rq_user, preq->rq_user);
+  strcpy(step->rq_host, preq->rq_host);
+
+  return(step);
+  }  /* END new_submit_step() */
+
+
+
+
+/*
+ * run_submit_step - run one step of a Submit Job request
+ *
+ * @return PBSE_NONE if the step succeeded, otherwise the step's error.
+ * On failure the error reply is left in preq.
+ */
+
+static int run_submit_step(
+
+  batch_request *preq,                   /* I/O */
+  batch_request *step,                   /* I (freed) */
+  int          (*func)(batch_request *)) /* I */
+
+  {
+  int rc;
+
+  if (step == NULL)
+    {
+    preq->rq_reply.brp_code = PBSE_MEM_MALLOC;
+    return(PBSE_MEM_MALLOC);
+    }
+
+  rc = func(step);
+
+  if (rc == PBSE_NONE)
+    rc = preq->rq_reply.brp_code;
+  else if (preq->rq_reply.brp_code == PBSE_NONE)
+    {
+    /* the step failed without replying */
+    preq->rq_reply.brp_code = rc;
+    }
+
+  return(rc);
+  }  /* END run_submit_step() */
+
+
+
+
+/*
+ * req_submitjob - Submit Job Batch Request
+ *
+ * Runs the Queue Job, Job Script, Ready To Commit and Commit steps of a
+ * job submission sent as a single request, so the client waits for one
+ * reply instead of four.  The client gets the reply of the commit or of
+ * the step that failed, and a job whose submission failed part way
+ * through is purged.
+ */
+
+int req_submitjob(
+
+  batch_request *preq)  /* I */
+
+  {
+  batch_request *step;
+  job           *pj;
+  char           jobid[PBS_MAXSVRJOBID + 1];
+  int            rc;
+
+  step = new_submit_step(preq, PBS_BATCH_QueueJob);
+
+  if (step != NULL)
+    {
+    strcpy(step->rq_ind.rq_queuejob.rq_jid, preq->rq_ind.rq_queuejob.rq_jid);
+    strcpy(step->rq_ind.rq_queuejob.rq_destin, preq->rq_ind.rq_queuejob.rq_destin);
+    list_move(&preq->rq_ind.rq_queuejob.rq_attr, &step->rq_ind.rq_queuejob.rq_attr);
+    }
+
+  if ((rc = run_submit_step(preq, step, req_quejob)) != PBSE_NONE)
+    {
+    reply_send(preq);
+    return(rc);
+    }
+
+  snprintf(jobid, sizeof(jobid), "%s", preq->rq_reply.brp_un.brp_jid);
+
+  if (preq->rq_ind.rq_queuejob.rq_scriptsz > 0)
+    {
+    step = new_submit_step(preq, PBS_BATCH_jobscript);
+
+    if (step != NULL)
+      {
+      step->rq_ind.rq_jobfile.rq_sequence = 0;
+      step->rq_ind.rq_jobfile.rq_type = JScript;
+      step->rq_ind.rq_jobfile.rq_size = preq->rq_ind.rq_queuejob.rq_scriptsz;
+      strcpy(step->rq_ind.rq_jobfile.rq_jobid, jobid);
+
+      /* the step owns the script now */
+      step->rq_ind.rq_jobfile.rq_data = preq->rq_ind.rq_queuejob.rq_script;
+      preq->rq_ind.rq_queuejob.rq_script = NULL;
+      }
+
+    rc = run_submit_step(preq, step, req_jobscript);
+    }
+
+#ifndef QUICKCOMMIT
+  if (rc == PBSE_NONE)
+    {
+    if ((step = new_submit_step(preq, PBS_BATCH_RdytoCommit)) != NULL)
+      strcpy(step->rq_ind.rq_rdytocommit, jobid);
+
+    rc = run_submit_step(preq, step, req_rdytocommit);
+    }
+#endif /* QUICKCOMMIT */
+
+  if (rc == PBSE_NONE)
+    {
+    if ((step = new_submit_step(preq, PBS_BATCH_Commit)) != NULL)
+      strcpy(step->rq_ind.rq_commit, jobid);
+
+    rc = run_submit_step(preq, step, req_commit);
+    }
+
+  if (rc != PBSE_NONE)
+    {
+    /* req_commit() purges the jobs it fails to queue, the other steps
+     * leave them on the new jobs list */
+    if ((pj = locate_new_job(jobid)) != NULL)
+      {
+      remove_job(&newjobs, pj);
+      svr_job_purge(pj);
+      }
+    }
+
+  reply_send(preq);
+
+  return(rc);
+  }  /* END req_submitjob() */
+
+
+
+
 /*
  * locate_new_job - locate a "new" job which has been set up req_quejob on
  * the servers new job list.
@@ -20,6 +20,8 @@ int req_rdytocommit(struct batch_request *preq);
 
 int req_commit(struct batch_request *preq);
 
+int req_submitjob(struct batch_request *preq);
+
 /* static job *locate_new_job(int sock, char *jobid); */
 
 #ifdef PNOT
@@ -85,7 +85,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 #include "libpbs.h"
 #include "list_link.h"
 #include "attribute.h"
@@ -107,6 +109,8 @@
 #include "mutex_mgr.hpp"
 #include "utils.h"
 #include "job_func.h"
+#include "threadpool.h"
+#include "req_register.h"
 
 
 #define SYNC_SCHED_HINT_NULL 0
@@ -131,8 +135,8 @@ char *get_correct_jobname(const char *jobid);
 void set_depend_hold(job *, pbs_attribute *);
 int register_sync(struct depend *,  char *child, char *host, long);
 int register_dep(pbs_attribute *, struct batch_request *, int, int *);
-int unregister_dep(pbs_attribute *, struct batch_request *);
-int unregister_sync(pbs_attribute *, struct batch_request *);
+int unregister_dep(pbs_attribute *, struct rq_register *);
+int unregister_sync(pbs_attribute *, struct rq_register *);
 
 struct depend *find_depend(int type, pbs_attribute *pattr);
 
@@ -148,6 +152,7 @@ void   del_depend(struct depend *);
 int    release_cheapest(job *, struct depend *);
 int    send_depend_req(job *, struct depend_job *pparent, int, int, int, void (*postfunc)(batch_request *),bool bAsyncOk);
 depend_job *alloc_dependjob(const char *jobid, const char *host);
+void post_doe(batch_request *preq);
 
 /* External Global Data Items */
 
@@ -165,6 +170,40 @@ extern char *PJobState[];
 extern int   svr_chk_owner(struct batch_request *, job *);
 
 
+ /*
+ * check_dependency_state()
+ * rejects dependencies on a job that has already done what they wait for
+ *
+ * @param pjob - the job depended on
+ * @param type - the dependency type
+ */
+
+int check_dependency_state(
+
+  job *pjob,
+  int  type)
+
+  {
+  if (((pjob->ji_qs.ji_state == JOB_STATE_COMPLETE) ||
+        (pjob->ji_qs.ji_state == JOB_STATE_EXITING)) &&
+      ((type == JOB_DEPEND_TYPE_AFTERSTART) ||
+       (type == JOB_DEPEND_TYPE_AFTERANY) ||
+       ((type == JOB_DEPEND_TYPE_AFTEROK) &&
+        (pjob->ji_qs.ji_un.ji_exect.ji_exitstat == 0)) ||
+       ((type == JOB_DEPEND_TYPE_AFTERNOTOK) &&
+        (pjob->ji_qs.ji_un.ji_exect.ji_exitstat != 0))))
+    {
+    log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, pbse_to_txt(PBSE_BADSTATE));
+
+    return(PBSE_BADSTATE);
+    }
+
+  return(PBSE_NONE);
+  } /* END check_dependency_state() */
+
+
+
+
  /*
  * check_dependency_job()
  * checks to make the sure the dependency request is legitimate
@@ -239,18 +278,8 @@ int check_dependency_job(
 
   type = preq->rq_ind.rq_register.rq_dependtype;
 
-  if (((pjob->ji_qs.ji_state == JOB_STATE_COMPLETE) ||
-        (pjob->ji_qs.ji_state == JOB_STATE_EXITING)) &&
-      ((type == JOB_DEPEND_TYPE_AFTERSTART) ||
-       (type == JOB_DEPEND_TYPE_AFTERANY) ||
-       ((type == JOB_DEPEND_TYPE_AFTEROK) &&
-        (pjob->ji_qs.ji_un.ji_exect.ji_exitstat == 0)) ||
-       ((type == JOB_DEPEND_TYPE_AFTERNOTOK) &&
-        (pjob->ji_qs.ji_un.ji_exect.ji_exitstat != 0))))
+  if ((rc = check_dependency_state(pjob, type)) != PBSE_NONE)
     {
-    log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, jobid, pbse_to_txt(PBSE_BADSTATE));
-    
-    rc = PBSE_BADSTATE;
     req_reject(rc, 0, preq, NULL, NULL);
     
     return(rc);
@@ -470,9 +499,9 @@ int register_dependency(
 
 int release_before_dependency(
 
-  batch_request *preq,
-  job           *pjob,
-  int            type)
+  struct rq_register *preg,
+  job                *pjob,
+  int                 type)
  
   {
   int                rc = PBSE_NONE;
@@ -489,11 +518,11 @@ int release_before_dependency(
   
   if ((pdep = find_depend(type, pattr)))
     {
-    if ((pdj = find_dependjob(pdep, preq->rq_ind.rq_register.rq_child)))
+    if ((pdj = find_dependjob(pdep, preg->rq_child)))
       {
       del_depend_job(pdep, pdj);
       
-      sprintf(log_buf, msg_registerrel, preq->rq_ind.rq_register.rq_child);
+      sprintf(log_buf, msg_registerrel, preg->rq_child);
       log_event(PBSEVENT_JOB,PBS_EVENTCLASS_JOB,pjob->ji_qs.ji_jobid,log_buf);
       
       if (pdep->dp_jobs.size() == 0)
@@ -518,8 +547,8 @@ int release_before_dependency(
 
 int release_syncwith_dependency(
  
-  batch_request *preq,
-  job           *pjob)
+  struct rq_register *preg,
+  job                *pjob)
  
   {
   pbs_attribute     *pattr = &pjob->ji_wattr[JOB_ATR_depend];
@@ -539,7 +568,7 @@ int release_syncwith_dependency(
     
     set_depend_hold(pjob, pattr);
     
-    sprintf(tmpcoststr, "%ld", preq->rq_ind.rq_register.rq_cost);
+    sprintf(tmpcoststr, "%ld", preg->rq_cost);
 
     if (pjob->ji_wattr[JOB_ATR_sched_hint].at_val.at_str != NULL)
       free(pjob->ji_wattr[JOB_ATR_sched_hint].at_val.at_str);
@@ -560,9 +589,9 @@ int release_syncwith_dependency(
 
 int release_dependency(
 
-  batch_request *preq,
-  job           *pjob,
-  int            type)
+  struct rq_register *preg,
+  job                *pjob,
+  int                 type)
 
   {
   int rc = PBSE_NONE;
@@ -578,13 +607,13 @@ int release_dependency(
       
     case JOB_DEPEND_TYPE_BEFORENOTOK:
       
-      rc = release_before_dependency(preq, pjob, type);
+      rc = release_before_dependency(preg, pjob, type);
       
       break;
       
     case JOB_DEPEND_TYPE_SYNCWITH:
       
-      rc = release_syncwith_dependency(preq, pjob);
+      rc = release_syncwith_dependency(preg, pjob);
       
       break;
     }
@@ -598,8 +627,8 @@ int release_dependency(
 
 int ready_dependency(
 
-  batch_request *preq,
-  job           *pjob)
+  struct rq_register *preg,
+  job                *pjob)
 
   {
   int                rc = PBSE_NONE;
@@ -616,7 +645,7 @@ int ready_dependency(
       {
       pdj = pdep->dp_jobs[i];
       
-      if (strcmp(pdj->dc_child, preq->rq_ind.rq_register.rq_child) == 0)
+      if (strcmp(pdj->dc_child, preg->rq_child) == 0)
         {
         pdj->dc_state = JOB_DEPEND_OP_READY;
         
@@ -639,23 +668,22 @@ int ready_dependency(
 
 int delete_dependency_job(
  
-  batch_request *preq,
-  job           **pjob_ptr)
+  struct rq_register  *preg,
+  job                **pjob_ptr)
  
   {
   job *pjob = *pjob_ptr;
   int  rc = PBSE_NONE;
   char log_buf[LOCAL_LOG_BUF_SIZE];
   
-  if (!strcmp(preq->rq_ind.rq_register.rq_parent,
-        preq->rq_ind.rq_register.rq_child))
+  if (!strcmp(preg->rq_parent, preg->rq_child))
     {
     rc = PBSE_IVALREQ; /* prevent an infinite loop */
     }
   // only abort if the job isn't already exiting
   else if (pjob->ji_qs.ji_state < JOB_STATE_EXITING)
     {
-    sprintf(log_buf, msg_registerdel, preq->rq_ind.rq_register.rq_child);
+    sprintf(log_buf, msg_registerdel, preg->rq_child);
     log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, pjob->ji_qs.ji_jobid, log_buf);
     
     /* pjob freed and set to NULL */
@@ -670,9 +698,9 @@ int delete_dependency_job(
 
 int unregister_dependency(
  
-  batch_request *preq,
-  job           *pjob,
-  int            type)
+  struct rq_register *preg,
+  job                *pjob,
+  int                 type)
 
   {
   pbs_attribute *pattr = &pjob->ji_wattr[JOB_ATR_depend];
@@ -686,12 +714,12 @@ int unregister_dependency(
       }
     else
       {
-      unregister_sync(pattr, preq);
+      unregister_sync(pattr, preg);
       }
     }
   else
     {
-    unregister_dep(pattr, preq);
+    unregister_dep(pattr, preg);
     }
   
   set_depend_hold(pjob, pattr);
@@ -702,6 +730,72 @@ int unregister_dependency(
 
 
 
+/*
+ * handle_dependency_op()
+ * performs every dependency operation but register on the job depended on
+ *
+ * @param preg - the operation
+ * @param pjob_ptr - the job depended on, set to NULL if the job is deleted
+ * @see req_register() - parent
+ * @see apply_local_depend_op() - parent
+ */
+
+int handle_dependency_op(
+
+  struct rq_register  *preg,
+  job                **pjob_ptr)
+
+  {
+  int  rc = PBSE_NONE;
+  char log_buf[LOCAL_LOG_BUF_SIZE + 1];
+
+  switch (preg->rq_op)
+    {
+    case JOB_DEPEND_OP_RELEASE:
+
+      rc = release_dependency(preg, *pjob_ptr, preg->rq_dependtype);
+
+      break;
+
+    case JOB_DEPEND_OP_READY:
+
+      rc = ready_dependency(preg, *pjob_ptr);
+ 
+      break;
+ 
+    case JOB_DEPEND_OP_DELETE:
+ 
+      rc = delete_dependency_job(preg, pjob_ptr);
+ 
+      break;
+ 
+    case JOB_DEPEND_OP_UNREG:
+
+      rc = unregister_dependency(preg, *pjob_ptr, preg->rq_dependtype);
+
+      break;
+
+    default:
+
+      sprintf(log_buf, msg_illregister, preg->rq_parent);
+
+      log_event(
+        PBSEVENT_DEBUG | PBSEVENT_SYSTEM | PBSEVENT_ERROR,
+        PBS_EVENTCLASS_REQUEST,
+        preg->rq_svr,
+        log_buf);
+
+      rc = PBSE_IVALREQ;
+
+      break;
+    }  /* END switch (preg->rq_op) */
+
+  return(rc);
+  } /* END handle_dependency_op() */
+
+
+
+
 /*
  * req_register - process the Register Dependency Request
  *
@@ -759,52 +853,10 @@ int req_register(
     }
  
   /* Handle the dependency */
-  switch (preq->rq_ind.rq_register.rq_op)
-    {
-    case JOB_DEPEND_OP_REGISTER:
-
-      rc = register_dependency(preq, pjob, type);
-
-      break;
-      
-    case JOB_DEPEND_OP_RELEASE:
-
-      rc = release_dependency(preq, pjob, type);
-
-      break;
-
-    case JOB_DEPEND_OP_READY:
-
-      rc = ready_dependency(preq, pjob);
- 
-      break;
- 
-    case JOB_DEPEND_OP_DELETE:
- 
-      rc = delete_dependency_job(preq, &pjob);
- 
-      break;
- 
-    case JOB_DEPEND_OP_UNREG:
-
-      rc =  unregister_dependency(preq, pjob, type);
-
-      break;
-
-    default:
-
-      sprintf(log_buf, msg_illregister, preq->rq_ind.rq_register.rq_parent);
-
-      log_event(
-        PBSEVENT_DEBUG | PBSEVENT_SYSTEM | PBSEVENT_ERROR,
-        PBS_EVENTCLASS_REQUEST,
-        preq->rq_host,
-        log_buf);
-
-      rc = PBSE_IVALREQ;
-
-      break;
-    }  /* END switch (preq->rq_ind.rq_register.rq_op) */
+  if (preq->rq_ind.rq_register.rq_op == JOB_DEPEND_OP_REGISTER)
+    rc = register_dependency(preq, pjob, type);
+  else
+    rc = handle_dependency_op(&preq->rq_ind.rq_register, &pjob);
 
   if (rc)
     {
@@ -1541,6 +1593,30 @@ void post_doe(
 
 
 
+/*
+ * add_local_depend_op - add an operation for target, a job of this server
+ */
+
+void add_local_depend_op(
+
+  std::vector<local_depend_op> &ops,
+  const char                   *target,
+  int                           type,
+  int                           op)
+
+  {
+  local_depend_op dop;
+
+  dop.target = target;
+  dop.type = type;
+  dop.op = op;
+  dop.cost = 0;
+
+  ops.push_back(dop);
+  } /* END add_local_depend_op() */
+
+
+
 /*
  * depend_on_exec - Perform actions if job has
  * "beforestart" dependency - send "register-release" to child job; or
@@ -1566,10 +1642,38 @@ int depend_on_exec(
 
   if (pdep != NULL)
     {
+    std::vector<local_depend_op> local_ops;
 
+    /* jobs of this server are released together, and forgotten here as
+     * post_doe() does for the others */
     for (unsigned int i = 0; i < pdep->dp_jobs.size(); i++)
       {
       pdj = pdep->dp_jobs[i];
+
+      if (depend_svr_is_local(pdj->dc_svr))
+        add_local_depend_op(local_ops, pdj->dc_child, pdep->dp_type, JOB_DEPEND_OP_RELEASE);
+      }
+
+    if (local_ops.size() > 0)
+      {
+      queue_local_depend_ops(jobid, local_ops);
+
+      for (unsigned int i = 0; i < local_ops.size(); i++)
+        {
+        if ((pdj = find_dependjob(pdep, (char *)local_ops[i].target.c_str())) != NULL)
+          del_depend_job(pdep, pdj);
+        }
+
+      if (pdep->dp_jobs.size() == 0)
+        {
+        del_depend(pdep);
+        pdep = NULL;
+        }
+      }
+
+    for (unsigned int i = 0; (pdep != NULL) && (i < pdep->dp_jobs.size()); i++)
+      {
+      pdj = pdep->dp_jobs[i];
     
       if (send_depend_req(pjob,
             pdj,
@@ -1657,9 +1761,14 @@ int depend_on_term(
   int                rc;
   int                shouldkill = 0;
   int                type;
+  char               jobid[PBS_MAXSVRJOBID + 1];
+
+  std::vector<local_depend_op> local_ops;
 
   if (pjob == NULL)
     return(PBSE_BAD_PARAMETER);
+
+  strcpy(jobid, pjob->ji_qs.ji_jobid);
  
   exitstat = pjob->ji_qs.ji_un.ji_exect.ji_exitstat;
   pattr = &pjob->ji_wattr[JOB_ATR_depend];
@@ -1735,10 +1844,17 @@ int depend_on_term(
             {
             pparent = pdep->dp_jobs[i];
 
+            if (depend_svr_is_local(pparent->dc_svr))
+              {
+              add_local_depend_op(local_ops, pparent->dc_child, type, JOB_DEPEND_OP_DELETE);
+              continue;
+              }
+
             rc = send_depend_req(pjob, pparent, type, JOB_DEPEND_OP_DELETE, SYNC_SCHED_HINT_NULL, free_br,true);
             
             if (rc == PBSE_JOBNOTFOUND)
               {
+              queue_local_depend_ops(jobid, local_ops);
               return(rc);
               }
             }
@@ -1755,9 +1871,16 @@ int depend_on_term(
         {
         pparent = pdep->dp_jobs[i];
 
+        if (depend_svr_is_local(pparent->dc_svr))
+          {
+          add_local_depend_op(local_ops, pparent->dc_child, type, op);
+          continue;
+          }
+
         /* "release" the job to execute */
         if ((rc = send_depend_req(pjob, pparent, type, op, SYNC_SCHED_HINT_NULL, free_br,true)) != PBSE_NONE)
           {
+          queue_local_depend_ops(jobid, local_ops);
           return(rc);
           }
         }
@@ -1766,6 +1889,10 @@ int depend_on_term(
     pdep = (struct depend *)GET_NEXT(pdep->dp_link);
     } /* END loop over each dependency */
 
+  /* everything for jobs of this server goes in one batch */
+  if (local_ops.size() > 0)
+    queue_local_depend_ops(jobid, local_ops);
+
   return(PBSE_NONE);
   }  /* END depend_on_term() */
 
@@ -2211,7 +2338,7 @@ int register_dep(
 int unregister_dep(
 
   pbs_attribute        *pattr,
-  struct batch_request *preq)
+  struct rq_register   *preg)
 
   {
   int                type;
@@ -2221,11 +2348,11 @@ int unregister_dep(
 
   /* get mirror image of dependency type */
 
-  type = preq->rq_ind.rq_register.rq_dependtype ^
+  type = preg->rq_dependtype ^
          (JOB_DEPEND_TYPE_BEFORESTART - JOB_DEPEND_TYPE_AFTERSTART);
 
   if (((pdp = find_depend(type, pattr)) == NULL) ||
-      ((pdjb = find_dependjob(pdp, preq->rq_ind.rq_register.rq_child)) == NULL))
+      ((pdjb = find_dependjob(pdp, preg->rq_child)) == NULL))
     {
     return(PBSE_IVALREQ);
     }
@@ -2246,7 +2373,7 @@ int unregister_dep(
 int unregister_sync(
 
   pbs_attribute        *pattr,
-  struct batch_request *preq)
+  struct rq_register   *preg)
 
   {
 
@@ -2255,7 +2382,7 @@ int unregister_sync(
   struct depend_job *pdjb;
 
   if (((pdp = find_depend(JOB_DEPEND_TYPE_SYNCCT, pattr)) == 0) ||
-      ((pdjb = find_dependjob(pdp, preq->rq_ind.rq_register.rq_child)) == 0))
+      ((pdjb = find_dependjob(pdp, preg->rq_child)) == 0))
     {
     return(PBSE_IVALREQ);
     }
@@ -2354,8 +2481,161 @@ struct depend_job *make_dependjob(
 
 
 
+/*
+ * depend_svr_is_local - true if svr names this server
+ */
+
+bool depend_svr_is_local(
+
+  const char *svr)
+
+  {
+  pbs_net_t svraddr1;
+  pbs_net_t svraddr2;
+  int       my_err;
+
+  if (!strcmp(svr, server_name))
+    return(true);
+
+  svraddr1 = get_hostaddr(&my_err, server_name);
+  svraddr2 = get_hostaddr(&my_err, (char *)svr);
+
+  return((svraddr1 != 0) &&
+         (svraddr1 == svraddr2));
+  } /* END depend_svr_is_local() */
+
+
+
+/*
+ * apply_local_depend_op - perform a dependency operation on a job of this
+ * server directly, as req_register() would for a request from sender
+ *
+ * @param sender - the id of the job the operation comes from
+ * @param dop - the operation
+ */
+
+int apply_local_depend_op(
+
+  const char            *sender,
+  const local_depend_op &dop)
+
+  {
+  struct rq_register  reg;
+  job                *pjob;
+  int                 rc;
+  char                log_buf[LOCAL_LOG_BUF_SIZE];
+
+  memset(&reg, 0, sizeof(reg));
+  snprintf(reg.rq_parent, sizeof(reg.rq_parent), "%s", dop.target.c_str());
+  snprintf(reg.rq_child, sizeof(reg.rq_child), "%s", sender);
+  snprintf(reg.rq_svr, sizeof(reg.rq_svr), "%s", server_name);
+  reg.rq_dependtype = dop.type;
+  reg.rq_op = dop.op;
+  reg.rq_cost = dop.cost;
+
+  if ((pjob = svr_find_job(reg.rq_parent, TRUE)) == NULL)
+    {
+    log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, reg.rq_parent, pbse_to_txt(PBSE_UNKJOBID));
+
+    return(PBSE_UNKJOBID);
+    }
+
+  if ((rc = check_dependency_state(pjob, dop.type)) == PBSE_NONE)
+    {
+    pjob->ji_modified = 1;
+
+    rc = handle_dependency_op(&reg, &pjob);
+    }
+
+  if (pjob != NULL)
+    {
+    if (rc != PBSE_NONE)
+      pjob->ji_modified = 0;
+    else if (pjob->ji_modified != 0)
+      job_save(pjob, SAVEJOB_FULL, 0);
+
+    unlock_ji_mutex(pjob, __func__, "1", LOGLEVEL);
+    }
+
+  if ((rc != PBSE_NONE) &&
+      (LOGLEVEL >= 7))
+    {
+    snprintf(log_buf, sizeof(log_buf), "dependency operation %d from %s failed: %s",
+      dop.op, sender, pbse_to_txt(rc));
+    log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, reg.rq_parent, log_buf);
+    }
+
+  return(rc);
+  } /* END apply_local_depend_op() */
+
+
+
+/*
+ * apply_local_depend_ops - threadpool task performing a local_depend_batch
+ */
+
+void *apply_local_depend_ops(
+
+  void *vp)
+
+  {
+  local_depend_batch *batch = (local_depend_batch *)vp;
+
+  for (unsigned int i = 0; i < batch->ops.size(); i++)
+    apply_local_depend_op(batch->sender.c_str(), batch->ops[i]);
+
+  delete batch;
+
+  return(NULL);
+  } /* END apply_local_depend_ops() */
+
+
+
+/*
+ * queue_local_depend_ops - perform dependency operations on jobs of this
+ * server without sending Register Dependency requests to ourselves
+ *
+ * The operations are done by the task pool, LOCAL_DEPEND_BATCH_SIZE to a
+ * task, so the caller never locks another job while holding sender's mutex
+ * and a large fan-out is spread over the pool's threads.
+ *
+ * @param sender - the id of the job the operations come from
+ * @param ops - the operations
+ */
+
+int queue_local_depend_ops(
+
+  const char                         *sender,
+  const std::vector<local_depend_op> &ops)
+
+  {
+  for (unsigned int start = 0; start < ops.size(); start += LOCAL_DEPEND_BATCH_SIZE)
+    {
+    local_depend_batch *batch = new local_depend_batch();
+    unsigned int        end = std::min(start + LOCAL_DEPEND_BATCH_SIZE, (unsigned int)ops.size());
+
+    batch->sender = sender;
+    batch->ops.assign(ops.begin() + start, ops.begin() + end);
+
+    if (enqueue_threadpool_request(apply_local_depend_ops, batch, task_pool) != PBSE_NONE)
+      {
+      /* out of memory, don't lose the releases */
+      log_err(ENOMEM, __func__, "cannot queue dependency operations, doing them now");
+
+      apply_local_depend_ops(batch);
+      }
+    }
+
+  return(PBSE_NONE);
+  } /* END queue_local_depend_ops() */
+
+
+
 /*
  * send_depend_req - build and send a Register Dependent request
+ *
+ * Operations other than register on jobs of this server are queued with
+ * queue_local_depend_ops() instead, and postfunc is not called for them.
  */
 
 int send_depend_req(
@@ -2380,6 +2660,19 @@ int send_depend_req(
   pbs_net_t             svraddr2;
   int                   my_err;
 
+  if ((op != JOB_DEPEND_OP_REGISTER) &&
+      (depend_svr_is_local(pparent->dc_svr)))
+    {
+    std::vector<local_depend_op> ops(1);
+
+    ops[0].target = pparent->dc_child;
+    ops[0].type = type;
+    ops[0].op = op;
+    ops[0].cost = (type == JOB_DEPEND_TYPE_SYNCWITH) ? schedhint : 0;
+
+    return(queue_local_depend_ops(pjob->ji_qs.ji_jobid, ops));
+    }
+
   preq = alloc_br(PBS_BATCH_RegistDep);
 
   if (preq == NULL)
@@ -8,6 +8,27 @@
 #include "pbs_job.h" /* job */
 #include "list_link.h" /* tlist_head */
 
+#include <string>
+#include <vector>
+
+#define LOCAL_DEPEND_BATCH_SIZE 128 /* dependency operations per task, see queue_local_depend_ops() */
+
+/* a dependency operation on a job of this server */
+typedef struct local_depend_op
+  {
+  std::string target; /* the job depended on */
+  int         type;
+  int         op;
+  long        cost;
+  } local_depend_op;
+
+/* operations from one job, done by one task */
+typedef struct local_depend_batch
+  {
+  std::string                  sender;
+  std::vector<local_depend_op> ops;
+  } local_depend_batch;
+
 int req_register(struct batch_request *preq);
 
 int req_registerarray(struct batch_request *preq);
@@ -16,6 +37,22 @@ int register_array_depend(job_array *pa, struct batch_request *preq, int type, i
 
 int depend_on_exec(job *pjob);
 
+int depend_on_term(job *pjob);
+
+int check_dependency_state(job *pjob, int type);
+
+int handle_dependency_op(struct rq_register *preg, job **pjob_ptr);
+
+bool depend_svr_is_local(const char *svr);
+
+void add_local_depend_op(std::vector<local_depend_op> &ops, const char *target, int type, int op);
+
+int apply_local_depend_op(const char *sender, const local_depend_op &dop);
+
+void *apply_local_depend_ops(void *vp);
+
+int queue_local_depend_ops(const char *sender, const std::vector<local_depend_op> &ops);
+
 void depend_clrrdy(job *pjob);
 
 int encode_depend(pbs_attribute *attr, tlist_head *phead, const char *atname, const char *rsname, int mode, int perm);
@@ -109,6 +109,7 @@
 #include "req_stat.h" /* stat_mom_job */
 #include "ji_mutex.h"
 #include "mutex_mgr.hpp"
+#include "job_select_index.h"
 
 /* Private Data */
 
@@ -351,6 +352,179 @@ int req_selectjobs(
 
 
 
+/*
+ * select_index_keys - the keys of the job index an entry of a selection
+ * list can use: a job can only match an equality on an indexed attribute
+ * if the job is indexed under one of the keys.
+ *
+ * Returns the index to use, or -1 if the entry can't use one
+ */
+
+static int select_index_keys(
+
+  struct select_list       *psel,
+  std::vector<std::string> &keys)
+
+  {
+  keys.clear();
+
+  if ((psel->sl_op != EQ) ||
+      ((psel->sl_attr.at_flags & ATR_VFLAG_SET) == 0))
+    return(-1);
+
+  switch (psel->sl_atindx)
+    {
+    case JOB_ATR_userlst:
+
+      {
+      struct array_strings *pas = psel->sl_attr.at_val.at_arst;
+
+      if ((pas == NULL) ||
+          (pas->as_usedptr == 0))
+        return(-1);
+
+      for (int i = 0; i < pas->as_usedptr; i++)
+        {
+        char *user = pas->as_string[i];
+        char *at = strchr(user, '@');
+
+        /* +/- entries and default settings can match anyone */
+        if ((*user == '+') ||
+            (*user == '-') ||
+            (*user == '@') ||
+            (*user == '\0'))
+          return(-1);
+
+        if (at != NULL)
+          keys.push_back(std::string(user, at - user));
+        else
+          keys.push_back(user);
+        }
+
+      return(JOB_INDEX_OWNER);
+      }
+
+    case JOB_ATR_state:
+
+      if (psel->sl_attr.at_val.at_str == NULL)
+        return(-1);
+
+      for (char *ps = psel->sl_attr.at_val.at_str; *ps != '\0'; ps++)
+        keys.push_back(std::string(1, *ps));
+
+      return(JOB_INDEX_STATE);
+
+    case JOB_ATR_euser:
+    case JOB_ATR_account:
+
+      if (psel->sl_attr.at_val.at_str == NULL)
+        return(-1);
+
+      keys.push_back(psel->sl_attr.at_val.at_str);
+
+      return((psel->sl_atindx == JOB_ATR_euser) ? JOB_INDEX_EUSER : JOB_INDEX_ACCOUNT);
+
+    default:
+
+      return(-1);
+    }
+  } /* END select_index_keys() */
+
+
+
+
+/*
+ * select_candidates - find the fewest jobs that have to be checked for
+ * a selection using the job indexes
+ *
+ * @param psel - the selection list
+ * @param pque - the queue selected from, if any
+ * @param job_ids - RETURN: the ids of the jobs to check
+ * @return true if an index could be used, false if every job must be checked
+ */
+
+static bool select_candidates(
+
+  struct select_list       *psel,
+  pbs_queue                *pque,
+  std::vector<std::string> &job_ids)
+
+  {
+  std::vector<std::string> keys;
+  std::vector<std::string> found;
+  bool                     indexed = false;
+
+  if (pque != NULL)
+    {
+    keys.push_back(pque->qu_qs.qu_name);
+    job_index_lookup(JOB_INDEX_QUEUE, keys, job_ids);
+    indexed = true;
+    }
+
+  for (; psel != NULL; psel = psel->sl_next)
+    {
+    int kind = select_index_keys(psel, keys);
+
+    if (kind < 0)
+      continue;
+
+    job_index_lookup(kind, keys, found);
+
+    if ((indexed == false) ||
+        (found.size() < job_ids.size()))
+      {
+      job_ids.swap(found);
+      indexed = true;
+      }
+    }
+
+  return(indexed);
+  } /* END select_candidates() */
+
+
+
+
+/*
+ * sel_next_job - the next job to check, locked: the next candidate still in
+ * the selected queue, or the next array summary from iter
+ */
+
+static job *sel_next_job(
+
+  struct stat_cntl         *cntl,
+  all_jobs_iterator        *iter,
+  std::vector<std::string> &candidates,
+  unsigned int             &next,
+  int                       summarize_arrays)
+
+  {
+  job *pjob;
+
+  if (summarize_arrays)
+    {
+    if (cntl->sc_pque)
+      return(next_job(cntl->sc_pque->qu_jobs_array_sum, iter));
+    else
+      return(next_job(&array_summary, iter));
+    }
+
+  while (next < candidates.size())
+    {
+    if ((pjob = find_job_in_registry(candidates[next++].c_str(), FALSE)) == NULL)
+      continue;
+
+    if ((cntl->sc_pque == NULL) ||
+        (!strcmp(pjob->ji_qs.ji_queue, cntl->sc_pque->qu_qs.qu_name)))
+      return(pjob);
+
+    unlock_ji_mutex(pjob, __func__, NULL, LOGLEVEL);
+    }
+
+  return(NULL);
+  } /* END sel_next_job() */
+
+
+
 static void sel_step3(
 
   struct stat_cntl *cntl)
@@ -373,6 +547,9 @@ static void sel_step3(
 
   all_jobs_iterator   *iter = NULL;
   long        query_others = 0;
+
+  std::vector<std::string>  candidates;
+  unsigned int              next_candidate = 0;
   
   get_svr_attr_l(SRV_ATR_query_others, &query_others);
   if (cntl->sc_origrq->rq_extend != NULL)
@@ -404,7 +581,7 @@ static void sel_step3(
     if (!strncmp(preq->rq_extend, EXECQUEONLY, strlen(EXECQUEONLY)))
       exec_only = 1;
 
-  if(summarize_arrays)
+  if (summarize_arrays)
     {
     if (cntl->sc_pque)
       {
@@ -419,41 +596,16 @@ static void sel_step3(
       array_summary.unlock();
       }
     }
-  else
+  else if (!select_candidates(cntl->sc_select, cntl->sc_pque, candidates))
     {
-    if (cntl->sc_pque)
-      {
-      cntl->sc_pque->qu_jobs->lock();
-      iter = cntl->sc_pque->qu_jobs->get_iterator();
-      cntl->sc_pque->qu_jobs->unlock();
-      }
-    else
-      {
-      alljobs.lock();
-      iter = alljobs.get_iterator();
-      alljobs.unlock();
-      }
-
+    /* array summaries aren't indexed, everything else only checks the jobs
+     * the indexes say could match, or a snapshot of alljobs if none can be
+     * used so that the walk doesn't hold alljobs' mutex */
+    get_job_ids(&alljobs, candidates);
     }
 
-
   /* now start checking for jobs that match the selection criteria */
-  if (summarize_arrays)
-    {
-    if (cntl->sc_pque)
-      pjob = next_job(cntl->sc_pque->qu_jobs_array_sum,iter);
-    else
-      {
-      pjob = next_job(&array_summary,iter);
-      }
-    }
-  else
-    {
-    if (cntl->sc_pque)
-      pjob = next_job(cntl->sc_pque->qu_jobs,iter);
-    else
-      pjob = next_job(&alljobs,iter);
-    }
+  pjob = sel_next_job(cntl, iter, candidates, next_candidate, summarize_arrays);
 
   while (pjob != NULL)
     {
@@ -528,20 +680,7 @@ nextjob:
     
     unlock_ji_mutex(pjob, __func__, "3", LOGLEVEL);
 
-    if (summarize_arrays)
-      {
-      if (cntl->sc_pque)
-        next = next_job(cntl->sc_pque->qu_jobs_array_sum,iter);
-      else
-        next = next_job(&array_summary,iter);
-      }
-    else
-      {
-      if (cntl->sc_pque)
-        next = next_job(cntl->sc_pque->qu_jobs,iter);
-      else
-        next = next_job(&alljobs,iter);
-      }
+    next = sel_next_job(cntl, iter, candidates, next_candidate, summarize_arrays);
 
     pjob = next;
     }
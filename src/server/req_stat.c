@@ -123,6 +123,9 @@
 #include "unistd.h"
 #include "log.h"
 #include "job_func.h"
+#include "threadpool.h"
+#include "job_delta.h"
+#include "user_info.h" /* format_user_usage */
 
 /* Global Data Items: */
 
@@ -145,6 +148,8 @@ extern pthread_mutex_t *netrates_mutex;
 
 int status_job(job *, struct batch_request *, svrattrl *, tlist_head *, bool, int *);
 int status_attrib(svrattrl *, attribute_def *, pbs_attribute *, int, int, tlist_head *, bool, int *, int);
+void get_job_status_cache_stats(unsigned long *, unsigned long *, long *, long *);
+void format_obit_stats(char *, int);
 extern int  status_nodeattrib(svrattrl *, attribute_def *, struct pbsnode *, int, int, tlist_head *, int*);
 extern int  hasprop(struct pbsnode *, struct prop *);
 extern void rel_resc(job*);
@@ -341,22 +346,150 @@ int req_stat_job(
 
 
 
+/*
+ * add_delta_entry - add a status entry holding a single string value
+ */
+
+static int add_delta_entry(
+
+  tlist_head *pstathd,
+  int         objtype,
+  const char *objname,
+  const char *name,
+  const char *value,
+  struct brp_status **ppstat)
+
+  {
+  struct brp_status *pstat = *ppstat;
+  svrattrl          *pal;
+
+  if (pstat == NULL)
+    {
+    if ((pstat = (struct brp_status *)calloc(1, sizeof(struct brp_status))) == NULL)
+      return(PBSE_SYSTEM);
+
+    CLEAR_LINK(pstat->brp_stlink);
+    pstat->brp_objtype = objtype;
+    snprintf(pstat->brp_objname, sizeof(pstat->brp_objname), "%s", objname);
+    CLEAR_HEAD(pstat->brp_attr);
+    append_link(pstathd, &pstat->brp_stlink, pstat);
+
+    *ppstat = pstat;
+    }
+
+  if ((pal = attrlist_create(name, NULL, strlen(value) + 1)) == NULL)
+    return(PBSE_SYSTEM);
+
+  strcpy((char *)pal->al_value, value);
+  pal->al_flags = ATR_VFLAG_SET;
+
+  append_link(&pstat->brp_attr, &pal->al_link, pal);
+
+  return(PBSE_NONE);
+  } /* END add_delta_entry() */
+
+
+
+/*
+ * may_see_purged_job - can the requester learn that this purged job existed
+ */
+
+static bool may_see_purged_job(
+
+  batch_request      *preq,
+  const std::string  &owner)
+
+  {
+  long   query_others = 0;
+  size_t len = strlen(preq->rq_user);
+
+  if (preq->rq_perm & (ATR_DFLAG_MGRD | ATR_DFLAG_OPRD))
+    return(true);
+
+  get_svr_attr_l(SRV_ATR_query_others, &query_others);
+
+  if (query_others)
+    return(true);
+
+  return((owner.compare(0, len, preq->rq_user) == 0) &&
+         ((owner.size() == len) ||
+          (owner[len] == '@')));
+  } /* END may_see_purged_job() */
+
+
+
+/*
+ * start_delta_status
+ *
+ * Starts the reply to a DELTASTATUS job status.  The first entry is named
+ * for the server and holds the sequence to ask from next time (delta_seq)
+ * and whether every job is being reported (delta_full).  It is followed by
+ * an entry with delta_purged set for each job purged since the client's
+ * sequence.
+ *
+ * @param preq - the request we're addressing
+ * @param since - RETURN: jobs must have changed after this to be reported
+ * @return PBSE_NONE or PBSE_SYSTEM
+ */
+
+int start_delta_status(
+
+  batch_request      *preq,
+  unsigned long long *since)
+
+  {
+  tlist_head                    *pstathd = &preq->rq_reply.brp_un.brp_status;
+  struct brp_status             *pstat = NULL;
+  std::vector<job_delta_purged>  purged;
+  unsigned long long             current = job_delta_get_seq();
+  bool                           complete;
+  char                           buf[64];
+  int                            rc;
+
+  /* anything changing from here on has a later sequence than current */
+  complete = job_delta_get_purged(*since, purged);
+
+  if (complete == false)
+    *since = 0;
+
+  snprintf(buf, sizeof(buf), "%llu", current);
+
+  if (((rc = add_delta_entry(pstathd, MGR_OBJ_SERVER, server_name, ATTR_delta_seq, buf, &pstat)) != PBSE_NONE) ||
+      ((rc = add_delta_entry(pstathd, MGR_OBJ_SERVER, server_name, ATTR_delta_full, (complete == true) ? "False" : "True", &pstat)) != PBSE_NONE))
+    return(rc);
+
+  for (unsigned int i = 0; i < purged.size(); i++)
+    {
+    if (may_see_purged_job(preq, purged[i].owner) == false)
+      continue;
+
+    pstat = NULL;
+
+    if ((rc = add_delta_entry(pstathd, MGR_OBJ_JOB, purged[i].jobid.c_str(), ATTR_delta_purged, "True", &pstat)) != PBSE_NONE)
+      return(rc);
+    }
+
+  return(PBSE_NONE);
+  } /* END start_delta_status() */
+
+
+
 /*
  * handle_truncated_qstat
  *
  * Performs the truncated qstat as requested
  * @param exec_only - true if we should only get the status for execution queues
- * @param dpal - the delta attributes to get the status on (doesn't work)
- * @param DTime - the time to check for a delta status (doesn't work)
  * @param condensed - true if the job status should be condensed
+ * @param since - only report jobs changed after this sequence, see job_delta.c
  * @param preq - the request we're addressing
  */
 
 void handle_truncated_qstat(
     
-  bool           exec_only,
-  bool           condensed,
-  batch_request *preq)
+  bool                exec_only,
+  bool                condensed,
+  unsigned long long  since,
+  batch_request      *preq)
 
   {
   long                 sentJobCounter = 0;
@@ -406,15 +539,21 @@ void handle_truncated_qstat(
       }
 
     /* loop through jobs in queue */
-    all_jobs_iterator *jobiter = NULL;
-    pque->qu_jobs->lock();
-    jobiter = pque->qu_jobs->get_iterator();
-    pque->qu_jobs->unlock();
+    std::vector<std::string> job_ids;
+
+    get_job_ids(pque->qu_jobs, job_ids);
 
-    while ((pjob = next_job(pque->qu_jobs, jobiter)) != NULL)
+    for (unsigned int i = 0; i < job_ids.size(); i++)
       {
+      if ((pjob = find_job_in_registry(job_ids[i].c_str(), FALSE)) == NULL)
+        continue;
+
       mutex_mgr job_mgr(pjob->ji_mutex, true);
 
+      /* it may have moved since the snapshot was taken */
+      if (strcmp(pjob->ji_qs.ji_queue, pque->qu_qs.qu_name))
+        continue;
+
       if ((qjcounter >= qmaxreport) &&
           (pjob->ji_qs.ji_state == JOB_STATE_QUEUED))
         {
@@ -422,6 +561,14 @@ void handle_truncated_qstat(
         continue;
         }
 
+      if (pjob->ji_delta_seq <= since)
+        {
+        if (pjob->ji_qs.ji_state == JOB_STATE_QUEUED)
+          qjcounter++;
+
+        continue;
+        }
+
       int rc = status_job(pjob, preq, pal, &preply->brp_un.brp_status, condensed, &bad);
 
       if ((rc != 0) &&
@@ -463,25 +610,37 @@ void handle_truncated_qstat(
  * get_correct_status_iterator
  *
  * @param cntl - specification for what kind of job status we're returning
- * @return the appropriate iterator for our kind of job status
+ * @param job_ids - RETURN: the ids of the jobs to status when they come from
+ * alljobs or a queue, walked without holding that container's mutex
+ * @return the appropriate iterator for our kind of job status, or NULL if
+ * job_ids is used instead
  */
 
 all_jobs_iterator *get_correct_status_iterator(
 
-  struct stat_cntl *cntl)
+  struct stat_cntl         *cntl,
+  std::vector<std::string> &job_ids)
 
   {
   all_jobs          *ajptr = NULL;
   all_jobs_iterator *iter;
 
   if (cntl->sc_type == tjstQueue)
-    ajptr = cntl->sc_pque->qu_jobs;
+    {
+    get_job_ids(cntl->sc_pque->qu_jobs, job_ids);
+    return(NULL);
+    }
   else if (cntl->sc_type == tjstSummarizeArraysQueue)
     ajptr = cntl->sc_pque->qu_jobs_array_sum;
   else if (cntl->sc_type == tjstSummarizeArraysServer)
     ajptr = &array_summary;
+  else if (cntl->sc_type == tjstArray)
+    return(NULL);
   else
-    ajptr = &alljobs;
+    {
+    get_job_ids(&alljobs, job_ids);
+    return(NULL);
+    }
 
   ajptr->lock();
   iter = ajptr->get_iterator();
@@ -496,36 +655,36 @@ all_jobs_iterator *get_correct_status_iterator(
  * get_next_status_job()
  *
  * @param cntl - specification for what kind of job status we're returning
- * @param job_array_index - the index we're at in the job array, if we're getting
- * the status for a job array
+ * @param job_index - the index we're at in the job array if we're getting
+ * the status for a job array, or in job_ids otherwise
  * @param iter - the iterator, if we're using one
+ * @param job_ids - the ids from get_correct_status_iterator()
  * @return the next job in our sequence, or NULL if we're done
  */
 
 job *get_next_status_job(
 
-  struct stat_cntl  *cntl,
-  int               &job_array_index,
-  job_array         *pa,
-  all_jobs_iterator *iter)
+  struct stat_cntl         *cntl,
+  int                      &job_index,
+  job_array                *pa,
+  all_jobs_iterator        *iter,
+  std::vector<std::string> &job_ids)
 
   {
   job *pjob = NULL;
 
-  if (cntl->sc_type == tjstQueue)
-    pjob = next_job(cntl->sc_pque->qu_jobs,iter);
-  else if (cntl->sc_type == tjstSummarizeArraysQueue)
+  if (cntl->sc_type == tjstSummarizeArraysQueue)
     pjob = next_job(cntl->sc_pque->qu_jobs_array_sum,iter);
   else if (cntl->sc_type == tjstSummarizeArraysServer)
     pjob = next_job(&array_summary,iter);
   else if (cntl->sc_type == tjstArray)
     {
-    /* increment job_array_index until we find a non-null pointer or hit the end */
-    while (++job_array_index < pa->ai_qs.array_size)
+    /* increment job_index until we find a non-null pointer or hit the end */
+    while (++job_index < pa->ai_qs.array_size)
       {
-      if (pa->job_ids[job_array_index] != NULL)
+      if (pa->job_ids[job_index] != NULL)
         {
-        if ((pjob = svr_find_job(pa->job_ids[job_array_index], FALSE)) != NULL)
+        if ((pjob = svr_find_job(pa->job_ids[job_index], FALSE)) != NULL)
           {
           break;
           }
@@ -533,7 +692,21 @@ job *get_next_status_job(
       }
     }
   else
-    pjob = next_job(&alljobs, iter);
+    {
+    while (++job_index < (int)job_ids.size())
+      {
+      if ((pjob = find_job_in_registry(job_ids[job_index].c_str(), FALSE)) == NULL)
+        continue;
+
+      /* it may have moved out of the queue since the snapshot was taken */
+      if ((cntl->sc_type != tjstQueue) ||
+          (!strcmp(pjob->ji_qs.ji_queue, cntl->sc_pque->qu_qs.qu_name)))
+        break;
+
+      unlock_ji_mutex(pjob, __func__, NULL, LOGLEVEL);
+      pjob = NULL;
+      }
+    }
 
   return(pjob);
   } // END get_next_status_job()
@@ -610,22 +783,32 @@ void req_stat_job_step2(
   bool                   exec_only = false;
 
   int                    bad = 0;
-  /* delta time - only report full pbs_attribute list if J->MTime > DTime */
-  int                    job_array_index = -1;
+  /* delta status - only report jobs changed since the client's sequence */
+  unsigned long long     since = 0;
+  int                    job_index = -1;
   job_array             *pa = NULL;
   all_jobs_iterator     *iter;
+  std::vector<std::string> job_ids;
 
   if (preq->rq_extend != NULL)
     {
     /* FORMAT:  { EXECQONLY } */
     if (strstr(preq->rq_extend, EXECQUEONLY))
       exec_only = true;
+
+    /* FORMAT:  { DELTASTATUS<seq> } */
+    if ((job_delta_parse_extend(preq->rq_extend, &since) == true) &&
+        ((rc = start_delta_status(preq, &since)) != PBSE_NONE))
+      {
+      req_reject(rc, 0, preq, NULL, NULL);
+      return;
+      }
     }
 
   if ((type == tjstTruncatedServer) || 
       (type == tjstTruncatedQueue))
     {
-    handle_truncated_qstat(exec_only, cntl->sc_condensed, preq);
+    handle_truncated_qstat(exec_only, cntl->sc_condensed, since, preq);
 
     return;
     } /* END if ((type == tjstTruncatedServer) || ...) */
@@ -633,7 +816,10 @@ void req_stat_job_step2(
     {
     pjob = svr_find_job(preq->rq_ind.rq_status.rq_id, FALSE);
     
-    if ((rc = status_job(pjob, preq, pal, &preply->brp_un.brp_status, cntl->sc_condensed, &bad)))
+    if ((pjob != NULL) &&
+        (pjob->ji_delta_seq <= since))
+      reply_send_svr(preq);
+    else if ((rc = status_job(pjob, preq, pal, &preply->brp_un.brp_status, cntl->sc_condensed, &bad)))
       req_reject(rc, bad, preq, NULL, NULL);
     else
       reply_send_svr(preq);
@@ -656,16 +842,17 @@ void req_stat_job_step2(
              (type == tjstSummarizeArraysServer))
       update_array_statuses();
 
-    iter = get_correct_status_iterator(cntl);
+    iter = get_correct_status_iterator(cntl, job_ids);
 
-    for (pjob = get_next_status_job(cntl, job_array_index, pa, iter);
+    for (pjob = get_next_status_job(cntl, job_index, pa, iter, job_ids);
          pjob != NULL;
-         pjob = get_next_status_job(cntl, job_array_index, pa, iter))
+         pjob = get_next_status_job(cntl, job_index, pa, iter, job_ids))
       {
       mutex_mgr job_mutex(pjob->ji_mutex, true);
 
       /* go ahead and build the status reply for this job */
-      if (pjob->ji_being_recycled == true)
+      if ((pjob->ji_being_recycled == true) ||
+          (pjob->ji_delta_seq <= since))
         continue;
 
       if (exec_only)
@@ -1508,6 +1695,107 @@ int status_node(
 
 
 
+/*
+ * format_threadpool_stats - describe the server's thread pools for the
+ * threadpool_stats attribute
+ */
+
+void format_threadpool_stats(
+
+  char *buf,
+  int   buf_len)
+
+  {
+  const char   *names[] = { "request_pool", "task_pool", "async_pool" };
+  threadpool_t *pools[] = { request_pool, task_pool, async_pool };
+  tp_stats_t    stats;
+  int           used = 0;
+  int           i;
+
+  buf[0] = '\0';
+
+  for (i = 0; (i < 3) && (used < buf_len); i++)
+    {
+    get_threadpool_stats(pools[i], &stats);
+
+    used += snprintf(buf + used, buf_len - used,
+      "%s%s: threads=%d idle=%d queued=%ld max_queued=%ld enqueued=%ld stolen=%ld avg_wait_us=%ld max_wait_us=%ld",
+      (i == 0) ? "" : "; ",
+      names[i],
+      stats.threads,
+      stats.idle,
+      stats.queued,
+      stats.max_queued,
+      stats.enqueued,
+      stats.stolen,
+      stats.avg_wait_us,
+      stats.max_wait_us);
+    }
+  } /* END format_threadpool_stats() */
+
+
+
+/*
+ * format_job_status_cache_stats - describe the job status cache for the
+ * job_status_cache attribute
+ */
+
+void format_job_status_cache_stats(
+
+  char *buf,
+  int   buf_len)
+
+  {
+  unsigned long hits;
+  unsigned long misses;
+  long          entries;
+  long          bytes;
+  int           hit_rate = 0;
+
+  get_job_status_cache_stats(&hits, &misses, &entries, &bytes);
+
+  if (hits + misses > 0)
+    hit_rate = (int)((hits * 100) / (hits + misses));
+
+  snprintf(buf, buf_len, "hits=%lu misses=%lu hit_rate=%d%% entries=%ld bytes=%ld",
+    hits,
+    misses,
+    hit_rate,
+    entries,
+    bytes);
+  } /* END format_job_status_cache_stats() */
+
+
+
+
+/*
+ * svr_attr_requested - whether a server status asks for attribute index, so
+ * the statistics attributes are only worked out for a status that shows them
+ *
+ * @param pal - the attributes asked for, NULL for all of them
+ */
+
+static bool svr_attr_requested(
+
+  svrattrl *pal,
+  int       index)
+
+  {
+  if (pal == NULL)
+    return(true);
+
+  for (; pal != NULL; pal = (svrattrl *)GET_NEXT(pal->al_link))
+    {
+    if (find_attr(svr_attr_def, pal->al_name, SRV_ATR_LAST) == index)
+      return(true);
+    }
+
+  return(false);
+  } /* END svr_attr_requested() */
+
+
+
+
 /*
  * req_stat_svr - service the Status Server Request
  *
@@ -1526,6 +1814,10 @@ int req_stat_svr(
   struct brp_status    *pstat;
   int                   bad = 0;
   char                  nc_buf[128];
+  char                  tp_buf[1024];
+  char                  sc_buf[256];
+  char                  ob_buf[512];
+  std::string           usage;
   int                   numjobs;
   int                   netrates[3];
 
@@ -1549,14 +1841,65 @@ int req_stat_svr(
   
   pthread_mutex_unlock(server.sv_jobstates_mutex);
 
-  netcounter_get(netrates);
-  snprintf(nc_buf, 127, "%d %d %d", netrates[0], netrates[1], netrates[2]);
+  pal = (svrattrl *)GET_NEXT(preq->rq_ind.rq_status.rq_attr);
+
+  if (svr_attr_requested(pal, SRV_ATR_NetCounter))
+    {
+    netcounter_get(netrates);
+    snprintf(nc_buf, 127, "%d %d %d", netrates[0], netrates[1], netrates[2]);
+
+    if (server.sv_attr[SRV_ATR_NetCounter].at_val.at_str != NULL)
+      free(server.sv_attr[SRV_ATR_NetCounter].at_val.at_str);
+    server.sv_attr[SRV_ATR_NetCounter].at_val.at_str = strdup(nc_buf);
+    if (server.sv_attr[SRV_ATR_NetCounter].at_val.at_str != NULL)
+      server.sv_attr[SRV_ATR_NetCounter].at_flags |= ATR_VFLAG_SET;
+    }
+
+  if (svr_attr_requested(pal, SRV_ATR_ThreadpoolStats))
+    {
+    format_threadpool_stats(tp_buf, sizeof(tp_buf));
+
+    if (server.sv_attr[SRV_ATR_ThreadpoolStats].at_val.at_str != NULL)
+      free(server.sv_attr[SRV_ATR_ThreadpoolStats].at_val.at_str);
+    server.sv_attr[SRV_ATR_ThreadpoolStats].at_val.at_str = strdup(tp_buf);
+    if (server.sv_attr[SRV_ATR_ThreadpoolStats].at_val.at_str != NULL)
+      server.sv_attr[SRV_ATR_ThreadpoolStats].at_flags |= ATR_VFLAG_SET;
+    }
 
-  if (server.sv_attr[SRV_ATR_NetCounter].at_val.at_str != NULL)
-    free(server.sv_attr[SRV_ATR_NetCounter].at_val.at_str);
-  server.sv_attr[SRV_ATR_NetCounter].at_val.at_str = strdup(nc_buf);
-  if (server.sv_attr[SRV_ATR_NetCounter].at_val.at_str != NULL)
-    server.sv_attr[SRV_ATR_NetCounter].at_flags |= ATR_VFLAG_SET;
+  if (svr_attr_requested(pal, SRV_ATR_JobStatusCache))
+    {
+    format_job_status_cache_stats(sc_buf, sizeof(sc_buf));
+
+    if (server.sv_attr[SRV_ATR_JobStatusCache].at_val.at_str != NULL)
+      free(server.sv_attr[SRV_ATR_JobStatusCache].at_val.at_str);
+    server.sv_attr[SRV_ATR_JobStatusCache].at_val.at_str = strdup(sc_buf);
+    if (server.sv_attr[SRV_ATR_JobStatusCache].at_val.at_str != NULL)
+      server.sv_attr[SRV_ATR_JobStatusCache].at_flags |= ATR_VFLAG_SET;
+    }
+
+  if (svr_attr_requested(pal, SRV_ATR_ObitStats))
+    {
+    format_obit_stats(ob_buf, sizeof(ob_buf));
+
+    if (server.sv_attr[SRV_ATR_ObitStats].at_val.at_str != NULL)
+      free(server.sv_attr[SRV_ATR_ObitStats].at_val.at_str);
+    server.sv_attr[SRV_ATR_ObitStats].at_val.at_str = strdup(ob_buf);
+    if (server.sv_attr[SRV_ATR_ObitStats].at_val.at_str != NULL)
+      server.sv_attr[SRV_ATR_ObitStats].at_flags |= ATR_VFLAG_SET;
+    }
+
+  if (svr_attr_requested(pal, SRV_ATR_UserUsage))
+    {
+    format_user_usage(usage);
+
+    if (server.sv_attr[SRV_ATR_UserUsage].at_val.at_str != NULL)
+      free(server.sv_attr[SRV_ATR_UserUsage].at_val.at_str);
+    server.sv_attr[SRV_ATR_UserUsage].at_val.at_str = NULL;
+    server.sv_attr[SRV_ATR_UserUsage].at_flags &= ~ATR_VFLAG_SET;
+    if ((usage.size() != 0) &&
+        ((server.sv_attr[SRV_ATR_UserUsage].at_val.at_str = strdup(usage.c_str())) != NULL))
+      server.sv_attr[SRV_ATR_UserUsage].at_flags |= ATR_VFLAG_SET;
+    }
   pthread_mutex_unlock(server.sv_attr_mutex);
 
   /* allocate a reply structure and a status sub-structure */
@@ -1590,8 +1933,6 @@ int req_stat_svr(
 
   /* add attributes to the status reply */
 
-  pal = (svrattrl *)GET_NEXT(preq->rq_ind.rq_status.rq_attr);
-
   if (status_attrib(
         pal,
         svr_attr_def,
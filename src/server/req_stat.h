@@ -27,6 +27,12 @@ int get_numa_statuses(struct pbsnode *pnode, struct batch_request *preq, int *ba
 
 int req_stat_node(struct batch_request *preq);
 
+int start_delta_status(struct batch_request *preq, unsigned long long *since);
+
+void format_threadpool_stats(char *buf, int buf_len);
+
+void format_job_status_cache_stats(char *buf, int buf_len);
+
 int req_stat_svr(struct batch_request *preq);
 
 /* static void update_state_ct(pbs_attribute *pattr, int *ct_array, char *buf); */
@@ -786,6 +786,7 @@ int init_resc_defs(void)
   int                   rindex = 0;
   int                   dindex = 0;
   int                   unkindex = 0;
+  resource_def         *old_defs = svr_resc_def;
 #ifndef PBS_MOM
 
   resource_def         *tmpresc = NULL;
@@ -871,6 +872,9 @@ int init_resc_defs(void)
 
   svr_resc_size = rindex + 1;
 
+  /* lookups through old_defs may still be running, so it is not freed */
+  index_resc_defs(svr_resc_def, svr_resc_size, old_defs);
+
   return(PBSE_NONE);
   } /* END init_resc_defs() */
 
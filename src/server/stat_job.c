@@ -86,8 +86,17 @@
  * Included funtions are:
  * status_job()
  * status_attrib()
+ *
+ * The status of each job is kept encoded (ji_status_cache) for the next
+ * request asking for the same attributes with the same permissions.  A job's
+ * cache is used until the job changes (ji_delta_seq, see job_delta.c), which
+ * includes the resources_used a mom reports with its status
+ * (process_job_attribute_information()).
+ * Walltime remaining changes with the clock, so it is never cached and is
+ * sent at its place in the middle of the cached entries.
  */
 #include <stdlib.h>
+#include <string.h>
 #include "libpbs.h"
 #include <ctype.h>
 #include <stdio.h>
@@ -106,9 +115,15 @@
 #include "svr_func.h" /* get_svr_attr_* */
 #include "log.h"
 #include "job_route.h" /* remove_procct */
+#include "dis.h"
+#include "tcp.h"
+
+#define JOB_STATUS_CACHE_MAX_BYTES  (256 * 1024 * 1024) /* stop caching job status past this */
+#define JOB_STATUS_CACHE_CHAN_SIZE  16384               /* starting size of the encode buffer */
 
 extern int     svr_authorize_jobreq(struct batch_request *, job *);
 int status_attrib(svrattrl *, attribute_def *, pbs_attribute *, int, int, tlist_head *, bool, int *, int);
+int add_walltime_remaining(int, pbs_attribute *, tlist_head *);
 
 /* Global Data Items: */
 
@@ -116,6 +131,252 @@ extern attribute_def job_attr_def[];
 
 extern struct server server;
 
+/* job status cache counters, see get_job_status_cache_stats() */
+static volatile unsigned long status_cache_hits = 0;
+static volatile unsigned long status_cache_misses = 0;
+static volatile long          status_cache_entries = 0;
+static volatile long          status_cache_bytes = 0;
+
+static __thread struct tcp_chan *status_chan = NULL; /* memory channel to encode into */
+
+
+
+/*
+ * status_cache_key - identify the status request a cached status answers
+ *
+ * FNV-1a over the requested attribute names and what limits what may be seen.
+ */
+
+unsigned long status_cache_key(
+
+  svrattrl *pal,
+  int       priv,
+  int       IsOwner,
+  bool      condensed)
+
+  {
+  unsigned long  key = 2166136261UL;
+  const char    *ptr;
+  int            flags[3];
+  unsigned int   i;
+
+  flags[0] = priv & ATR_DFLAG_RDACC;
+  flags[1] = IsOwner;
+  flags[2] = (condensed == true);
+
+  for (i = 0; i < sizeof(flags); i++)
+    key = (key ^ ((unsigned char *)flags)[i]) * 16777619UL;
+
+  for (;pal != NULL;pal = (svrattrl *)GET_NEXT(pal->al_link))
+    {
+    for (ptr = pal->al_name; (ptr != NULL) && (*ptr != '\0'); ptr++)
+      key = (key ^ (unsigned char)*ptr) * 16777619UL;
+
+    key = (key ^ '.') * 16777619UL;
+
+    for (ptr = pal->al_resc; (ptr != NULL) && (*ptr != '\0'); ptr++)
+      key = (key ^ (unsigned char)*ptr) * 16777619UL;
+
+    key = (key ^ ',') * 16777619UL;
+    }
+
+  return(key);
+  } /* END status_cache_key() */
+
+
+
+/*
+ * job_status_cache_free - drop pjob's cached status
+ *
+ * NOTE: pjob's mutex must be held
+ */
+
+void job_status_cache_free(
+
+  job *pjob)
+
+  {
+  struct brp_encoded *penc = pjob->ji_status_cache;
+
+  if (penc == NULL)
+    return;
+
+  pjob->ji_status_cache = NULL;
+
+  __sync_fetch_and_sub(&status_cache_entries, 1);
+  __sync_fetch_and_sub(&status_cache_bytes, (long)penc->be_len);
+
+  brp_encoded_release(penc);
+  } /* END job_status_cache_free() */
+
+
+
+/*
+ * get_job_status_cache_stats - report how well the job status cache does
+ */
+
+void get_job_status_cache_stats(
+
+  unsigned long *hits,
+  unsigned long *misses,
+  long          *entries,
+  long          *bytes)
+
+  {
+  *hits = __sync_add_and_fetch(&status_cache_hits, 0);
+  *misses = __sync_add_and_fetch(&status_cache_misses, 0);
+  *entries = __sync_add_and_fetch(&status_cache_entries, 0);
+  *bytes = __sync_add_and_fetch(&status_cache_bytes, 0);
+  } /* END get_job_status_cache_stats() */
+
+
+
+static bool is_walltime_remaining(
+
+  svrattrl *pal)
+
+  {
+  return((pal->al_resc != NULL) &&
+         (!strcmp(pal->al_name, "Walltime")) &&
+         (!strcmp(pal->al_resc, "Remaining")));
+  } /* END is_walltime_remaining() */
+
+
+
+static struct tcp_chan *get_status_chan()
+
+  {
+  if (status_chan == NULL)
+    {
+    struct tcp_chan *chan;
+
+    if ((chan = (struct tcp_chan *)calloc(1, sizeof(struct tcp_chan))) == NULL)
+      return(NULL);
+
+    if ((chan->writebuf.tdis_thebuf = (char *)calloc(1, JOB_STATUS_CACHE_CHAN_SIZE + 1)) == NULL)
+      {
+      free(chan);
+      return(NULL);
+      }
+
+    chan->writebuf.tdis_bufsize = JOB_STATUS_CACHE_CHAN_SIZE;
+    chan->sock = -1;
+
+    status_chan = chan;
+    }
+
+  /* tcp_puts() may have moved the buffer */
+  status_chan->writebuf.tdis_leadp = status_chan->writebuf.tdis_thebuf;
+  status_chan->writebuf.tdis_trailp = status_chan->writebuf.tdis_thebuf;
+  status_chan->writebuf.tdis_eod = status_chan->writebuf.tdis_thebuf;
+
+  return(status_chan);
+  } /* END get_status_chan() */
+
+
+
+/*
+ * cache_job_status - encode pstat's entries and keep them as pjob's cache
+ *
+ * On success the encoded entries are moved from pstat->brp_attr to
+ * pstat->brp_encoded, leaving only walltime remaining in the list.  On any
+ * failure pstat is left as it was and is sent the usual way.
+ *
+ * NOTE: pjob's mutex must be held
+ */
+
+int cache_job_status(
+
+  job               *pjob,
+  struct brp_status *pstat,
+  unsigned long      key)
+
+  {
+  struct tcp_chan    *chan;
+  struct brp_encoded *penc;
+  svrattrl           *pal;
+  svrattrl           *next;
+  char               *start;
+  size_t              len;
+  size_t              split = 0;
+  bool                walltime = false;
+  int                 count = 0;
+
+  if ((chan = get_status_chan()) == NULL)
+    return(PBSE_SYSTEM);
+
+  for (pal = (svrattrl *)GET_NEXT(pstat->brp_attr); pal != NULL; pal = (svrattrl *)GET_NEXT(pal->al_link))
+    {
+    if ((walltime == false) &&
+        (is_walltime_remaining(pal) == true))
+      {
+      split = chan->writebuf.tdis_leadp - chan->writebuf.tdis_thebuf;
+      walltime = true;
+      continue;
+      }
+
+    if (encode_DIS_svrattrl_entry(chan, pal) != DIS_SUCCESS)
+      return(PBSE_SYSTEM);
+
+    count++;
+    }
+
+  start = chan->writebuf.tdis_thebuf;
+  len = chan->writebuf.tdis_leadp - start;
+
+  if (walltime == false)
+    split = len;
+
+  /* the old cache's bytes are about to be given back */
+  if (pjob->ji_status_cache != NULL)
+    job_status_cache_free(pjob);
+
+  if (__sync_add_and_fetch(&status_cache_bytes, (long)len) > JOB_STATUS_CACHE_MAX_BYTES)
+    {
+    __sync_fetch_and_sub(&status_cache_bytes, (long)len);
+    return(PBSE_RESCUNAV);
+    }
+
+  if ((penc = (struct brp_encoded *)malloc(sizeof(struct brp_encoded) + len)) == NULL)
+    {
+    __sync_fetch_and_sub(&status_cache_bytes, (long)len);
+    return(PBSE_SYSTEM);
+    }
+
+  penc->be_refs = 1; /* the job's */
+  penc->be_count = count;
+  penc->be_split = split;
+  penc->be_len = len;
+  memcpy(penc->be_data, start, len);
+
+  __sync_fetch_and_add(&status_cache_entries, 1);
+
+  pjob->ji_status_cache = penc;
+  pjob->ji_status_cache_seq = pjob->ji_delta_seq;
+  pjob->ji_status_cache_key = key;
+  pjob->ji_status_cache_walltime = walltime;
+
+  /* what was encoded is now sent from the cache */
+  pal = (svrattrl *)GET_NEXT(pstat->brp_attr);
+
+  while (pal != NULL)
+    {
+    next = (svrattrl *)GET_NEXT(pal->al_link);
+
+    if (is_walltime_remaining(pal) == false)
+      {
+      delete_link(&pal->al_link);
+      free(pal);
+      }
+
+    pal = next;
+    }
+
+  pstat->brp_encoded = brp_encoded_hold(penc);
+
+  return(PBSE_NONE);
+  } /* END cache_job_status() */
+
 
 
 
@@ -141,6 +402,7 @@ int status_job(
   int                IsOwner = 0;
   long               query_others = 0;
   long               condensed_timeout = JOB_CONDENSED_TIMEOUT;
+  unsigned long      key;
 
   /* Make sure procct is removed from the job 
      resource attributes */
@@ -186,6 +448,24 @@ int status_job(
 
   *bad = 0;
 
+  key = status_cache_key(pal, preq->rq_perm, IsOwner, condensed);
+
+  if ((pjob->ji_status_cache != NULL) &&
+      (pjob->ji_status_cache_seq == pjob->ji_delta_seq) &&
+      (pjob->ji_status_cache_key == key))
+    {
+    __sync_fetch_and_add(&status_cache_hits, 1);
+
+    pstat->brp_encoded = brp_encoded_hold(pjob->ji_status_cache);
+
+    if (pjob->ji_status_cache_walltime == true)
+      add_walltime_remaining(JOB_ATR_start_time, pjob->ji_wattr, &pstat->brp_attr);
+
+    return(PBSE_NONE);
+    }
+
+  __sync_fetch_and_add(&status_cache_misses, 1);
+
   if (status_attrib(
         pal,
         job_attr_def,
@@ -200,6 +480,8 @@ int status_job(
     return(PBSE_NOATTR);
     }
 
+  cache_job_status(pjob, pstat, key);
+
   return (0);
   }  /* END status_job() */
 
@@ -9,8 +9,18 @@
 
 
 
-int status_job(job *pjob, struct batch_request *preq, svrattrl *pal, tlist_head *pstathd, int *bad);
+int status_job(job *pjob, struct batch_request *preq, svrattrl *pal, tlist_head *pstathd, bool condensed, int *bad);
 
-int status_attrib(svrattrl *pal, attribute_def *padef, pbs_attribute *pattr, int limit, int priv, tlist_head *phead, int *bad, int IsOwner);
+int status_attrib(svrattrl *pal, attribute_def *padef, pbs_attribute *pattr, int limit, int priv, tlist_head *phead, bool condensed, int *bad, int IsOwner);
+
+int add_walltime_remaining(int index, pbs_attribute *pattr, tlist_head *phead);
+
+unsigned long status_cache_key(svrattrl *pal, int priv, int IsOwner, bool condensed);
+
+int cache_job_status(job *pjob, struct brp_status *pstat, unsigned long key);
+
+void job_status_cache_free(job *pjob);
+
+void get_job_status_cache_stats(unsigned long *hits, unsigned long *misses, long *entries, long *bytes);
 
 #endif /* _STAT_JOB_H */
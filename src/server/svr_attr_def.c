@@ -1481,4 +1481,64 @@ attribute_def svr_attr_def[] =
       ATR_TYPE_LONG,
       PARENT_TYPE_SERVER},
 
+    /* SRV_ATR_ThreadpoolStats */
+    {(char *)ATTR_threadpoolstats, /* "threadpool_stats" */
+     decode_null,
+     encode_str,
+     set_null,
+     comp_str,
+     free_null,
+     NULL_FUNC,
+     READ_ONLY,
+     ATR_TYPE_STR,
+     PARENT_TYPE_SERVER},
+
+    /* SRV_ATR_JobStatusCache */
+    {(char *)ATTR_jobstatuscache, /* "job_status_cache" */
+     decode_null,
+     encode_str,
+     set_null,
+     comp_str,
+     free_null,
+     NULL_FUNC,
+     READ_ONLY,
+     ATR_TYPE_STR,
+     PARENT_TYPE_SERVER},
+
+    /* SRV_ATR_ObitStats */
+    {(char *)ATTR_obitstats, /* "obit_stats" */
+     decode_null,
+     encode_str,
+     set_null,
+     comp_str,
+     free_null,
+     NULL_FUNC,
+     READ_ONLY,
+     ATR_TYPE_STR,
+     PARENT_TYPE_SERVER},
+
+    /* SRV_ATR_UserUsage */
+    {(char *)ATTR_userusage, /* "user_usage" */
+     decode_null,
+     encode_str,
+     set_null,
+     comp_str,
+     free_null,
+     NULL_FUNC,
+     READ_ONLY,
+     ATR_TYPE_STR,
+     PARENT_TYPE_SERVER},
+
+    /* SRV_ATR_Capabilities */
+    {(char *)ATTR_capabilities, /* "capabilities" */
+     decode_str,
+     encode_str,
+     set_str,
+     comp_str,
+     free_str,
+     NULL_FUNC,
+     READ_ONLY,
+     ATR_TYPE_STR,
+     PARENT_TYPE_SERVER},
+
   };
@@ -147,6 +147,8 @@
 #include <vector>
 
 #include "user_info.h" /* remove_server_suffix() */
+#include "job_delta.h"
+#include "job_select_index.h"
 
 #define MSG_LEN_LONG 160
 
@@ -294,6 +296,15 @@ const char *PJobSubState[] =
 
 
 
+/*
+ * insert_into_alljobs_by_rank() - place pjob in aj in order of queue rank
+ *
+ * The container keeps the rank of each job it was given here, so neither the
+ * list nor the other jobs' mutexes are touched.  pjob stays locked.
+ *
+ * @return PBSE_NONE, ALREADY_IN_LIST or ENOMEM
+ */
+
 int insert_into_alljobs_by_rank(
 
   all_jobs         *aj,
@@ -301,64 +312,19 @@ int insert_into_alljobs_by_rank(
   char            *jobid)
 
   {
-  job  *pjcur;
-  aj->lock();
-  all_jobs_iterator  *iter = aj->get_iterator(true);
-  long  job_qrank = pjob->ji_wattr[JOB_ATR_qrank].at_val.at_long;
-  std::string curJobid = "";
-  
-  unlock_ji_mutex(pjob, __func__, "4", LOGLEVEL);
-
-  while ((pjcur = iter->get_next_item()) != NULL)
-    {
-    mutex_mgr pjcur_mgr(pjcur->ji_mutex, true);
-    if (job_qrank > pjcur->ji_wattr[JOB_ATR_qrank].at_val.at_long)
-      {
-      pjcur_mgr.set_unlock_on_exit(false);
-      break;
-      }
-    
-    if (strcmp(jobid, pjcur->ji_qs.ji_jobid) == 0)
-      {
-      delete iter;
+  long job_qrank = pjob->ji_wattr[JOB_ATR_qrank].at_val.at_long;
+  int  rc = PBSE_NONE;
 
-      aj->unlock();
-      return(ALREADY_IN_LIST);
-      }
-    }
-
-  delete iter;
-
-  if (pjcur != NULL)
-    {
-    if(aj->find(pjcur->ji_qs.ji_jobid))
-      {
-      curJobid = pjcur->ji_qs.ji_jobid;
-      }
-    unlock_ji_mutex(pjcur, __func__, "8", LOGLEVEL);
-    pjcur = NULL;
-    }
-  aj->unlock();
+  aj->lock();
 
-  if ((pjob = svr_find_job(jobid, FALSE)) == NULL)
-    {
-    return(PBSE_JOBNOTFOUND);
-    }
+  if (aj->find(jobid) != NULL)
+    rc = ALREADY_IN_LIST;
+  else if (aj->insert_by_rank(pjob, pjob->ji_qs.ji_jobid, job_qrank) == false)
+    rc = ENOMEM;
 
-  aj->lock();
-  if (curJobid.length() == 0)
-    {
-    /* link first in list */
-    aj->insert_first(pjob,pjob->ji_qs.ji_jobid);
-    }
-  else
-    {
-    /* link after 'current' job in list */
-    aj->insert_after(curJobid, pjob,pjob->ji_qs.ji_jobid);
-    }
   aj->unlock();
 
-  return(PBSE_NONE);
+  return(rc);
   } /* END insert_into_alljobs_by_rank() */
 
 
@@ -498,6 +464,7 @@ int svr_enquejob(
       alljobs.insert(pjob,pjob->ji_qs.ji_jobid);
     else
       alljobs.insert_after(prev_job_id,pjob,pjob->ji_qs.ji_jobid);
+    job_registry_add(pjob);
     alljobs.unlock();
 
     if (has_sv_qs_mutex == FALSE)
@@ -534,8 +501,7 @@ int svr_enquejob(
     {
     rc = insert_into_alljobs_by_rank(pque->qu_jobs, pjob, job_id);
 
-    if ((rc == ALREADY_IN_LIST) ||
-        (rc == PBSE_JOBNOTFOUND))
+    if (rc != PBSE_NONE)
       {
       if (rc == ALREADY_IN_LIST)
         {
@@ -549,15 +515,14 @@ int svr_enquejob(
     pque->qu_numjobs++;
     pque->qu_njstate[pjob->ji_qs.ji_state]++;
     
-    /* increment this user's job count for this queue */
+    /* count this job for its user in this queue and on the server */
     if (LOGLEVEL >= 6)
       {
       snprintf(log_buf, sizeof(log_buf), "jobs queued job id %s for %s", pjob->ji_qs.ji_jobid, pque->qu_qs.qu_name);
       log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, __func__, log_buf);
       }
 
-    increment_queued_jobs(pque->qu_uih, pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pjob);
-    increment_queued_jobs(&users, pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pjob);
+    add_user_usage(pjob);
     }
 
   if ((pjob->ji_is_array_template) ||
@@ -565,8 +530,7 @@ int svr_enquejob(
     {
     rc = insert_into_alljobs_by_rank(pque->qu_jobs_array_sum, pjob, job_id);
 
-    if ((rc == ALREADY_IN_LIST) ||
-        (rc == PBSE_JOBNOTFOUND))
+    if (rc != PBSE_NONE)
       {
       if (rc == ALREADY_IN_LIST)
         rc = PBSE_NONE;
@@ -735,24 +699,10 @@ int svr_dequejob(
   else
     pque = pjob->ji_qhdr;
 
+  remove_user_usage(pjob);
+
   if (pque != NULL)
     {
-    /* At this point unless the job is in state of JOB_STATE_COMPLETE we need to decrement the queue count */
-    if ((pque->qu_qs.qu_type == QTYPE_RoutePush) ||
-        (pjob->ji_qs.ji_state != JOB_STATE_COMPLETE))
-      {
-      if (pjob->ji_qs.ji_state != JOB_STATE_COMPLETE)
-        decrement_queued_jobs(&users, pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pjob);
-
-      rc = decrement_queued_jobs(pque->qu_uih, pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pjob);
-      if (rc != PBSE_NONE)
-        {
-        snprintf(log_buf, sizeof(log_buf), "failed to decrement user job count: %s. %s", 
-          pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pbse_to_txt(rc));
-        log_event(PBSEVENT_JOB, PBS_EVENTCLASS_QUEUE, __func__, log_buf);
-        }
-      }
-
     std::string jobid = pjob->ji_qs.ji_jobid;
     if ((rc = remove_job(pque->qu_jobs, pjob)) == PBSE_NONE)
       {
@@ -969,6 +919,9 @@ void set_jobstate_basic(
   pjob.ji_wattr[JOB_ATR_substate].at_val.at_long = newsubstate;
 
   set_statechar(&pjob);
+
+  job_index_update(&pjob);
+  update_user_usage(&pjob);
   } /* END set_jobstate_basic() */
 
 
@@ -1103,6 +1056,8 @@ int svr_setjobstate(
   if (is_valid_state_transition(*pjob, newstate, newsubstate) == false)
     return(PBSE_BAD_JOB_STATE_TRANSITION);
 
+  job_delta_touch(pjob);
+
   if (pjob->ji_parent_job != NULL)
     return(set_subjob_state(pjob, newstate, newsubstate, has_queue_mutex));
 
@@ -1178,19 +1133,6 @@ int svr_setjobstate(
         {
         changed = true;
 
-        /* decrement queued job count if we're completing */
-        if ((pjob->ji_is_array_template == FALSE) &&
-            (newstate == JOB_STATE_COMPLETE))
-          {
-          if (LOGLEVEL >= 6)
-            {
-            sprintf(log_buf, "jobs queued job id %s for users", jid.c_str());
-            log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, __func__, log_buf);
-            }
-
-          decrement_queued_jobs(&users, pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pjob);
-          }
-
         if (pque != NULL)
           {
           /* the array job isn't actually a job so don't count it here */
@@ -1198,19 +1140,6 @@ int svr_setjobstate(
             {
             pque->qu_njstate[oldstate]--;
             pque->qu_njstate[newstate]++;
-
-            /* decrement queued job count if we're completing */
-            if ((pjob->ji_qs.ji_state != JOB_STATE_TRANSIT) &&
-                (pjob->ji_qs.ji_state != JOB_STATE_COMPLETE) &&
-                (newstate == JOB_STATE_COMPLETE))
-              {
-              if (LOGLEVEL >= 6)
-                {
-                sprintf(log_buf, "jobs queued job id %s for queue %s", jid.c_str(), pque->qu_qs.qu_name);
-                log_event(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, __func__, log_buf);
-                }
-              decrement_queued_jobs(pque->qu_uih, pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str, pjob);
-              }
             }
 
           /* if execution queue, and eligibility to run has improved, */
@@ -1968,12 +1897,16 @@ static int count_queued_jobs(
   const char      *user) /* I */
 
   {
-  int num_jobs = 0;
+  int        num_jobs = 0;
+  user_usage uu;
 
   if (user == NULL)
     num_jobs = pque->qu_numjobs - pque->qu_njstate[JOB_STATE_COMPLETE];
   else
-    num_jobs = get_num_queued(pque->qu_uih, user);
+    {
+    get_user_usage(user, pque->qu_qs.qu_name, uu);
+    num_jobs = uu.queued;
+    }
 
   return(num_jobs);
   } /* END count_queued_jobs */
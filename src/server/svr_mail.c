@@ -104,6 +104,7 @@
 #include "threadpool.h"
 #include "svrfunc.h" /* get_svr_attr_* */
 #include "work_task.h"
+#include "mail_spool.h"
 #include <sys/wait.h>
 
 /* Unit tests should use the special unit test sendmail command */
@@ -192,15 +193,35 @@ void add_body_info(
  * of the message.
  *
  */
+void write_email_body(
+
+  FILE      *outmail_input,
+  mail_info *mi)
+
+  {
+  char *bodyfmt = NULL;
+  char  bodyfmtbuf[MAXLINE];
+
+  /* mail body formating statement */
+  get_svr_attr_str(SRV_ATR_MailBodyFmt, &bodyfmt);
+  if (bodyfmt == NULL)
+    {
+    add_body_info(bodyfmtbuf, mi);
+    bodyfmt = bodyfmtbuf;
+    }
+
+  svr_format_job(outmail_input, mi, bodyfmt);
+  } /* END write_email_body() */
+
+
+
 void write_email(
 
   FILE      *outmail_input,
   mail_info *mi)
 
   {
-  char       *bodyfmt = NULL;
   const char *subjectfmt = NULL;
-  char bodyfmtbuf[MAXLINE];
 
   /* Pipe in mail headers: To: and Subject: */
   fprintf(outmail_input, "To: %s\n", mi->mailto);
@@ -219,18 +240,53 @@ void write_email(
   /* Set "Precedence: bulk" to avoid vacation messages, etc */
   fprintf(outmail_input, "Precedence: bulk\n\n");
 
-  /* mail body formating statement */
-  get_svr_attr_str(SRV_ATR_MailBodyFmt, &bodyfmt);
-  if (bodyfmt == NULL)
+  /* Now pipe in the email body */
+  write_email_body(outmail_input, mi);
+
+  } /* write_email() */
+
+
+
+/*
+ * write_email_digest()
+ *
+ * Writes the notifications the mail spool coalesced for one set of
+ * recipients as a single message, one body after another.  A digest of
+ * one is written the same as write_email() would.
+ */
+
+void write_email_digest(
+
+  FILE        *outmail_input,
+  mail_digest &md)
+
+  {
+  if (md.items.size() == 1)
     {
-    add_body_info(bodyfmtbuf, mi);
-    bodyfmt = bodyfmtbuf;
+    write_email(outmail_input, md.items[0]);
+    return;
     }
 
-  /* Now pipe in the email body */
-  svr_format_job(outmail_input, mi, bodyfmt);
+  fprintf(outmail_input, "To: %s\n", md.mailto.c_str());
 
-  } /* write_email() */
+  if (md.array_id.size() > 0)
+    fprintf(outmail_input, "Subject: PBS JOB ARRAY %s: %d job notifications\n",
+      md.array_id.c_str(), (int)md.items.size());
+  else
+    fprintf(outmail_input, "Subject: PBS: %d job notifications\n",
+      (int)md.items.size());
+
+  /* Set "Precedence: bulk" to avoid vacation messages, etc */
+  fprintf(outmail_input, "Precedence: bulk\n\n");
+
+  for (size_t i = 0; i < md.items.size(); i++)
+    {
+    if (i > 0)
+      fprintf(outmail_input, "\n----------------------------------------\n\n");
+
+    write_email_body(outmail_input, md.items[i]);
+    }
+  } /* END write_email_digest() */
 
 
 /*
@@ -708,8 +764,12 @@ void svr_mailowner(
   else
     mi->text = NULL;
 
-  /* have a thread do the work of sending the mail */
-  enqueue_threadpool_request(send_the_mail, mi, task_pool);
+  /* queue it to be coalesced with other mail to the same recipients,
+   * or if the mail spool isn't running have a thread do the work of
+   * sending the mail */
+  if (mail_spool_add(mi,
+        (pjob->ji_arraystructid[0] != '\0') ? pjob->ji_arraystructid : NULL) != PBSE_NONE)
+    enqueue_threadpool_request(send_the_mail, mi, task_pool);
 
   return;
   }  /* END svr_mailowner() */
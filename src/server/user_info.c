@@ -78,14 +78,36 @@
 */
 
 #include <string>
+#include <map>
 #include <stdio.h>
 #include <errno.h>
+#include <pthread.h>
 #include "user_info.h"
 #include "svrfunc.h"
 #include "array.h"
 #include "server.h"
+#include "resource.h"
+#include "resc_def_all.h" /* count_proc */
 
-user_info_holder users;
+/*
+ * The usage table holds what each user's jobs add up to in each queue, and
+ * under the queue name "" on the whole server.  Rather than walking the
+ * jobs, it is kept up to date as jobs are enqueued, change state and are
+ * dequeued: usage_jobs remembers what each counted job last added, and a
+ * change applies the difference.  The max_user_queuable limits of the
+ * server and the queues are checked against it.
+ */
+
+typedef struct job_usage
+  {
+  std::string user;
+  std::string queue;
+  user_usage  uu;
+  } job_usage;
+
+static pthread_mutex_t                                           usage_mutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, std::map<std::string, user_usage> > usage_table;
+static std::map<std::string, job_usage>                          usage_jobs;
 
 
 /*
@@ -110,29 +132,6 @@ void remove_server_suffix(
 
 
 
-unsigned int get_num_queued(
-    
-  user_info_holder *uih,
-  const char       *user_name)
-
-  {
-  unsigned int  num_queued = 0;
-  user_info    *ui = NULL;
-
-  uih->lock();
-
-  if ((ui = uih->find(user_name)) != NULL)
-    {
-    num_queued = ui->num_jobs_queued;
-    }
-
-  uih->unlock();
-
-  return(num_queued);
-  } /* END get_num_queued() */
-
-
-
 unsigned int count_jobs_submitted(
 
   job *pjob)
@@ -159,20 +158,17 @@ int  can_queue_new_job(
   {
   long         max_queuable = -1;
   int          can_queue_another = TRUE;
-  unsigned int num_queued = 0;
   unsigned int num_to_add;
-  std::string  uname(user_name);
+  user_usage   uu;
 
   get_svr_attr_l(SRV_ATR_MaxUserQueuable, &max_queuable);
 
-  remove_server_suffix(uname);
-
   if (max_queuable >= 0)
     {
     num_to_add = count_jobs_submitted(pjob);
-    num_queued = get_num_queued(&users, uname.c_str());
+    get_user_usage(user_name, NULL, uu);
 
-    if (num_queued + num_to_add > (unsigned int)max_queuable)
+    if ((unsigned int)uu.queued + num_to_add > (unsigned int)max_queuable)
       can_queue_another = FALSE;
     }
   
@@ -182,117 +178,300 @@ int  can_queue_new_job(
 
 
 
-int  increment_queued_jobs(
-   
-  user_info_holder *uih,
-  char             *user_name,
-  job              *pjob)
+/*
+ * job_procs - the processors a job asked for, as initialize_procct()
+ * counts them: the processors in its nodes spec plus procs
+ */
+
+static long job_procs(
+
+  job *pjob)
 
   {
-  int           rc = PBSE_NONE;
-  user_info    *ui;
-  unsigned      bit = COUNTED_GLOBALLY;
+  pbs_attribute *pattr = &pjob->ji_wattr[JOB_ATR_resource];
+  resource_def  *prdef;
+  resource      *presc;
+  long           procs = 0;
 
+  if ((pattr->at_flags & ATR_VFLAG_SET) == 0)
+    return(0);
 
-  /* If pbs_server is restarting we may get jobs in a completed state.
-     we do not want to count these jobs as queued */
-  if (pjob->ji_qs.ji_state == JOB_STATE_COMPLETE)
-    return(rc);
+  if (((prdef = find_resc_def(svr_resc_def, "nodes", svr_resc_size)) != NULL) &&
+      ((presc = find_resc_entry(pattr, prdef)) != NULL) &&
+      (presc->rs_value.at_val.at_str != NULL))
+    procs = count_proc(presc->rs_value.at_val.at_str);
 
-  if (uih != &users)
-    bit = COUNTED_IN_QUEUE;
+  if (((prdef = find_resc_def(svr_resc_def, "procs", svr_resc_size)) != NULL) &&
+      ((presc = find_resc_entry(pattr, prdef)) != NULL))
+    procs += presc->rs_value.at_val.at_long;
+
+  return(procs);
+  } /* END job_procs() */
 
-  // Prevent recounting a job  
-  if (pjob->ji_queue_counted & bit)
-    return(PBSE_NONE);
 
-  unsigned int  num_submitted = count_jobs_submitted(pjob);
-  std::string   uname(user_name);
-  
-  remove_server_suffix(uname);
 
-  uih->lock();
 
-  /* get the user if there is one */
-  if ((ui = uih->find(uname)) != NULL)
+/*
+ * apply_user_usage - add (sign 1) or take away (sign -1) a job's usage in
+ * its queue and on the server
+ *
+ * NOTE: usage_mutex must be held
+ */
+
+static void apply_user_usage(
+
+  const job_usage &ju,
+  int              sign)
+
+  {
+  std::map<std::string, user_usage> &per_queue = usage_table[ju.user];
+  const char                        *queues[] = { "", ju.queue.c_str() };
+
+  for (int i = 0; i < 2; i++)
     {
-    ui->num_jobs_queued += num_submitted;
+    user_usage &uu = per_queue[queues[i]];
+
+    uu.queued  += sign * ju.uu.queued;
+    uu.running += sign * ju.uu.running;
+    uu.procs   += sign * ju.uu.procs;
     }
-  else
+  } /* END apply_user_usage() */
+
+
+
+
+/*
+ * set_user_usage - make the usage table reflect pjob as it is now
+ *
+ * @param pjob - the job, locked
+ * @param add - count the job if it isn't counted already
+ */
+
+static void set_user_usage(
+
+  job  *pjob,
+  bool  add)
+
+  {
+  job_usage    ju;
+  std::string  jobid(pjob->ji_qs.ji_jobid);
+
+  /* array templates stand in for their sub-jobs, which are counted themselves */
+  if ((pjob->ji_is_array_template) ||
+      (pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str == NULL))
+    return;
+
+  ju.user = pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str;
+  remove_server_suffix(ju.user);
+  ju.queue = pjob->ji_qs.ji_queue;
+  ju.uu.queued = (pjob->ji_qs.ji_state != JOB_STATE_COMPLETE) ? 1 : 0;
+  ju.uu.running = (pjob->ji_qs.ji_state == JOB_STATE_RUNNING) ? 1 : 0;
+  ju.uu.procs = 0;
+
+  pthread_mutex_lock(&usage_mutex);
+
+  std::map<std::string, job_usage>::iterator it = usage_jobs.find(jobid);
+
+  if (it == usage_jobs.end())
     {
-    /* user doesn't exist, create a new one and insert */
-    ui = (user_info *)calloc(1, sizeof(user_info));
-    ui->user_name = strdup(uname.c_str());
-    ui->num_jobs_queued = num_submitted;
+    if (add == false)
+      {
+      pthread_mutex_unlock(&usage_mutex);
+      return;
+      }
+
+    it = usage_jobs.insert(std::make_pair(jobid, job_usage())).first;
+    it->second.uu.queued = 0;
+    it->second.uu.running = 0;
+    it->second.uu.procs = 0;
+    }
+  else if ((it->second.uu.running) &&
+           (ju.uu.running))
+    {
+    /* still running: its processors were counted when it started */
+    ju.uu.procs = it->second.uu.procs;
+    }
+
+  if ((ju.uu.running) &&
+      (it->second.uu.running == 0))
+    {
+    /* only look at the resources when the job starts running */
+    pthread_mutex_unlock(&usage_mutex);
+    ju.uu.procs = job_procs(pjob);
+    pthread_mutex_lock(&usage_mutex);
 
-    if (!uih->insert(ui,ui->user_name))
+    if ((it = usage_jobs.find(jobid)) == usage_jobs.end())
       {
-      rc = ENOMEM;
-      log_err(rc, __func__, "Can't resize the user info array");
+      pthread_mutex_unlock(&usage_mutex);
+      return;
       }
     }
 
-  uih->unlock();
+  if (it->second.user.size() != 0)
+    apply_user_usage(it->second, -1);
 
-  // Mark this job as being counted as queued
-  pjob->ji_queue_counted |= bit;
+  it->second = ju;
+  apply_user_usage(it->second, 1);
 
-  return(rc);
-  } /* END increment_queued_jobs() */
+  pthread_mutex_unlock(&usage_mutex);
+  } /* END set_user_usage() */
 
 
 
 
-int  decrement_queued_jobs(
+/*
+ * add_user_usage - count a job which has been enqueued
+ */
 
-  user_info_holder *uih,    
-  char             *user_name,
-  job              *pjob)
+void add_user_usage(
+
+  job *pjob)
 
   {
-  user_info *ui;
-  int        rc = THING_NOT_FOUND;
-  char       log_buf[LOCAL_LOG_BUF_SIZE];
-  std::string  uname(user_name);
-  
-  unsigned      bit = COUNTED_GLOBALLY;
+  set_user_usage(pjob, true);
+  } /* END add_user_usage() */
 
-  if (uih != &users)
-    bit = COUNTED_IN_QUEUE;
 
-  // Prevent re-decrementing the same job twice
-  if ((pjob->ji_queue_counted & bit) == 0)
-    return(PBSE_NONE);
-  
+
+
+/*
+ * update_user_usage - recount a job after its state changes.  Jobs which
+ * aren't counted yet are left alone.
+ */
+
+void update_user_usage(
+
+  job *pjob)
+
+  {
+  set_user_usage(pjob, false);
+  } /* END update_user_usage() */
+
+
+
+
+/*
+ * remove_user_usage - stop counting a job which has been dequeued
+ */
+
+void remove_user_usage(
+
+  job *pjob)
+
+  {
+  pthread_mutex_lock(&usage_mutex);
+
+  std::map<std::string, job_usage>::iterator it = usage_jobs.find(pjob->ji_qs.ji_jobid);
+
+  if (it != usage_jobs.end())
+    {
+    apply_user_usage(it->second, -1);
+    usage_jobs.erase(it);
+    }
+
+  pthread_mutex_unlock(&usage_mutex);
+  } /* END remove_user_usage() */
+
+
+
+
+/*
+ * get_user_usage - look up what a user's jobs add up to
+ *
+ * @param user_name - the user, with or without @server
+ * @param queue_name - the queue, or NULL for the whole server
+ * @param uu - RETURN: the usage, all 0 if the user has no jobs there
+ */
+
+void get_user_usage(
+
+  const char *user_name,
+  const char *queue_name,
+  user_usage &uu)
+
+  {
+  std::string uname(user_name);
+
   remove_server_suffix(uname);
 
-  uih->lock();
+  memset(&uu, 0, sizeof(uu));
+
+  pthread_mutex_lock(&usage_mutex);
+
+  std::map<std::string, std::map<std::string, user_usage> >::iterator it = usage_table.find(uname);
 
-  if ((ui = uih->find(uname)) != NULL)
+  if (it != usage_table.end())
     {
-    if (ui->num_jobs_queued == 0)
+    std::map<std::string, user_usage>::iterator qit = it->second.find((queue_name != NULL) ? queue_name : "");
+
+    if (qit != it->second.end())
+      uu = qit->second;
+    }
+
+  pthread_mutex_unlock(&usage_mutex);
+  } /* END get_user_usage() */
+
+
+
+
+/*
+ * format_user_usage - write out the usage table for the user_usage server
+ * attribute: user:queued/running/procs for the server and
+ * user@queue:queued/running/procs for each queue, leaving out users and
+ * queues with no jobs
+ */
+
+void format_user_usage(
+
+  std::string &out)
+
+  {
+  char buf[64];
+
+  out.clear();
+
+  pthread_mutex_lock(&usage_mutex);
+
+  std::map<std::string, std::map<std::string, user_usage> >::iterator it = usage_table.begin();
+
+  while (it != usage_table.end())
+    {
+    std::map<std::string, user_usage>::iterator qit = it->second.begin();
+
+    while (qit != it->second.end())
       {
+      user_usage &uu = qit->second;
 
-      if (LOGLEVEL >= 6)
+      if ((uu.queued == 0) &&
+          (uu.running == 0) &&
+          (uu.procs == 0))
         {
-        snprintf(log_buf, sizeof(log_buf), "decremented number of jobs queued when already at 0");
-        log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_JOB, __func__, log_buf);
+        it->second.erase(qit++);
+        continue;
         }
-      }
-    else
-      {
-      ui->num_jobs_queued--;
-      }
-    rc = PBSE_NONE;
-    }
 
-  uih->unlock();
+      if (out.size() != 0)
+        out += ",";
 
-  // Mark this job as no longer counted as queued
-  pjob->ji_queue_counted &= ~bit;
+      out += it->first;
+
+      if (qit->first.size() != 0)
+        {
+        out += "@";
+        out += qit->first;
+        }
 
-  return(rc);
-  } /* END decrement_queued_jobs() */
+      snprintf(buf, sizeof(buf), ":%d/%d/%ld", uu.queued, uu.running, uu.procs);
+      out += buf;
 
+      qit++;
+      }
 
+    if (it->second.empty())
+      usage_table.erase(it++);
+    else
+      it++;
+    }
 
+  pthread_mutex_unlock(&usage_mutex);
+  } /* END format_user_usage() */
@@ -11,6 +11,8 @@ START_TEST(test_PBSD_rdrpy)
   {
   fail_unless(PBSD_rdrpy(NULL, -1) == NULL);
   fail_unless(PBSD_rdrpy(NULL, PBS_NET_MAX_CONNECTIONS) == NULL);
+  fail_unless(PBSD_rdrpy_chan(NULL, -1, NULL) == NULL);
+  fail_unless(PBSD_rdrpy_chan(NULL, PBS_NET_MAX_CONNECTIONS, NULL) == NULL);
 
   }
 END_TEST
@@ -1,6 +1,7 @@
 #include "license_pbs.h" /* See here for the software license */
 #include <stdlib.h>
 #include <stdio.h> /* fprintf */
+#include <string.h> /* strdup */
 
 #include "libpbs.h" /* connect_handle, batch_reply */
 #include "u_hash_map_structs.h" /* job_data */
@@ -27,6 +28,10 @@ const char *dis_emsg[] =
 
 int flush_rc;
 int extend_rc;
+int submit_encoded;
+int submit_encoded_at_first_reply = -1;
+int replies_read;
+int reply_error_at = -1;
 
 
 ssize_t read_nonblocking_socket(int fd, void *buf, ssize_t count)
@@ -76,10 +81,51 @@ int encode_DIS_QueueJob_hash(struct tcp_chan *chan, char *jobid, char *destin, j
   return(0);
   }
 
+int encode_DIS_SubmitJob(struct tcp_chan *chan, char *destin, struct attropl *aoplp, char *script, int script_len)
+  {
+  return(0);
+  }
+
+int encode_DIS_SubmitJob_hash(struct tcp_chan *chan, char *destin, job_data_container *job_attr, job_data_container *res_attr, char *script, int script_len)
+  {
+  submit_encoded++;
+
+  return(0);
+  }
+
+struct batch_reply *PBSD_rdrpy_chan(int *local_errno, int c, struct tcp_chan *chan)
+  {
+  struct batch_reply *reply = (struct batch_reply *)calloc(1, sizeof(struct batch_reply));
+
+  if (submit_encoded_at_first_reply == -1)
+    submit_encoded_at_first_reply = submit_encoded;
+
+  if (replies_read == reply_error_at)
+    {
+    reply->brp_code = PBSE_BADATVAL;
+    reply->brp_choice = BATCH_REPLY_CHOICE_Text;
+    reply->brp_un.brp_txt.brp_str = strdup("bad value");
+    }
+  else
+    {
+    reply->brp_choice = BATCH_REPLY_CHOICE_Commit;
+    snprintf(reply->brp_un.brp_jid, sizeof(reply->brp_un.brp_jid), "%d.napali", replies_read);
+    }
+
+  replies_read++;
+
+  *local_errno = reply->brp_code;
+
+  return(reply);
+  }
+
 void PBSD_FreeReply(struct batch_reply *reply)
   {
-  fprintf(stderr, "The call to PBSD_FreeReply needs to be mocked!!\n");
-  exit(1);
+  if ((reply != NULL) &&
+      (reply->brp_choice == BATCH_REPLY_CHOICE_Text))
+    free(reply->brp_un.brp_txt.brp_str);
+
+  free(reply);
   }
 
 int encode_DIS_ReqExtend(struct tcp_chan *chan, char *extend)
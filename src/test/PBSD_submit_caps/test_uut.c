@@ -10,6 +10,9 @@
 int PBSD_scbuf(int c, int reqtype, int seq, char *buf, int len, char *jobid, enum job_file which);
 extern int flush_rc;
 extern int extend_rc;
+extern int submit_encoded;
+extern int submit_encoded_at_first_reply;
+extern int reply_error_at;
 extern struct connect_handle connection[];
 extern const char *dis_emsg[];
 
@@ -97,6 +100,93 @@ START_TEST(test_PBSD_QueueJob_hash)
 END_TEST
 
 
+START_TEST(test_PBSD_submitjob)
+  {
+  fail_unless(PBSD_submitjob(-1, NULL, NULL, NULL, NULL, 0, NULL) == NULL);
+  fail_unless(PBSD_submitjob(PBS_NET_MAX_CONNECTIONS, NULL, NULL, NULL, NULL, 0, NULL) == NULL);
+  }
+END_TEST
+
+
+START_TEST(test_PBSD_SubmitJob_hash)
+  {
+  char *jobid = NULL;
+  char *msg = NULL;
+
+  fail_unless(PBSD_SubmitJob_hash(-1, NULL, NULL, NULL, NULL, 0, NULL, &jobid, &msg) == PBSE_IVALREQ);
+  fail_unless(PBSD_SubmitJob_hash(PBS_NET_MAX_CONNECTIONS, NULL, NULL, NULL, NULL, 0, NULL, &jobid, &msg) == PBSE_IVALREQ);
+
+  initialize_connections();
+
+  // set to trigger a failure in encode_DIS_ReqExtend
+  extend_rc = 1;
+  connection[5].ch_errtxt = NULL;
+  fail_unless(PBSD_SubmitJob_hash(5, NULL, NULL, NULL, NULL, 0, NULL, &jobid, &msg) != PBSE_NONE);
+  fail_unless(!strcmp(msg, dis_emsg[extend_rc]), msg);
+  extend_rc = 0;
+  }
+END_TEST
+
+
+START_TEST(test_PBSD_read_script)
+  {
+  char *buf = (char *)"x";
+  int   len = 1;
+
+  fail_unless(PBSD_read_script(NULL, &buf, &len) == PBSE_NONE);
+  fail_unless((buf == NULL) && (len == 0));
+
+  fail_unless(PBSD_read_script((char *)"", &buf, &len) == PBSE_NONE);
+  fail_unless(buf == NULL);
+
+  fail_unless(PBSD_read_script((char *)"/no/such/job/script", &buf, &len) == PBSE_BADSCRIPT);
+  fail_unless(buf == NULL);
+  }
+END_TEST
+
+
+START_TEST(test_PBSD_submit_bulk)
+  {
+  struct pbs_bulk_job jobs[40];
+  char                jobid[PBS_MAXSVRJOBID + 1];
+
+  memset(jobs, 0, sizeof(jobs));
+
+  fail_unless(PBSD_submit_bulk(-1, jobs, 40, NULL) == PBSE_IVALREQ);
+  fail_unless(PBSD_submit_bulk(PBS_NET_MAX_CONNECTIONS, jobs, 40, NULL) == PBSE_IVALREQ);
+
+  initialize_connections();
+
+  flush_rc = 0;
+  submit_encoded = 0;
+
+  // one job's script cannot be read, another is rejected by the server
+  jobs[7].script = (char *)"/no/such/job/script";
+  reply_error_at = 3;
+
+  fail_unless(PBSD_submit_bulk(5, jobs, 40, NULL) == PBSE_NONE);
+
+  // the requests are pipelined: a full window goes out before a reply is read
+  fail_unless(submit_encoded_at_first_reply == 32, "%d", submit_encoded_at_first_reply);
+  fail_unless(submit_encoded == 39);
+
+  fail_unless(jobs[3].jobid == NULL);
+  fail_unless(jobs[3].errcode == PBSE_BADATVAL);
+  fail_unless(!strcmp(jobs[3].errmsg, "bad value"));
+
+  fail_unless(jobs[7].jobid == NULL);
+  fail_unless(jobs[7].errcode == PBSE_BADSCRIPT);
+
+  // replies are matched to jobs in order, skipping the job never sent
+  fail_unless(!strcmp(jobs[6].jobid, "6.napali"));
+  fail_unless(!strcmp(jobs[8].jobid, "7.napali"));
+  snprintf(jobid, sizeof(jobid), "%d.napali", 38);
+  fail_unless(!strcmp(jobs[39].jobid, jobid));
+  fail_unless(jobs[39].errcode == PBSE_NONE);
+  }
+END_TEST
+
+
 START_TEST(test_PBSD_jobfile)
   {
   enum job_file which = JScript;
@@ -131,6 +221,13 @@ Suite *PBSD_submit_caps_suite(void)
   tcase_add_test(tc_core, test_PBSD_rdytocmt);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_PBSD_submitjob");
+  tcase_add_test(tc_core, test_PBSD_submitjob);
+  tcase_add_test(tc_core, test_PBSD_SubmitJob_hash);
+  tcase_add_test(tc_core, test_PBSD_read_script);
+  tcase_add_test(tc_core, test_PBSD_submit_bulk);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
@@ -3,12 +3,16 @@
 #include "test_accounting.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <string>
 #include "pbs_error.h"
 #include "pbs_job.h"
+#include "acct.h"
 
 
 extern char *acct_file;
+extern pthread_mutex_t *acctfile_mutex;
 void add_procs_and_nodes_used(job &pjob, std::string &acct_data);
 const char *exec1 = "napali/0+napali/1+napali/2+napali/3+napali/4+napali/5";
 const char *exec2 = "2/0+2/1+2/2+2/3+3/0+3/1+3/2+3/3+4/0+4/1+4/2+4/3";
@@ -41,6 +45,76 @@ START_TEST(test_add_procs_and_nodes_used)
   }
 END_TEST
 
+int count_lines(const char *path)
+  {
+  FILE *fp = fopen(path, "r");
+  char  buf[1024];
+  int   count = 0;
+
+  if (fp == NULL)
+    return(0);
+
+  while (fgets(buf, sizeof(buf), fp) != NULL)
+    count++;
+
+  fclose(fp);
+
+  return(count);
+  }
+
+
+START_TEST(test_account_batch)
+  {
+  job pjob;
+
+  memset(&pjob, 0, sizeof(pjob));
+  strcpy(pjob.ji_qs.ji_jobid, "1.napali");
+
+  unlink("/tmp/acct_batch_ut");
+  acct_file = strdup("/tmp/acct_batch_ut");
+  acctfile_mutex = (pthread_mutex_t *)calloc(1, sizeof(pthread_mutex_t));
+  pthread_mutex_init(acctfile_mutex, NULL);
+
+  account_record(PBS_ACCT_QUEUE, &pjob, "queue=batch");
+  fail_unless(count_lines(acct_file) == 1);
+
+  /* held until the outermost end */
+  account_batch_begin();
+  account_record(PBS_ACCT_END, &pjob, "Exit_status=0");
+  account_batch_begin();
+  account_record(PBS_ACCT_END, &pjob, NULL);
+  account_batch_end();
+  fail_unless(count_lines(acct_file) == 1);
+  account_batch_end();
+  fail_unless(count_lines(acct_file) == 3);
+
+  account_batch_end();
+  account_record(PBS_ACCT_DEL, &pjob, "requestor=dbeer");
+  fail_unless(count_lines(acct_file) == 4);
+
+  /* records handed over are written when the taker says */
+  std::string records;
+
+  account_batch_begin();
+  account_record(PBS_ACCT_END, &pjob, "Exit_status=0");
+  account_batch_detach(records);
+  fail_unless(count_lines(acct_file) == 4);
+  fail_unless(records.find("1.napali;Exit_status=0") != std::string::npos);
+
+  account_record(PBS_ACCT_DEL, &pjob, "requestor=dbeer");
+  fail_unless(count_lines(acct_file) == 5);
+
+  account_batch_write(records);
+  fail_unless(count_lines(acct_file) == 6);
+
+  acct_close(false);
+  unlink("/tmp/acct_batch_ut");
+  }
+END_TEST
+
+
+
+
 START_TEST(test_two)
   {
 
@@ -55,6 +129,10 @@ Suite *accounting_suite(void)
   tcase_add_test(tc_core, test_add_procs_and_nodes_used);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_account_batch");
+  tcase_add_test(tc_core, test_account_batch);
+  suite_add_tcase(s, tc_core);
+
   tc_core = tcase_create("test_two");
   tcase_add_test(tc_core, test_two);
   suite_add_tcase(s, tc_core);
@@ -7,6 +7,8 @@
 
 #include "pbs_error.h"
 
+struct resource_index *get_resc_index(pbs_attribute *pattr);
+
 START_TEST(test_one)
   {
   pbs_attribute attr;
@@ -35,6 +37,147 @@ START_TEST(test_two)
   }
 END_TEST
 
+START_TEST(test_indexed_find_resc_def)
+  {
+  resource_def  defs[4];
+  resource_def *new_defs;
+
+  memset(defs, 0, sizeof(defs));
+
+  defs[0].rs_name = "nodes";
+  defs[1].rs_name = "mem";
+  defs[2].rs_name = "walltime";
+  defs[3].rs_name = "|unknown|";
+
+  fail_unless(index_resc_defs(defs, 4, NULL) == PBSE_NONE);
+
+  fail_unless(find_resc_def(defs, "mem", 4) == defs + 1);
+  fail_unless(find_resc_def(defs, "walltime", 4) == defs + 2);
+  fail_unless(find_resc_def(defs, "walltime", 2) == NULL);
+  fail_unless(find_resc_def(defs, "MEM", 4) == NULL);
+  fail_unless(find_resc_def(defs, "vmem", 4) == NULL);
+
+  /* a rebuilt array takes over the old one's index */
+  new_defs = (resource_def *)calloc(5, sizeof(resource_def));
+  memcpy(new_defs, defs, 3 * sizeof(resource_def));
+  new_defs[3].rs_name = "gres";
+  new_defs[4].rs_name = "|unknown|";
+
+  fail_unless(index_resc_defs(new_defs, 5, defs) == PBSE_NONE);
+
+  fail_unless(find_resc_def(new_defs, "gres", 5) == new_defs + 3);
+  fail_unless(find_resc_def(new_defs, "nodes", 5) == new_defs);
+  fail_unless(find_resc_def(defs, "walltime", 4) == defs + 2);
+
+  free(new_defs);
+  }
+END_TEST
+
+START_TEST(test_resc_index)
+  {
+  const char    *names[] = { "cput", "mem", "nodes", "vmem", "walltime", "|unknown|" };
+  resource_def   defs[6];
+  resource_def   vmem_copy;
+  resource_def  *saved_defs = svr_resc_def;
+  int            saved_size = svr_resc_size;
+  pbs_attribute  attr;
+  pbs_attribute  moved;
+  pbs_attribute  copy;
+  resource_def   new_defs[6];
+  resource      *pr;
+
+  for (int i = 0; i < 6; i++)
+    {
+    memcpy(defs + i, svr_resc_def_const, sizeof(resource_def));
+    defs[i].rs_name = names[i];
+    }
+
+  memcpy(new_defs, defs, sizeof(defs));
+
+  svr_resc_def = defs;
+  svr_resc_size = 6;
+
+  memset(&attr, 0, sizeof(attr));
+  memset(&moved, 0, sizeof(moved));
+  CLEAR_HEAD(attr.at_val.at_list);
+  CLEAR_HEAD(moved.at_val.at_list);
+
+  fail_unless(add_resource_entry(&attr, defs + 4) != NULL);
+  fail_unless(add_resource_entry(&attr, defs + 2) != NULL);
+  fail_unless(add_resource_entry(&attr, defs + 0) != NULL);
+  fail_unless(find_resc_entry(&attr, defs + 2)->rs_defin == defs + 2);
+  /* too short to index */
+  fail_unless(get_resc_index(&attr) == NULL);
+  fail_unless(add_resource_entry(&attr, defs + 3) != NULL);
+  /* indexes are built by the first search */
+  fail_unless(get_resc_index(&attr) == NULL);
+  fail_unless(find_resc_entry(&attr, defs + 2)->rs_defin == defs + 2);
+  fail_unless(get_resc_index(&attr) != NULL);
+  fail_unless(attr.at_rindex == get_resc_index(&attr));
+
+  /* the list is still sorted */
+  pr = (resource *)GET_NEXT(attr.at_val.at_list);
+  fail_unless(pr->rs_defin == defs + 0);
+
+  fail_unless(find_resc_entry(&attr, defs + 1) == NULL);
+  fail_unless(add_resource_entry(&attr, defs + 2) == find_resc_entry(&attr, defs + 2));
+
+  /* definitions are matched by name */
+  memcpy(&vmem_copy, defs + 3, sizeof(resource_def));
+  fail_unless(find_resc_entry(&attr, &vmem_copy)->rs_defin == defs + 3);
+
+  /* the index follows entries that are taken out and added */
+  pr = find_resc_entry(&attr, defs + 4);
+  unlink_resc_entry(&attr, pr);
+  free(pr);
+  fail_unless(get_resc_index(&attr) != NULL);
+  fail_unless(find_resc_entry(&attr, defs + 4) == NULL);
+  fail_unless(find_resc_entry(&attr, defs + 3) != NULL);
+
+  fail_unless(add_resource_entry(&attr, defs + 1) != NULL);
+  fail_unless(find_resc_entry(&attr, defs + 1)->rs_defin == defs + 1);
+
+  /* a copy of the pbs_attribute doesn't use or free the original's index */
+  memcpy(&copy, &attr, sizeof(attr));
+  fail_unless(get_resc_index(&copy) == NULL);
+  CLEAR_HEAD(copy.at_val.at_list);
+  free_resc(&copy);
+  fail_unless(copy.at_rindex == NULL);
+  fail_unless(get_resc_index(&attr) != NULL);
+
+  move_resc_list(&attr, &moved);
+  fail_unless(get_resc_index(&attr) == NULL);
+  fail_unless(GET_NEXT(attr.at_val.at_list) == NULL);
+  fail_unless(find_resc_entry(&attr, defs + 1) == NULL);
+  fail_unless(get_resc_index(&moved) != NULL);
+  fail_unless(find_resc_entry(&moved, defs + 1)->rs_defin == defs + 1);
+
+  free_resc(&moved);
+  fail_unless(moved.at_rindex == NULL);
+
+  /* an index built for another svr_resc_def is dropped */
+  fail_unless(add_resource_entry(&attr, defs + 0) != NULL);
+  fail_unless(add_resource_entry(&attr, defs + 1) != NULL);
+  fail_unless(add_resource_entry(&attr, defs + 2) != NULL);
+  fail_unless(add_resource_entry(&attr, defs + 3) != NULL);
+  fail_unless(find_resc_entry(&attr, defs + 3) != NULL);
+  fail_unless(get_resc_index(&attr) != NULL);
+
+  svr_resc_def = new_defs;
+  fail_unless(get_resc_index(&attr) == NULL);
+  fail_unless(attr.at_rindex == NULL);
+  fail_unless(find_resc_entry(&attr, new_defs + 2)->rs_defin == defs + 2);
+  fail_unless(get_resc_index(&attr) != NULL);
+  svr_resc_def = defs;
+
+  free_resc(&attr);
+  fail_unless(attr.at_rindex == NULL);
+
+  svr_resc_def = saved_defs;
+  svr_resc_size = saved_size;
+  }
+END_TEST
+
 Suite *attr_fn_resc_suite(void)
   {
   Suite *s = suite_create("attr_fn_resc_suite methods");
@@ -46,6 +189,14 @@ Suite *attr_fn_resc_suite(void)
   tcase_add_test(tc_core, test_two);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_indexed_find_resc_def");
+  tcase_add_test(tc_core, test_indexed_find_resc_def);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_resc_index");
+  tcase_add_test(tc_core, test_resc_index);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
@@ -113,6 +113,36 @@ START_TEST(test_three)
   }
 END_TEST
 
+START_TEST(test_indexed_find_attr)
+  {
+  attribute_def defs[5];
+
+  memset(defs, 0, sizeof(defs));
+
+  defs[0].at_name = "Job_Name";
+  defs[1].at_name = "Job_Owner";
+  defs[2].at_name = "job_name";
+  defs[3].at_name = "queue";
+  defs[4].at_name = "server";
+
+  /* only the first four are indexed, server has to be scanned for */
+  fail_unless(index_attr_defs(defs, 4) == PBSE_NONE);
+  fail_unless(index_attr_defs(defs, 0) == -1);
+
+  fail_unless(find_attr(defs, "JOB_NAME", 5) == 0);
+  fail_unless(find_attr(defs, "job_owner", 5) == 1);
+  fail_unless(find_attr(defs, "Queue", 5) == 3);
+  fail_unless(find_attr(defs, "server", 5) == 4);
+  fail_unless(find_attr(defs, "server", 4) == -1);
+  fail_unless(find_attr(defs, "queue", 3) == -1);
+  fail_unless(find_attr(defs, "Job_Nam", 5) == -1);
+  fail_unless(find_attr(defs, "", 5) == -1);
+
+  /* arrays without an index are still searched */
+  fail_unless(find_attr(defs + 1, "queue", 4) == 2);
+  }
+END_TEST
+
 
 Suite *attr_func_suite(void)
   {
@@ -129,6 +159,10 @@ Suite *attr_func_suite(void)
   tcase_add_test(tc_core, test_three);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_indexed_find_attr");
+  tcase_add_test(tc_core, test_indexed_find_attr);
+  suite_add_tcase(s, tc_core);
+
 
   return s;
   }
@@ -62,6 +62,12 @@ int decode_DIS_QueueJob(struct tcp_chan *chan, struct batch_request *preq)
   exit(1);
   }
 
+int decode_DIS_SubmitJob(struct tcp_chan *chan, struct batch_request *preq)
+  {
+  fprintf(stderr, "The call to decode_DIS_SubmitJob needs to be mocked!!\n");
+  exit(1);
+  }
+
 int decode_DIS_SignalJob(struct tcp_chan *chan, struct batch_request *preq)
   {
   fprintf(stderr, "The call to decode_DIS_SignalJob needs to be mocked!!\n");
@@ -35,3 +35,9 @@ int diswsi(tcp_chan *chan, int value)
  exit(1);
  }
 
+
+int encode_DIS_svrattrl_cached(tcp_chan *chan, struct brp_encoded *penc, svrattrl *psattl)
+ {
+ fprintf(stderr, "The call to encode_DIS_svrattrl_cached needs to be mocked!!\n");
+ exit(1);
+ }
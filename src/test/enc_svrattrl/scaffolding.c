@@ -21,3 +21,15 @@ int diswui(tcp_chan *chan, unsigned value)
  fprintf(stderr, "The call to log_event needs to be mocked!!\n");
  exit(1);
  }
+
+int tcp_puts(struct tcp_chan *chan, const char *str, size_t ct)
+ {
+ fprintf(stderr, "The call to tcp_puts needs to be mocked!!\n");
+ exit(1);
+ }
+
+int tcp_wcommit(struct tcp_chan *chan, int commit_flag)
+ {
+ fprintf(stderr, "The call to tcp_wcommit needs to be mocked!!\n");
+ exit(1);
+ }
@@ -74,3 +74,7 @@ const char *id_map::get_name(int id)
   {
   return(NULL);
   }
+
+void job_index_add(job *pjob) {}
+
+void job_index_remove(job *pjob) {}
@@ -258,6 +258,133 @@ START_TEST(find_job_by_array_with_removed_record_test)
   }
 END_TEST
 
+START_TEST(job_registry_test)
+  {
+  extern all_jobs alljobs;
+  struct job *test_job = job_alloc();
+  struct job *found;
+
+  strcpy(test_job->ji_qs.ji_jobid, "10.napali");
+
+  fail_unless(job_registry_has("10.napali") == false);
+  fail_unless(find_job_in_registry("10.napali", FALSE) == NULL);
+
+  // only alljobs' jobs are registered
+  all_jobs other;
+  fail_unless(insert_job(&other, test_job) == PBSE_NONE);
+  fail_unless(job_registry_has("10.napali") == false);
+
+  fail_unless(insert_job(&alljobs, test_job) == PBSE_NONE);
+  fail_unless(job_registry_has("10.napali") == true);
+  found = find_job_in_registry("10.napali", FALSE);
+  fail_unless(found == test_job);
+  fail_unless(svr_find_job("10.napali", FALSE) == test_job);
+
+  // ids come back in the container's order
+  std::vector<std::string> ids;
+  struct job *first = job_alloc();
+  strcpy(first->ji_qs.ji_jobid, "9.napali");
+  fail_unless(insert_job_first(&other, first) == PBSE_NONE);
+  get_job_ids(&other, ids);
+  fail_unless(ids.size() == 2);
+  fail_unless(ids[0] == "9.napali");
+  fail_unless(ids[1] == "10.napali");
+
+  // a job recycled after it was found in the registry isn't returned
+  strcpy(test_job->ji_qs.ji_jobid, "0000000001234567");
+  fail_unless(find_job_in_registry("10.napali", FALSE) == NULL);
+  strcpy(test_job->ji_qs.ji_jobid, "10.napali");
+
+  fail_unless(remove_job(&alljobs, test_job) == PBSE_NONE);
+  fail_unless(job_registry_has("10.napali") == false);
+  fail_unless(find_job_in_registry("10.napali", FALSE) == NULL);
+  }
+END_TEST
+
+START_TEST(job_epoch_test)
+  {
+  unsigned long long retired;
+
+  // nobody is looking
+  retired = job_epoch_retire();
+  fail_unless(job_epoch_passed(retired) == true);
+
+  // a lookup started before the job was retired holds it
+  job_epoch_enter();
+  retired = job_epoch_retire();
+  fail_unless(job_epoch_passed(retired) == false);
+
+  // nested calls keep the outer lookup's epoch
+  job_epoch_enter();
+  job_epoch_exit();
+  fail_unless(job_epoch_passed(retired) == false);
+
+  job_epoch_exit();
+  fail_unless(job_epoch_passed(retired) == true);
+
+  // a lookup started after it doesn't
+  job_epoch_enter();
+  fail_unless(job_epoch_passed(retired) == true);
+  job_epoch_exit();
+  }
+END_TEST
+
+START_TEST(insert_by_rank_test)
+  {
+  all_jobs            alljobs;
+  all_jobs_iterator  *iter;
+  job                *pjob;
+  const char         *ids[] = { "3.napali", "1.napali", "4.napali", "2.napali", "5.napali" };
+  long                ranks[] = { 30, 10, 40, 20, 20 };
+  const char         *order[] = { "1.napali", "2.napali", "5.napali", "3.napali", "4.napali" };
+  job                *jobs[5];
+  int                 i;
+
+  alljobs.lock();
+
+  for (i = 0; i < 5; i++)
+    {
+    jobs[i] = job_alloc();
+    strcpy(jobs[i]->ji_qs.ji_jobid, ids[i]);
+    fail_unless(alljobs.insert_by_rank(jobs[i], ids[i], ranks[i]) == true);
+    }
+
+  /* no duplicates */
+  fail_unless(alljobs.insert_by_rank(jobs[0], ids[0], 1) == false);
+
+  /* equal ranks keep the order they were inserted in */
+  iter = alljobs.get_iterator();
+  for (i = 0; (pjob = iter->get_next_item()) != NULL; i++)
+    fail_unless(!strcmp(pjob->ji_qs.ji_jobid, order[i]), "%d: %s", i, pjob->ji_qs.ji_jobid);
+  fail_unless(i == 5);
+  delete iter;
+
+  /* removed jobs leave the index, and swapped jobs trade ranks */
+  alljobs.remove("1.napali");
+  alljobs.swap("2.napali", "4.napali");
+
+  pjob = job_alloc();
+  strcpy(pjob->ji_qs.ji_jobid, "6.napali");
+  fail_unless(alljobs.insert_by_rank(pjob, "6.napali", 25) == true);
+
+  const char *after[] = { "4.napali", "5.napali", "6.napali", "3.napali", "2.napali" };
+  iter = alljobs.get_iterator();
+  for (i = 0; (pjob = iter->get_next_item()) != NULL; i++)
+    fail_unless(!strcmp(pjob->ji_qs.ji_jobid, after[i]), "%d: %s", i, pjob->ji_qs.ji_jobid);
+  fail_unless(i == 5);
+  delete iter;
+
+  pjob = job_alloc();
+  strcpy(pjob->ji_qs.ji_jobid, "7.napali");
+  fail_unless(alljobs.insert_by_rank(pjob, "7.napali", 1) == true);
+  iter = alljobs.get_iterator();
+  fail_unless(!strcmp(iter->get_next_item()->ji_qs.ji_jobid, "7.napali"));
+  delete iter;
+
+  alljobs.unlock();
+  }
+END_TEST
+
 Suite *job_container_suite(void)
   {
   Suite *s = suite_create("job_container test suite methods");
@@ -265,6 +392,11 @@ Suite *job_container_suite(void)
   tcase_add_test(tc_core, swap_jobs_test);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("job_registry_test");
+  tcase_add_test(tc_core, job_registry_test);
+  tcase_add_test(tc_core, job_epoch_test);
+  suite_add_tcase(s, tc_core);
+
   tc_core = tcase_create("insert_job_test");
   tcase_add_test(tc_core, insert_job_test);
   suite_add_tcase(s, tc_core);
@@ -293,6 +425,10 @@ Suite *job_container_suite(void)
   tcase_add_test(tc_core, next_job_test);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("insert_by_rank_test");
+  tcase_add_test(tc_core, insert_by_rank_test);
+  suite_add_tcase(s, tc_core);
+
   tc_core = tcase_create("find_job_by_array_with_removed_record");
   tcase_add_test(tc_core, find_job_by_array_with_removed_record_test);
   suite_add_tcase(s, tc_core);
@@ -0,0 +1,14 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "pbs_job.h"
+
+int LOGLEVEL = 7; /* force logging code to be exercised as tests run */
+
+int job_status_cache_free_count = 0;
+
+void job_status_cache_free(job *pjob)
+  {
+  job_status_cache_free_count++;
+  }
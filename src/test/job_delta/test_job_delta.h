@@ -0,0 +1,9 @@
+#include "license_pbs.h" /* See here for the software license */
+#ifndef _JOB_DELTA_CT_H
+#define _JOB_DELTA_CT_H
+#include <check.h>
+
+#define JOB_DELTA_SUITE 1
+Suite *job_delta_suite();
+
+#endif /* _JOB_DELTA_CT_H */
@@ -0,0 +1,132 @@
+#include "license_pbs.h" /* See here for the software license */
+#include "job_delta.h"
+#include "test_job_delta.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "pbs_error.h"
+#include "pbs_ifl.h"
+#include "pbs_job.h"
+
+extern int job_status_cache_free_count;
+
+
+START_TEST(test_touch_and_purge)
+  {
+  job                            pjob;
+  unsigned long long             start = job_delta_get_seq();
+  unsigned long long             mid;
+  std::vector<job_delta_purged>  purged;
+
+  memset(&pjob, 0, sizeof(pjob));
+
+  job_delta_touch(&pjob);
+  fail_unless(pjob.ji_delta_seq == start + 1);
+  fail_unless(job_status_cache_free_count == 1);
+
+  job_delta_note_purged("1.napali", "dbeer@napali");
+  mid = job_delta_get_seq();
+  job_delta_note_purged("2.napali", NULL);
+
+  fail_unless(job_delta_get_seq() == start + 3);
+
+  /* only purges after since come back, oldest first */
+  fail_unless(job_delta_get_purged(start, purged) == true);
+  fail_unless(purged.size() == 2);
+  fail_unless(purged[0].jobid == "1.napali");
+  fail_unless(purged[0].owner == "dbeer@napali");
+  fail_unless(purged[1].jobid == "2.napali");
+  fail_unless(purged[1].owner.size() == 0);
+
+  purged.clear();
+  fail_unless(job_delta_get_purged(mid, purged) == true);
+  fail_unless(purged.size() == 1);
+  fail_unless(purged[0].jobid == "2.napali");
+
+  purged.clear();
+  fail_unless(job_delta_get_purged(job_delta_get_seq(), purged) == true);
+  fail_unless(purged.size() == 0);
+
+  /* a sequence from before the server started can't be answered */
+  fail_unless(job_delta_get_purged(start - 1, purged) == false);
+  fail_unless(job_delta_get_purged(0, purged) == false);
+  }
+END_TEST
+
+
+START_TEST(test_forgotten_purges)
+  {
+  unsigned long long             start = job_delta_get_seq();
+  std::vector<job_delta_purged>  purged;
+  char                           jobid[32];
+
+  for (int i = 0; i <= JOB_DELTA_MAX_PURGED; i++)
+    {
+    snprintf(jobid, sizeof(jobid), "%d.napali", i);
+    job_delta_note_purged(jobid, NULL);
+    }
+
+  /* the oldest purge was dropped, so clients from before it get everything */
+  fail_unless(job_delta_get_purged(start, purged) == false);
+  fail_unless(purged.size() == 0);
+
+  fail_unless(job_delta_get_purged(start + 1, purged) == true);
+  fail_unless(purged.size() == JOB_DELTA_MAX_PURGED);
+  fail_unless(purged[0].jobid == "1.napali");
+  }
+END_TEST
+
+
+START_TEST(test_parse_extend)
+  {
+  unsigned long long since = 7;
+
+  fail_unless(job_delta_parse_extend(NULL, &since) == false);
+  fail_unless(job_delta_parse_extend(EXECQUEONLY, &since) == false);
+  fail_unless(since == 7);
+
+  fail_unless(job_delta_parse_extend(DELTASTATUS "12345", &since) == true);
+  fail_unless(since == 12345);
+
+  fail_unless(job_delta_parse_extend(EXECQUEONLY DELTASTATUS "99", &since) == true);
+  fail_unless(since == 99);
+
+  fail_unless(job_delta_parse_extend(DELTASTATUS, &since) == true);
+  fail_unless(since == 0);
+  }
+END_TEST
+
+
+Suite *job_delta_suite(void)
+  {
+  Suite *s = suite_create("job_delta_suite methods");
+  TCase *tc_core = tcase_create("test_touch_and_purge");
+  tcase_add_test(tc_core, test_touch_and_purge);
+  tcase_add_test(tc_core, test_forgotten_purges);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_parse_extend");
+  tcase_add_test(tc_core, test_parse_extend);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(job_delta_suite());
+  srunner_set_log(sr, "job_delta_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return number_failed;
+  }
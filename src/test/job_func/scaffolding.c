@@ -47,7 +47,6 @@ pthread_mutex_t job_log_mutex = PTHREAD_MUTEX_INITIALIZER;
 completed_jobs_map_class completed_jobs_map;
 sem_t *job_clone_semaphore;
 
-user_info_holder users;
 extern bool add_job_called;
 
 void log_err(int errnum, const char *routine, const char *text) {}
@@ -404,11 +403,6 @@ int lock_ji_mutex(job *pjob, const char *id, const char *msg, int logging)
   return(0);
   }
 
-int  decrement_queued_jobs(user_info_holder *uih, char *user_name)
-  {
-  return(0);
-  }
-
 int set_str(
     
   pbs_attribute *attr,
@@ -625,3 +619,14 @@ bool completed_jobs_map_class::add_job(char const* s, time_t t)
 std::string get_path_jobdata(const char *a, const char *b) {return ""; }
 
 void add_to_completed_jobs(work_task *ptask) {}
+
+void job_delta_touch(job *pjob) {}
+void job_delta_note_purged(const char *jobid, const char *owner) {}
+
+void job_status_cache_free(job *pjob) {}
+void job_index_remove(job *pjob) {}
+
+bool job_registry_has(const char *job_id)
+  {
+  return(false);
+  }
@@ -0,0 +1,43 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "pbs_job.h" /* all_jobs, job */
+#include "work_task.h" /* work_task, work_type */
+
+int LOGLEVEL = 7; /* force logging code to be exercised as tests run */
+all_jobs alljobs;
+int tasks_set = 0;
+int jobs_saved = 0;
+bool exit_called = false;
+
+void log_err(int errnum, const char *routine, const char *text) {}
+void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
+
+ssize_t write_ac_socket(int fd, const void *buf, ssize_t count)
+  {
+  return(write(fd, buf, count));
+  }
+
+struct work_task *set_task(enum work_type type, long event_id, void (*func)(struct work_task *), void *parm, int get_lock)
+  {
+  tasks_set++;
+  return(NULL);
+  }
+
+job *next_job(all_jobs *aj, all_jobs_iterator *iter)
+  {
+  return(NULL);
+  }
+
+int unlock_ji_mutex(job *pjob, const char *id, const char *msg, int logging)
+  {
+  return(0);
+  }
+
+int job_save(job *pjob, int updatetype, int mom_port)
+  {
+  jobs_saved++;
+  return(0);
+  }
@@ -0,0 +1,9 @@
+#include "license_pbs.h" /* See here for the software license */
+#ifndef _JOB_JOURNAL_CT_H
+#define _JOB_JOURNAL_CT_H
+#include <check.h>
+
+#define JOB_JOURNAL_SUITE 1
+Suite *job_journal_suite();
+
+#endif /* _JOB_JOURNAL_CT_H */
@@ -0,0 +1,293 @@
+#include "license_pbs.h" /* See here for the software license */
+#include "job_journal.h"
+#include "test_job_journal.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "pbs_error.h"
+#include "pbs_job.h"
+
+extern int tasks_set;
+
+char journal_dir[] = "./journal_test/";
+
+
+void remove_journal()
+  {
+  std::string path(journal_dir);
+
+  unlink((path + JOB_JOURNAL_FILE).c_str());
+  unlink((path + JOB_JOURNAL_OLD_FILE).c_str());
+  rmdir(journal_dir);
+  }
+
+
+START_TEST(test_append_and_load)
+  {
+  std::vector<std::string> records;
+  unsigned long long       first_seq;
+  int                      gen = 0;
+
+  remove_journal();
+  mkdir(journal_dir, 0700);
+
+  // nothing on disk yet
+  fail_unless(job_journal_load(journal_dir) == PBSE_NONE);
+  job_journal_get_records("1.napali", 0, records);
+  fail_unless(records.size() == 0);
+
+  // appends fail until the journal is open
+  fail_unless(job_journal_is_open() == false);
+  fail_unless(job_journal_append("1.napali", "a", 1, &gen) == -1);
+
+  fail_unless(job_journal_open(journal_dir) == PBSE_NONE);
+  fail_unless(job_journal_is_open() == true);
+
+  first_seq = job_journal_get_seq();
+  fail_unless(job_journal_append("1.napali", "<one/>", 6, &gen) == PBSE_NONE);
+  fail_unless(gen > 0);
+  fail_unless(job_journal_append("2.napali", "<two/>", 6, &gen) == PBSE_NONE);
+  fail_unless(job_journal_append("1.napali", "<three/>", 8, &gen) == PBSE_NONE);
+  fail_unless(job_journal_get_seq() == first_seq + 3);
+
+  job_journal_close();
+  fail_unless(job_journal_is_open() == false);
+
+  fail_unless(job_journal_load(journal_dir) == PBSE_NONE);
+
+  job_journal_get_records("1.napali", 0, records);
+  fail_unless(records.size() == 2);
+  fail_unless(records[0] == "<one/>");
+  fail_unless(records[1] == "<three/>");
+
+  // only records newer than the job file are replayed
+  job_journal_get_records("1.napali", first_seq + 1, records);
+  fail_unless(records.size() == 1);
+  fail_unless(records[0] == "<three/>");
+
+  job_journal_get_records("2.napali", 0, records);
+  fail_unless(records.size() == 1);
+  fail_unless(records[0] == "<two/>");
+
+  job_journal_get_records("3.napali", 0, records);
+  fail_unless(records.size() == 0);
+
+  // sequences already used by a job file are never handed out again
+  job_journal_note_seq(first_seq + 100);
+  fail_unless(job_journal_get_seq() == first_seq + 100);
+  job_journal_note_seq(first_seq);
+  fail_unless(job_journal_get_seq() == first_seq + 100);
+
+  remove_journal();
+  }
+END_TEST
+
+
+off_t journal_size()
+  {
+  std::string path(journal_dir);
+  struct stat sb;
+
+  if (stat((path + JOB_JOURNAL_FILE).c_str(), &sb) != 0)
+    return(-1);
+
+  return(sb.st_size);
+  }
+
+
+START_TEST(test_batch)
+  {
+  std::vector<std::string> records;
+  off_t                    size;
+  int                      gen = 0;
+
+  remove_journal();
+  mkdir(journal_dir, 0700);
+
+  fail_unless(job_journal_open(journal_dir) == PBSE_NONE);
+  size = journal_size();
+
+  // nothing was appended
+  job_journal_begin_batch();
+  fail_unless(job_journal_end_batch() == PBSE_NONE);
+
+  // batched records are only queued until the batch ends
+  job_journal_begin_batch();
+  fail_unless(job_journal_append("1.napali", "<one/>", 6, &gen) == PBSE_NONE);
+  fail_unless(job_journal_append("2.napali", "<two/>", 6, &gen) == PBSE_NONE);
+  fail_unless(journal_size() == size);
+  fail_unless(job_journal_end_batch() == PBSE_NONE);
+  fail_unless(journal_size() > size);
+
+  // a detached batch is waited for by whoever takes its sequence
+  unsigned long long seq;
+
+  size = journal_size();
+  job_journal_begin_batch();
+  fail_unless(job_journal_append("2.napali", "<four/>", 7, &gen) == PBSE_NONE);
+  seq = job_journal_detach_batch();
+  fail_unless(seq != 0);
+  fail_unless(journal_size() == size);
+  fail_unless(job_journal_wait(seq) == PBSE_NONE);
+  fail_unless(journal_size() > size);
+  fail_unless(job_journal_wait(0) == PBSE_NONE);
+
+  // unbatched appends are written right away again
+  size = journal_size();
+  fail_unless(job_journal_append("1.napali", "<three/>", 8, &gen) == PBSE_NONE);
+  fail_unless(journal_size() > size);
+
+  job_journal_close();
+
+  fail_unless(job_journal_load(journal_dir) == PBSE_NONE);
+  job_journal_get_records("1.napali", 0, records);
+  fail_unless(records.size() == 2);
+  job_journal_get_records("2.napali", 0, records);
+  fail_unless(records.size() == 2);
+
+  remove_journal();
+  }
+END_TEST
+
+
+START_TEST(test_truncated_record)
+  {
+  std::vector<std::string> records;
+  std::string              path(journal_dir);
+  FILE                    *fp;
+  int                      gen = 0;
+
+  remove_journal();
+  mkdir(journal_dir, 0700);
+
+  fail_unless(job_journal_open(journal_dir) == PBSE_NONE);
+  fail_unless(job_journal_append("1.napali", "<one/>", 6, &gen) == PBSE_NONE);
+  job_journal_close();
+
+  // simulate a crash part way through appending the next record
+  path += JOB_JOURNAL_FILE;
+  fail_unless((fp = fopen(path.c_str(), "a")) != NULL);
+  fprintf(fp, "R %llu 1.napali 20\n<partial", job_journal_get_seq() + 1);
+  fclose(fp);
+
+  fail_unless(job_journal_load(journal_dir) == PBSE_NONE);
+  job_journal_get_records("1.napali", 0, records);
+  fail_unless(records.size() == 1);
+  fail_unless(records[0] == "<one/>");
+
+  // opening the journal again starts a new, empty one
+  fail_unless(job_journal_open(journal_dir) == PBSE_NONE);
+  job_journal_close();
+  fail_unless(job_journal_load(journal_dir) == PBSE_NONE);
+  job_journal_get_records("1.napali", 0, records);
+  fail_unless(records.size() == 0);
+
+  remove_journal();
+  }
+END_TEST
+
+
+START_TEST(test_bad_header)
+  {
+  std::vector<std::string> records;
+  std::string              path(journal_dir);
+  FILE                    *fp;
+
+  remove_journal();
+  mkdir(journal_dir, 0700);
+
+  path += JOB_JOURNAL_FILE;
+  fail_unless((fp = fopen(path.c_str(), "w")) != NULL);
+  fprintf(fp, "NOT_A_JOURNAL\nR 1 1.napali 6\n<one/>\n");
+  fclose(fp);
+
+  job_journal_load(journal_dir);
+  job_journal_get_records("1.napali", 0, records);
+  fail_unless(records.size() == 0);
+
+  remove_journal();
+  }
+END_TEST
+
+
+START_TEST(test_compact_nothing_rotated)
+  {
+  tasks_set = 0;
+
+  // no generation waiting to be compacted
+  job_journal_compact(NULL);
+  fail_unless(tasks_set == 0);
+  }
+END_TEST
+
+
+START_TEST(test_replay_save_failed)
+  {
+  std::vector<std::string> records;
+  int                      gen = 0;
+
+  remove_journal();
+  mkdir(journal_dir, 0700);
+
+  fail_unless(job_journal_open(journal_dir) == PBSE_NONE);
+  fail_unless(job_journal_append("1.napali", "<one/>", 6, &gen) == PBSE_NONE);
+  job_journal_close();
+
+  // a job whose records were replayed couldn't be saved: keep the journal
+  fail_unless(job_journal_load(journal_dir) == PBSE_NONE);
+  job_journal_note_replay_failed();
+  fail_unless(job_journal_open(journal_dir) == -1);
+  fail_unless(job_journal_is_open() == false);
+
+  fail_unless(job_journal_load(journal_dir) == PBSE_NONE);
+  job_journal_get_records("1.napali", 0, records);
+  fail_unless(records.size() == 1);
+
+  remove_journal();
+  }
+END_TEST
+
+
+Suite *job_journal_suite(void)
+  {
+  Suite *s = suite_create("job_journal_suite methods");
+
+  TCase *tc_core = tcase_create("test_append_and_load");
+  tcase_add_test(tc_core, test_append_and_load);
+  tcase_add_test(tc_core, test_truncated_record);
+  tcase_add_test(tc_core, test_batch);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_bad_header");
+  tcase_add_test(tc_core, test_bad_header);
+  tcase_add_test(tc_core, test_compact_nothing_rotated);
+  suite_add_tcase(s, tc_core);
+
+  /* last, it leaves the journal unable to open */
+  tc_core = tcase_create("test_replay_save_failed");
+  tcase_add_test(tc_core, test_replay_save_failed);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(job_journal_suite());
+  srunner_set_log(sr, "job_journal_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return number_failed;
+  }
@@ -27,7 +27,6 @@ pthread_mutex_t job_log_mutex = PTHREAD_MUTEX_INITIALIZER;
 all_jobs array_summary;
 const char *msg_daemonname = "unset";
 char path_checkpoint[MAXPATHLEN + 1];
-user_info_holder users;
 char *job_log_file = NULL;
 all_jobs newjobs;
 const char *pbs_o_host = "PBS_O_HOST";
@@ -267,6 +266,7 @@ int set_l(struct pbs_attribute *attr, struct pbs_attribute *new_attr, enum batch
 int array_delete(job_array *pa) {return 0;}
 int array_save(job_array *pa) {return 0;}
 int reply_jobid(struct batch_request *preq, char *jobid, int which) {return 0;}
+int reply_send(struct batch_request *request) {return 0;}
 void mutex_mgr::set_unlock_on_exit(bool val) {}
 int client_to_svr(pbs_net_t hostaddr, unsigned int port, int local_port, char *EMsg) {return 0;}
 int issue_signal(job **pjob_ptr, const char *signame, void (*func)(struct batch_request *), void *extra, char *extend) {return 0;}
@@ -286,9 +286,7 @@ int get_fullhostname(char *shortname, char *namebuf, int bufsize, char *EMsg) {r
 int svr_save(struct server *ps, int mode) {return 0;}
 int encode_l(pbs_attribute *attr, tlist_head *phead, const char *atname, const char *rsname, int mode, int perm) {return 0;}
 int mutex_mgr::lock(){return 0;}
-int  increment_queued_jobs(user_info_holder *uih, char *user_name, job *pjob) {return 0;}
 int relay_to_mom(job **pjob_ptr, batch_request   *request, void (*func)(struct work_task *)) {return 0;}
-int  decrement_queued_jobs(user_info_holder *uih, char *user_name, job *pjob) {return 0;}
 void reply_badattr(int code, int aux, svrattrl *pal, struct batch_request *preq) {}
 void req_reject(int code, int aux, struct batch_request *preq, const char *HostName, const char *Msg) {}
 void free_unkn(pbs_attribute *pattr) {}
@@ -363,3 +361,36 @@ bool completed_jobs_map_class::add_job(char const* s, time_t t) {return false;}
 std::string get_path_jobdata(const char *a, const char *b) {return "";}
 
 void add_to_completed_jobs(work_task *wt) {}
+
+bool job_journal_is_open() {return(false);}
+unsigned long long job_journal_get_seq() {return(0);}
+void job_journal_note_seq(unsigned long long seq) {}
+void job_journal_note_replay_failed() {}
+std::vector<std::string> journal_records;
+void job_journal_get_records(const char *jobid, unsigned long long after_seq, std::vector<std::string> &records)
+  {
+  records = journal_records;
+  }
+int job_journal_append(const char *jobid, const char *record, size_t len, int *gen) {return(-1);}
+
+void job_delta_touch(job *pjob) {}
+void job_delta_note_purged(const char *jobid, const char *owner) {}
+
+void job_status_cache_free(job *pjob) {}
+
+unsigned long long job_epoch_retire()
+  {
+  return(1);
+  }
+
+bool job_epoch_passed(unsigned long long retired)
+  {
+  return(true);
+  }
+
+bool job_registry_has(const char *job_id)
+  {
+  return(false);
+  }
+
+void job_index_update(job *pjob) {}
@@ -19,11 +19,11 @@ extern int svr_resc_size;
 extern attribute_def job_attr_def[];
 extern void free_server_attrs(tlist_head *att_head);
 extern completed_jobs_map_class completed_jobs_map;
+extern std::vector<std::string> journal_records;
 int fill_resource_list(job **pj, xmlNodePtr resource_list_node, char *log_buf, size_t buflen, const char *aname);
 
 char  server_name[] = "lei.ac";
 
-int add_encoded_attributes(xmlNodePtr *attr_node, pbs_attribute *pattr);
 void translate_dependency_to_string(pbs_attribute *pattr, std::string &value);
 
 START_TEST(test_translate_dependency_to_string)
@@ -64,7 +64,7 @@ START_TEST(test_add_encoded_attributes)
   attributes[JOB_ATR_job_owner].at_flags |= ATR_VFLAG_SET;
   attributes[JOB_ATR_job_owner].at_val.at_str = strdup("dbeer@napali");
 
-  add_encoded_attributes(&attr_node, attributes);
+  add_encoded_attributes(&attr_node, attributes, NULL, false);
   xmlNode *child = attr_node->children;
 
   fail_unless(child != NULL);
@@ -87,7 +87,7 @@ START_TEST(test_add_encoded_attributes)
   prd.rs_name = "walltime";
   attributes[JOB_ATR_job_owner].at_flags = 0;
   xmlNodePtr attr_node = xmlNewNode(NULL, (xmlChar *)ATTRIB_TAG);
-  add_encoded_attributes(&attr_node, attributes);
+  add_encoded_attributes(&attr_node, attributes, NULL, false);
   xmlNode *child = attr_node->children;
 
   fail_unless(child != NULL);
@@ -282,6 +282,10 @@ START_TEST(fill_resource_list_test)
   char        buf[1024];
   svr_resc_def = svr_resc_def_const;
 
+  /* the definitions run through the "unknown" one */
+  for (svr_resc_size = 1; strcmp(svr_resc_def[svr_resc_size - 1].rs_name, "|unknown|"); svr_resc_size++)
+    ;
+
   fail_unless(fill_resource_list(&pjob, xmlDocGetRootElement(doc), buf, sizeof(buf), ATTR_l) == 0);
   
   const char *rl_empty_sample = "<Resource_List>\n</Resource_List>";
@@ -313,12 +317,35 @@ START_TEST(test_job_recover)
   }
 END_TEST
 
+START_TEST(test_journal_replay_torn_record)
+  {
+  char  buf[1024];
+  job  *pj = create_a_job("unit_test_job2");
+
+  fail_unless(pj != NULL);
+
+  journal_records.clear();
+  journal_records.push_back("<job><attributes><Job_Name>replayed</Job_Name></attributes></job>");
+  journal_records.push_back("<job><attributes><Job_Name>torn");
+
+  /* the torn record ends the replay but the job keeps what came before */
+  fail_unless(job_journal_replay(&pj, buf, sizeof(buf)) == 1);
+  fail_unless(pj->ji_wattr[JOB_ATR_jobname].at_val.at_str != NULL);
+  fail_unless(!strcmp(pj->ji_wattr[JOB_ATR_jobname].at_val.at_str, "replayed"));
+  fail_unless(strstr(buf, "record 2 of 2") != NULL);
+
+  journal_records.clear();
+  fail_unless(job_journal_replay(&pj, buf, sizeof(buf)) == 0);
+  }
+END_TEST
+
 Suite *job_recov_suite(void)
   {
   Suite *s = suite_create("job_recov_suite methods");
 
   TCase *tc_core = tcase_create("test_job_recover");
   tcase_add_test(tc_core, test_job_recover);
+  tcase_add_test(tc_core, test_journal_replay_torn_record);
   tcase_add_test(tc_core, fill_resource_list_test);
   tcase_add_test(tc_core, test_add_encoded_attributes);
   tcase_add_test(tc_core, test_translate_dependency_to_string);
@@ -0,0 +1,9 @@
+#include "license_pbs.h" /* See here for the software license */
+#ifndef _JOB_SELECT_INDEX_CT_H
+#define _JOB_SELECT_INDEX_CT_H
+#include <check.h>
+
+#define JOB_SELECT_INDEX_SUITE 1
+Suite *job_select_index_suite();
+
+#endif /* _JOB_SELECT_INDEX_CT_H */
@@ -0,0 +1,174 @@
+#include "license_pbs.h" /* See here for the software license */
+#include "job_select_index.h"
+#include "test_job_select_index.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "pbs_error.h"
+#include "pbs_ifl.h"
+#include "pbs_job.h"
+
+
+void set_job(
+
+  job        *pjob,
+  const char *jobid,
+  int         internal_id,
+  const char *owner,
+  char        state,
+  const char *queue)
+
+  {
+  memset(pjob, 0, sizeof(job));
+
+  strcpy(pjob->ji_qs.ji_jobid, jobid);
+  strcpy(pjob->ji_qs.ji_queue, queue);
+  pjob->ji_internal_id = internal_id;
+
+  pjob->ji_wattr[JOB_ATR_job_owner].at_val.at_str = strdup(owner);
+  pjob->ji_wattr[JOB_ATR_job_owner].at_flags = ATR_VFLAG_SET;
+  pjob->ji_wattr[JOB_ATR_state].at_val.at_char = state;
+  }
+
+
+std::vector<std::string> lookup(
+
+  int         kind,
+  const char *key1,
+  const char *key2)
+
+  {
+  std::vector<std::string> keys;
+  std::vector<std::string> ids;
+
+  keys.push_back(key1);
+  if (key2 != NULL)
+    keys.push_back(key2);
+
+  job_index_lookup(kind, keys, ids);
+
+  return(ids);
+  }
+
+
+START_TEST(test_get_keys)
+  {
+  job         pjob;
+  std::string keys[JOB_INDEX_COUNT];
+
+  set_job(&pjob, "1.napali", 1, "dbeer@napali", 'Q', "batch");
+  pjob.ji_wattr[JOB_ATR_account].at_val.at_str = strdup("physics");
+  pjob.ji_wattr[JOB_ATR_account].at_flags = ATR_VFLAG_SET;
+
+  job_index_get_keys(&pjob, keys);
+
+  fail_unless(keys[JOB_INDEX_OWNER] == "dbeer");
+  fail_unless(keys[JOB_INDEX_EUSER].size() == 0);
+  fail_unless(keys[JOB_INDEX_STATE] == "Q");
+  fail_unless(keys[JOB_INDEX_QUEUE] == "batch");
+  fail_unless(keys[JOB_INDEX_ACCOUNT] == "physics");
+  }
+END_TEST
+
+
+START_TEST(test_add_update_remove)
+  {
+  job                      j1;
+  job                      j2;
+  job                      j3;
+  std::vector<std::string> ids;
+
+  /* recovered jobs are registered before they have an internal id */
+  set_job(&j1, "1.napali", 0, "dbeer@napali", 'Q', "batch");
+  set_job(&j2, "2.napali", 0, "knielson@napali", 'Q', "batch");
+  set_job(&j3, "3.napali", 0, "dbeer@napali", 'R', "long");
+
+  /* found in the order they were added */
+  job_index_add(&j1);
+  job_index_add(&j3);
+  job_index_add(&j2);
+
+  ids = lookup(JOB_INDEX_OWNER, "dbeer", NULL);
+  fail_unless(ids.size() == 2);
+  fail_unless(ids[0] == "1.napali");
+  fail_unless(ids[1] == "3.napali");
+
+  ids = lookup(JOB_INDEX_STATE, "Q", "R");
+  fail_unless(ids.size() == 3);
+  fail_unless(ids[0] == "1.napali");
+  fail_unless(ids[1] == "3.napali");
+  fail_unless(ids[2] == "2.napali");
+
+  /* adding a job again keeps its place */
+  job_index_add(&j1);
+  fail_unless(lookup(JOB_INDEX_OWNER, "dbeer", NULL)[0] == "1.napali");
+
+  fail_unless(lookup(JOB_INDEX_QUEUE, "batch", NULL).size() == 2);
+  fail_unless(lookup(JOB_INDEX_QUEUE, "express", NULL).size() == 0);
+
+  /* moving a job moves its entries */
+  j1.ji_wattr[JOB_ATR_state].at_val.at_char = 'R';
+  strcpy(j1.ji_qs.ji_queue, "long");
+  job_index_update(&j1);
+
+  ids = lookup(JOB_INDEX_STATE, "R", NULL);
+  fail_unless(ids.size() == 2);
+  fail_unless(ids[0] == "1.napali");
+  fail_unless(lookup(JOB_INDEX_STATE, "Q", NULL).size() == 1);
+  fail_unless(lookup(JOB_INDEX_OWNER, "dbeer", NULL).size() == 2);
+  fail_unless(lookup(JOB_INDEX_QUEUE, "long", NULL).size() == 2);
+
+  /* jobs that aren't indexed stay that way */
+  job j4;
+  set_job(&j4, "4.napali", 4, "dbeer@napali", 'Q', "batch");
+  job_index_update(&j4);
+  fail_unless(lookup(JOB_INDEX_OWNER, "dbeer", NULL).size() == 2);
+
+  job_index_remove(&j3);
+  job_index_remove(&j4);
+
+  ids = lookup(JOB_INDEX_OWNER, "dbeer", NULL);
+  fail_unless(ids.size() == 1);
+  fail_unless(ids[0] == "1.napali");
+  fail_unless(lookup(JOB_INDEX_QUEUE, "long", NULL).size() == 1);
+
+  job_index_remove(&j1);
+  job_index_remove(&j2);
+  fail_unless(lookup(JOB_INDEX_STATE, "Q", "R").size() == 0);
+  fail_unless(j1.ji_index_entry == NULL);
+  }
+END_TEST
+
+
+Suite *job_select_index_suite(void)
+  {
+  Suite *s = suite_create("job_select_index_suite methods");
+  TCase *tc_core = tcase_create("test_get_keys");
+  tcase_add_test(tc_core, test_get_keys);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_add_update_remove");
+  tcase_add_test(tc_core, test_add_update_remove);
+  suite_add_tcase(s, tc_core);
+
+  return s;
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(job_select_index_suite());
+  srunner_set_log(sr, "job_select_index_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return number_failed;
+  }
@@ -0,0 +1,35 @@
+#include "license_pbs.h" /* See here for the software license */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "server.h" /* mail_info */
+#include "mail_spool.h"
+
+int LOGLEVEL = 7; /* force logging code to be exercised as tests run */
+
+void free_mail_info(mail_info *mi)
+  {
+  free(mi->mailto);
+  free(mi->text);
+  free(mi);
+  }
+
+void write_email_digest(FILE *outmail_input, mail_digest &md)
+  {
+  fprintf(outmail_input, "To: %s\n", md.mailto.c_str());
+  fprintf(outmail_input, "Subject: %d %s\n\n", (int)md.items.size(), md.array_id.c_str());
+
+  for (size_t i = 0; i < md.items.size(); i++)
+    fprintf(outmail_input, "%s\n", md.items[i]->text);
+  }
+
+int get_svr_attr_str(int index, char **str)
+  {
+  *str = NULL;
+  return(0);
+  }
+
+void log_err(int errnum, const char *routine, const char *text) {}
+void log_record(int eventtype, int objclass, const char *objname, const char *text) {}
+void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
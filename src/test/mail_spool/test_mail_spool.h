@@ -0,0 +1,9 @@
+#include "license_pbs.h" /* See here for the software license */
+#ifndef _MAIL_SPOOL_CT_H
+#define _MAIL_SPOOL_CT_H
+#include <check.h>
+
+#define MAIL_SPOOL_SUITE 1
+Suite *mail_spool_suite();
+
+#endif /* _MAIL_SPOOL_CT_H */
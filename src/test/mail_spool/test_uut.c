@@ -0,0 +1,179 @@
+#include "license_pbs.h" /* See here for the software license */
+#include "mail_spool.h"
+#include "test_mail_spool.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <string>
+#include "pbs_error.h"
+
+const char *spool = "/tmp/mail_spool_ut/";
+
+
+mail_info *make_mail(const char *mailto, const char *text)
+  {
+  mail_info *mi = (mail_info *)calloc(1, sizeof(mail_info));
+
+  mi->mailto = strdup(mailto);
+  mi->text = strdup(text);
+
+  return(mi);
+  }
+
+int count_spooled()
+  {
+  DIR           *dp = opendir(spool);
+  struct dirent *pdirent;
+  int            count = 0;
+
+  if (dp == NULL)
+    return(-1);
+
+  while ((pdirent = readdir(dp)) != NULL)
+    {
+    if (strstr(pdirent->d_name, MAIL_SPOOL_SUFFIX) != NULL)
+      count++;
+    }
+
+  closedir(dp);
+
+  return(count);
+  }
+
+bool file_contains(const char *path, const char *text)
+  {
+  FILE *fp = fopen(path, "r");
+  char  buf[1024];
+  bool  found = false;
+
+  if (fp == NULL)
+    return(false);
+
+  while (fgets(buf, sizeof(buf), fp) != NULL)
+    {
+    if (strstr(buf, text) != NULL)
+      found = true;
+    }
+
+  fclose(fp);
+
+  return(found);
+  }
+
+
+START_TEST(test_spool_file)
+  {
+  std::string from;
+  std::string to;
+  std::string msg;
+
+  system("rm -rf /tmp/mail_spool_ut; mkdir /tmp/mail_spool_ut");
+
+  fail_unless(mail_spool_write_file("/tmp/mail_spool_ut/1.mail", "root@napali", "dbeer,knielson", "Subject: x\n\nbody\n") == PBSE_NONE);
+  fail_unless(access("/tmp/mail_spool_ut/1.mail.tmp", F_OK) != 0);
+
+  fail_unless(mail_spool_read_file("/tmp/mail_spool_ut/1.mail", from, to, msg) == PBSE_NONE);
+  fail_unless(from == "root@napali");
+  fail_unless(to == "dbeer,knielson");
+  fail_unless(msg == "Subject: x\n\nbody\n");
+
+  fail_unless(mail_spool_read_file("/tmp/mail_spool_ut/2.mail", from, to, msg) != PBSE_NONE);
+  }
+END_TEST
+
+
+START_TEST(test_run_sendmail)
+  {
+  const char *msg = "Subject: hello\n\nthe job ended\n";
+
+  unlink("/tmp/mail.out");
+
+  fail_unless(run_sendmail("root@napali", "dbeer,knielson", msg, strlen(msg)) == 0);
+  fail_unless(file_contains("/tmp/mail.out", "MAILFROM=root@napali"));
+  fail_unless(file_contains("/tmp/mail.out", "MAILTO=dbeer knielson"));
+  fail_unless(file_contains("/tmp/mail.out", "the job ended"));
+
+  unlink("/tmp/mail.out");
+  }
+END_TEST
+
+
+START_TEST(test_spool_and_deliver)
+  {
+  mail_info *mi = make_mail("dbeer", "not running");
+
+  /* nothing is queued while the spool is not running */
+  fail_unless(mail_spool_add(mi, NULL) == -1);
+  free(mi->mailto);
+  free(mi->text);
+  free(mi);
+
+  system("rm -rf /tmp/mail_spool_ut");
+  unlink("/tmp/mail.out");
+
+  fail_unless(mail_spool_start(spool) == PBSE_NONE);
+  fail_unless(count_spooled() == 0);
+
+  /* the subjobs of one array to the same user make one message */
+  fail_unless(mail_spool_add(make_mail("dbeer", "1[1]"), "1[].napali") == PBSE_NONE);
+  fail_unless(mail_spool_add(make_mail("dbeer", "1[2]"), "1[].napali") == PBSE_NONE);
+  fail_unless(mail_spool_add(make_mail("dbeer", "1[3]"), "1[].napali") == PBSE_NONE);
+  fail_unless(mail_spool_add(make_mail("knielson", "2"), NULL) == PBSE_NONE);
+
+  /* stopping before MAIL_SPOOL_DELAY leaves them spooled, not sent */
+  mail_spool_shutdown();
+  fail_unless(count_spooled() == 2);
+  fail_unless(access("/tmp/mail.out", F_OK) != 0);
+
+  fail_unless(mail_spool_add(make_mail("dbeer", "stopped"), NULL) == -1);
+
+  /* and they are sent after the next start */
+  fail_unless(mail_spool_start(spool) == PBSE_NONE);
+
+  for (int i = 0; (i < 30) && (count_spooled() > 0); i++)
+    usleep(100000);
+
+  fail_unless(count_spooled() == 0);
+  fail_unless(access("/tmp/mail.out", F_OK) == 0);
+
+  mail_spool_shutdown();
+
+  unlink("/tmp/mail.out");
+  system("rm -rf /tmp/mail_spool_ut");
+  }
+END_TEST
+
+
+Suite *mail_spool_suite(void)
+  {
+  Suite *s = suite_create("mail_spool test suite methods");
+  TCase *tc_core = tcase_create("test_spool_file");
+  tcase_add_test(tc_core, test_spool_file);
+  tcase_add_test(tc_core, test_run_sendmail);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_spool_and_deliver");
+  tcase_add_test(tc_core, test_spool_and_deliver);
+  suite_add_tcase(s, tc_core);
+
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(mail_spool_suite());
+  srunner_set_log(sr, "mail_spool_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
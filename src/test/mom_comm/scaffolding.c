@@ -147,6 +147,16 @@ int mom_get_sample()
   return(0);
   }
 
+bool cgroup_accounting_enabled(void)
+  {
+  return(false);
+  }
+
+int move_to_job_cgroup(pid_t pid, const char *jobid)
+  {
+  return(0);
+  }
+
 int run_pelog(int which, char *specpelog, job *pjog, int pe_io_type, int deletejob)
   {
   return(0);
@@ -0,0 +1,192 @@
+#include "license_pbs.h" /* See here for the software license */
+#include "mom_copy.h"
+#include "test_mom_copy.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "pbs_error.h"
+
+const char *copy_dir = "/tmp/mom_copy_ut";
+
+
+void write_file(const char *path, const char *text, mode_t mode)
+  {
+  FILE *fp = fopen(path, "w");
+
+  fputs(text, fp);
+  fclose(fp);
+
+  chmod(path, mode);
+  }
+
+std::string read_file(const char *path)
+  {
+  FILE        *fp = fopen(path, "r");
+  char         buf[1024];
+  std::string  text;
+
+  if (fp == NULL)
+    return(text);
+
+  while (fgets(buf, sizeof(buf), fp) != NULL)
+    text += buf;
+
+  fclose(fp);
+
+  return(text);
+  }
+
+void reset_copy_dir()
+  {
+  system("rm -rf /tmp/mom_copy_ut; mkdir -p /tmp/mom_copy_ut/out");
+  }
+
+
+START_TEST(test_copy_file)
+  {
+  std::string error;
+  struct stat st;
+
+  reset_copy_dir();
+
+  write_file("/tmp/mom_copy_ut/1.OU", "job output\n", 0640);
+
+  fail_unless(copy_path("/tmp/mom_copy_ut/1.OU", "/tmp/mom_copy_ut/1.out", FALSE, error) == PBSE_NONE);
+  fail_unless(read_file("/tmp/mom_copy_ut/1.out") == "job output\n");
+  fail_unless(stat("/tmp/mom_copy_ut/1.out", &st) == 0);
+  fail_unless((st.st_mode & 0777) == 0640);
+
+  /* copied into a directory under its own name */
+  fail_unless(copy_path("/tmp/mom_copy_ut/1.OU", "/tmp/mom_copy_ut/out", TRUE, error) == PBSE_NONE);
+  fail_unless(read_file("/tmp/mom_copy_ut/out/1.OU") == "job output\n");
+
+  /* an existing file is replaced */
+  write_file("/tmp/mom_copy_ut/1.OU", "more\n", 0640);
+  fail_unless(copy_path("/tmp/mom_copy_ut/1.OU", "/tmp/mom_copy_ut/1.out", FALSE, error) == PBSE_NONE);
+  fail_unless(read_file("/tmp/mom_copy_ut/1.out") == "more\n");
+
+  fail_unless(copy_path("/tmp/mom_copy_ut/2.OU", "/tmp/mom_copy_ut/2.out", FALSE, error) == ENOENT);
+  fail_unless(error.find("/tmp/mom_copy_ut/2.OU") != std::string::npos);
+  }
+END_TEST
+
+
+START_TEST(test_copy_tree)
+  {
+  std::string error;
+  char        target[256];
+  ssize_t     len;
+
+  reset_copy_dir();
+
+  system("mkdir -p /tmp/mom_copy_ut/in/sub");
+  write_file("/tmp/mom_copy_ut/in/a", "a\n", 0644);
+  write_file("/tmp/mom_copy_ut/in/sub/b", "b\n", 0600);
+  symlink("a", "/tmp/mom_copy_ut/in/link");
+
+  /* trailing slashes don't change the name it's copied under */
+  fail_unless(copy_path("/tmp/mom_copy_ut/in/", "/tmp/mom_copy_ut/out", TRUE, error) == PBSE_NONE);
+  fail_unless(read_file("/tmp/mom_copy_ut/out/in/a") == "a\n");
+  fail_unless(read_file("/tmp/mom_copy_ut/out/in/sub/b") == "b\n");
+
+  len = readlink("/tmp/mom_copy_ut/out/in/link", target, sizeof(target) - 1);
+  fail_unless(len == 1);
+  target[len] = '\0';
+  fail_unless(!strcmp(target, "a"));
+
+  /* a directory copied to a new name */
+  fail_unless(copy_path("/tmp/mom_copy_ut/in", "/tmp/mom_copy_ut/in2", FALSE, error) == PBSE_NONE);
+  fail_unless(read_file("/tmp/mom_copy_ut/in2/sub/b") == "b\n");
+  }
+END_TEST
+
+
+START_TEST(test_copy_paths)
+  {
+  std::vector<mom_copy> copies;
+  char                  path[256];
+
+  reset_copy_dir();
+
+  fail_unless(mom_copy_init(2) == PBSE_NONE);
+
+  for (int i = 0; i < 10; i++)
+    {
+    mom_copy mc;
+
+    snprintf(path, sizeof(path), "%s/%d.OU", copy_dir, i);
+    write_file(path, path, 0644);
+
+    mc.source = path;
+    snprintf(path, sizeof(path), "%s/out/%d.out", copy_dir, i);
+    mc.dest = path;
+    mc.rc = -1;
+
+    copies.push_back(mc);
+    }
+
+  /* one that fails doesn't stop the others */
+  copies[4].source = "/tmp/mom_copy_ut/missing";
+
+  copy_paths(copies, 3, TRUE);
+
+  for (int i = 0; i < 10; i++)
+    {
+    if (i == 4)
+      {
+      fail_unless(copies[i].rc == ENOENT);
+      fail_unless(copies[i].error.size() > 0);
+      continue;
+      }
+
+    fail_unless(copies[i].rc == PBSE_NONE, "copy %d failed: %s", i, copies[i].error.c_str());
+    fail_unless(read_file(copies[i].dest.c_str()) == copies[i].source);
+    }
+
+  /* without a slot table copies aren't limited */
+  fail_unless(mom_copy_init(0) == PBSE_NONE);
+
+  copies[4].source = "/tmp/mom_copy_ut/4.OU";
+  copy_paths(copies, 1, FALSE);
+  fail_unless(copies[4].rc == PBSE_NONE);
+
+  system("rm -rf /tmp/mom_copy_ut");
+  }
+END_TEST
+
+
+Suite *mom_copy_suite(void)
+  {
+  Suite *s = suite_create("mom_copy test suite methods");
+  TCase *tc_core = tcase_create("test_copy_file");
+  tcase_add_test(tc_core, test_copy_file);
+  tcase_add_test(tc_core, test_copy_tree);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_copy_paths");
+  tcase_add_test(tc_core, test_copy_paths);
+  suite_add_tcase(s, tc_core);
+
+  return(s);
+  }
+
+void rundebug()
+  {
+  }
+
+int main(void)
+  {
+  int number_failed = 0;
+  SRunner *sr = NULL;
+  rundebug();
+  sr = srunner_create(mom_copy_suite());
+  srunner_set_log(sr, "mom_copy_suite.log");
+  srunner_run_all(sr, CK_NORMAL);
+  number_failed = srunner_ntests_failed(sr);
+  srunner_free(sr);
+  return(number_failed);
+  }
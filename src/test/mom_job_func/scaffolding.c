@@ -136,6 +136,11 @@ int delete_cpuset(const char *, bool)
   return 0;
   }
 
+int delete_job_cgroup(const char *jobid)
+  {
+  return 0;
+  }
+
 char *pbse_to_txt(int err)
   {
   fprintf(stderr, "The call to pbse_to_txt needs to be mocked!!\n");
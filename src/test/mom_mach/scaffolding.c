@@ -13,6 +13,7 @@
 #include "pbs_nodes.h"
 #include "pbs_config.h"
 #include "node_frequency.hpp"
+#include "pbs_cgroup.h"
 
 
 char log_buffer[LOG_BUF_SIZE];
@@ -185,3 +186,20 @@ bool node_frequency::get_frequency_string(std::string& str,bool full)
 
 node_frequency nd_frequency;
 void from_frequency(struct cpu_frequency_value *pfreq, char *cvnbuf) {}
+
+bool cgroup_enabled = false;
+cgroup_usage cgroup_usage_value;
+
+bool cgroup_accounting_enabled(void)
+  {
+  return(cgroup_enabled);
+  }
+
+int read_job_cgroup_usage(const char *jobid, cgroup_usage *cu)
+  {
+  if (cgroup_enabled == false)
+    return(-1);
+
+  *cu = cgroup_usage_value;
+  return(0);
+  }
@@ -9,6 +9,7 @@
 
 #include "pbs_job.h"
 #include "pbs_error.h"
+#include "pbs_cgroup.h"
 
 int get_job_sid_from_pid(int);
 int injob(job*, int);
@@ -17,6 +18,7 @@ int overmem_proc(job*, unsigned long long);
 int overcpu_proc(job*, unsigned long);
 unsigned long long resi_sum(job*);
 unsigned long long mem_sum(job*);
+int mom_get_sample(void);
 
 double cputfactor;
 
@@ -29,6 +31,7 @@ extern pid2procarrayindex_map_t pid2procarrayindex_map;
 extern proc_stat_t   *proc_array;
 
 extern void *get_next_return_value;
+extern bool cgroup_enabled;
 
 START_TEST(test_get_job_sid_from_pid)
   { 
@@ -434,6 +437,55 @@ START_TEST(test_mem_sum)
   }
 END_TEST
 
+START_TEST(test_cgroup_sums)
+  {
+  job *pjob;
+
+  pid2jobsid_map.clear();
+  pid2procarrayindex_map.clear();
+  global_job_sid_set.clear();
+
+  pjob = (job *)calloc(1, sizeof(job));
+  fail_unless(pjob != NULL);
+
+  pjob->ji_job_pid_set = new job_pid_set_t;
+
+  /* a job sampled from its cgroup doesn't look at the process table */
+  pjob->ji_cgroup_sampled = true;
+  pjob->ji_cgroup_populated = true;
+  pjob->ji_cgroup_cput = 50;
+  pjob->ji_cgroup_mem = 4096;
+  pjob->ji_cgroup_vmem = 8192;
+
+  cputfactor = 2.0;
+  fail_unless(cput_sum(pjob) == 100);
+  fail_unless((pjob->ji_flags & MOM_NO_PROC) == 0);
+  fail_unless(resi_sum(pjob) == 4096);
+  fail_unless(mem_sum(pjob) == 8192);
+
+  /* an empty cgroup means the job has no processes left */
+  pjob->ji_cgroup_populated = false;
+  fail_unless(cput_sum(pjob) == 100);
+  fail_unless((pjob->ji_flags & MOM_NO_PROC) != 0);
+
+  cputfactor = 1.0;
+  }
+END_TEST
+
+START_TEST(test_mom_get_sample_cgroup)
+  {
+  /* with cgroup accounting and no running jobs the process table is skipped */
+  cgroup_enabled = true;
+  get_next_return_value = NULL;
+  pid2jobsid_map[10] = 1000;
+
+  fail_unless(mom_get_sample() == PBSE_NONE);
+  fail_unless(pid2jobsid_map.size() == 0);
+
+  cgroup_enabled = false;
+  }
+END_TEST
+
 Suite *mom_mach_suite(void)
   {
   Suite *s = suite_create("mom_mach_suite methods");
@@ -465,6 +517,11 @@ Suite *mom_mach_suite(void)
   tcase_add_test(tc_core, test_mem_sum);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_cgroup_sums");
+  tcase_add_test(tc_core, test_cgroup_sums);
+  tcase_add_test(tc_core, test_mom_get_sample_cgroup);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
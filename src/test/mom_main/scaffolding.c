@@ -793,6 +793,13 @@ unsigned hwloc_get_nbobjs_by_depth (hwloc_topology_t topology, unsigned depth)
 
 void cleanup_torque_cpuset(void){}
 
+int init_torque_cgroup(const char *root)
+  {
+  return(-1);
+  }
+
+void cleanup_torque_cgroup(void) {}
+
 void create_cpuset_reservation_if_needed(job &pjob){}
 
 int init_torque_cpuset(void)
@@ -869,3 +876,8 @@ time_t get_stat_update_interval()
   }
 
 void empty_received_nodes() {}
+
+int add_conn(int sock, enum conn_type type, pbs_net_t addr, unsigned int port, unsigned int socktype, void *(*func)(void *))
+  {
+  return(0);
+  }
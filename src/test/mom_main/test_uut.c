@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <sys/wait.h>
 #include <string>
 #include <sstream>
 #include "pbs_config.h"
@@ -27,10 +28,19 @@ int  parse_integer_range(const char *range_str, int &start, int &end);
 time_t calculate_select_timeout();
 
 extern int  exiting_tasks;
+extern int  termin_child;
+extern int  sigchld_fd;
+
+void init_sigchld_fd(void);
+int  drain_sigchld_fd(void);
 
 bool call_scan_for_exiting();
 extern tlist_head svr_alljobs;
 
+extern pjobexec_t TMOMStartInfo[];
+int  TMOMStartsPending(void);
+int  TMOMWaitForStarting(int);
+
 START_TEST(test_read_mom_hierarchy)
   {
   system("rm -f bob");
@@ -253,6 +263,79 @@ START_TEST(test_setcudavisibledevices)
 END_TEST
 
 
+START_TEST(test_sigchld_fd)
+  {
+  pid_t pid;
+
+  termin_child = 0;
+  fail_unless(drain_sigchld_fd() == FALSE);
+
+  init_sigchld_fd();
+#ifdef HAVE_SYS_SIGNALFD_H
+  fail_unless(sigchld_fd >= 0);
+
+  /* nothing has exited yet */
+  fail_unless(drain_sigchld_fd() == FALSE);
+  fail_unless(termin_child == 0);
+
+  if ((pid = fork()) == 0)
+    exit(0);
+
+  waitpid(pid, NULL, 0);
+
+  fail_unless(drain_sigchld_fd() == TRUE);
+  fail_unless(termin_child == 1);
+  fail_unless(drain_sigchld_fd() == FALSE);
+
+  close(sigchld_fd);
+  sigchld_fd = -1;
+#endif
+  }
+END_TEST
+
+
+START_TEST(test_starts_pending)
+  {
+  int fds[2];
+
+  CLEAR_HEAD(svr_alljobs);
+  memset(&TMOMStartInfo[3], 0, sizeof(pjobexec_t));
+
+  fail_unless(TMOMStartsPending() == 0);
+  fail_unless(TMOMWaitForStarting(0) == 0);
+
+  fail_unless(pipe(fds) == 0);
+  strcpy(TMOMStartInfo[3].jobid, "1.napali");
+  TMOMStartInfo[3].jsmpipe[0] = fds[0];
+  TMOMStartInfo[3].jsmpipe[1] = fds[1];
+
+  fail_unless(TMOMStartsPending() == 1);
+
+  /* launching jobs are checked on every second */
+  time_now = 110;
+  wait_time = 10;
+  LastServerUpdateTime = 100;
+  ServerStatUpdateInterval = 20;
+  last_poll_time = 90;
+  CheckPollTime = 30;
+  fail_unless(calculate_select_timeout() == 1);
+
+  /* the starter hasn't reported back */
+  fail_unless(TMOMWaitForStarting(0) == 0);
+
+  fail_unless(write(fds[1], "x", 1) == 1);
+  fail_unless(TMOMWaitForStarting(1) == 1);
+
+  close(fds[0]);
+  close(fds[1]);
+  memset(&TMOMStartInfo[3], 0, sizeof(pjobexec_t));
+
+  fail_unless(TMOMStartsPending() == 0);
+  fail_unless(calculate_select_timeout() == 10);
+  }
+END_TEST
+
+
 Suite *mom_main_suite(void)
   {
   Suite *s = suite_create("mom_main_suite methods");
@@ -267,6 +350,7 @@ Suite *mom_main_suite(void)
 
   tc_core = tcase_create("calculate_select_timeout_test");
   tcase_add_test(tc_core, calculate_select_timeout_test);
+  tcase_add_test(tc_core, test_starts_pending);
   suite_add_tcase(s, tc_core);
 
   tc_core = tcase_create("test_call_scan_for_exiting");
@@ -277,6 +361,10 @@ Suite *mom_main_suite(void)
   tcase_add_test(tc_core, test_setcudavisibledevices);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_sigchld_fd");
+  tcase_add_test(tc_core, test_sigchld_fd);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
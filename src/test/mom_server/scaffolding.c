@@ -86,6 +86,7 @@ int              MOMConfigUseSMT           = 1; /* 0: off, 1: on */
 #endif
 
 struct tcp_chan default_chan;
+int             MOMConfigStatusDelta = 0;
 
 
 int MUReadPipe(char *Command, char *Buffer, int BufSize)
@@ -3,10 +3,12 @@
 #include "test_mom_server.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "pbs_error.h"
 #include "mom_server.h"
 #include "resmon.h"
+#include "pbs_nodes.h"
 
 #define MAXLINE 1024
 #define NO_SERVER_CONFIGURED -1
@@ -16,6 +18,9 @@ extern mom_hierarchy_t *mh;
 extern void sort_paths();
 
 int mom_server_update_stat(mom_server *pms, std::vector<std::string> &strings);
+void build_status_update(std::vector<std::string> &status, std::vector<std::string> &update);
+void commit_status_update(std::vector<std::string> &status);
+void reset_status_delta();
 
 char PBSNodeMsgBuf[MAXLINE];
 char PBSNodeCheckPath[MAXLINE];
@@ -31,6 +36,7 @@ extern int    UpdateFailCount;
 extern time_t LastServerUpdateTime;
 extern int    is_reporter_mom;
 extern mom_server mom_servers[PBS_MAXSERVER];
+extern int    MOMConfigStatusDelta;
 
 
 START_TEST(test_sort_paths)
@@ -219,6 +225,66 @@ START_TEST(test_mom_server_all_update_stat_clear_force)
 END_TEST
 
 
+START_TEST(test_build_status_update)
+  {
+  std::vector<std::string> status;
+  std::vector<std::string> update;
+
+  status.push_back("state=free");
+  status.push_back("ncpus=4");
+  status.push_back("loadave=0.10");
+  status.push_back(START_GPU_STATUS);
+  status.push_back("gpuid=0");
+  status.push_back(END_GPU_STATUS);
+
+  /* deltas off - the status is sent as is */
+  MOMConfigStatusDelta = 0;
+  build_status_update(status, update);
+  fail_unless(update == status);
+
+  /* nothing acknowledged yet - full, versioned update */
+  MOMConfigStatusDelta = 1;
+  reset_status_delta();
+  build_status_update(status, update);
+  fail_unless(update.size() == 7);
+  fail_unless(!strncmp(update[0].c_str(), "status_seq=", 11));
+  commit_status_update(status);
+
+  /* only changed keys, state and the gpu block are resent */
+  status[2] = "loadave=2.00";
+  status.erase(status.begin() + 1);
+  build_status_update(status, update);
+  fail_unless(update.size() == 8, "%d", (int)update.size());
+  fail_unless(!strncmp(update[0].c_str(), "status_delta=", 13));
+  fail_unless(!strncmp(update[1].c_str(), "status_seq=", 11));
+  fail_unless(update[2] == "state=free");
+  fail_unless(update[3] == "loadave=2.00");
+  fail_unless(update[4] == START_GPU_STATUS);
+  fail_unless(update[6] == END_GPU_STATUS);
+  fail_unless(update[7] == "status_removed=ncpus");
+  commit_status_update(status);
+
+  /* every 10th update is full */
+  for (int i = 0; i < 8; i++)
+    {
+    build_status_update(status, update);
+    fail_unless(!strncmp(update[0].c_str(), "status_delta=", 13));
+    commit_status_update(status);
+    }
+
+  build_status_update(status, update);
+  fail_unless(!strncmp(update[0].c_str(), "status_seq=", 11));
+  fail_unless(update.size() == status.size() + 1);
+
+  /* until a full update is acknowledged the next one is full too */
+  build_status_update(status, update);
+  fail_unless(!strncmp(update[0].c_str(), "status_seq=", 11));
+
+  MOMConfigStatusDelta = 0;
+  }
+END_TEST
+
+
 Suite *mom_server_suite(void)
   {
   Suite *s = suite_create("mom_server_suite methods");
@@ -238,6 +304,10 @@ Suite *mom_server_suite(void)
   tcase_add_test(tc_core, test_send_update_force_flag);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_build_status_update");
+  tcase_add_test(tc_core, test_build_status_update);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
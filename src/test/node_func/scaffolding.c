@@ -464,3 +464,11 @@ void free_br(struct batch_request *preq)
 void mom_hierarchy_handler::reloadHierarchy()
 {
 }
+
+int refresh_node_status(
+
+  struct pbsnode *np)
+
+  {
+  return(0);
+  }
@@ -41,6 +41,8 @@ extern std::vector<int> jobsKilled;
 
 extern int str_to_attr_count;
 extern int decode_resc_count;
+extern int job_delta_touch_count;
+extern int find_nodebyname_count;
 
 
 START_TEST(test_add_remove_mic_jobs)
@@ -297,9 +299,11 @@ START_TEST(process_job_attribute_information_test)
   std::string jobid("2.napali");
 
   str_to_attr_count = 0;
+  job_delta_touch_count = 0;
   process_job_attribute_information(jobid, attr_str);
   fail_unless(str_to_attr_count == 3);
   fail_unless(decode_resc_count == 3);
+  fail_unless(job_delta_touch_count == 1);
   }
 END_TEST
 
@@ -399,6 +403,36 @@ START_TEST(get_next_exec_host_test)
   }
 END_TEST
 
+START_TEST(free_queued_nodes_test)
+  {
+  job *pjob1 = (job *)calloc(1, sizeof(job));
+  job *pjob2 = (job *)calloc(1, sizeof(job));
+
+  strcpy(pjob1->ji_qs.ji_jobid, "1.napali");
+  pjob1->ji_internal_id = 1;
+  pjob1->ji_qs.ji_svrflags = JOB_SVFLG_HasNodes;
+  pjob1->ji_wattr[JOB_ATR_exec_host].at_val.at_str = strdup("bob/0+bob/1+2/0");
+  pjob1->ji_wattr[JOB_ATR_exec_host].at_flags = ATR_VFLAG_SET;
+
+  strcpy(pjob2->ji_qs.ji_jobid, "2.napali");
+  pjob2->ji_internal_id = 2;
+  pjob2->ji_wattr[JOB_ATR_exec_host].at_val.at_str = strdup("2/1+3/0");
+  pjob2->ji_wattr[JOB_ATR_exec_host].at_flags = ATR_VFLAG_SET;
+
+  queue_free_nodes(pjob1);
+  queue_free_nodes(pjob2);
+  fail_unless((pjob1->ji_qs.ji_svrflags & JOB_SVFLG_HasNodes) == 0);
+
+  /* each node is looked up and locked once for both jobs */
+  find_nodebyname_count = 0;
+  fail_unless(free_queued_nodes() == 3);
+  fail_unless(find_nodebyname_count == 3);
+
+  fail_unless(free_queued_nodes() == 0);
+  fail_unless(find_nodebyname_count == 3);
+  }
+END_TEST
+
 START_TEST(sync_node_jobs_with_moms_test)
   {
   struct pbsnode *pnode = (struct pbsnode *)calloc(1, sizeof(struct pbsnode));
@@ -728,6 +762,7 @@ Suite *node_manager_suite(void)
   tcase_add_test(tc_core, remove_job_from_node_test);
   tcase_add_test(tc_core, job_already_being_killed_test);
   tcase_add_test(tc_core, process_job_attribute_information_test);
+  tcase_add_test(tc_core, free_queued_nodes_test);
   tcase_add_test(tc_core, process_as_node_list_test);
   tcase_add_test(tc_core, node_is_spec_acceptable_test);
   tcase_add_test(tc_core, populate_range_string_from_job_reservation_info_test);
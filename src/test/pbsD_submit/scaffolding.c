@@ -1,33 +1,96 @@
 #include "license_pbs.h" /* See here for the software license */
 #include <stdlib.h>
 #include <stdio.h> /* fprintf */
+#include <string.h> /* strdup */
 
 #include "attribute.h" /* attropl */
+#include "libpbs.h" /* connect_handle, pbs_bulk_job */
+#include "pbs_error.h"
+#include "server_limits.h" /* PBS_NET_MAX_CONNECTIONS */
 
 int pbs_errno = 0;
+struct connect_handle connection[PBS_NET_MAX_CONNECTIONS];
+
+int submitjob_calls = 0;
+int queuejob_calls = 0;
+int statserver_calls = 0;
+int statserver_errno = PBSE_NOATTR; /* a server from before Submit Job */
 
 int PBSD_jscript(int c, char *script_file, char *jobid)
   {
-  fprintf(stderr, "The call to PBSD_jscript needs to be mocked!!\n");
-  exit(1);
+  return(0);
   }
 
 int PBSD_commit(int connect, char *jobid)
   {
-  fprintf(stderr, "The call to PBSD_commit needs to be mocked!!\n");
-  exit(1);
+  return(0);
   }
 
 int PBSD_rdytocmt(int connect, char *jobid)
   {
-  fprintf(stderr, "The call to PBSD_rdytocmt needs to be mocked!!\n");
-  exit(1);
+  return(0);
   }
 
 char *PBSD_queuejob(int connect, int *local_errno, char *jobid, char *destin, struct attropl *attrib, char *extend)
   {
-  fprintf(stderr, "The call to PBSD_queuejob needs to be mocked!!\n");
+  queuejob_calls++;
+
+  return(strdup("1.napali"));
+  }
+
+int PBSD_read_script(char *script_file, char **buf, int *len)
+  {
+  *buf = strdup("");
+  *len = 0;
+
+  return(PBSE_NONE);
+  }
+
+char *PBSD_submitjob(int connect, int *local_errno, char *destin, struct attropl *attrib, char *script, int script_len, char *extend)
+  {
+  submitjob_calls++;
+
+  return(strdup("2.napali"));
+  }
+
+struct batch_status *pbs_statserver_err(int c, struct attrl *attrib, char *extend, int *local_errno)
+  {
+  struct batch_status *bs;
+
+  statserver_calls++;
+
+  if (statserver_errno != PBSE_NONE)
+    {
+    *local_errno = statserver_errno;
+
+    return(NULL);
+    }
+
+  bs = (struct batch_status *)calloc(1, sizeof(struct batch_status));
+  bs->attribs = (struct attrl *)calloc(1, sizeof(struct attrl));
+  bs->attribs->name = strdup(ATTR_capabilities);
+  bs->attribs->value = strdup(SUBMIT_JOB_CAPABILITY);
+
+  return(bs);
+  }
+
+void pbs_statfree(struct batch_status *bs)
+  {
+  free(bs->attribs->name);
+  free(bs->attribs->value);
+  free(bs->attribs);
+  free(bs);
+  }
+
+int PBSD_submit_bulk(int connect, struct pbs_bulk_job *jobs, int job_count, char *extend)
+  {
+  fprintf(stderr, "The call to PBSD_submit_bulk needs to be mocked!!\n");
   exit(1);
   }
 
+int pbs_submit_hash_ext(int socket, void *job_attr, void *res_attr, char *script, char *destination, char *extend, char **return_jobid, char **msg)
+  {
+  fprintf(stderr, "The call to pbs_submit_hash_ext needs to be mocked!!\n");
+  exit(1);
+  }
 
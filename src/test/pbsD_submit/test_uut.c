@@ -3,21 +3,83 @@
 #include "test_pbsD_submit.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
 
 
 #include "pbs_error.h"
 
+extern int submitjob_calls;
+extern int queuejob_calls;
+extern int statserver_calls;
+extern int statserver_errno;
+
 START_TEST(test_one)
   {
+  struct pbs_bulk_job job;
 
+  fail_unless(pbs_submit_bulk(-1, &job, 1, NULL) == 0);
+  fail_unless(pbs_errno == PBSE_IVALREQ);
 
+  fail_unless(pbs_submit_bulk(0, NULL, 1, NULL) == 0);
+  fail_unless(pbs_errno == PBSE_IVALREQ);
   }
 END_TEST
 
 START_TEST(test_two)
   {
+  struct attropl  attr;
+  pthread_mutex_t mutex;
+  char           *jobid;
+  int             local_errno = 0;
+
+  memset(&attr, 0, sizeof(attr));
+  pthread_mutex_init(&mutex, NULL);
+  connection[1].ch_mutex = &mutex;
+  snprintf(connection[1].ch_server, sizeof(connection[1].ch_server), "napali:15001");
+
+  /* a server without the capabilities attribute gets the job in steps */
+  jobid = pbs_submit_err(1, &attr, NULL, (char *)"batch", NULL, &local_errno);
+  fail_unless(jobid != NULL);
+  fail_unless(!strcmp(jobid, "1.napali"));
+  fail_unless(statserver_calls == 1);
+  fail_unless(submitjob_calls == 0);
+  fail_unless(queuejob_calls == 1);
+  free(jobid);
+
+  /* it is only asked once */
+  jobid = pbs_submit_err(1, &attr, NULL, (char *)"batch", NULL, &local_errno);
+  fail_unless(jobid != NULL);
+  fail_unless(statserver_calls == 1);
+  fail_unless(submitjob_calls == 0);
+  fail_unless(queuejob_calls == 2);
+  free(jobid);
+
+  /* a server which couldn't be asked is asked again next time */
+  snprintf(connection[1].ch_server, sizeof(connection[1].ch_server), "waimea:15001");
+  statserver_errno = PBSE_PROTOCOL;
+  jobid = pbs_submit_err(1, &attr, NULL, (char *)"batch", NULL, &local_errno);
+  fail_unless(statserver_calls == 2);
+  fail_unless(submitjob_calls == 0);
+  fail_unless(queuejob_calls == 3);
+  free(jobid);
+
+  /* one which lists submit_job gets a single Submit Job */
+  statserver_errno = PBSE_NONE;
+  jobid = pbs_submit_err(1, &attr, NULL, (char *)"batch", NULL, &local_errno);
+  fail_unless(jobid != NULL);
+  fail_unless(!strcmp(jobid, "2.napali"));
+  fail_unless(statserver_calls == 3);
+  fail_unless(submitjob_calls == 1);
+  fail_unless(queuejob_calls == 3);
+  free(jobid);
 
+  jobid = pbs_submit_err(1, &attr, NULL, (char *)"batch", NULL, &local_errno);
+  fail_unless(statserver_calls == 3);
+  fail_unless(submitjob_calls == 2);
+  free(jobid);
 
+  connection[1].ch_mutex = NULL;
   }
 END_TEST
 
@@ -32,3 +32,21 @@ int PBSD_QueueJob_hash(int connect, char *jobid, char *destin, job_data_containe
  exit(1);
  }
 
+int PBSD_read_script(char *script_file, char **buf, int *len)
+ {
+ fprintf(stderr, "The call to PBSD_read_script needs to be mocked!!\n");
+ exit(1);
+ }
+
+int PBSD_SubmitJob_hash(int connect, char *destin, job_data_container *job_attr, job_data_container *res_attr, char *script, int script_len, char *extend, char **job_id, char **msg)
+ {
+ fprintf(stderr, "The call to PBSD_SubmitJob_hash needs to be mocked!!\n");
+ exit(1);
+ }
+
+
+bool submit_stepwise(int c)
+ {
+ fprintf(stderr, "The call to submit_stepwise needs to be mocked!!\n");
+ exit(1);
+ }
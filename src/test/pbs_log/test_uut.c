@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <dirent.h>
+#include <string.h>
+#include <time.h>
 
 #include <string>
 
@@ -94,6 +96,58 @@ START_TEST(test_two)
   }
 END_TEST
 
+START_TEST(test_log_ring_append)
+  {
+  log_ring *ring = (log_ring *)calloc(1, sizeof(log_ring));
+  char      line[LOG_RING_SIZE / 4];
+
+  memset(line, 'x', sizeof(line));
+
+  /* fill the ring, the fifth line does not fit */
+  for (int i = 0; i < 4; i++)
+    fail_unless(log_ring_append(ring, line, sizeof(line)) == PBSE_NONE);
+
+  fail_unless(ring->head == LOG_RING_SIZE);
+  fail_unless(log_ring_append(ring, line, sizeof(line)) == -1);
+  fail_unless(ring->dropped == 1);
+
+  /* once written the space is reused, wrapping around the end */
+  ring->tail = sizeof(line) + 10;
+  fail_unless(log_ring_append(ring, "abcdefghij0123456789", 20) == PBSE_NONE);
+  fail_unless(memcmp(ring->data, "abcdefghij0123456789", 20) == 0);
+  fail_unless(ring->head == LOG_RING_SIZE + 20);
+
+  ring->tail = LOG_RING_SIZE - 5;
+  ring->head = LOG_RING_SIZE - 5;
+  fail_unless(log_ring_append(ring, "0123456789", 10) == PBSE_NONE);
+  fail_unless(memcmp(ring->data + LOG_RING_SIZE - 5, "01234", 5) == 0);
+  fail_unless(memcmp(ring->data, "56789", 5) == 0);
+
+  free(ring);
+  }
+END_TEST
+
+START_TEST(test_log_timestamp)
+  {
+  int         ms;
+  int         yday;
+  const char *first = log_timestamp(&ms, &yday);
+  struct tm   tm;
+  time_t      now = time(NULL);
+
+  localtime_r(&now, &tm);
+
+  fail_unless(strlen(first) == strlen("MM/DD/YYYY HH:MM:SS"));
+  fail_unless((ms >= 0) && (ms < 1000));
+  fail_unless(first[2] == '/');
+  fail_unless(first[13] == ':');
+
+  /* the same buffer is handed back while the second does not change */
+  fail_unless(log_timestamp(NULL, NULL) == first);
+  fail_unless((yday == tm.tm_yday) || (tm.tm_hour == 0));
+  }
+END_TEST
+
 Suite *pbs_log_suite(void)
   {
   Suite *s = suite_create("pbs_log_suite methods");
@@ -105,6 +159,11 @@ Suite *pbs_log_suite(void)
   tcase_add_test(tc_core, test_two);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_log_ring_append");
+  tcase_add_test(tc_core, test_log_ring_append);
+  tcase_add_test(tc_core, test_log_timestamp);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
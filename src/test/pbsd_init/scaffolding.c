@@ -53,6 +53,7 @@ const char *msg_init_recovque = "Recovered queue %s";
 attribute_def job_attr_def[10];
 const char *msg_init_expctq = "Expected %d, recovered %d queues";
 char *path_arrays;
+char *path_mail;
 char *log_file = NULL;
 const char *msg_script_open = "Unable to open script file";
 all_jobs newjobs;
@@ -98,7 +99,6 @@ const char *path_mom_hierarchy = "/dev/null";
 pthread_mutex_t *svr_do_schedule_mutex;
 pthread_mutex_t *listener_command_mutex;
 pthread_mutex_t *retry_routing_mutex;
-user_info_holder users;
 id_map job_mapper;
 threadpool_t *async_pool;
 bool exit_called = false;
@@ -108,8 +108,6 @@ void on_job_rerun_task(struct work_task *ptask)
   {
   }
 
-void initialize_user_info_holder(user_info_holder *uih) {}
-
 job_array *get_jobs_array(job **pjob)
   {
   fprintf(stderr, "The call to get_jobs_array needs to be mocked!!\n");
@@ -651,3 +649,8 @@ mom_hierarchy_handler hierarchy_handler; //The global declaration.
 int is_svr_attr_set(int i) {return 0;}
 
 std::string get_path_jobdata(const char *a, const char *b) {return "";}
+
+int job_journal_load(const char *dir) {return(0);}
+int job_journal_open(const char *dir) {return(0);}
+
+int mail_spool_start(const char *dir) {return(0);}
@@ -220,6 +220,11 @@ int log_open(char *filename, char *directory)
   exit(1);
   }
 
+int log_start_writer()
+  {
+  return(0);
+  }
+
 int init_network(unsigned int socket, void *(*readfunc)(void *))
   {
   fprintf(stderr, "The call to init_network needs to be mocked!!\n");
@@ -508,3 +513,5 @@ void clear_all_alps_reservations() {}
 completed_jobs_map_class::completed_jobs_map_class() {}
 completed_jobs_map_class::~completed_jobs_map_class() {}
 void *remove_completed_jobs(void *vp) {return(NULL);}
+
+void mail_spool_shutdown() {}
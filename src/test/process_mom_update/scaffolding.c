@@ -1,5 +1,6 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
@@ -45,6 +46,8 @@ void log_err(int errnum, const char *routine, const char *text) {}
 void close_conn(int sd, int has_mutex) {}
 id_map job_mapper;
 bool exit_called = false;
+struct pbsnode          *status_node = NULL;
+std::vector<std::string> decoded_status;
 
 char *threadsafe_tokenizer(
 
@@ -104,6 +107,9 @@ void *sync_node_jobs(
   }
 
 threadpool_t *task_pool;
+void       *(*queued_func)(void *) = NULL;
+void         *queued_arg = NULL;
+int           queued_count = 0;
 
 int enqueue_threadpool_request(
 
@@ -112,6 +118,9 @@ int enqueue_threadpool_request(
   threadpool_t *tp)
 
   {
+  queued_func = func;
+  queued_arg = arg;
+  queued_count++;
   return(0);
   }
 
@@ -139,6 +148,10 @@ struct pbsnode *find_nodebyname(
   const char *nodename) /* I */
 
   {
+  if ((status_node != NULL) &&
+      (!strcmp(nodename, status_node->nd_name)))
+    return(status_node);
+
   return(NULL);
   }
 
@@ -205,6 +218,9 @@ int decode_arst(
   int            perm) /* only used for resources */
 
   {
+  if (val != NULL)
+    decoded_status.push_back(val);
+
   return(0);
   }
 
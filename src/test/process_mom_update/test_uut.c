@@ -1,13 +1,22 @@
 #include "pbs_nodes.h"
+#include <string>
+#include <vector>
 #include <stdio.h>
 #include <stdlib.h>
 #include <check.h>
 
 #include "pbs_error.h"
+#include "mom_update.h"
 
 int set_note_error(struct pbsnode *np, const char *str);
 int restore_note(struct pbsnode *np);
 
+extern struct pbsnode          *status_node;
+extern std::vector<std::string> decoded_status;
+extern void *(*queued_func)(void *);
+extern void  *queued_arg;
+extern int    queued_count;
+
 START_TEST(test_set_note_error)
   {
   struct pbsnode *pnode = (struct pbsnode *)calloc(1, sizeof(pbsnode));
@@ -57,6 +66,201 @@ END_TEST
 
 
 
+START_TEST(test_status_delta)
+  {
+  struct pbsnode           *pnode = (struct pbsnode *)calloc(1, sizeof(pbsnode));
+  std::vector<std::string>  status;
+
+  pnode->nd_name = strdup("napali");
+  status_node = pnode;
+
+  /* a full, versioned update */
+  status.push_back("status_seq=1");
+  status.push_back("ncpus=16");
+  status.push_back("physmem=1024kb");
+  status.push_back("loadave=0.00");
+  decoded_status.clear();
+  fail_unless(process_status_info("napali", status) == PBSE_NONE);
+  fail_unless(pnode->nd_status_seq == 1);
+  fail_unless(pnode->nd_raw_status->size() == 4);
+  /* nothing is decoded until the status is read */
+  fail_unless(decoded_status.size() == 0, "%d", (int)decoded_status.size());
+  fail_unless(pnode->nd_status_stale == true);
+  fail_unless(refresh_node_status(pnode) == PBSE_NONE);
+  fail_unless(decoded_status.size() == 4, "%d", (int)decoded_status.size());
+  fail_unless(pnode->nd_status_stale == false);
+
+  /* and only once */
+  decoded_status.clear();
+  fail_unless(refresh_node_status(pnode) == PBSE_NONE);
+  fail_unless(decoded_status.size() == 0);
+
+  /* changed and removed keys relative to update 1 */
+  status.clear();
+  status.push_back("status_delta=1");
+  status.push_back("status_seq=2");
+  status.push_back("loadave=3.50");
+  status.push_back("status_removed=physmem");
+  decoded_status.clear();
+  fail_unless(process_status_info("napali", status) == PBSE_NONE);
+  fail_unless(pnode->nd_status_seq == 2);
+  fail_unless(pnode->nd_raw_status->size() == 3);
+  fail_unless((*pnode->nd_raw_status)["ncpus"] == "ncpus=16");
+  fail_unless((*pnode->nd_raw_status)["loadave"] == "loadave=3.50");
+  fail_unless(pnode->nd_raw_status->find("physmem") == pnode->nd_raw_status->end());
+  fail_unless(decoded_status.size() == 0);
+  /* the whole status is rebuilt, including rectime */
+  fail_unless(refresh_node_status(pnode) == PBSE_NONE);
+  fail_unless(decoded_status.size() == 3);
+  fail_unless(decoded_status[0] == "loadave=3.50");
+  fail_unless(decoded_status[1] == "ncpus=16");
+
+  /* a delta against an update the server never saw is refused */
+  status.clear();
+  status.push_back("status_delta=5");
+  status.push_back("status_seq=6");
+  status.push_back("ncpus=8");
+  decoded_status.clear();
+  fail_unless(process_status_info("napali", status) == STATUS_SEQ_MISMATCH);
+  fail_unless(pnode->nd_status_seq == 2);
+  fail_unless((*pnode->nd_raw_status)["ncpus"] == "ncpus=16");
+  fail_unless(pnode->nd_status_stale == false);
+  fail_unless(decoded_status.size() == 0);
+
+  /* an unversioned update drops the sequence */
+  status.clear();
+  status.push_back("ncpus=8");
+  decoded_status.clear();
+  fail_unless(process_status_info("napali", status) == PBSE_NONE);
+  fail_unless(pnode->nd_status_seq == 0);
+  fail_unless(pnode->nd_raw_status->size() == 0);
+  fail_unless(pnode->nd_status_stale == false);
+  fail_unless(decoded_status.size() == 2);
+
+  /* so the next delta can't be applied */
+  status.clear();
+  status.push_back("status_delta=2");
+  status.push_back("status_seq=3");
+  status.push_back("ncpus=16");
+  fail_unless(process_status_info("napali", status) == STATUS_SEQ_MISMATCH);
+
+  status_node = NULL;
+  }
+END_TEST
+
+
+
+mom_update *make_update(const char *node_name, const char *first, const char *second)
+  {
+  std::vector<std::string> status;
+
+  status.push_back(first);
+
+  if (second != NULL)
+    status.push_back(second);
+
+  return(new_mom_update(node_name, status));
+  }
+
+
+
+START_TEST(test_coalesce_mom_updates)
+  {
+  std::vector<mom_update *> batch;
+
+  batch.push_back(make_update("napali", "status_seq=1", "ncpus=16"));
+  batch.push_back(make_update("waimea", "status_seq=1", "ncpus=8"));
+  batch.push_back(make_update("napali", "status_delta=1", "status_seq=2"));
+  batch.push_back(make_update("napali", "status_seq=3", "ncpus=16"));
+  batch.push_back(make_update("waimea", "status_delta=1", "status_seq=2"));
+
+  fail_unless(batch[0]->full == true);
+  fail_unless(batch[2]->full == false);
+
+  /* napali's third update replaces both earlier ones; waimea's delta needs
+   * the update it is relative to */
+  fail_unless(coalesce_mom_updates(batch) == 2);
+  fail_unless(batch.size() == 3);
+  fail_unless(batch[0]->node_name == "waimea");
+  fail_unless(batch[1]->status[0] == "status_seq=3");
+  fail_unless(batch[2]->status[0] == "status_delta=1");
+
+  for (unsigned int i = 0; i < batch.size(); i++)
+    delete batch[i];
+  batch.clear();
+
+  /* a mom that restarted and nodes relayed through a hierarchy are always
+   * applied */
+  batch.push_back(make_update("napali", "first_update=true", "ncpus=16"));
+  batch.push_back(make_update("napali", "node=waimea", "ncpus=8"));
+  batch.push_back(make_update("napali", "ncpus=16", NULL));
+
+  fail_unless(batch[0]->first_update == true);
+  fail_unless(batch[0]->coalescable == false);
+  fail_unless(batch[1]->coalescable == false);
+  fail_unless(coalesce_mom_updates(batch) == 0);
+  fail_unless(batch.size() == 3);
+
+  for (unsigned int i = 0; i < batch.size(); i++)
+    delete batch[i];
+  }
+END_TEST
+
+
+
+START_TEST(test_queue_mom_update)
+  {
+  struct pbsnode           *pnode = (struct pbsnode *)calloc(1, sizeof(pbsnode));
+  std::vector<std::string>  status;
+
+  pnode->nd_name = strdup("napali");
+  status_node = pnode;
+  queued_count = 0;
+
+  status.push_back("first_update=true");
+  status.push_back("status_seq=1");
+  status.push_back("ncpus=16");
+  fail_unless(queue_mom_update("napali", status) == SEND_HELLO);
+  fail_unless(status.size() == 0);
+  fail_unless(queued_count == 1);
+  fail_unless(queued_func == apply_mom_updates);
+
+  status.push_back("status_seq=2");
+  status.push_back("ncpus=32");
+  fail_unless(queue_mom_update("napali", status) == PBSE_NONE);
+
+  status.push_back("status_seq=3");
+  status.push_back("ncpus=64");
+  fail_unless(queue_mom_update("napali", status) == PBSE_NONE);
+
+  /* one apply task per shard */
+  fail_unless(queued_count == 1);
+
+  /* nothing is applied until the task runs, and then only the newest full
+   * update after the one from the mom's start */
+  fail_unless(pnode->nd_status_seq == 0);
+  decoded_status.clear();
+  apply_mom_updates(queued_arg);
+  fail_unless(pnode->nd_status_seq == 3);
+  fail_unless(pnode->nd_raw_status->size() == 2);
+  fail_unless((*pnode->nd_raw_status)["ncpus"] == "ncpus=64");
+
+  /* a delta that doesn't apply asks for a full update next time */
+  status.push_back("status_delta=7");
+  status.push_back("status_seq=8");
+  status.push_back("ncpus=8");
+  fail_unless(queue_mom_update("napali", status) == PBSE_NONE);
+  fail_unless(queued_count == 2);
+  apply_mom_updates(queued_arg);
+  fail_unless(pnode->nd_status_seq == 3);
+  fail_unless(pnode->nd_request_full_status == TRUE);
+
+  status_node = NULL;
+  }
+END_TEST
+
+
+
 Suite *process_mom_update_suite(void)
   {
   Suite *s = suite_create("process_mom_update test suite methods");
@@ -67,6 +271,15 @@ Suite *process_mom_update_suite(void)
   tc_core = tcase_create("test_two");
   tcase_add_test(tc_core, test_two);
   suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_status_delta");
+  tcase_add_test(tc_core, test_status_delta);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_coalesce_mom_updates");
+  tcase_add_test(tc_core, test_coalesce_mom_updates);
+  tcase_add_test(tc_core, test_queue_mom_update);
+  suite_add_tcase(s, tc_core);
   
   return(s);
   }
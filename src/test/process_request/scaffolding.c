@@ -253,6 +253,12 @@ void req_commit(struct batch_request *preq)
   exit(1);
   }
 
+int req_submitjob(struct batch_request *preq)
+  {
+  fprintf(stderr, "The call to req_submitjob needs to be mocked!!\n");
+  exit(1);
+  }
+
 void reply_free(struct batch_reply *prep) {}
 
 void free_attrlist(tlist_head *pattrlisthead) 
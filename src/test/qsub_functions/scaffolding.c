@@ -5,10 +5,13 @@
 #include <time.h>
 #include "u_hash_map_structs.h"
 #include "port_forwarding.h"
+#include <string>
+#include <vector>
 
 int pbs_errno = 0; 
 char *pbs_server = NULL;
 bool exit_called = false;
+std::vector<std::string> added_opts;
 
 
 char *pbs_geterrmsg(int connect)
@@ -19,8 +22,7 @@ char *pbs_geterrmsg(int connect)
 
 int hash_find(job_data_container *head, const char *name, job_data **env_var)
   {
-  fprintf(stderr, "The call to hash_find to be mocked!!\n");
-  exit(1);
+  return(0);
   }
 
 int TShowAbout_exit(void)
@@ -43,8 +45,7 @@ int parse_destination_id(char *destination_in, char **queue_name_out, char **ser
 
 int check_job_name(char *name, int chk_alpha)
   {
-  fprintf(stderr, "The call to check_job_name to be mocked!!\n");
-  exit(1);
+  return(0);
   }
 
 int hash_add_hash(job_data_container *dest, job_data_container *src, int overwrite_existing)
@@ -182,8 +183,7 @@ void hash_add_or_exit(
   int                 var_type)             /* I - Sets the type of the variable */
 
   {
-  fprintf(stderr, "The call to hash_add_or_exit to be mocked!!\n");
-  exit(1);
+  added_opts.push_back(std::string(name) + "=" + val);
   }
 
 void set_env_opts(job_data_container *env_attr, char **envp)
@@ -224,6 +224,12 @@ int cnt2server(const char *SpecServer)
   fprintf(stderr, "The call to cnt2server to be mocked!!\n");
   exit(1);
   }
+
+int pbs_submit_bulk(int connect, struct pbs_bulk_job *jobs, int job_count, char *extend)
+  {
+  fprintf(stderr, "The call to pbs_submit_bulk to be mocked!!\n");
+  exit(1);
+  }
 }
 
 int pbs_submit_hash(
@@ -4,11 +4,26 @@
  * that breaks STL basic_ios.h class definition
  */
 #include "qsub_functions.h"
+#include "pbs_ifl.h"
+#include "pbs_constants.h"
+#include "pbs_error.h"
 
 #include "test_qsub_functions.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+extern std::vector<std::string> added_opts;
+extern int J_opt;
+extern int P_opt;
+
+bool opt_added(const char *opt)
+  {
+  return(std::find(added_opts.begin(), added_opts.end(), opt) != added_opts.end());
+  }
 
 START_TEST(test_x11_get_proto_1)
   {
@@ -58,9 +73,9 @@ END_TEST
 
 START_TEST(test_make_argv)
   {
-#define MAX_ARGV_LEN 16
+#define TEST_ARGV_LEN 16
   int argc;
-  char *vect[MAX_ARGV_LEN + 1] = {};
+  char *vect[TEST_ARGV_LEN + 1] = {};
 
   /* 0: "qsub"         1            2                3                     4    5    6   7 8 */
   char const * line = "simple_arg \"quoted ' arg\" \'s\"quoted \" arg\' \\\\ \\\" \\\' \\  end";
@@ -93,6 +108,84 @@ START_TEST(test_make_argv)
   }
 END_TEST
 
+START_TEST(test_get_manifest_opt)
+  {
+  int   argc;
+  char *argv[6];
+
+  argv[0] = (char *)"qsub";
+  argv[1] = (char *)"-q";
+  argv[2] = (char *)"batch";
+  argv[3] = NULL;
+  argc = 3;
+  fail_unless(get_manifest_opt(&argc, argv) == NULL);
+  fail_unless(argc == 3);
+
+  argv[3] = (char *)"--manifest=jobs.txt";
+  argv[4] = NULL;
+  argc = 4;
+  fail_unless(strcmp(get_manifest_opt(&argc, argv), "jobs.txt") == 0);
+  fail_unless(argc == 3);
+  fail_unless(argv[3] == NULL);
+
+  argv[1] = (char *)"--manifest";
+  argv[2] = (char *)"-";
+  argv[3] = (char *)"-z";
+  argv[4] = NULL;
+  argc = 4;
+  fail_unless(strcmp(get_manifest_opt(&argc, argv), "-") == 0);
+  fail_unless(argc == 2);
+  fail_unless(strcmp(argv[1], "-z") == 0);
+  fail_unless(argv[2] == NULL);
+  }
+END_TEST
+
+START_TEST(test_manifest_lines)
+  {
+  char     *argv[] = { (char *)"qsub", (char *)"-q", (char *)"batch", NULL };
+  char     *line_argv[MAX_ARGV_LEN + 1] = {};
+  char     *job_argv[MAX_ARGV_LEN + 1];
+  char      line1[] = "-J 1-2 -P bob -N first one.sh";
+  char      line2[] = "-N second -q fast two.sh";
+  char      line3[] = "-N third three.sh";
+  int       job_argc;
+  job_info  ji;
+
+  fail_unless(manifest_job_argv(3, argv, line1, line_argv, &job_argc, job_argv) == PBSE_NONE);
+  fail_unless(job_argc == 10);
+  fail_unless(strcmp(job_argv[2], "batch") == 0);
+  fail_unless(strcmp(job_argv[3], "-J") == 0);
+  fail_unless(job_argv[10] == NULL);
+
+  reset_job_parse_state();
+  process_opts(job_argc, job_argv, &ji, CMDLINE_DATA);
+  fail_unless(J_opt == TRUE);
+  fail_unless(P_opt == TRUE);
+  fail_unless(opt_added("destination=batch"));
+  fail_unless(opt_added(ATTR_N "=first"));
+
+  /* the second job shares none of the first one's options */
+  added_opts.clear();
+  fail_unless(manifest_job_argv(3, argv, line2, line_argv, &job_argc, job_argv) == PBSE_NONE);
+  fail_unless(job_argc == 8);
+
+  reset_job_parse_state();
+  fail_unless(J_opt == FALSE);
+  fail_unless(P_opt == FALSE);
+  process_opts(job_argc, job_argv, &ji, CMDLINE_DATA);
+  fail_unless(J_opt == FALSE);
+  fail_unless(P_opt == FALSE);
+  fail_unless(opt_added(ATTR_N "=second"));
+  fail_unless(opt_added("destination=fast"));
+  fail_unless(!opt_added(ATTR_N "=first"));
+  fail_unless(added_opts.size() == 3);
+  fail_unless(optind == 7);
+
+  /* qsub's arguments and the line's must fit together */
+  fail_unless(manifest_job_argv(MAX_ARGV_LEN - 1, job_argv, line3, line_argv, &job_argc, job_argv) == PBSE_IVALREQ);
+  }
+END_TEST
+
 Suite *qsub_functions_suite(void)
   {
   Suite *s = suite_create("qsub_functions methods");
@@ -108,6 +201,14 @@ Suite *qsub_functions_suite(void)
   tcase_add_test(tc_core, test_make_argv);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_get_manifest_opt");
+  tcase_add_test(tc_core, test_get_manifest_opt);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_manifest_lines");
+  tcase_add_test(tc_core, test_manifest_lines);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
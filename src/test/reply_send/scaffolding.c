@@ -88,3 +88,4 @@ void DIS_tcp_cleanup(struct tcp_chan *chan) {}
 void log_err(int errnum, const char *routine, const char *text) {}
 void log_record(int eventtype, int objclass, const char *objname, const char *text) {}
 void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
+void brp_encoded_release(struct brp_encoded *penc) {}
@@ -22,6 +22,8 @@
 #include "id_map.hpp"
 #include "completed_jobs_map.h"
 #include "resource.h"
+#include "threadpool.h" /* threadpool_t */
+#include <vector>
 
 
 int  attr_count = 0;
@@ -139,11 +141,41 @@ job_array *get_jobs_array(job **pjob)
 
 void free_nodes(job *) {}
 
+int queued_frees = 0;
+int queued_free_passes = 0;
+
+void queue_free_nodes(job *)
+  {
+  queued_frees++;
+  }
+
+int free_queued_nodes()
+  {
+  queued_free_passes++;
+  return(0);
+  }
+
 void free_br(struct batch_request *preq) {}
 
+bool set_task_ok = false;
+std::vector<work_task *> set_tasks;
+
 struct work_task *set_task(enum work_type type, long event_id, void (*func)(work_task *), void *parm, int get_lock)
   {
-  return(NULL);
+  work_task *ptask;
+
+  if (set_task_ok == false)
+    return(NULL);
+
+  ptask = (work_task *)calloc(1, sizeof(work_task));
+  ptask->wt_type = type;
+  ptask->wt_event = event_id;
+  ptask->wt_func = func;
+  ptask->wt_parm1 = parm;
+  ptask->wt_mutex = (pthread_mutex_t *)calloc(1, sizeof(pthread_mutex_t));
+  set_tasks.push_back(ptask);
+
+  return(ptask);
   }
 
 int depend_on_term(job *pjob)
@@ -339,6 +371,43 @@ void log_record(int eventtype, int objclass, const char *objname, const char *te
 
 void account_jobend(job *pjob, std::string &data) {}
 
+int acct_batches = 0;
+int journal_batches = 0;
+int enqueued = 0;
+threadpool_t *task_pool;
+std::vector<void *(*)(void *)> enqueued_funcs;
+std::vector<void *> enqueued_args;
+
+void account_batch_begin() {}
+
+void account_batch_end()
+  {
+  acct_batches++;
+  }
+
+void job_journal_begin_batch() {}
+
+unsigned long long job_journal_detach_batch()
+  {
+  return(1);
+  }
+
+int job_journal_wait(unsigned long long seq)
+  {
+  if (seq != 0)
+    journal_batches++;
+
+  return(PBSE_NONE);
+  }
+
+int enqueue_threadpool_request(void *(*func)(void *), void *arg, threadpool_t *tp)
+  {
+  enqueued++;
+  enqueued_funcs.push_back(func);
+  enqueued_args.push_back(arg);
+  return(PBSE_NONE);
+  }
+
 void update_array_values(job_array *pa, int old_state, enum ArrayEventsEnum event, const char *job_id, long job_atr_hold, int job_exit_status) {}
 
 id_map::id_map() {}
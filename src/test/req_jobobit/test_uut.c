@@ -12,6 +12,7 @@
 #include "server.h"
 #include "work_task.h"
 #include "completed_jobs_map.h"
+#include <vector>
 
 
 char *setup_from(job *pjob, const char *suffix);
@@ -57,6 +58,13 @@ extern bool purged;
 extern long disable_requeue;
 extern int  attr_count;
 extern int  next_count;
+extern int  acct_batches;
+extern int  journal_batches;
+extern bool set_task_ok;
+extern std::vector<work_task *> set_tasks;
+extern int  enqueued;
+extern std::vector<void *(*)(void *)> enqueued_funcs;
+extern std::vector<void *> enqueued_args;
 
 
 void init_server()
@@ -192,6 +200,93 @@ END_TEST
 
 
 
+START_TEST(obit_stats_test)
+  {
+  struct timeval start;
+  char           buf[512];
+
+  gettimeofday(&start, NULL);
+  start.tv_sec -= 2;
+
+  obit_stage_done(OBIT_STAGE_EXITED, &start);
+  format_obit_stats(buf, sizeof(buf));
+
+  fail_unless(strstr(buf, "batches=") == buf, buf);
+  fail_unless(strstr(buf, " exited=1/2") != NULL, buf);
+  fail_unless(strstr(buf, " complete=0/0.0/0.0") != NULL, buf);
+  }
+END_TEST
+
+
+
+
+START_TEST(queue_obit_test)
+  {
+  bad_job = 1;
+  enqueued = 0;
+  acct_batches = 0;
+  journal_batches = 0;
+  enqueued_funcs.clear();
+  enqueued_args.clear();
+  set_task_ok = true;
+  set_tasks.clear();
+
+  /* only the first obituary of a batch starts a task */
+  queue_obit("1.napali");
+  queue_obit("2.napali");
+  fail_unless(enqueued == 1);
+
+  /* each exit is a task of its own */
+  fail_unless(process_obit_batch() == 2);
+  fail_unless(enqueued == 3);
+  fail_unless(process_obit_batch() == 0);
+
+  /* an exit's accounting is written when it is done, its journal wait is
+   * left to the batch but set to happen within OBIT_BATCH_HOLD_SECS */
+  enqueued_funcs[1](enqueued_args[1]);
+  fail_unless(acct_batches == 1);
+  fail_unless(journal_batches == 0);
+  fail_unless(set_tasks.size() == 1);
+  fail_unless(set_tasks[0]->wt_type == WORK_Timed);
+
+  /* the flush task doesn't wait for the slow exit */
+  set_tasks[0]->wt_func(set_tasks[0]);
+  fail_unless(journal_batches == 1);
+
+  enqueued_funcs[2](enqueued_args[2]);
+  fail_unless(acct_batches == 2);
+  fail_unless(journal_batches == 2);
+  fail_unless(set_tasks.size() == 1);
+
+  /* the last exit doesn't wait for a flush task either */
+  queue_obit("3.napali");
+  queue_obit("4.napali");
+  fail_unless(enqueued == 4);
+  fail_unless(process_obit_batch() == 2);
+  enqueued_funcs[4](enqueued_args[4]);
+  fail_unless(set_tasks.size() == 2);
+  enqueued_funcs[5](enqueued_args[5]);
+  fail_unless(acct_batches == 4);
+  fail_unless(journal_batches == 3);
+  set_tasks[1]->wt_func(set_tasks[1]);
+  fail_unless(journal_batches == 3);
+
+  /* nor does a batch of one */
+  queue_obit("5.napali");
+  fail_unless(process_obit_batch() == 1);
+  enqueued_funcs[7](enqueued_args[7]);
+  fail_unless(acct_batches == 5);
+  fail_unless(journal_batches == 4);
+  fail_unless(set_tasks.size() == 2);
+
+  set_task_ok = false;
+  bad_job = 0;
+  }
+END_TEST
+
+
+
+
 START_TEST(handle_exiting_or_abort_substate_test)
   {
   job            pjob;
@@ -639,6 +734,8 @@ Suite *req_jobobit_suite(void)
   tcase_add_test(tc_core, update_substate_from_exit_status_test);
   tcase_add_test(tc_core, handle_stagedel_test);
   tcase_add_test(tc_core, get_used_test);
+  tcase_add_test(tc_core, obit_stats_test);
+  tcase_add_test(tc_core, queue_obit_test);
   suite_add_tcase(s, tc_core);
 
   return(s);
@@ -431,3 +431,11 @@ int get_svr_attr_l(
   {
   return(0);
   }
+
+int refresh_node_status(
+
+  struct pbsnode *np)
+
+  {
+  return(0);
+  }
@@ -34,7 +34,6 @@ char *path_spool;
 struct server server;
 const char *msg_daemonname = "unset";
 int LOGLEVEL = 7; /* force logging code to be exercised as tests run */
-user_info_holder users;
 threadpool_t *task_pool;
 char str_to_set[1024];
 long long_to_set = -1;
@@ -362,15 +361,7 @@ int  can_queue_new_job(char *user_name, job *pjob)
   return(0);
   }
 
-int  increment_queued_jobs(user_info_holder *uih, char *user_name, job *pjob)
-  {
-  return(0);
-  }
-
-int  decrement_queued_jobs(user_info_holder *uih, char *user_name, job *pjob)
-  {
-  return(0);
-  }
+void remove_user_usage(job *pjob) {}
 
 ssize_t write_ac_socket(int fd, const void *buf, ssize_t count)
   {
@@ -441,3 +432,15 @@ void log_ext(int i, char const* s, char const* s2, int i2)
   }
 
 std::string get_path_jobdata(const char *a, const char *b) {return "";}
+
+batch_request *alloc_br(int type)
+  {
+  fprintf(stderr, "The call to alloc_br to be mocked!!\n");
+  exit(1);
+  }
+
+int reply_send(struct batch_request *request)
+  {
+  fprintf(stderr, "The call to reply_send to be mocked!!\n");
+  exit(1);
+  }
@@ -11,6 +11,8 @@
 #include "array.h" /* job_array */
 #include "work_task.h" /* work_task */
 #include "queue.h"
+#include "threadpool.h" /* threadpool_t */
+#include "req_register.h" /* local_depend_batch */
 
 const char *msg_illregister = "Illegal op in register request received for job %s";
 const char *msg_registerdel = "Job deleted as result of dependency on job %s";
@@ -334,6 +336,15 @@ int safe_strncat(char *str, const char *to_append, size_t space_remaining)
   return(0);
   }
 
+threadpool_t *task_pool;
+std::vector<local_depend_batch *> queued_depend_batches;
+
+int enqueue_threadpool_request(void *(*func)(void *), void *arg, threadpool_t *tp)
+  {
+  queued_depend_batches.push_back((local_depend_batch *)arg);
+  return(0);
+  }
+
 pbs_net_t get_hostaddr(
 
   int  *local_errno, /* O */    
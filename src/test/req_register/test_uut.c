@@ -18,7 +18,7 @@ struct depend_job *make_dependjob(struct depend *pdep, char *jobid, char *host);
 struct depend_job *find_dependjob(struct depend *pdep, char *name);
 int register_sync(struct depend *pdep, char *child, char *host, long cost);
 int register_dep(pbs_attribute *pattr, batch_request *preq, int type, int *made);
-int unregister_dep(pbs_attribute *pattr, batch_request *preq);
+int unregister_dep(pbs_attribute *pattr, struct rq_register *preg);
 void del_depend(struct depend *pd);
 int comp_depend(pbs_attribute *a1, pbs_attribute *a2);
 void free_depend(pbs_attribute *pattr);
@@ -29,13 +29,13 @@ void cat_jobsvr(char **Dest, char *Src);
 int decode_depend(pbs_attribute *pattr, const char *name, const char *rescn, const char *val, int perm);
 int encode_depend(pbs_attribute *pattr, tlist_head *phead, const char *atname, const char *rsname, int mode, int perm);
 int set_depend(pbs_attribute *attr, pbs_attribute *new_attr, enum batch_op op);
-int unregister_sync(pbs_attribute *attr, batch_request *preq);
+int unregister_sync(pbs_attribute *attr, struct rq_register *preg);
 int register_before_dep(batch_request *preq, job *pjob, int type);
 int register_dependency(batch_request *preq, job *pjob, int type);
-int release_before_dependency(batch_request *preq, job *pjob, int type);
-int release_syncwith_dependency(batch_request *preq, job *pjob);
+int release_before_dependency(struct rq_register *preg, job *pjob, int type);
+int release_syncwith_dependency(struct rq_register *preg, job *pjob);
 void set_depend_hold(job *pjob, pbs_attribute *pattr);
-int delete_dependency_job(batch_request *preq, job **pjob_ptr);
+int delete_dependency_job(struct rq_register *preg, job **pjob_ptr);
 int req_register(batch_request *preq);
 bool remove_array_dependency_job_from_job(struct array_depend *pdep, job *pjob, char *job_array_id);
 void removeAfterAnyDependency(const char *pJobID, const char *targetJob);
@@ -307,12 +307,12 @@ START_TEST(unregister_dep_test)
 
   initialize_depend_attr(&pattr);
 
-  fail_unless(unregister_dep(&pattr, &preq) == PBSE_IVALREQ, "didn't error on non-existent dep");
+  fail_unless(unregister_dep(&pattr, &preq.rq_ind.rq_register) == PBSE_IVALREQ, "didn't error on non-existent dep");
 
   pdep = make_depend(5, &pattr);
   make_dependjob(pdep, job1, host);
 
-  fail_unless(unregister_dep(&pattr, &preq) == PBSE_NONE, "didn't unregister");
+  fail_unless(unregister_dep(&pattr, &preq.rq_ind.rq_register) == PBSE_NONE, "didn't unregister");
   }
 END_TEST
 
@@ -542,9 +542,9 @@ START_TEST(unregister_sync_test)
   make_dependjob(pdep, job2, host);
   pdep->dp_released = 1;
 
-  fail_unless(unregister_sync(&pattr, &preq) == PBSE_IVALREQ, "bad name worked?");
+  fail_unless(unregister_sync(&pattr, &preq.rq_ind.rq_register) == PBSE_IVALREQ, "bad name worked?");
   strcpy(preq.rq_ind.rq_register.rq_child, job1);
-  fail_unless(unregister_sync(&pattr, &preq) == PBSE_NONE, "success");
+  fail_unless(unregister_sync(&pattr, &preq.rq_ind.rq_register) == PBSE_NONE, "success");
   }
 END_TEST*/
 
@@ -644,8 +644,8 @@ START_TEST(release_before_dependency_test)
   make_dependjob(pdep, job1, host);
   register_dependency(&preq, &pjob, JOB_DEPEND_TYPE_BEFOREOK);
 
-  fail_unless(release_before_dependency(&preq, &pjob, JOB_DEPEND_TYPE_BEFOREOK) == PBSE_NONE);
-  fail_unless(release_before_dependency(&preq, &pjob, JOB_DEPEND_TYPE_BEFOREOK) == PBSE_IVALREQ);
+  fail_unless(release_before_dependency(&preq.rq_ind.rq_register, &pjob, JOB_DEPEND_TYPE_BEFOREOK) == PBSE_NONE);
+  fail_unless(release_before_dependency(&preq.rq_ind.rq_register, &pjob, JOB_DEPEND_TYPE_BEFOREOK) == PBSE_IVALREQ);
   }
 END_TEST
 
@@ -662,13 +662,13 @@ START_TEST(release_syncwith_dependency_test)
   pattr = &pjob.ji_wattr[JOB_ATR_depend];
   initialize_depend_attr(pattr);
 
-  fail_unless(release_syncwith_dependency(&preq, &pjob) == PBSE_NOSYNCMSTR);
+  fail_unless(release_syncwith_dependency(&preq.rq_ind.rq_register, &pjob) == PBSE_NOSYNCMSTR);
 
   pdep = make_depend(JOB_DEPEND_TYPE_SYNCWITH, pattr);
   make_dependjob(pdep, job1, host);
   pdep->dp_released = 0;
   
-  fail_unless(release_syncwith_dependency(&preq, &pjob) == PBSE_NONE);
+  fail_unless(release_syncwith_dependency(&preq.rq_ind.rq_register, &pjob) == PBSE_NONE);
   }
 END_TEST
 
@@ -713,15 +713,87 @@ START_TEST(delete_dependency_job_test)
   strcpy(preq.rq_ind.rq_register.rq_parent, job1);
   strcpy(preq.rq_ind.rq_register.rq_child, job1);
 
-  fail_unless(delete_dependency_job(&preq, &pjob) == PBSE_IVALREQ);
+  fail_unless(delete_dependency_job(&preq.rq_ind.rq_register, &pjob) == PBSE_IVALREQ);
   strcpy(preq.rq_ind.rq_register.rq_child, job2);
-  fail_unless(delete_dependency_job(&preq, &pjob) == PBSE_NONE);
+  fail_unless(delete_dependency_job(&preq.rq_ind.rq_register, &pjob) == PBSE_NONE);
   fail_unless(pjob == NULL);
   }
 END_TEST
 
 
 extern job *pGlobalJob;
+extern std::vector<local_depend_batch *> queued_depend_batches;
+
+START_TEST(depend_on_term_local_test)
+  {
+  job           *pjob = job_alloc();
+  struct depend *pdep;
+  char           jobid[PBS_MAXSVRJOBID + 1];
+  unsigned int   queued = 0;
+
+  strcpy(server_name, host);
+  strcpy(pjob->ji_qs.ji_jobid, "3.napali");
+  initialize_depend_attr(&pjob->ji_wattr[JOB_ATR_depend]);
+  pdep = make_depend(JOB_DEPEND_TYPE_BEFOREANY, &pjob->ji_wattr[JOB_ATR_depend]);
+
+  for (int i = 0; i < 300; i++)
+    {
+    snprintf(jobid, sizeof(jobid), "%d.napali", 100 + i);
+    make_dependjob(pdep, jobid, host);
+    }
+
+  queued_depend_batches.clear();
+
+  /* jobs of this server are released without any request, in batches */
+  fail_unless(depend_on_term(pjob) == PBSE_NONE);
+  fail_unless(queued_depend_batches.size() == 3);
+
+  for (unsigned int i = 0; i < queued_depend_batches.size(); i++)
+    {
+    fail_unless(queued_depend_batches[i]->sender == "3.napali");
+    fail_unless(queued_depend_batches[i]->ops.size() <= LOCAL_DEPEND_BATCH_SIZE);
+    fail_unless(queued_depend_batches[i]->ops[0].op == JOB_DEPEND_OP_RELEASE);
+    queued += queued_depend_batches[i]->ops.size();
+    }
+
+  fail_unless(queued == 300);
+  fail_unless(queued_depend_batches[0]->ops[0].target == "100.napali");
+  fail_unless(queued_depend_batches[2]->ops.back().target == "399.napali");
+  }
+END_TEST
+
+
+START_TEST(apply_local_depend_op_test)
+  {
+  job             *pjob = job_alloc();
+  struct depend   *pdep;
+  local_depend_op  dop;
+
+  strcpy(server_name, host);
+  strcpy(pjob->ji_qs.ji_jobid, "5.napali");
+  initialize_depend_attr(&pjob->ji_wattr[JOB_ATR_depend]);
+  pdep = make_depend(JOB_DEPEND_TYPE_AFTEROK, &pjob->ji_wattr[JOB_ATR_depend]);
+  make_dependjob(pdep, (char *)"4.napali", host);
+
+  dop.target = "6.napali";
+  dop.type = JOB_DEPEND_TYPE_BEFOREOK;
+  dop.op = JOB_DEPEND_OP_RELEASE;
+  dop.cost = 0;
+
+  fail_unless(apply_local_depend_op("4.napali", dop) == PBSE_UNKJOBID);
+
+  pGlobalJob = pjob;
+  dop.target = "5.napali";
+
+  /* the sender's afterok is satisfied */
+  fail_unless(apply_local_depend_op("4.napali", dop) == PBSE_NONE);
+  fail_unless(find_depend(JOB_DEPEND_TYPE_AFTEROK, &pjob->ji_wattr[JOB_ATR_depend]) == NULL);
+  fail_unless(apply_local_depend_op("4.napali", dop) == PBSE_IVALREQ);
+
+  pGlobalJob = NULL;
+  }
+END_TEST
+
 
 START_TEST(remove_after_any_test)
   {
@@ -823,6 +895,8 @@ Suite *req_register_suite(void)
   tcase_add_test(tc_core, release_syncwith_dependency_test);
   tcase_add_test(tc_core, set_depend_hold_test);
   tcase_add_test(tc_core, delete_dependency_job_test);
+  tcase_add_test(tc_core, depend_on_term_local_test);
+  tcase_add_test(tc_core, apply_local_depend_op_test);
   tcase_add_test(tc_core, remove_after_any_test);
   tcase_add_test(tc_core, req_register_test);
   tcase_add_test(tc_core, set_array_depend_holds_test);
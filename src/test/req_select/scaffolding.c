@@ -11,6 +11,7 @@
 #include "batch_request.h" /* batch_request */
 
 #include "svrfunc.h" /* stat_cntl */
+#include "job_select_index.h"
 
 int svr_resc_size = 0;
 attribute_def job_attr_def[10];
@@ -163,3 +164,12 @@ int unlock_ji_mutex(job *pjob, const char *id, const char *msg, int logging)
 void log_err(int errnum, const char *routine, const char *text) {}
 void log_record(int eventtype, int objclass, const char *objname, const char *text) {}
 void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
+
+job *find_job_in_registry(const char *job_id, int get_subjob)
+  {
+  return(NULL);
+  }
+
+void get_job_ids(all_jobs *aj, std::vector<std::string> &ids) {}
+
+void job_index_lookup(int kind, const std::vector<std::string> &keys, std::vector<std::string> &job_ids) {}
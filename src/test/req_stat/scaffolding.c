@@ -1,6 +1,7 @@
 #include "license_pbs.h" /* See here for the software license */
 #include <stdlib.h>
 #include <stdio.h> /* fprintf */
+#include <string.h> /* memset */
 #include <pthread.h> /* pthread_mutex_t */
 
 #include "pbs_nodes.h" /* all_nodes, pbsnode */
@@ -13,6 +14,8 @@
 #include "list_link.h" /* tlist_head, list_link */
 #include "work_task.h" /* work_task, work_type */
 #include "u_tree.h" /* AvlTree */
+#include "threadpool.h" /* threadpool_t, tp_stats_t */
+#include "job_delta.h" /* job_delta_purged */
 #include "queue.h"
 
 all_nodes allnodes;
@@ -56,8 +59,13 @@ void svr_mailowner(job *pjob, int mailpoint, int force, const char *text)
 
 svrattrl *attrlist_create(const char *aname, const char *rname, int vsize)
   {
-  fprintf(stderr, "The call to attrlist_create to be mocked!!\n");
-  exit(1);
+  svrattrl *pal = (svrattrl *)calloc(1, sizeof(svrattrl));
+
+  CLEAR_LINK(pal->al_link);
+  pal->al_name = strdup(aname);
+  pal->al_value = (char *)calloc(1, vsize);
+
+  return(pal);
   }
 
 int modify_job_attr(job *pjob, svrattrl *plist, int perm, int *bad)
@@ -138,6 +146,16 @@ job *next_job(all_jobs *aj, all_jobs_iterator *iter)
   return(NULL);
   }
 
+void get_job_ids(all_jobs *aj, std::vector<std::string> &ids) {}
+
+job *find_job_in_registry(const char *job_id, int get_subjob)
+  {
+  job *pjob = (job *)calloc(1, sizeof(job));
+  strcpy(pjob->ji_qs.ji_jobid, job_id);
+  strcpy(pjob->ji_qs.ji_queue, "batch");
+  return(pjob);
+  }
+
 void rel_resc(job *pjob)
   {
   }
@@ -168,8 +186,7 @@ int job_abt(struct job **pjobp, const char *text, bool b=false)
 
 void *get_next(list_link pl, char *file, int line)
   {
-  fprintf(stderr, "The call to get_next to be mocked!!\n");
-  exit(1);
+  return(pl.ll_next->ll_struct);
   }
 
 int issue_Drequest(int conn, struct batch_request *request, bool close_handle)
@@ -190,6 +207,62 @@ struct pbsnode *AVL_find(u_long key, uint16_t port, AvlTree tree)
   exit(1);
   }
 
+unsigned long long             delta_seq = 100;
+bool                           delta_complete = true;
+std::vector<job_delta_purged>  delta_purged;
+
+unsigned long long job_delta_get_seq()
+  {
+  return(delta_seq);
+  }
+
+bool job_delta_get_purged(unsigned long long since, std::vector<job_delta_purged> &purged)
+  {
+  for (unsigned int i = 0; (delta_complete == true) && (i < delta_purged.size()); i++)
+    if (delta_purged[i].seq > since)
+      purged.push_back(delta_purged[i]);
+
+  return(delta_complete);
+  }
+
+bool job_delta_parse_extend(const char *extend, unsigned long long *since)
+  {
+  return(false);
+  }
+
+threadpool_t *request_pool;
+threadpool_t *task_pool;
+threadpool_t *async_pool;
+
+void get_threadpool_stats(threadpool_t *tp, tp_stats_t *stats)
+  {
+  memset(stats, 0, sizeof(tp_stats_t));
+
+  if (tp == request_pool)
+    {
+    stats->threads = 10;
+    stats->queued = 3;
+    }
+  }
+
+void get_job_status_cache_stats(unsigned long *hits, unsigned long *misses, long *entries, long *bytes)
+  {
+  *hits = 3;
+  *misses = 1;
+  *entries = 1;
+  *bytes = 512;
+  }
+
+void format_obit_stats(char *buf, int buf_len)
+  {
+  snprintf(buf, buf_len, "batches=0");
+  }
+
+void format_user_usage(std::string &out)
+  {
+  out = "dbeer:1/1/8,dbeer@batch:1/1/8";
+  }
+
 void netcounter_get(int netrates[])
   {
   fprintf(stderr, "The call to netcounter_get to be mocked!!\n");
@@ -210,8 +283,11 @@ void release_req(struct work_task *pwt)
 
 void append_link(tlist_head *head, list_link *new_link, void *pobj)
   {
-  fprintf(stderr, "The call to append_link to be mocked!!\n");
-  exit(1);
+  new_link->ll_struct = pobj;
+  new_link->ll_prior = head->ll_prior;
+  new_link->ll_next = head;
+  head->ll_prior->ll_next = new_link;
+  head->ll_prior = new_link;
   }
 
 pbs_queue *next_queue(all_queues *aq, all_queues_iterator *iter)
@@ -344,3 +420,15 @@ void log_record(int eventtype, int objclass, const char *objname, const char *te
 void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
 
 int svr_unresolvednodes = 0;
+
+int find_attr(struct attribute_def *attr_def, const char *name, int limit)
+  {
+  for (int i = 0; i < limit; i++)
+    {
+    if ((attr_def[i].at_name != NULL) &&
+        (!strcasecmp(attr_def[i].at_name, name)))
+      return(i);
+    }
+
+  return(-1);
+  }
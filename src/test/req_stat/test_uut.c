@@ -5,9 +5,11 @@
 #include <stdio.h>
 #include "pbs_error.h"
 #include "array.h"
+#include "threadpool.h"
+#include "job_delta.h"
 
 bool in_execution_queue(job *pjob, job_array *pa);
-job *get_next_status_job(struct stat_cntl *cntl, int &job_array_index, job_array *pa, all_jobs_iterator *iter);
+job *get_next_status_job(struct stat_cntl *cntl, int &job_index, job_array *pa, all_jobs_iterator *iter, std::vector<std::string> &job_ids);
 extern int abort_called;
 
 enum TJobStatTypeEnum
@@ -66,6 +68,7 @@ START_TEST(test_get_next_status_job)
   struct stat_cntl cntl;
   int              array_index = -1;
   pbs_queue        pque;
+  std::vector<std::string> job_ids;
 
   job_array *pa = (job_array *)calloc(1, sizeof(job_array));
   pa->ai_qs.array_size = 2;
@@ -73,40 +76,163 @@ START_TEST(test_get_next_status_job)
   pa->job_ids[0] = strdup("1[0].napali");
   pa->job_ids[1] = strdup("1[1].napali");
 
-  // next job is currently set to return NULL every time, so all of these are NULL
+  // next job is currently set to return NULL every time and there are no ids,
+  // so all of these are NULL
   cntl.sc_type = tjstQueue;
   cntl.sc_pque = &pque;
-  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL) == NULL);
+  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL, job_ids) == NULL);
 
   cntl.sc_type = tjstSummarizeArraysQueue;
-  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL) == NULL);
+  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL, job_ids) == NULL);
 
   cntl.sc_type = tjstSummarizeArraysServer;
-  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL) == NULL);
+  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL, job_ids) == NULL);
 
   cntl.sc_type = tjstServer;
-  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL) == NULL);
+  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL, job_ids) == NULL);
+
+  // jobs from the snapshot are only returned while they're in the queue
+  job_ids.push_back("2.napali");
+  job_ids.push_back("3.napali");
+  strcpy(pque.qu_qs.qu_name, "batch");
+  array_index = -1;
+  cntl.sc_type = tjstQueue;
+  job *pjob = get_next_status_job(&cntl, array_index, pa, NULL, job_ids);
+  fail_unless(pjob != NULL);
+  fail_unless(array_index == 0);
+  fail_unless(!strcmp(pjob->ji_qs.ji_jobid, "2.napali"));
+
+  strcpy(pque.qu_qs.qu_name, "other");
+  fail_unless(get_next_status_job(&cntl, array_index, pa, NULL, job_ids) == NULL);
+  fail_unless(array_index == 2);
+
+  array_index = -1;
+  cntl.sc_type = tjstServer;
+  pjob = get_next_status_job(&cntl, array_index, pa, NULL, job_ids);
+  fail_unless(pjob != NULL);
+  fail_unless(!strcmp(pjob->ji_qs.ji_jobid, "2.napali"));
 
   // these should grab the jobs from the array
+  array_index = -1;
   cntl.sc_type = tjstArray;
-  job *pjob = get_next_status_job(&cntl, array_index, pa, NULL);
+  pjob = get_next_status_job(&cntl, array_index, pa, NULL, job_ids);
   fail_unless(pjob != NULL);
   fail_unless(array_index == 0);
   fail_unless(!strcmp(pjob->ji_qs.ji_jobid, "1[0].napali"));
   
-  pjob = get_next_status_job(&cntl, array_index, pa, NULL);
+  pjob = get_next_status_job(&cntl, array_index, pa, NULL, job_ids);
   fail_unless(pjob != NULL);
   fail_unless(array_index == 1);
   fail_unless(!strcmp(pjob->ji_qs.ji_jobid, "1[1].napali"));
   
   // we are now past the number of jobs in the array, this should return NULL
-  pjob = get_next_status_job(&cntl, array_index, pa, NULL);
+  pjob = get_next_status_job(&cntl, array_index, pa, NULL, job_ids);
   fail_unless(pjob == NULL);
   fail_unless(array_index == 2);
   }
 END_TEST
 
 
+START_TEST(test_format_threadpool_stats)
+  {
+  char buf[1024];
+
+  request_pool = (threadpool_t *)calloc(1, sizeof(threadpool_t));
+  format_threadpool_stats(buf, sizeof(buf));
+
+  fail_unless(!strncmp(buf, "request_pool: threads=10 idle=0 queued=3 ", 41), buf);
+  fail_unless(strstr(buf, "; task_pool: threads=0 ") != NULL, buf);
+  fail_unless(strstr(buf, "; async_pool: threads=0 ") != NULL, buf);
+
+  /* a short buffer is truncated, not overrun */
+  format_threadpool_stats(buf, 20);
+  fail_unless(strlen(buf) == 19);
+  }
+END_TEST
+
+
+START_TEST(test_format_job_status_cache_stats)
+  {
+  char buf[256];
+
+  format_job_status_cache_stats(buf, sizeof(buf));
+
+  fail_unless(!strcmp(buf, "hits=3 misses=1 hit_rate=75% entries=1 bytes=512"), buf);
+  }
+END_TEST
+
+
+extern unsigned long long            delta_seq;
+extern bool                          delta_complete;
+extern std::vector<job_delta_purged> delta_purged;
+
+START_TEST(test_start_delta_status)
+  {
+  batch_request      preq;
+  unsigned long long since = 50;
+  job_delta_purged   purged;
+  struct brp_status *pstat;
+  svrattrl          *pal;
+
+  memset(&preq, 0, sizeof(preq));
+  CLEAR_HEAD(preq.rq_reply.brp_un.brp_status);
+  strcpy(preq.rq_user, "dbeer");
+
+  purged.seq = 40;
+  purged.jobid = "1.napali";
+  purged.owner = "dbeer@napali";
+  delta_purged.push_back(purged);
+  purged.seq = 60;
+  purged.jobid = "2.napali";
+  delta_purged.push_back(purged);
+  purged.seq = 70;
+  purged.jobid = "3.napali";
+  purged.owner = "someone@napali";
+  delta_purged.push_back(purged);
+
+  fail_unless(start_delta_status(&preq, &since) == PBSE_NONE);
+  fail_unless(since == 50);
+
+  pstat = (struct brp_status *)GET_NEXT(preq.rq_reply.brp_un.brp_status);
+  fail_unless(pstat->brp_objtype == MGR_OBJ_SERVER);
+  pal = (svrattrl *)GET_NEXT(pstat->brp_attr);
+  fail_unless(!strcmp(pal->al_name, ATTR_delta_seq));
+  fail_unless(!strcmp(pal->al_value, "100"));
+  pal = (svrattrl *)GET_NEXT(pal->al_link);
+  fail_unless(!strcmp(pal->al_name, ATTR_delta_full));
+  fail_unless(!strcmp(pal->al_value, "False"));
+
+  /* only the purge after since that this user owns */
+  pstat = (struct brp_status *)GET_NEXT(pstat->brp_stlink);
+  fail_unless(pstat != NULL);
+  fail_unless(!strcmp(pstat->brp_objname, "2.napali"));
+  pal = (svrattrl *)GET_NEXT(pstat->brp_attr);
+  fail_unless(!strcmp(pal->al_name, ATTR_delta_purged));
+  fail_unless(GET_NEXT(pstat->brp_stlink) == NULL);
+
+  /* a manager sees every purge */
+  CLEAR_HEAD(preq.rq_reply.brp_un.brp_status);
+  preq.rq_perm = ATR_DFLAG_MGRD;
+  fail_unless(start_delta_status(&preq, &since) == PBSE_NONE);
+  pstat = (struct brp_status *)GET_NEXT(preq.rq_reply.brp_un.brp_status);
+  pstat = (struct brp_status *)GET_NEXT(pstat->brp_stlink);
+  pstat = (struct brp_status *)GET_NEXT(pstat->brp_stlink);
+  fail_unless(!strcmp(pstat->brp_objname, "3.napali"));
+
+  /* forgotten purges mean every job is sent */
+  CLEAR_HEAD(preq.rq_reply.brp_un.brp_status);
+  delta_complete = false;
+  fail_unless(start_delta_status(&preq, &since) == PBSE_NONE);
+  fail_unless(since == 0);
+  pstat = (struct brp_status *)GET_NEXT(preq.rq_reply.brp_un.brp_status);
+  pal = (svrattrl *)GET_NEXT(pstat->brp_attr);
+  pal = (svrattrl *)GET_NEXT(pal->al_link);
+  fail_unless(!strcmp(pal->al_value, "True"));
+  fail_unless(GET_NEXT(pstat->brp_stlink) == NULL);
+  }
+END_TEST
+
+
 Suite *req_stat_suite(void)
   {
   Suite *s = suite_create("req_stat_suite methods");
@@ -119,6 +245,15 @@ Suite *req_stat_suite(void)
   tcase_add_test(tc_core, test_get_next_status_job);
   suite_add_tcase(s, tc_core);
 
+  tc_core = tcase_create("test_start_delta_status");
+  tcase_add_test(tc_core, test_start_delta_status);
+  suite_add_tcase(s, tc_core);
+
+  tc_core = tcase_create("test_format_threadpool_stats");
+  tcase_add_test(tc_core, test_format_threadpool_stats);
+  tcase_add_test(tc_core, test_format_job_status_cache_stats);
+  suite_add_tcase(s, tc_core);
+
   return s;
   }
 
@@ -19,6 +19,7 @@
 #include "list_link.h" /* list_link, tlist_head */
 #include "power_state.hpp"
 #include "sys_file.hpp"
+#include "mom_copy.h"
 
 char *apbasil_protocol;
 char *apbasil_path;
@@ -43,6 +44,8 @@ unsigned int alarm_time = 10;
 char *TNoSpoolDirList[TMAX_NSDCOUNT];
 tlist_head svr_alljobs;
 int LOGLEVEL = 7; /* force logging code to be exercised as tests run */
+int MOMCopyStreams = 4;
+int MOMCopyVerify = 0;
 const char *msg_manager = "%s at request of %s@%s";
 int multi_mom = 1;
 char MOMUNameMissing[64];
@@ -420,3 +423,12 @@ int terminate_sisters(job *pjob, int sig)
   {
   return 0;
   }
+
+int mom_copy_init(int streams)
+  {
+  return(0);
+  }
+
+void copy_paths(std::vector<mom_copy> &copies, int streams, int verify)
+  {
+  }
@@ -67,6 +67,7 @@ unsigned int pbs_rm_port = 0;
 char DEFAULT_UMASK[1024];
 tlist_head mom_polljobs;
 long TJobStartBlockTime = 5;
+int max_concurrent_launches = 8;
 char *TNoSpoolDirList[TMAX_NSDCOUNT];
 int LOGLEVEL = 7; /* force logging code to be exercised as tests run */
 char *submithost_suffix = NULL;
@@ -94,6 +95,8 @@ int diswcs (struct tcp_chan *chan, const char *value,size_t nchars)
 int create_job_cpuset(job * pj) { return 0; }
 int DIS_tcp_wflush (struct tcp_chan *chan) { return 0; }
 int move_to_job_cpuset(pid_t, job *) { return 0; }
+bool cgroup_accounting_enabled(void) { return false; }
+int move_to_job_cgroup(pid_t, const char *) { return 0; }
 int diswsi(tcp_chan *chan, int i) { return 0; }
 int encode_DIS_svrattrl(tcp_chan *chan, svrattrl *s) { return 0; }
 int im_compose(tcp_chan *chan, char *arg2, char *a3, int a4, int a5, unsigned int a6) { return 0; }
@@ -462,6 +465,16 @@ int TMOMJobGetStartInfo(job *pjob, pjobexec_t **TJEP)
   exit(1);
   }
 
+int TMOMStartsPending(void)
+  {
+  return(0);
+  }
+
+int TMOMWaitForStarting(int Timeout)
+  {
+  return(0);
+  }
+
 void set_termcc(int fd)
   {
   fprintf(stderr, "The call to set_termcc needs to be mocked!!\n");
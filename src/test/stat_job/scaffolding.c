@@ -1,11 +1,13 @@
 #include "license_pbs.h" /* See here for the software license */
 #include <stdlib.h>
 #include <stdio.h> /* fprintf */
+#include <string.h>
 
 #include "attribute.h" /* attribute_def, svrattrl */
 #include "server.h" /* server */
 #include "batch_request.h" /* batch_request */
 #include "list_link.h" /* list_link */
+#include "tcp.h" /* tcp_chan */
 
 attribute_def job_attr_def[10];
 struct server server;
@@ -14,8 +16,15 @@ struct server server;
 
 svrattrl *attrlist_create(const char *aname, const char *rname, int vsize)
   {
-  fprintf(stderr, "The call to attrlist_create to be mocked!!\n");
-  exit(1);
+  svrattrl *pal = (svrattrl *)calloc(1, sizeof(svrattrl));
+
+  CLEAR_LINK(pal->al_link);
+  pal->al_name = strdup(aname);
+  if (rname != NULL)
+    pal->al_resc = strdup(rname);
+  pal->al_value = (char *)calloc(1, vsize);
+
+  return(pal);
   }
 
 int svr_authorize_jobreq(struct batch_request *preq, job *pjob)
@@ -32,14 +41,50 @@ int find_attr(struct attribute_def *attr_def, const char *name, int limit)
 
 void *get_next(list_link pl, char *file, int line)
   {
-  fprintf(stderr, "The call to get_next to be mocked!!\n");
-  exit(1);
+  return(pl.ll_next->ll_struct);
   }
 
 void append_link(tlist_head *head, list_link *new_link, void *pobj)
   {
-  fprintf(stderr, "The call to append_link to be mocked!!\n");
-  exit(1);
+  new_link->ll_struct = pobj;
+  new_link->ll_prior = head->ll_prior;
+  new_link->ll_next = head;
+  head->ll_prior->ll_next = new_link;
+  head->ll_prior = new_link;
+  }
+
+void delete_link(list_link *old)
+  {
+  old->ll_prior->ll_next = old->ll_next;
+  old->ll_next->ll_prior = old->ll_prior;
+  old->ll_next = old;
+  old->ll_prior = old;
+  }
+
+/* encodes just the name, enough to see what was cached where */
+int encode_DIS_svrattrl_entry(struct tcp_chan *chan, svrattrl *ps)
+  {
+  size_t len = strlen(ps->al_name);
+
+  memcpy(chan->writebuf.tdis_leadp, ps->al_name, len);
+  chan->writebuf.tdis_leadp += len;
+
+  return(0);
+  }
+
+struct brp_encoded *brp_encoded_hold(struct brp_encoded *penc)
+  {
+  if (penc != NULL)
+    penc->be_refs++;
+
+  return(penc);
+  }
+
+void brp_encoded_release(struct brp_encoded *penc)
+  {
+  if ((penc != NULL) &&
+      (--penc->be_refs == 0))
+    free(penc);
   }
 
 int get_svr_attr_l(int index, long *l)
@@ -4,8 +4,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <string.h>
+
 #include "pbs_error.h"
 #include "pbs_job.h"
+#include "libpbs.h"
 
 bool include_in_status(int index);
 
@@ -38,10 +41,85 @@ START_TEST(test_include_in_status)
   }
 END_TEST
 
-START_TEST(test_two)
+START_TEST(test_status_cache_key)
   {
+  svrattrl *pal = attrlist_create("Job_Name", NULL, 1);
+  unsigned long key = status_cache_key(NULL, ATR_DFLAG_USRD, 1, false);
+
+  fail_unless(key == status_cache_key(NULL, ATR_DFLAG_USRD, 1, false));
+  /* only the read permissions matter */
+  fail_unless(key == status_cache_key(NULL, ATR_DFLAG_USRD | ATR_DFLAG_USWR, 1, false));
+  fail_unless(key != status_cache_key(NULL, ATR_DFLAG_USRD | ATR_DFLAG_MGRD, 1, false));
+  fail_unless(key != status_cache_key(NULL, ATR_DFLAG_USRD, 0, false));
+  fail_unless(key != status_cache_key(NULL, ATR_DFLAG_USRD, 1, true));
+  fail_unless(key != status_cache_key(pal, ATR_DFLAG_USRD, 1, false));
+  }
+END_TEST
 
 
+START_TEST(test_cache_job_status)
+  {
+  job                *pjob = (job *)calloc(1, sizeof(job));
+  struct brp_status   pstat;
+  struct brp_encoded *old;
+  svrattrl           *pal;
+  unsigned long       hits;
+  unsigned long       misses;
+  long                entries;
+  long                bytes;
+
+  memset(&pstat, 0, sizeof(pstat));
+  CLEAR_HEAD(pstat.brp_attr);
+
+  pal = attrlist_create("aa", NULL, 1);
+  append_link(&pstat.brp_attr, &pal->al_link, pal);
+  pal = attrlist_create("Walltime", "Remaining", 1);
+  append_link(&pstat.brp_attr, &pal->al_link, pal);
+  pal = attrlist_create("bbb", NULL, 1);
+  append_link(&pstat.brp_attr, &pal->al_link, pal);
+
+  pjob->ji_delta_seq = 7;
+
+  fail_unless(cache_job_status(pjob, &pstat, 42) == PBSE_NONE);
+  fail_unless(pjob->ji_status_cache != NULL);
+  fail_unless(pjob->ji_status_cache_seq == 7);
+  fail_unless(pjob->ji_status_cache_key == 42);
+  fail_unless(pjob->ji_status_cache_walltime == true);
+
+  /* walltime remaining stays in the list and goes between the cached entries */
+  fail_unless(pstat.brp_encoded == pjob->ji_status_cache);
+  fail_unless(pstat.brp_encoded->be_refs == 2);
+  fail_unless(pstat.brp_encoded->be_count == 2);
+  fail_unless(pstat.brp_encoded->be_split == 2);
+  fail_unless(pstat.brp_encoded->be_len == 5);
+  fail_unless(!memcmp(pstat.brp_encoded->be_data, "aabbb", 5));
+
+  pal = (svrattrl *)GET_NEXT(pstat.brp_attr);
+  fail_unless(pal != NULL);
+  fail_unless(!strcmp(pal->al_name, "Walltime"));
+  fail_unless(GET_NEXT(pal->al_link) == NULL);
+
+  get_job_status_cache_stats(&hits, &misses, &entries, &bytes);
+  fail_unless(entries == 1);
+  fail_unless(bytes == 5);
+
+  /* rebuilding replaces the old cache, which lives on while it is being sent */
+  old = pstat.brp_encoded;
+  fail_unless(cache_job_status(pjob, &pstat, 43) == PBSE_NONE);
+  fail_unless(pjob->ji_status_cache != old);
+  fail_unless(old->be_refs == 1);
+  brp_encoded_release(old);
+  fail_unless(pjob->ji_status_cache->be_count == 0);
+  fail_unless(pjob->ji_status_cache->be_split == 0);
+  get_job_status_cache_stats(&hits, &misses, &entries, &bytes);
+  fail_unless(entries == 1);
+  fail_unless(bytes == 0);
+
+  job_status_cache_free(pjob);
+  fail_unless(pjob->ji_status_cache == NULL);
+  get_job_status_cache_stats(&hits, &misses, &entries, &bytes);
+  fail_unless(entries == 0);
+  fail_unless(bytes == 0);
   }
 END_TEST
 
@@ -52,8 +130,9 @@ Suite *stat_job_suite(void)
   tcase_add_test(tc_core, test_include_in_status);
   suite_add_tcase(s, tc_core);
 
-  tc_core = tcase_create("test_two");
-  tcase_add_test(tc_core, test_two);
+  tc_core = tcase_create("test_status_cache_key");
+  tcase_add_test(tc_core, test_status_cache_key);
+  tcase_add_test(tc_core, test_cache_job_status);
   suite_add_tcase(s, tc_core);
 
   return s;
@@ -33,8 +33,8 @@ int LOGLEVEL = 10;
 pthread_mutex_t *svr_do_schedule_mutex;
 pthread_mutex_t *listener_command_mutex;
 struct pbsnode *alps_reporter;
-user_info_holder users;
-int decrement_count;
+int update_usage_count;
+int user_queued;
 job napali_job;
 
 
@@ -67,9 +67,6 @@ pbs_queue *find_queuebyname(const char *quename)
 
   snprintf(pq->qu_qs.qu_name, sizeof(pq->qu_qs.qu_name), "%s", quename);
 
-  /* set up the user info struct */
-  pq->qu_uih = (user_info_holder *)calloc(1, sizeof(user_info_holder));
-
   return(pq);
   }
 
@@ -106,9 +103,6 @@ pbs_queue *get_jobs_queue(job **pjob)
 
   snprintf(pq->qu_qs.qu_name, sizeof(pq->qu_qs.qu_name), "%s", "qu_name");
 
-  /* set up the user info struct */
-  pq->qu_uih = (user_info_holder *)calloc(1, sizeof(user_info_holder));
-
   return(pq);
   }
 
@@ -312,22 +306,6 @@ int lock_sv_qs_mutex(pthread_mutex_t *sv_qs_mutex, const char *msg_string)
   return(0);
   }
 
-unsigned int get_num_queued(user_info_holder *uih, const char *user_name)
-  {
-  return(0);
-  }
-
-int increment_queued_jobs(user_info_holder *uih, char *user_name, job *pjob)
-  {
-  return(0);
-  }
-
-int decrement_queued_jobs(user_info_holder *uih, char *user_name, job *pjob)
-  {
-  decrement_count++;
-  return(0);
-  }
-
 int get_jobs_index(all_jobs *aj, struct job *pjob)
   {
   return(0);
@@ -451,3 +429,24 @@ char *csv_nth(const char *csv_str, int n)
   exit(1);
   }
 
+
+void job_delta_touch(job *pjob) {}
+
+void job_registry_add(job *pjob) {}
+
+void job_index_update(job *pjob) {}
+
+void add_user_usage(job *pjob) {}
+
+void update_user_usage(job *pjob)
+  {
+  update_usage_count++;
+  }
+
+void remove_user_usage(job *pjob) {}
+
+void get_user_usage(const char *user_name, const char *queue_name, user_usage &uu)
+  {
+  memset(&uu, 0, sizeof(uu));
+  uu.queued = user_queued;
+  }
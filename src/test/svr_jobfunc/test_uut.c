@@ -17,7 +17,8 @@ int chk_mppnodect(resource *mppnodect, pbs_queue *pque, long nppn, long mpp_widt
 void job_wait_over(struct work_task *);
 bool is_valid_state_transition(job &pjob, int newstate, int newsubstate);
 
-extern int decrement_count;
+extern int update_usage_count;
+extern int user_queued;
 extern job napali_job;
 extern attribute_def job_attr_def[];
 
@@ -157,13 +158,10 @@ START_TEST(svr_setjobstate_test)
   fail_unless(svr_setjobstate(&test_job, JOB_STATE_QUEUED, JOB_SUBSTATE_QUEUED, FALSE) == PBSE_NONE);
   fail_unless(test_job.ji_wattr[JOB_ATR_exec_host].at_val.at_str != NULL, "exec_host list got removed when it shouldn't have...");
 
-  decrement_count = 0;
+  // completing a job recounts its user's usage
+  update_usage_count = 0;
   fail_unless(svr_setjobstate(&test_job, JOB_STATE_COMPLETE, JOB_SUBSTATE_COMPLETE, FALSE) == PBSE_NONE);
-  fail_unless(decrement_count == 2);
-
-  decrement_count = 0;
-  fail_unless(svr_setjobstate(&test_job, JOB_STATE_COMPLETE, JOB_SUBSTATE_COMPLETE, FALSE) == PBSE_NONE);
-  fail_unless(decrement_count == 0);
+  fail_unless(update_usage_count == 1);
   }
 END_TEST
 
@@ -402,6 +400,19 @@ START_TEST(svr_chkque_test)
   result = svr_chkque(&test_job, &test_queue, hostname, 0, NULL);
   fail_unless(result == PBSE_QUNOENB, "svr_chkque some_string fail");
 
+  /* max_user_queuable is checked against the user's queued jobs in the queue */
+  test_queue.qu_attr[QA_ATR_Enabled].at_val.at_long = 1;
+  test_queue.qu_attr[QA_ATR_MaxUserJobs].at_flags = ATR_VFLAG_SET;
+  test_queue.qu_attr[QA_ATR_MaxUserJobs].at_val.at_long = 2;
+  test_job.ji_wattr[JOB_ATR_job_owner].at_val.at_str = (char *)"tom@napali";
+  user_queued = 2;
+  result = svr_chkque(&test_job, &test_queue, hostname, 0, NULL);
+  fail_unless(result == PBSE_MAXUSERQUED, "svr_chkque max_user_queuable fail: %d", result);
+
+  user_queued = 1;
+  result = svr_chkque(&test_job, &test_queue, hostname, 0, NULL);
+  fail_unless(result != PBSE_MAXUSERQUED);
+
 
   /* must reallocate as_string for this to work.
   disallowed_types_array_strings.as_usedptr = 2;
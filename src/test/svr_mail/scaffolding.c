@@ -116,3 +116,5 @@ void log_record(int eventtype, int objclass, const char *objname, const char *te
 void log_event(int eventtype, int objclass, const char *objname, const char *text) {}
 
 
+
+int mail_spool_add(mail_info *mi, const char *array_id) {return(-1);}
@@ -3,21 +3,113 @@
 #include "test_u_threadpool.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 
 #include "pbs_error.h"
+#include "threadpool.h"
+
+int        tp_deque_push(tp_deque_t *dq, tp_work_t *work);
+tp_work_t *tp_deque_pop(tp_deque_t *dq);
+tp_work_t *tp_deque_steal(tp_deque_t *dq);
+
+int done_count;
+int spawn_count;
+
+void *count_work(void *arg)
+  {
+  __sync_fetch_and_add(&done_count, 1);
+  return(NULL);
+  }
+
+void *spawn_work(void *arg)
+  {
+  threadpool_t *tp = (threadpool_t *)arg;
+  int           i;
+
+  /* enqueued from a worker, so it lands on that worker's deque */
+  for (i = 0; i < 10; i++)
+    enqueue_threadpool_request(count_work, NULL, tp);
+
+  __sync_fetch_and_add(&spawn_count, 1);
+  return(NULL);
+  }
 
 START_TEST(test_one)
   {
+  tp_deque_t dq;
+  tp_work_t  w[3];
+  int        i;
+
+  memset(&dq, 0, sizeof(dq));
 
+  fail_unless(tp_deque_pop(&dq) == NULL);
+  fail_unless(tp_deque_steal(&dq) == NULL);
 
+  for (i = 0; i < 3; i++)
+    fail_unless(tp_deque_push(&dq, w + i) == TRUE);
+
+  /* the owner works newest first, thieves take the oldest */
+  fail_unless(tp_deque_pop(&dq) == w + 2);
+  fail_unless(tp_deque_steal(&dq) == w);
+  fail_unless(tp_deque_pop(&dq) == w + 1);
+  fail_unless(tp_deque_pop(&dq) == NULL);
+  fail_unless(tp_deque_steal(&dq) == NULL);
+
+  /* a full deque refuses more work */
+  for (i = 0; i < TP_DEQUE_SIZE; i++)
+    fail_unless(tp_deque_push(&dq, w) == TRUE);
+
+  fail_unless(tp_deque_push(&dq, w) == FALSE);
+  fail_unless(tp_deque_steal(&dq) == w);
+  fail_unless(tp_deque_push(&dq, w) == TRUE);
   }
 END_TEST
 
 START_TEST(test_two)
   {
+  threadpool_t *tp = NULL;
+  tp_stats_t    stats;
+  int           i;
+  int           waited = 0;
+
+  done_count = 0;
+  spawn_count = 0;
+
+  fail_unless(initialize_threadpool(&tp, 4, 8, -1) == 0);
+  start_request_pool(tp);
+
+  for (i = 0; i < 100; i++)
+    fail_unless(enqueue_threadpool_request(count_work, NULL, tp) == 0);
+
+  for (i = 0; i < 5; i++)
+    fail_unless(enqueue_threadpool_request(spawn_work, tp, tp) == 0);
+
+  while (((done_count < 150) ||
+          (spawn_count < 5)) &&
+         (waited++ < 1000))
+    usleep(10000);
+
+  fail_unless(done_count == 150, "%d items done", done_count);
+
+  while ((tp->tp_queued != 0) &&
+         (waited++ < 1000))
+    usleep(10000);
+
+  get_threadpool_stats(tp, &stats);
+  fail_unless(stats.enqueued == 155);
+  fail_unless(stats.queued == 0);
+  fail_unless(stats.max_queued > 0);
+  fail_unless(stats.threads >= 4);
 
+  /* the maximums restart after each report */
+  get_threadpool_stats(tp, &stats);
+  fail_unless(stats.max_queued == 0);
+  fail_unless(stats.max_wait_us == 0);
 
+  destroy_request_pool(tp);
+  fail_unless(tp->tp_nthreads == 0);
   }
 END_TEST
 
@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include "user_info.h"
+#include "resource.h"
 
 bool exit_called = false;
 int LOGLEVEL = 10;
@@ -31,3 +32,31 @@ int num_array_jobs(const char *array_req)
 
 
 void log_err(int error, const char *func_id, const char *msg) {}
+
+resource_def *svr_resc_def;
+int           svr_resc_size = 0;
+long          job_nodes_procs = 0;
+
+resource_def *find_resc_def(resource_def *rscdf, const char *name, int limit)
+  {
+  static resource_def nodes_def;
+
+  if (!strcmp(name, "nodes"))
+    return(&nodes_def);
+
+  return(NULL);
+  }
+
+resource *find_resc_entry(pbs_attribute *pattr, resource_def *rscdf)
+  {
+  static resource nodes;
+
+  nodes.rs_value.at_val.at_str = (char *)"2:ppn=4";
+
+  return(&nodes);
+  }
+
+long count_proc(char *spec)
+  {
+  return(job_nodes_procs);
+  }
@@ -6,9 +6,10 @@
 #include "user_info.h"
 #include <check.h>
 
-unsigned int get_num_queued(user_info_holder *, const char *);
 unsigned int count_jobs_submitted(job *);
 
+extern long job_nodes_procs;
+
 
 START_TEST(remove_server_suffix_test)
   {
@@ -28,41 +29,12 @@ END_TEST
 
 
 
-START_TEST(get_num_queued_test)
-  {
-  unsigned int queued;
-  users.lock();
-  users.clear();
-  users.unlock();
-  user_info ui;
-
-  ui.user_name = (char *)"tom";
-  ui.num_jobs_queued = 1;
-
-  users.lock();
-  users.insert(&ui,ui.user_name);
-  users.unlock();
-
-  queued = get_num_queued(&users, "bob");
-  fail_unless(queued == 0, "incorrect queued count for bob");
-
-  queued = get_num_queued(&users, "tom");
-  fail_unless(queued == 1, "incorrect queued count for tom");
-  }
-END_TEST
-
-
-
-
 START_TEST(count_jobs_submitted_test)
   {
   unsigned int submitted;
   job          pjob;
 
   memset(&pjob, 0, sizeof(pjob));
-  users.lock();
-  users.clear();
-  users.unlock();
 
   submitted = count_jobs_submitted(&pjob);
   fail_unless(submitted == 1, "incorrect count for non-array job");
@@ -78,140 +50,129 @@ END_TEST
 START_TEST(can_queue_new_job_test)
   {
   job pjob;
+  job tom_job;
 
   memset(&pjob, 0, sizeof(pjob));
-  users.lock();
-  users.clear();
-
-  user_info *ui = (user_info *)calloc(1,sizeof(user_info));
-
-  ui->user_name = strdup("tom");
-  ui->num_jobs_queued = 1;
-
-  users.insert(ui,ui->user_name);
-
-  ui = (user_info *)calloc(1,sizeof(user_info));
-
-  ui->user_name = strdup("bob");
-  ui->num_jobs_queued = 0;
-
-  users.insert(ui,ui->user_name);
-  users.unlock();
+  memset(&tom_job, 0, sizeof(tom_job));
 
+  /* max_user_queuable is 1 and tom already has a job queued */
+  strcpy(tom_job.ji_qs.ji_jobid, "5.napali");
+  strcpy(tom_job.ji_qs.ji_queue, "batch");
+  tom_job.ji_qs.ji_state = JOB_STATE_QUEUED;
+  tom_job.ji_wattr[JOB_ATR_job_owner].at_val.at_str = (char *)"tom@napali";
+  add_user_usage(&tom_job);
 
   fail_unless(can_queue_new_job((char *)"bob", &pjob) == TRUE, "user without a job can't queue one?");
   fail_unless(can_queue_new_job((char *)"tom", &pjob) == FALSE, (char *)"tom allowed over limit");
+  fail_unless(can_queue_new_job((char *)"tom@napali", &pjob) == FALSE, (char *)"tom allowed over limit");
   pjob.ji_wattr[JOB_ATR_job_array_request].at_val.at_str = (char *)"0-10";
 
   fail_unless(can_queue_new_job((char *)"bob", &pjob) == FALSE, "array job allowed over limit");
   fail_unless(can_queue_new_job((char *)"tom", &pjob) == FALSE, "array job allowed over limit");
-  }
-END_TEST
-
-
-
-START_TEST(increment_queued_jobs_test)
-  {
-  job pjob;
 
-  memset(&pjob, 0, sizeof(pjob));
-  users.lock();
-  users.clear();
-
-  user_info *ui = (user_info *)calloc(1,sizeof(user_info));
-
-  ui->user_name = strdup("tom");
-  ui->num_jobs_queued = 1;
-
-  users.insert(ui,ui->user_name);
-
-  ui = (user_info *)calloc(1,sizeof(user_info));
-
-  ui->user_name = strdup("bob");
-  ui->num_jobs_queued = 0;
-
-  users.insert(ui,ui->user_name);
-  users.unlock();
+  /* completed jobs don't count against the limit */
+  pjob.ji_wattr[JOB_ATR_job_array_request].at_val.at_str = NULL;
+  tom_job.ji_qs.ji_state = JOB_STATE_COMPLETE;
+  update_user_usage(&tom_job);
+  fail_unless(can_queue_new_job((char *)"tom", &pjob) == TRUE);
 
-  fail_unless(increment_queued_jobs(&users, (char *)"tom", &pjob) == 0, "can't increment queued jobs");
-  pjob.ji_queue_counted = 0;
-  fail_unless(increment_queued_jobs(&users, (char *)"bob", &pjob) == 0, "can't increment queued jobs");
-  pjob.ji_queue_counted = 0;
-  // after 1 increment the count should be 2 because initialize_user_info() starts out with tom at 
-  // 1 instead of 0, as a normal program would start. Its done this way for the decrement code.
-  fail_unless(get_num_queued(&users, "tom") == 2, "didn't actually increment tom 1");
-  fail_unless(increment_queued_jobs(&users, strdup("tom@napali"), &pjob) == 0);
-  fail_unless(get_num_queued(&users, "tom") == 3, "didn't actually increment tom 2");
-
-  // Enqueue the job without resetting to make sure the count doesn't change
-  fail_unless(increment_queued_jobs(&users, strdup("tom@napali"), &pjob) == 0);
-  fail_unless(get_num_queued(&users, "tom") == 3, "Shouldn't have incremented with the bit set");
+  remove_user_usage(&tom_job);
   }
 END_TEST
 
 
 
-
-START_TEST(decrement_queued_jobs_test)
+START_TEST(user_usage_test)
   {
-  users.lock();
-  users.clear();
-  user_info *ui = (user_info *)calloc(1,sizeof(user_info));
-
-  ui->user_name = strdup("tom"); 
-  ui->num_jobs_queued = 1;
-  job pjob;
-  memset(&pjob, 0, sizeof(pjob));
-
-  users.insert(ui,ui->user_name);
-  users.unlock();
-
-  pjob.ji_queue_counted = COUNTED_GLOBALLY;
-  fail_unless(decrement_queued_jobs(&users, (char *)"bob", &pjob) == THING_NOT_FOUND, "decremented for non-existent user");
-  pjob.ji_queue_counted = COUNTED_GLOBALLY;
-  fail_unless(decrement_queued_jobs(&users, (char *)"tom@neverland.com", &pjob) == 0, "couldn't decrement for tom?");
-
-  fail_unless(get_num_queued(&users, "tom") == 0, "didn't actually decrement tom");
-  pjob.ji_queue_counted = COUNTED_GLOBALLY;
-  
-  fail_unless(decrement_queued_jobs(&users, (char *)"tom", &pjob) == 0,
-    "couldn't decrement for tom?");
-  fail_unless(get_num_queued(&users, "tom") == 0, "Disallow going negative in the count");
-
-  // Make sure we are clearing and resetting the bits  
-  fail_unless(increment_queued_jobs(&users, strdup("tom@napali"), &pjob) == 0);
-  fail_unless(get_num_queued(&users, "tom") == 1);
-  fail_unless(decrement_queued_jobs(&users, (char *)"tom", &pjob) == 0);
-  fail_unless(get_num_queued(&users, "tom") == 0);
-
+  job         j1;
+  job         j2;
+  user_usage  uu;
+  std::string out;
+
+  memset(&j1, 0, sizeof(j1));
+  memset(&j2, 0, sizeof(j2));
+
+  strcpy(j1.ji_qs.ji_jobid, "1.napali");
+  strcpy(j1.ji_qs.ji_queue, "batch");
+  j1.ji_qs.ji_state = JOB_STATE_QUEUED;
+  j1.ji_wattr[JOB_ATR_job_owner].at_val.at_str = (char *)"tom@napali";
+  j1.ji_wattr[JOB_ATR_resource].at_flags = ATR_VFLAG_SET;
+
+  strcpy(j2.ji_qs.ji_jobid, "2.napali");
+  strcpy(j2.ji_qs.ji_queue, "long");
+  j2.ji_qs.ji_state = JOB_STATE_QUEUED;
+  j2.ji_wattr[JOB_ATR_job_owner].at_val.at_str = (char *)"tom@napali";
+
+  /* jobs that were never enqueued aren't counted */
+  update_user_usage(&j1);
+  get_user_usage("tom", NULL, uu);
+  fail_unless(uu.queued == 0);
+
+  add_user_usage(&j1);
+  add_user_usage(&j2);
+  add_user_usage(&j2);
+
+  get_user_usage("tom@napali", NULL, uu);
+  fail_unless(uu.queued == 2);
+  fail_unless(uu.running == 0);
+  get_user_usage("tom", "batch", uu);
+  fail_unless(uu.queued == 1);
+  get_user_usage("bob", NULL, uu);
+  fail_unless(uu.queued == 0);
+
+  /* processors are counted from when the job starts running */
+  job_nodes_procs = 8;
+  j1.ji_qs.ji_state = JOB_STATE_RUNNING;
+  update_user_usage(&j1);
+  job_nodes_procs = 100;
+  update_user_usage(&j1);
+
+  get_user_usage("tom", "batch", uu);
+  fail_unless(uu.queued == 1);
+  fail_unless(uu.running == 1);
+  fail_unless(uu.procs == 8);
+  get_user_usage("tom", NULL, uu);
+  fail_unless(uu.running == 1);
+  fail_unless(uu.procs == 8);
+
+  format_user_usage(out);
+  fail_unless(out == "tom:2/1/8,tom@batch:1/1/8,tom@long:1/0/0", out.c_str());
+
+  j1.ji_qs.ji_state = JOB_STATE_COMPLETE;
+  update_user_usage(&j1);
+  get_user_usage("tom", NULL, uu);
+  fail_unless(uu.queued == 1);
+  fail_unless(uu.running == 0);
+  fail_unless(uu.procs == 0);
+
+  remove_user_usage(&j1);
+  remove_user_usage(&j2);
+  remove_user_usage(&j2);
+
+  get_user_usage("tom", NULL, uu);
+  fail_unless(uu.queued == 0);
+
+  format_user_usage(out);
+  fail_unless(out.size() == 0);
   }
 END_TEST
 
 
 
-
 Suite *user_info_suite(void)
   {
   Suite *s = suite_create("user_info test suite methods");
-  TCase *tc_core = tcase_create("get_num_queued_test");
-  tcase_add_test(tc_core, get_num_queued_test);
-  suite_add_tcase(s, tc_core);
-  
-  tc_core = tcase_create("count_jobs_submitted_test");
+  TCase *tc_core = tcase_create("count_jobs_submitted_test");
   tcase_add_test(tc_core, count_jobs_submitted_test);
+  tcase_add_test(tc_core, remove_server_suffix_test);
   suite_add_tcase(s, tc_core);
   
   tc_core = tcase_create("can_queue_new_job_test");
   tcase_add_test(tc_core, can_queue_new_job_test);
   suite_add_tcase(s, tc_core);
 
-  tc_core = tcase_create("increment_queued_jobs_test");
-  tcase_add_test(tc_core, increment_queued_jobs_test);
-  suite_add_tcase(s, tc_core);
-
-  tc_core = tcase_create("decrement_queued_jobs_test");
-  tcase_add_test(tc_core, decrement_queued_jobs_test);
-  tcase_add_test(tc_core, remove_server_suffix_test);
+  tc_core = tcase_create("user_usage_test");
+  tcase_add_test(tc_core, user_usage_test);
   suite_add_tcase(s, tc_core);
   
   return(s);